@@ -16,6 +16,7 @@
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/FormattedStream.h>
+#include <llvm/Support/Signals.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Target/TargetMachine.h>
@@ -23,10 +24,16 @@
 #include <llvm/TargetParser/SubtargetFeature.h>
 #include <llvm/TargetParser/TargetParser.h>
 #include <llvm/TargetParser/Triple.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+#include <cstdio>
+#include <cstdlib>
 #include <system_error>
 
 static llvm::codegen::RegisterCodeGenFlags CGF;
 
+// Objects already written by -fstream, linked in with the main one.
+static std::vector<std::string> streamedObjects;
+
 std::string GetFeatureString()
 {
     std::vector<std::string> mattrs = llvm::codegen::getMAttrs();
@@ -54,22 +61,60 @@ static llvm::ToolOutputFile* GetOutputStream(const std::string& filename)
     return FDOut;
 }
 
-static void CreateObject(llvm::Module* module, const std::string& objname)
+// Vector versions of the math functions in the runtime (vecmath.c). These are only 128 bits
+// wide, as wider vectors aren't passed in registers unless the runtime is built for AVX.
+static const llvm::VecDesc runtimeVecFuncs[] = {
+    { "llvm.sin.f64", "__vsin_d2", llvm::ElementCount::getFixed(2), false, "_ZGV_LLVM_N2v" },
+    { "llvm.cos.f64", "__vcos_d2", llvm::ElementCount::getFixed(2), false, "_ZGV_LLVM_N2v" },
+    { "llvm.exp.f64", "__vexp_d2", llvm::ElementCount::getFixed(2), false, "_ZGV_LLVM_N2v" },
+    { "llvm.log.f64", "__vlog_d2", llvm::ElementCount::getFixed(2), false, "_ZGV_LLVM_N2v" },
+    { "atan", "__vatan_d2", llvm::ElementCount::getFixed(2), false, "_ZGV_LLVM_N2v" },
+    { "llvm.sin.f32", "__vsin_f4", llvm::ElementCount::getFixed(4), false, "_ZGV_LLVM_N4v" },
+    { "llvm.cos.f32", "__vcos_f4", llvm::ElementCount::getFixed(4), false, "_ZGV_LLVM_N4v" },
+    { "llvm.exp.f32", "__vexp_f4", llvm::ElementCount::getFixed(4), false, "_ZGV_LLVM_N4v" },
+    { "llvm.log.f32", "__vlog_f4", llvm::ElementCount::getFixed(4), false, "_ZGV_LLVM_N4v" },
+};
+
+std::unique_ptr<llvm::TargetLibraryInfoImpl> CreateTargetLibraryInfo(const llvm::Triple& triple)
 {
-    TIME_TRACE();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmPrinters();
-    llvm::InitializeAllAsmParsers();
+    auto tlii = std::make_unique<llvm::TargetLibraryInfoImpl>(triple);
+    switch (vecLib)
+    {
+    case NoVecLib:
+	break;
+    // libmvec and SVML only exist for x86, and glibc only has libmvec for x86-64.
+    case LibmVec:
+	if (triple.getArch() == llvm::Triple::x86_64)
+	{
+	    tlii->addVectorizableFunctionsFromVecLib(llvm::TargetLibraryInfoImpl::LIBMVEC_X86, triple);
+	}
+	break;
+    case Sleef:
+	tlii->addVectorizableFunctionsFromVecLib(llvm::TargetLibraryInfoImpl::SLEEFGNUABI, triple);
+	break;
+    case SVML:
+	if (triple.isX86())
+	{
+	    tlii->addVectorizableFunctionsFromVecLib(llvm::TargetLibraryInfoImpl::SVML, triple);
+	}
+	break;
+    case Runtime:
+	tlii->addVectorizableFunctions(runtimeVecFuncs);
+	break;
+    }
+    return tlii;
+}
 
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine(const llvm::Triple& triple,
+                                                          std::optional<llvm::CodeModel::Model> cm)
+{
     std::string         error;
-    llvm::Triple        triple = llvm::Triple(module->getTargetTriple());
     const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple.getTriple(), error);
 
     if (!target)
     {
 	std::cerr << "Error, could not find target: " << error << std::endl;
-	return;
+	return 0;
     }
 
     std::string mcpu = llvm::codegen::getMCPU();
@@ -78,10 +123,63 @@ static void CreateObject(llvm::Module* module, const std::string& objname)
 	mcpu = llvm::sys::getHostCPUName().str();
     }
 
-    llvm::TargetOptions                  options;
-    std::string                          FeaturesStr = GetFeatureString();
-    std::unique_ptr<llvm::TargetMachine> tm(
-        target->createTargetMachine(triple.getTriple(), mcpu, FeaturesStr, options, llvm::Reloc::PIC_));
+    // No optimisation in the code generator means FastISel and the fast register allocator.
+    llvm::CodeGenOptLevel level = fastCompile ? llvm::CodeGenOptLevel::None : llvm::CodeGenOptLevel::Default;
+    llvm::TargetOptions   options;
+    std::string           FeaturesStr = GetFeatureString();
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+        triple.getTriple(), mcpu, FeaturesStr, options, llvm::Reloc::PIC_, cm, level));
+}
+
+// Globals of 2GB or more can't be reached with the 32-bit offsets of the small code model.
+// On x86-64 ELF, put them in the large data sections and use the medium code model, so
+// the rest of the program (and the runtime) can still use short addressing.
+static bool PlaceHugeGlobals(llvm::Module* module, const llvm::Triple& triple)
+{
+    if (model != m64 || triple.getArch() != llvm::Triple::x86_64 || !triple.isOSBinFormatELF())
+    {
+	return false;
+    }
+    const llvm::DataLayout& dl = module->getDataLayout();
+    bool                    huge = false;
+    for (auto& gv : module->globals())
+    {
+	llvm::Type* ty = gv.getValueType();
+	if (!gv.isDeclaration() && !gv.hasSection() && ty->isSized() &&
+	    dl.getTypeAllocSize(ty) >= (1ULL << 31))
+	{
+	    gv.setSection(gv.getInitializer()->isNullValue() ? ".lbss" : ".ldata");
+	    huge = true;
+	}
+    }
+    return huge;
+}
+
+static void CreateObject(llvm::Module* module, const std::string& objname)
+{
+    TIME_TRACE();
+    // We only ever generate code for the host, so the other targets are just startup cost.
+    if (fastCompile)
+    {
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+	llvm::InitializeNativeTargetAsmParser();
+    }
+    else
+    {
+	llvm::InitializeAllTargets();
+	llvm::InitializeAllTargetMCs();
+	llvm::InitializeAllAsmPrinters();
+	llvm::InitializeAllAsmParsers();
+    }
+
+    llvm::Triple                         triple = llvm::Triple(module->getTargetTriple());
+    std::optional<llvm::CodeModel::Model> cm;
+    if (PlaceHugeGlobals(module, triple))
+    {
+	cm = llvm::CodeModel::Medium;
+    }
+    std::unique_ptr<llvm::TargetMachine> tm = CreateTargetMachine(triple, cm);
 
     if (!tm)
     {
@@ -90,7 +188,8 @@ static void CreateObject(llvm::Module* module, const std::string& objname)
     }
 
     llvm::legacy::PassManager           PM;
-    llvm::TargetLibraryInfoWrapperPass* TLI = new llvm::TargetLibraryInfoWrapperPass(triple);
+    llvm::TargetLibraryInfoWrapperPass* TLI =
+        new llvm::TargetLibraryInfoWrapperPass(*CreateTargetLibraryInfo(triple));
     PM.add(TLI);
 
     std::unique_ptr<llvm::ToolOutputFile> Out(GetOutputStream(objname));
@@ -102,7 +201,7 @@ static void CreateObject(llvm::Module* module, const std::string& objname)
 
     llvm::raw_pwrite_stream* OS = &Out->os();
 
-    if (tm->addPassesToEmitFile(PM, *OS, nullptr, llvm::CodeGenFileType::ObjectFile, false))
+    if (tm->addPassesToEmitFile(PM, *OS, nullptr, llvm::CodeGenFileType::ObjectFile, fastCompile))
     {
 	std::cerr << objname
 	          << ": target does not support generation of this"
@@ -113,6 +212,130 @@ static void CreateObject(llvm::Module* module, const std::string& objname)
     Out->keep();
 }
 
+// Declares, in the module the code is moved to, the globals of the original module that the code uses.
+// Those that were local to the original module become hidden globals, so the objects link together.
+class DeclarationMaterializer : public llvm::ValueMaterializer
+{
+public:
+    DeclarationMaterializer(llvm::Module* m) : module(m) {}
+    llvm::Value* materialize(llvm::Value* v) override
+    {
+	auto gv = llvm::dyn_cast<llvm::GlobalValue>(v);
+	if (!gv || gv->getParent() == module)
+	{
+	    return 0;
+	}
+	if (gv->hasLocalLinkage())
+	{
+	    if (!gv->hasName())
+	    {
+		gv->setName("stream.global");
+	    }
+	    gv->setLinkage(llvm::GlobalValue::ExternalLinkage);
+	    gv->setVisibility(llvm::GlobalValue::HiddenVisibility);
+	}
+	llvm::GlobalValue* decl;
+	if (auto f = llvm::dyn_cast<llvm::Function>(gv))
+	{
+	    auto fd = llvm::Function::Create(f->getFunctionType(), llvm::GlobalValue::ExternalLinkage,
+	                                     f->getAddressSpace(), f->getName(), module);
+	    fd->copyAttributesFrom(f);
+	    decl = fd;
+	}
+	else
+	{
+	    auto                  var = llvm::cast<llvm::GlobalVariable>(gv);
+	    llvm::GlobalVariable* vd = new llvm::GlobalVariable(
+	        *module, var->getValueType(), var->isConstant(), llvm::GlobalValue::ExternalLinkage, 0,
+	        var->getName(), 0, var->getThreadLocalMode(), var->getAddressSpace());
+	    vd->copyAttributesFrom(var);
+	    decl = vd;
+	}
+	return decl;
+    }
+
+private:
+    llvm::Module* module;
+};
+
+std::unique_ptr<llvm::Module> MoveToModule(llvm::Module* module, const std::vector<llvm::Function*>& funcs)
+{
+    TIME_TRACE();
+    auto m = std::make_unique<llvm::Module>(funcs.back()->getName(), module->getContext());
+    m->setTargetTriple(module->getTargetTriple());
+    m->setDataLayout(module->getDataLayout());
+    if (llvm::NamedMDNode* cus = module->getNamedMetadata("llvm.dbg.cu"))
+    {
+	llvm::NamedMDNode* newCus = m->getOrInsertNamedMetadata("llvm.dbg.cu");
+	for (auto cu : cus->operands())
+	{
+	    newCus->addOperand(cu);
+	}
+    }
+
+    // The bodies move to new functions, and the old ones stay behind as declarations, so that code
+    // still to be generated can call them.
+    llvm::ValueToValueMapTy      vmap;
+    std::vector<llvm::Function*> moved;
+    for (auto f : funcs)
+    {
+	if (f->hasLocalLinkage())
+	{
+	    f->setLinkage(llvm::GlobalValue::ExternalLinkage);
+	    f->setVisibility(llvm::GlobalValue::HiddenVisibility);
+	}
+	llvm::Function* nf = llvm::Function::Create(f->getFunctionType(), llvm::GlobalValue::ExternalLinkage,
+	                                            f->getAddressSpace(), f->getName(), m.get());
+	nf->copyAttributesFrom(f);
+	llvm::SmallVector<std::pair<unsigned, llvm::MDNode*>, 4> mds;
+	f->getAllMetadata(mds);
+	for (auto md : mds)
+	{
+	    nf->setMetadata(md.first, md.second);
+	}
+	f->clearMetadata();
+	nf->splice(nf->end(), f);
+	for (auto args = std::make_pair(f->arg_begin(), nf->arg_begin()); args.first != f->arg_end();
+	     ++args.first, ++args.second)
+	{
+	    args.first->replaceAllUsesWith(&*args.second);
+	    args.second->takeName(&*args.first);
+	}
+	vmap[f] = nf;
+	moved.push_back(nf);
+    }
+
+    DeclarationMaterializer materializer(m.get());
+    for (auto nf : moved)
+    {
+	for (auto& bb : *nf)
+	{
+	    for (auto& inst : bb)
+	    {
+		for (auto& op : inst.operands())
+		{
+		    if (auto c = llvm::dyn_cast<llvm::Constant>(op.get()))
+		    {
+			op.set(llvm::MapValue(c, vmap, llvm::RF_None, 0, &materializer));
+		    }
+		}
+	    }
+	}
+    }
+
+    // Nested functions that nothing outside uses can be local to the new module.
+    for (size_t i = 0; i + 1 < funcs.size(); i++)
+    {
+	funcs[i]->removeDeadConstantUsers();
+	if (funcs[i]->use_empty())
+	{
+	    moved[i]->setLinkage(llvm::GlobalValue::InternalLinkage);
+	    funcs[i]->setVisibility(llvm::GlobalValue::DefaultVisibility);
+	}
+    }
+    return m;
+}
+
 std::string replace_ext(const std::string& origName, const std::string& expectedExt,
                         const std::string& newExt)
 {
@@ -124,6 +347,29 @@ std::string replace_ext(const std::string& origName, const std::string& expected
     return origName.substr(0, origName.size() - expectedExt.size()) + newExt;
 }
 
+static void RemoveStreamedObjects()
+{
+    for (auto& obj : streamedObjects)
+    {
+	remove(obj.c_str());
+	llvm::sys::DontRemoveFileOnSignal(obj);
+    }
+    streamedObjects.clear();
+}
+
+// The objects are only needed until the link, so they are removed however the compiler exits.
+void CreateStreamedObject(llvm::Module* module, const std::string& filename)
+{
+    if (streamedObjects.empty())
+    {
+	std::atexit(RemoveStreamedObjects);
+    }
+    std::string objname = replace_ext(filename, ".pas", "." + std::to_string(streamedObjects.size()) + ".o");
+    streamedObjects.push_back(objname);
+    llvm::sys::RemoveFileOnSignal(objname);
+    CreateObject(module, objname);
+}
+
 bool CreateBinary(llvm::Module* module, const std::string& filename, EmitType emit)
 {
     TIME_TRACE();
@@ -155,13 +401,29 @@ bool CreateBinary(llvm::Module* module, const std::string& filename, EmitType em
 	{
 	    debugFlag = " -g";
 	}
-	std::string cmd = compiler + " " + modelStr + verboseflags + " " + objname + " -L\"" + libpath +
-	                  "\" -lruntime" + modelStr + debugFlag + " -lm -o " + exename;
+	// libmvec is pulled in by -lm, and the runtime versions are in libruntime.
+	std::string vecLibFlag;
+	if (vecLib == Sleef)
+	{
+	    vecLibFlag = " -lsleefgnuabi";
+	}
+	else if (vecLib == SVML)
+	{
+	    vecLibFlag = " -lsvml";
+	}
+	std::string objects = objname;
+	for (auto& obj : streamedObjects)
+	{
+	    objects += " " + obj;
+	}
+	std::string cmd = compiler + " " + modelStr + verboseflags + " " + objects + " -L\"" + libpath +
+	                  "\" -lruntime" + modelStr + debugFlag + vecLibFlag + " -lm -lpthread -o " + exename;
 	if (verbosity)
 	{
 	    std::cerr << "Executing final link command: " << cmd << std::endl;
 	}
 	int res = system(cmd.c_str());
+	RemoveStreamedObjects();
 	if (res != 0)
 	{
 	    std::cerr << "Error: " << res << std::endl;
@@ -195,19 +457,7 @@ llvm::Module* CreateModule()
 	triple = triple.get64BitArchVariant();
     }
     module->setTargetTriple(triple.getTriple());
-    std::string         error;
-    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple.getTriple(), error);
-    if (!target)
-    {
-	std::cerr << "Error, could not find target: " << error << std::endl;
-	return 0;
-    }
-
-    std::string                          FeaturesStr = GetFeatureString();
-    llvm::TargetOptions                  options;
-    std::string                          mcpu = llvm::codegen::getMCPU();
-    std::unique_ptr<llvm::TargetMachine> tm(
-        target->createTargetMachine(triple.getTriple(), mcpu, FeaturesStr, options, llvm::Reloc::Static));
+    std::unique_ptr<llvm::TargetMachine> tm = CreateTargetMachine(triple);
     ICE_IF(!tm, "Could not create TargetMachine");
     const llvm::DataLayout dl = tm->createDataLayout();
     module->setDataLayout(dl);
@@ -1,11 +1,26 @@
 #ifndef BINARY_H
 #define BINARY_H
 #include "options.h"
+#include <llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/TargetParser/Triple.h>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 bool CreateBinary(llvm::Module* module, const std::string& fileName, EmitType emit);
 
 llvm::Module* CreateModule();
 
+// Move the code of funcs to a module of its own, leaving declarations of them behind.
+std::unique_ptr<llvm::Module> MoveToModule(llvm::Module* module, const std::vector<llvm::Function*>& funcs);
+// Write the object code of a module split off by MoveToModule, to be linked in by CreateBinary.
+void CreateStreamedObject(llvm::Module* module, const std::string& fileName);
+
+std::unique_ptr<llvm::TargetMachine> CreateTargetMachine(const llvm::Triple&                   triple,
+                                                         std::optional<llvm::CodeModel::Model> cm = {});
+std::unique_ptr<llvm::TargetLibraryInfoImpl> CreateTargetLibraryInfo(const llvm::Triple& triple);
+
 #endif
@@ -1,6 +1,7 @@
 #include "builtin.h"
 #include "expr.h"
 #include "options.h"
+#include <cmath>
 #include <functional>
 #include <llvm/IR/DataLayout.h>
 
@@ -8,18 +9,28 @@ extern llvm::Module* theModule;
 
 namespace Builtin
 {
-    static bool CastIntegerToReal(ExprAST*& arg)
+    static bool CastToReal(ExprAST*& arg)
     {
-	if (!llvm::isa<Types::RealDecl>(arg->Type()))
+	if (!llvm::isa<Types::RealDecl>(arg->Type()) && !IsIntegral(arg->Type()))
 	{
-	    // Implicit typecast.
-	    if (!IsIntegral(arg->Type()))
+	    return false;
+	}
+	// Implicit typecast, also of single and extended.
+	arg = Recast(arg, Types::Get<Types::RealDecl>());
+	return true;
+    }
+
+    // The argument if it is an integer constant, else null.
+    static IntegerExprAST* ConstantIntArg(ExprAST* arg)
+    {
+	if (auto e = llvm::dyn_cast<IntegerExprAST>(arg))
+	{
+	    if (IsIntegral(e->Type()))
 	    {
-		return false;
+		return e;
 	    }
-	    arg = Recast(arg, Types::Get<Types::RealDecl>());
 	}
-	return true;
+	return 0;
     }
 
     using ArgList = const std::vector<ExprAST*>;
@@ -92,6 +103,7 @@ namespace Builtin
 	using FunctionSameAsArg::FunctionSameAsArg;
 	Types::TypeDecl* Type() const override;
 	llvm::Value*     CodeGen(llvm::IRBuilder<>& builder) override;
+	ExprAST*         Fold() override;
     };
 
     class FunctionSqr : public FunctionSameAsArg
@@ -99,6 +111,7 @@ namespace Builtin
     public:
 	using FunctionSameAsArg::FunctionSameAsArg;
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ExprAST*     Fold() override;
     };
 
     class FunctionOdd : public FunctionBool
@@ -107,6 +120,7 @@ namespace Builtin
 	using FunctionBool::FunctionBool;
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
 	ErrorType    Semantics() override;
+	ExprAST*     Fold() override;
     };
 
     class FunctionRound : public FunctionInt
@@ -156,6 +170,7 @@ namespace Builtin
 	llvm::Value*     CodeGen(llvm::IRBuilder<>& builder) override;
 	Types::TypeDecl* Type() const override { return Types::Get<Types::CharDecl>(); }
 	ErrorType        Semantics() override;
+	ExprAST*         Fold() override;
     };
 
     class FunctionOrd : public FunctionInt
@@ -164,6 +179,7 @@ namespace Builtin
 	using FunctionInt::FunctionInt;
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
 	ErrorType    Semantics() override;
+	ExprAST*     Fold() override;
     };
 
     class FunctionLength : public FunctionInt
@@ -172,6 +188,38 @@ namespace Builtin
 	using FunctionInt::FunctionInt;
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
 	ErrorType    Semantics() override;
+	ExprAST*     Fold() override;
+    };
+
+    class FunctionHigh : public FunctionInt
+    {
+    public:
+	using FunctionInt::FunctionInt;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    class FunctionSetLength : public FunctionVoid
+    {
+    public:
+	using FunctionVoid::FunctionVoid;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    // include(m, k) adds k to a map or hashset, exclude(m, k) removes it.
+    class FunctionMapKey : public FunctionVoid
+    {
+    public:
+	FunctionMapKey(const std::string& fn, ArgList& a, const std::string& nn)
+	    : FunctionVoid(fn, a), func(nn)
+	{
+	}
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+
+    private:
+	std::string func;
     };
 
     class FunctionPopcnt : public FunctionInt
@@ -188,6 +236,10 @@ namespace Builtin
 	using FunctionSameAsArg::FunctionSameAsArg;
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
 	ErrorType    Semantics() override;
+	ExprAST*     Fold() override;
+
+    protected:
+	bool Step(llvm::APInt& step);
     };
 
     class FunctionPred : public FunctionSucc
@@ -195,6 +247,7 @@ namespace Builtin
     public:
 	using FunctionSucc::FunctionSucc;
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ExprAST*     Fold() override;
     };
 
     class FunctionFloat : public FunctionBase
@@ -225,7 +278,9 @@ namespace Builtin
     {
     public:
 	using FunctionFloat::FunctionFloat;
-	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	llvm::Value*     CodeGen(llvm::IRBuilder<>& builder) override;
+	Types::TypeDecl* Type() const override;
+	ErrorType        Semantics() override;
     };
 
     class FunctionNew : public FunctionVoid
@@ -515,6 +570,155 @@ namespace Builtin
 	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
     };
 
+    class FunctionSpawn : public FunctionLongInt
+    {
+    public:
+	using FunctionLongInt::FunctionLongInt;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+
+    private:
+	llvm::Function* Thunk(llvm::IRBuilder<>& builder, llvm::Function* fn, bool hasClosure);
+    };
+
+    class FunctionJoin : public FunctionVoid
+    {
+    public:
+	using FunctionVoid::FunctionVoid;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    class FunctionAtomicInc : public FunctionVoid
+    {
+    public:
+	FunctionAtomicInc(const std::string& fn, ArgList& a, llvm::AtomicRMWInst::BinOp o)
+	    : FunctionVoid(fn, a), op(o)
+	{
+	}
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+
+    private:
+	llvm::AtomicRMWInst::BinOp op;
+    };
+
+    class FunctionAtomicCas : public FunctionBool
+    {
+    public:
+	using FunctionBool::FunctionBool;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    class FunctionMakeChannel : public FunctionLongInt
+    {
+    public:
+	using FunctionLongInt::FunctionLongInt;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    class FunctionSend : public FunctionVoid
+    {
+    public:
+	using FunctionVoid::FunctionVoid;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    class FunctionReceive : public FunctionBool
+    {
+    public:
+	using FunctionBool::FunctionBool;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+	ErrorType    Semantics() override;
+    };
+
+    class FunctionShuffle : public FunctionBase
+    {
+    public:
+	FunctionShuffle(const std::string& fn, ArgList& a);
+	ErrorType        Semantics() override;
+	llvm::Value*     CodeGen(llvm::IRBuilder<>& builder) override;
+	Types::TypeDecl* Type() const override { return (resType) ? resType : args[0]->Type(); }
+
+    private:
+	size_t           FirstIndex() const;
+	Types::TypeDecl* resType;
+    };
+
+    class FunctionVectorReduce : public FunctionBase
+    {
+    public:
+	FunctionVectorReduce(const std::string& fn, ArgList& a, llvm::Intrinsic::ID i)
+	    : FunctionBase(fn, a), id(i)
+	{
+	}
+	ErrorType        Semantics() override;
+	llvm::Value*     CodeGen(llvm::IRBuilder<>& builder) override;
+	Types::TypeDecl* Type() const override;
+
+    private:
+	llvm::Intrinsic::ID id;
+    };
+
+    class FunctionSelect : public FunctionBase
+    {
+    public:
+	using FunctionBase::FunctionBase;
+	ErrorType        Semantics() override;
+	llvm::Value*     CodeGen(llvm::IRBuilder<>& builder) override;
+	Types::TypeDecl* Type() const override { return args[1]->Type(); }
+    };
+
+    class FunctionExpect : public FunctionBool
+    {
+    public:
+	FunctionExpect(const std::string& fn, ArgList& a, bool e) : FunctionBool(fn, a), expected(e) {}
+	ErrorType    Semantics() override;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+
+    private:
+	bool expected;
+    };
+
+    class FunctionSort : public FunctionVoid
+    {
+    public:
+	using FunctionVoid::FunctionVoid;
+	ErrorType    Semantics() override;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+
+    private:
+	FunctionExprAST* LessFunction() const;
+	Types::TypeDecl* ElementType() const;
+    };
+
+    class FunctionFillChar : public FunctionVoid
+    {
+    public:
+	using FunctionVoid::FunctionVoid;
+	ErrorType    Semantics() override;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+    };
+
+    class FunctionMove : public FunctionVoid
+    {
+    public:
+	using FunctionVoid::FunctionVoid;
+	ErrorType    Semantics() override;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+    };
+
+    class FunctionCompareMem : public FunctionBool
+    {
+    public:
+	using FunctionBool::FunctionBool;
+	ErrorType    Semantics() override;
+	llvm::Value* CodeGen(llvm::IRBuilder<>& builder) override;
+    };
+
     void FunctionBase::accept(ASTVisitor& v)
     {
 	for (auto a : args)
@@ -546,6 +750,17 @@ namespace Builtin
 	{
 	    return ErrorType::WrongArgType;
 	}
+	// Mixed real types are converted to the more precise one.
+	if (llvm::isa<Types::RealDecl>(args[0]->Type()) || llvm::isa<Types::RealDecl>(args[1]->Type()))
+	{
+	    const Types::TypeDecl* ty = args[0]->Type()->CompatibleType(args[1]->Type());
+	    if (!ty)
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	    args[0] = Recast(args[0], ty);
+	    args[1] = Recast(args[1], ty);
+	}
 	return ErrorType::Ok;
     }
 
@@ -575,7 +790,7 @@ namespace Builtin
 	    llvm::Value* imxim = builder.CreateFMul(im, im, "imxim");
 	    llvm::Value* sum = builder.CreateFAdd(rexre, imxim, "addi");
 
-	    llvm::FunctionCallee f = GetFunction(ty, { ty }, "llvm.sqrt.f64");
+	    llvm::FunctionCallee f = GetFunction(ty, { ty }, FloatIntrinsicName("sqrt", ty));
 	    return builder.CreateCall(f, sum, "sqrt");
 	}
 
@@ -591,7 +806,25 @@ namespace Builtin
 	    llvm::Value* res = builder.CreateSelect(cmp, a, neg, "abs");
 	    return res;
 	}
-	return CallRuntimeFPFunc(builder, "llvm.fabs.f64", args);
+	return CallRuntimeFPFunc(builder, FloatIntrinsicName("fabs", a->getType()), args);
+    }
+
+    ExprAST* FunctionAbs::Fold()
+    {
+	if (auto r = llvm::dyn_cast<RealExprAST>(args[0]))
+	{
+	    return new RealExprAST(r->Loc(), std::fabs(r->Value()));
+	}
+	if (IntegerExprAST* e = ConstantIntArg(args[0]))
+	{
+	    llvm::APInt v = ConstantIntValue(e);
+	    if (!IsUnsigned(e->Type()) && v.isNegative())
+	    {
+		v.negate();
+	    }
+	    return MakeIntegerExpr(e->Loc(), v, e->Type());
+	}
+	return 0;
     }
 
     llvm::Value* FunctionOdd::CodeGen(llvm::IRBuilder<>& builder)
@@ -601,6 +834,15 @@ namespace Builtin
 	return builder.CreateTrunc(v, Types::Get<Types::BoolDecl>()->LlvmType(), "odd");
     }
 
+    ExprAST* FunctionOdd::Fold()
+    {
+	if (IntegerExprAST* e = ConstantIntArg(args[0]))
+	{
+	    return MakeIntegerExpr(e->Loc(), ConstantIntValue(e).trunc(1), Types::Get<Types::BoolDecl>());
+	}
+	return 0;
+    }
+
     ErrorType FunctionOdd::Semantics()
     {
 	if (args.size() != 1)
@@ -645,12 +887,37 @@ namespace Builtin
 	return builder.CreateFMul(a, a, "sqr");
     }
 
+    ExprAST* FunctionSqr::Fold()
+    {
+	if (auto r = llvm::dyn_cast<RealExprAST>(args[0]))
+	{
+	    return new RealExprAST(r->Loc(), r->Value() * r->Value());
+	}
+	if (IntegerExprAST* e = ConstantIntArg(args[0]))
+	{
+	    llvm::APInt v = ConstantIntValue(e);
+	    return MakeIntegerExpr(e->Loc(), v * v, e->Type());
+	}
+	return 0;
+    }
+
     llvm::Value* FunctionFloat::CodeGen(llvm::IRBuilder<>& builder)
     {
 	if (llvm::isa<Types::ComplexDecl>(args[0]->Type()))
 	{
 	    return CallRuntimeCplxFunc(builder, func, args);
 	}
+	// There is no errno in Pascal, so the libm function only depends on its argument. Saying
+	// so lets the vectoriser replace it with the vector library's version.
+	if (vecLib != NoVecLib)
+	{
+	    llvm::Type* ty = args[0]->Type()->LlvmType();
+	    if (auto fn = llvm::dyn_cast<llvm::Function>(GetFunction(ty, { ty }, func).getCallee()))
+	    {
+		fn->setDoesNotAccessMemory();
+		fn->setDoesNotThrow();
+	    }
+	}
 	return CallRuntimeFPFunc(builder, func, args);
     }
 
@@ -670,7 +937,7 @@ namespace Builtin
 	    return ErrorType::WrongArgCount;
 	}
 
-	if (llvm::isa<Types::ComplexDecl>(args[0]->Type()) || CastIntegerToReal(args[0]))
+	if (llvm::isa<Types::ComplexDecl>(args[0]->Type()) || CastToReal(args[0]))
 	{
 	    return ErrorType::Ok;
 	}
@@ -683,12 +950,36 @@ namespace Builtin
 	{
 	    return CallRuntimeCplxFunc(builder, func, args);
 	}
-	return CallRuntimeFPFunc(builder, "llvm." + func + ".f64", args);
+	return CallRuntimeFPFunc(builder, FloatIntrinsicName(func, args[0]->Type()->LlvmType()), args);
+    }
+
+    // Intrinsics work on single and extended too, without converting to real.
+    Types::TypeDecl* FunctionFloatIntrinsic::Type() const
+    {
+	if (llvm::isa<Types::RealDecl>(args[0]->Type()))
+	{
+	    return args[0]->Type();
+	}
+	return FunctionFloat::Type();
+    }
+
+    ErrorType FunctionFloatIntrinsic::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (llvm::isa<Types::ComplexDecl, Types::RealDecl>(args[0]->Type()) || CastToReal(args[0]))
+	{
+	    return ErrorType::Ok;
+	}
+	return ErrorType::WrongArgType;
     }
 
     llvm::Value* FunctionRound::CodeGen(llvm::IRBuilder<>& builder)
     {
-	llvm::Value* v = CallRuntimeFPFunc(builder, "llvm.round.f64", args);
+	llvm::Type*  ty = args[0]->Type()->LlvmType();
+	llvm::Value* v = CallRuntimeFPFunc(builder, FloatIntrinsicName("round", ty), args);
 	return builder.CreateFPToSI(v, Types::Get<Types::IntegerDecl>()->LlvmType(), "to.int");
     }
 
@@ -721,6 +1012,7 @@ namespace Builtin
 	{
 	    return ErrorType::WrongArgType;
 	}
+	CastToReal(args[0]);
 	return ErrorType::Ok;
     }
 
@@ -728,11 +1020,11 @@ namespace Builtin
     {
 	llvm::Value*         orig = args[0]->CodeGen();
 	llvm::Type*          ty = args[0]->Type()->LlvmType();
-	llvm::FunctionCallee fnAbs = GetFunction(ty, { ty }, "llvm.fabs.f64");
+	llvm::FunctionCallee fnAbs = GetFunction(ty, { ty }, FloatIntrinsicName("fabs", ty));
 	llvm::Value*         abs = builder.CreateCall(fnAbs, orig, "abs");
-	llvm::FunctionCallee fnFloor = GetFunction(ty, { ty }, "llvm.floor.f64");
+	llvm::FunctionCallee fnFloor = GetFunction(ty, { ty }, FloatIntrinsicName("floor", ty));
 	llvm::Value*         floor = builder.CreateCall(fnFloor, abs, "floor");
-	llvm::FunctionCallee fnCopySign = GetFunction(ty, { ty, ty }, "llvm.copysign.f64");
+	llvm::FunctionCallee fnCopySign = GetFunction(ty, { ty, ty }, FloatIntrinsicName("copysign", ty));
 	return builder.CreateCall(fnCopySign, { floor, orig }, "int");
     }
 
@@ -808,6 +1100,16 @@ namespace Builtin
 	return builder.CreateTrunc(a, Types::Get<Types::CharDecl>()->LlvmType(), "chr");
     }
 
+    ExprAST* FunctionChr::Fold()
+    {
+	if (IntegerExprAST* e = ConstantIntArg(args[0]))
+	{
+	    Types::TypeDecl* ty = Types::Get<Types::CharDecl>();
+	    return MakeIntegerExpr(e->Loc(), ConstantIntValue(e).zextOrTrunc(8), ty);
+	}
+	return 0;
+    }
+
     ErrorType FunctionChr::Semantics()
     {
 	if (args.size() != 1)
@@ -827,6 +1129,16 @@ namespace Builtin
 	return builder.CreateZExt(a, Types::Get<Types::IntegerDecl>()->LlvmType(), "ord");
     }
 
+    ExprAST* FunctionOrd::Fold()
+    {
+	if (IntegerExprAST* e = ConstantIntArg(args[0]))
+	{
+	    Types::TypeDecl* ty = Types::Get<Types::IntegerDecl>();
+	    return MakeIntegerExpr(e->Loc(), ConstantIntValue(e).zextOrTrunc(32), ty);
+	}
+	return 0;
+    }
+
     ErrorType FunctionOrd::Semantics()
     {
 	if (args.size() != 1)
@@ -848,6 +1160,35 @@ namespace Builtin
 	return builder.CreateAdd(a, b, "succ");
     }
 
+    // The amount to step by, if it is known and as wide as the first argument.
+    bool FunctionSucc::Step(llvm::APInt& step)
+    {
+	unsigned width = args[0]->Type()->LlvmType()->getIntegerBitWidth();
+	if (args.size() == 1)
+	{
+	    step = llvm::APInt(width, 1);
+	    return true;
+	}
+	IntegerExprAST* e = ConstantIntArg(args[1]);
+	if (!e || e->Type()->LlvmType() != args[0]->Type()->LlvmType())
+	{
+	    return false;
+	}
+	step = ConstantIntValue(e);
+	return true;
+    }
+
+    ExprAST* FunctionSucc::Fold()
+    {
+	IntegerExprAST* e = ConstantIntArg(args[0]);
+	llvm::APInt     step;
+	if (!e || !Step(step))
+	{
+	    return 0;
+	}
+	return MakeIntegerExpr(e->Loc(), ConstantIntValue(e) + step, e->Type());
+    }
+
     ErrorType FunctionSucc::Semantics()
     {
 	if (args.size() < 1 || args.size() > 2)
@@ -873,25 +1214,42 @@ namespace Builtin
 	return builder.CreateSub(a, b, "pred");
     }
 
+    ExprAST* FunctionPred::Fold()
+    {
+	IntegerExprAST* e = ConstantIntArg(args[0]);
+	llvm::APInt     step;
+	if (!e || !Step(step))
+	{
+	    return 0;
+	}
+	return MakeIntegerExpr(e->Loc(), ConstantIntValue(e) - step, e->Type());
+    }
+
     llvm::Value* FunctionNew::CodeGen(llvm::IRBuilder<>& builder)
     {
 	auto pd = llvm::dyn_cast<Types::PointerDecl>(args[0]->Type());
 	ICE_IF(!pd, "The argument to new should be a PointerDecl!");
 	const Types::TypeDecl* elemTy = pd->SubType();
 	size_t                 size = elemTy->Size();
-	llvm::Type*            ty = Types::Get<Types::IntegerDecl>()->LlvmType();
+	llvm::Type*            ty = Types::GetIndexType()->LlvmType();
 
 	// Result is "void *"
 	llvm::Type*          voidTy = Types::GetVoidPtrType();
 	llvm::FunctionCallee f = GetFunction(voidTy, { ty }, "__new");
 
-	llvm::Value* retVal = builder.CreateCall(f, { MakeIntegerConstant(size) }, "new");
+	llvm::Value* retVal = builder.CreateCall(f, { llvm::ConstantInt::get(ty, size) }, "new");
 
 	auto var = llvm::dyn_cast<AddressableAST>(args[0]);
 	// TODO: Fix this to be a proper TypeCast...
 	retVal = builder.CreateBitCast(retVal, pd->LlvmType(), "cast");
 	llvm::Value* pA = var->Address();
 
+	// A dynamic array or map starts out empty.
+	if (Types::IsManaged(elemTy))
+	{
+	    builder.CreateStore(llvm::Constant::getNullValue(elemTy->LlvmType()), retVal);
+	}
+
 	// TODO: We need to recursively process the type here, and construct vtables for all
 	// of the elements that are classes (that have VTables).
 	if (auto cd = llvm::dyn_cast<Types::ClassDecl>(elemTy))
@@ -924,7 +1282,13 @@ namespace Builtin
 	llvm::Type*          ty = args[0]->Type()->LlvmType();
 	llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), { ty }, "__dispose");
 
-	return builder.CreateCall(f, { args[0]->CodeGen() });
+	llvm::Value* p = args[0]->CodeGen();
+	auto         pd = llvm::cast<Types::PointerDecl>(args[0]->Type());
+	if (Types::IsManaged(pd->SubType()))
+	{
+	    CallManagedFunc("Free", pd->SubType(), { p });
+	}
+	return builder.CreateCall(f, { p });
     }
 
     ErrorType FunctionHalt::Semantics()
@@ -948,19 +1312,27 @@ namespace Builtin
 	    v = args[0]->CodeGen();
 	}
 
-	llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(),
-	                                     { Types::Get<Types::IntegerDecl>()->LlvmType() }, "exit");
+	llvm::FunctionCallee f = GetErrorFunction({ Types::Get<Types::IntegerDecl>()->LlvmType() }, "exit");
 
 	return builder.CreateCall(f, { v });
     }
 
+    // An element of a bit packed array shares its bytes with its neighbours, so can't be updated
+    // in place.
+    static bool IsBitPackedElement(ExprAST* arg)
+    {
+	auto ae = llvm::dyn_cast<ArrayExprAST>(arg);
+	return ae && ae->IsBitPacked();
+    }
+
     ErrorType FunctionInc::Semantics()
     {
 	if (args.size() != 1)
 	{
 	    return ErrorType::WrongArgCount;
 	}
-	if (!IsIntegral(args[0]->Type()) || !llvm::isa<AddressableAST>(args[0]))
+	if (!IsIntegral(args[0]->Type()) || !llvm::isa<AddressableAST>(args[0]) ||
+	    IsBitPackedElement(args[0]))
 	{
 	    return ErrorType::WrongArgType;
 	}
@@ -972,10 +1344,10 @@ namespace Builtin
 	auto var = llvm::dyn_cast<AddressableAST>(args[0]);
 	ICE_IF(!var, "Expected variable here... Semantics not working?");
 	llvm::Value* pA = var->Address();
-	llvm::Type*  ty = var->Type()->LlvmType();
-	llvm::Value* a = builder.CreateLoad(ty, pA, "inc");
+	llvm::Type*  ty = var->Type()->StorageType();
+	llvm::Value* a = FromStorage(var->Type(), builder.CreateLoad(ty, pA, "inc"));
 	a = builder.CreateAdd(a, MakeConstant(1, var->Type()), "inc");
-	return builder.CreateStore(a, pA);
+	return builder.CreateStore(ToStorage(var->Type(), a), pA);
     }
 
     llvm::Value* FunctionDec::CodeGen(llvm::IRBuilder<>& builder)
@@ -983,10 +1355,43 @@ namespace Builtin
 	auto var = llvm::dyn_cast<AddressableAST>(args[0]);
 	ICE_IF(!var, "Expected variable here... Semantics not working?");
 	llvm::Value* pA = var->Address();
-	llvm::Type*  ty = var->Type()->LlvmType();
-	llvm::Value* a = builder.CreateLoad(ty, pA, "dec");
+	llvm::Type*  ty = var->Type()->StorageType();
+	llvm::Value* a = FromStorage(var->Type(), builder.CreateLoad(ty, pA, "dec"));
 	a = builder.CreateSub(a, MakeConstant(1, var->Type()), "dec");
-	return builder.CreateStore(a, pA);
+	return builder.CreateStore(ToStorage(var->Type(), a), pA);
+    }
+
+    // Copy count elements between an unpacked array, starting at index start, and a bit-packed array.
+    static llvm::Value* CopyBitPacked(llvm::IRBuilder<>& builder, Types::ArrayDecl* ty, llvm::Value* unpacked,
+                                      llvm::Value* start, llvm::Value* packed, size_t count, bool pack)
+    {
+	llvm::Type*       intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	Types::TypeDecl*  subTy = ty->SubType();
+	llvm::Type*       elemTy = subTy->StorageType();
+	llvm::Function*   fn = builder.GetInsertBlock()->getParent();
+	llvm::BasicBlock* preBB = builder.GetInsertBlock();
+	llvm::BasicBlock* loopBB = llvm::BasicBlock::Create(theContext, "packloop", fn);
+	llvm::BasicBlock* doneBB = llvm::BasicBlock::Create(theContext, "packdone", fn);
+
+	builder.CreateBr(loopBB);
+	builder.SetInsertPoint(loopBB);
+	llvm::PHINode* i = builder.CreatePHI(intTy, 2, "i");
+	i->addIncoming(MakeIntegerConstant(0), preBB);
+	llvm::Value* elem = builder.CreateGEP(elemTy, unpacked, builder.CreateAdd(start, i), "elem");
+	if (pack)
+	{
+	    StoreBitPacked(ty, packed, i, FromStorage(subTy, builder.CreateLoad(elemTy, elem)));
+	}
+	else
+	{
+	    builder.CreateStore(ToStorage(subTy, LoadBitPacked(ty, packed, i)), elem);
+	}
+	llvm::Value* next = builder.CreateAdd(i, MakeIntegerConstant(1));
+	i->addIncoming(next, builder.GetInsertBlock());
+	llvm::Value* more = builder.CreateICmpULT(next, MakeIntegerConstant(count));
+	llvm::Value* br = builder.CreateCondBr(more, loopBB, doneBB);
+	builder.SetInsertPoint(doneBB);
+	return br;
     }
 
     // Pack(a, start, apacked);
@@ -1002,7 +1407,7 @@ namespace Builtin
 	{
 	    if (IsIntegral(args[1]->Type()) && args[1]->Type()->AssignableType(t0->Ranges()[0]))
 	    {
-		if (t0->SubType() != t2->SubType())
+		if (t0->SubType() != t2->SubType() || t0->IsSoA() || t2->IsSoA())
 		{
 		    return ErrorType::WrongArgType;
 		}
@@ -1037,7 +1442,15 @@ namespace Builtin
 	llvm::Value* pA = var0->Address();
 	llvm::Value* pB = var2->Address();
 
-	llvm::Type*  ptrTy = ty0->SubType()->LlvmType();
+	auto ty2 = llvm::dyn_cast<Types::ArrayDecl>(args[2]->Type());
+	if (ty2->BitsPerElement())
+	{
+	    start = builder.CreateIntCast(start, Types::Get<Types::IntegerDecl>()->LlvmType(),
+	                                  !IsUnsigned(args[1]->Type()));
+	    return CopyBitPacked(builder, ty2, pA, start, pB, ty2->Ranges()[0]->GetRange()->Size(), true);
+	}
+
+	llvm::Type*  ptrTy = ty0->SubType()->StorageType();
 	llvm::Value* src = builder.CreateGEP(ptrTy, pA, start, "dest");
 	llvm::Align  dest_align{ std::max(AlignOfType(pB->getType()), MIN_ALIGN) };
 	llvm::Align  src_align{ std::max(AlignOfType(src->getType()), MIN_ALIGN) };
@@ -1057,7 +1470,7 @@ namespace Builtin
 	{
 	    if (IsIntegral(args[2]->Type()) && args[2]->Type()->AssignableType(t1->Ranges()[0]))
 	    {
-		if (t0->SubType() != t1->SubType())
+		if (t0->SubType() != t1->SubType() || t0->IsSoA() || t1->IsSoA())
 		{
 		    return ErrorType::WrongArgType;
 		}
@@ -1092,9 +1505,17 @@ namespace Builtin
 	llvm::Value* pA = var0->Address();
 	llvm::Value* pB = var1->Address();
 
-	llvm::Type*  ptrTy = ty1->SubType()->LlvmType();
-	llvm::Value* dest = builder.CreateGEP(ptrTy, pB, start, "dest");
-	llvm::Align  dest_align{ std::max(AlignOfType(dest->getType()), MIN_ALIGN) };
+	auto ty0 = llvm::dyn_cast<Types::ArrayDecl>(args[0]->Type());
+	if (ty0->BitsPerElement())
+	{
+	    start = builder.CreateIntCast(start, Types::Get<Types::IntegerDecl>()->LlvmType(),
+	                                  !IsUnsigned(args[2]->Type()));
+	    return CopyBitPacked(builder, ty0, pB, start, pA, ty0->Ranges()[0]->GetRange()->Size(), false);
+	}
+
+	llvm::Type*  ptrTy = ty1->SubType()->StorageType();
+	llvm::Value* dest = builder.CreateGEP(ptrTy, pB, start, "dest");
+	llvm::Align  dest_align{ std::max(AlignOfType(dest->getType()), MIN_ALIGN) };
 	llvm::Align  src_align{ std::max(AlignOfType(pA->getType()), MIN_ALIGN) };
 	return builder.CreateMemCpy(dest, dest_align, pA, src_align, args[0]->Type()->Size());
     }
@@ -1141,12 +1562,21 @@ namespace Builtin
 	{
 	    ICE("Unknown type for 'val'");
 	}
-	llvm::Value*         res = var1->Address();
-	llvm::Type*          ty0 = str->getType();
-	llvm::Type*          ty1 = res->getType();
+	// Single and extended are converted from a real temporary.
+	Types::TypeDecl* realTy = Types::Get<Types::RealDecl>();
+	bool             convert = llvm::isa<Types::RealDecl>(var1->Type()) && !realTy->SameAs(var1->Type());
+	llvm::Value*     res = (convert) ? CreateTempAlloca(realTy) : var1->Address();
+	llvm::Type*      ty0 = str->getType();
+	llvm::Type*      ty1 = res->getType();
 	llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), { ty0, ty1 }, name);
 
-	return builder.CreateCall(f, { str, res });
+	llvm::Value* call = builder.CreateCall(f, { str, res });
+	if (convert)
+	{
+	    llvm::Value* v = builder.CreateLoad(realTy->LlvmType(), res);
+	    builder.CreateStore(builder.CreateFPCast(v, var1->Type()->LlvmType()), var1->Address());
+	}
+	return call;
     }
 
     llvm::Value* FunctionFile::CodeGen(llvm::IRBuilder<>& builder)
@@ -1201,8 +1631,26 @@ namespace Builtin
 	return FunctionFile::Semantics();
     }
 
+    // The count is the second field of the descriptor of both dynamic arrays and maps.
+    static llvm::Value* HeapArrayLength(llvm::IRBuilder<>& builder, ExprAST* arr)
+    {
+	llvm::Value* v = MakeAddressable(arr);
+	llvm::Type*  sizeTy = Types::Get<Types::Int64Decl>()->LlvmType();
+	v = builder.CreateStructGEP(arr->Type()->LlvmType(), v, 1, "lenPtr");
+	v = builder.CreateLoad(sizeTy, v, "len");
+	return builder.CreateTrunc(v, Types::Get<Types::IntegerDecl>()->LlvmType());
+    }
+
     llvm::Value* FunctionLength::CodeGen(llvm::IRBuilder<>& builder)
     {
+	if (auto s = llvm::dyn_cast<StringExprAST>(args[0]))
+	{
+	    return MakeIntegerConstant(s->Str().size());
+	}
+	if (Types::IsManaged(args[0]->Type()))
+	{
+	    return HeapArrayLength(builder, args[0]);
+	}
 	llvm::Value* v = MakeAddressable(args[0]);
 	llvm::Type*  charTy = Types::Get<Types::CharDecl>()->LlvmType();
 	v = builder.CreateGEP(charTy, v, MakeIntegerConstant(0), "str_0");
@@ -1217,7 +1665,83 @@ namespace Builtin
 	{
 	    return ErrorType::WrongArgCount;
 	}
-	if (!llvm::isa<Types::StringDecl>(args[0]->Type()))
+	if (!llvm::isa<StringExprAST>(args[0]) &&
+	    !llvm::isa<Types::StringDecl, Types::HeapArrayDecl, Types::MapDecl>(args[0]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    ExprAST* FunctionLength::Fold()
+    {
+	if (auto s = llvm::dyn_cast<StringExprAST>(args[0]))
+	{
+	    return new IntegerExprAST(s->Loc(), s->Str().size(), Types::Get<Types::IntegerDecl>());
+	}
+	return 0;
+    }
+
+    // Dynamic arrays are indexed from zero, so the highest index is one less than the length.
+    llvm::Value* FunctionHigh::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	return builder.CreateSub(HeapArrayLength(builder, args[0]), MakeIntegerConstant(1), "high");
+    }
+
+    ErrorType FunctionHigh::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!llvm::isa<Types::HeapArrayDecl>(args[0]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionSetLength::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	auto         hty = llvm::cast<Types::HeapArrayDecl>(args[0]->Type());
+	llvm::Value* arr = llvm::cast<AddressableAST>(args[0])->Address();
+	llvm::Value* len = args[1]->CodeGen();
+	len = builder.CreateSExt(len, Types::Get<Types::Int64Decl>()->LlvmType(), "len");
+	return CallHeapArrayFunc("SetLength", hty, { arr, len });
+    }
+
+    ErrorType FunctionSetLength::Semantics()
+    {
+	if (args.size() != 2)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!llvm::isa<Types::HeapArrayDecl>(args[0]->Type()) || !llvm::isa<AddressableAST>(args[0]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	if (!IsIntegral(args[1]->Type()) || llvm::isa<Types::CharDecl, Types::BoolDecl>(args[1]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionMapKey::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	return CallMapKeyFunc(func, args[0], args[1],
+	                      (func == "Insert") ? Types::GetVoidPtrType()
+	                                         : Types::Get<Types::VoidDecl>()->LlvmType());
+    }
+
+    ErrorType FunctionMapKey::Semantics()
+    {
+	if (args.size() != 2)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	auto mty = llvm::dyn_cast<Types::MapDecl>(args[0]->Type());
+	if (!mty || !llvm::isa<AddressableAST>(args[0]) || !RecastMapKey(args[1], mty))
 	{
 	    return ErrorType::WrongArgType;
 	}
@@ -1369,7 +1893,7 @@ namespace Builtin
     {
 	llvm::Value*         message = args[0]->CodeGen();
 	llvm::Type*          ty = message->getType();
-	llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), { ty }, "__Panic");
+	llvm::FunctionCallee f = GetErrorFunction({ ty }, "__Panic");
 
 	return builder.CreateCall(f, { message });
     }
@@ -1393,8 +1917,8 @@ namespace Builtin
 	std::string      name = "llvm.ctpop.i";
 	if (IsIntegral(type))
 	{
-	    name += std::to_string(type->Size() * 8);
 	    llvm::Type*          ty = type->LlvmType();
+	    name += std::to_string(ty->getIntegerBitWidth());
 	    llvm::FunctionCallee f = GetFunction(ty, { ty }, name);
 	    llvm::Value*         a = args[0]->CodeGen();
 	    return builder.CreateCall(f, a, "popcnt");
@@ -1457,7 +1981,7 @@ namespace Builtin
 	{
 	    return ErrorType::WrongArgCount;
 	}
-	if (!CastIntegerToReal(args[0]) || !CastIntegerToReal(args[1]))
+	if (!CastToReal(args[0]) || !CastToReal(args[1]))
 	{
 	    return ErrorType::WrongArgType;
 	}
@@ -1507,14 +2031,13 @@ namespace Builtin
 
     llvm::Value* FunctionMax::CodeGen(llvm::IRBuilder<>& builder)
     {
-	if (llvm::isa<Types::RealDecl>(args[0]->Type()) || llvm::isa<Types::RealDecl>(args[1]->Type()))
+	llvm::Value* a = args[0]->CodeGen();
+	llvm::Value* b = args[1]->CodeGen();
+	if (llvm::isa<Types::RealDecl>(args[0]->Type()))
 	{
-	    FunctionFloat2Arg max("llvm.maxnum.f64", args);
-	    return max.CodeGen(builder);
+	    return builder.CreateMaxNum(a, b, "max");
 	}
 
-	llvm::Value* a = args[0]->CodeGen();
-	llvm::Value* b = args[1]->CodeGen();
 	llvm::Value* sel;
 	if (IsUnsigned(args[0]->Type()) || IsUnsigned(args[1]->Type()))
 	{
@@ -1529,13 +2052,12 @@ namespace Builtin
 
     llvm::Value* FunctionMin::CodeGen(llvm::IRBuilder<>& builder)
     {
-	if (llvm::isa<Types::RealDecl>(args[0]->Type()) || llvm::isa<Types::RealDecl>(args[1]->Type()))
-	{
-	    FunctionFloat2Arg min("llvm.minnum.f64", args);
-	    return min.CodeGen(builder);
-	}
 	llvm::Value* a = args[0]->CodeGen();
 	llvm::Value* b = args[1]->CodeGen();
+	if (llvm::isa<Types::RealDecl>(args[0]->Type()))
+	{
+	    return builder.CreateMinNum(a, b, "min");
+	}
 	llvm::Value* sel;
 	if (IsUnsigned(args[0]->Type()) || IsUnsigned(args[1]->Type()))
 	{
@@ -1569,7 +2091,7 @@ namespace Builtin
 	llvm::Value* mone = MakeIntegerConstant(-1);
 	if (llvm::isa<Types::RealDecl>(args[0]->Type()))
 	{
-	    llvm::Value* fzero = llvm::ConstantFP::get(theContext, llvm::APFloat(0.0));
+	    llvm::Value* fzero = llvm::ConstantFP::get(v->getType(), 0.0);
 	    llvm::Value* sel1 = builder.CreateFCmpOGT(v, fzero, "gt");
 	    llvm::Value* sel2 = builder.CreateFCmpOLT(v, fzero, "lt");
 	    llvm::Value* res = builder.CreateSelect(sel1, one, zero, "sgn1");
@@ -1756,7 +2278,7 @@ namespace Builtin
 	{
 	    return ErrorType::WrongArgCount;
 	}
-	if (!CastIntegerToReal(args[0]) || !CastIntegerToReal(args[1]))
+	if (!CastToReal(args[0]) || !CastToReal(args[1]))
 	{
 	    return ErrorType::WrongArgType;
 	}
@@ -1840,6 +2362,1294 @@ namespace Builtin
 	return builder.CreateCall(f, { c });
     }
 
+    // Cast integral arguments to LongInt, as used by the thread and channel runtime functions.
+    static bool CastToInt64(ExprAST*& arg)
+    {
+	if (!IsIntegral(arg->Type()))
+	{
+	    return false;
+	}
+	arg = Recast(arg, Types::Get<Types::Int64Decl>());
+	return true;
+    }
+
+    // Atomic operations need at least a byte, so booleans are not allowed.
+    static bool IsAtomicVariable(ExprAST* arg)
+    {
+	return IsIntegral(arg->Type()) && !llvm::isa<Types::BoolDecl>(arg->Type()) &&
+	       llvm::isa<AddressableAST>(arg) && !IsBitPackedElement(arg);
+    }
+
+    // spawn(proc) or spawn(proc, n), where proc is a procedure with no arguments, or with one
+    // integer value argument.
+    ErrorType FunctionSpawn::Semantics()
+    {
+	if (args.size() < 1 || args.size() > 2)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	auto fnArg = llvm::dyn_cast<FunctionExprAST>(args[0]);
+	if (!fnArg || !llvm::isa<Types::VoidDecl>(fnArg->Proto()->Type()) || fnArg->Proto()->HasSelf())
+	{
+	    return ErrorType::WrongArgType;
+	}
+	const PrototypeAST*        proto = fnArg->Proto();
+	const std::vector<VarDef>& protoArgs = proto->Args();
+	size_t                     closureArgs = (proto->Function()->ClosureType()) ? 1 : 0;
+	if (protoArgs.size() - closureArgs != args.size() - 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (args.size() == 2)
+	{
+	    const VarDef& a = protoArgs.back();
+	    if (a.IsRef() || !IsIntegral(a.Type()) || !IsIntegral(args[1]->Type()))
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	    args[1] = Recast(args[1], a.Type());
+	}
+	return ErrorType::Ok;
+    }
+
+    // Make "<proc>.spawn(ctx, arg)" that calls the procedure from the runtime.
+    llvm::Function* FunctionSpawn::Thunk(llvm::IRBuilder<>& builder, llvm::Function* fn, bool hasClosure)
+    {
+	std::string name = (fn->getName() + ".spawn").str();
+	if (llvm::Function* thunk = theModule->getFunction(name))
+	{
+	    return thunk;
+	}
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	builder.SetCurrentDebugLocation(llvm::DebugLoc());
+
+	llvm::Type*         voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+	llvm::Type*         ptrTy = Types::GetVoidPtrType();
+	llvm::Type*         int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	llvm::FunctionType* ft = llvm::FunctionType::get(voidTy, { ptrTy, int64Ty }, false);
+	llvm::Function* thunk = llvm::Function::Create(ft, llvm::Function::InternalLinkage, name, theModule);
+	builder.SetInsertPoint(llvm::BasicBlock::Create(theContext, "entry", thunk));
+
+	std::vector<llvm::Value*> callArgs;
+	auto                      ai = thunk->arg_begin();
+	if (hasClosure)
+	{
+	    callArgs.push_back(&*ai);
+	}
+	ai++;
+	if (callArgs.size() < fn->arg_size())
+	{
+	    llvm::Type* argTy = fn->getFunctionType()->getParamType(callArgs.size());
+	    callArgs.push_back(builder.CreateTrunc(&*ai, argTy, "arg"));
+	}
+	builder.CreateCall(fn, callArgs);
+	builder.CreateRetVoid();
+	return thunk;
+    }
+
+    llvm::Value* FunctionSpawn::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	auto            fnArg = llvm::dyn_cast<FunctionExprAST>(args[0]);
+	FunctionAST*    fn = fnArg->Proto()->Function();
+	llvm::Function* llvmFn = llvm::dyn_cast<llvm::Function>(fnArg->CodeGen());
+	ICE_IF(!llvmFn, "Expected a function for spawn");
+
+	llvm::Type*  ptrTy = Types::GetVoidPtrType();
+	llvm::Type*  int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	llvm::Value* ctx = llvm::Constant::getNullValue(ptrTy);
+	// The closure lives in the caller's frame, so the thread must be joined before it returns.
+	if (Types::TypeDecl* closureTy = fn->ClosureType())
+	{
+	    std::vector<VariableExprAST*> vf;
+	    for (auto u : fn->UsedVars())
+	    {
+		vf.push_back(new VariableExprAST(fn->Loc(), u.Name(), u.Type()));
+	    }
+	    ctx = (new ClosureAST(fn->Loc(), closureTy, vf))->CodeGen();
+	}
+	llvm::Value* arg = llvm::ConstantInt::get(int64Ty, 0);
+	if (args.size() == 2)
+	{
+	    arg = builder.CreateIntCast(args[1]->CodeGen(), int64Ty, !IsUnsigned(args[1]->Type()), "arg");
+	}
+
+	llvm::Function*      thunk = Thunk(builder, llvmFn, fn->ClosureType());
+	llvm::FunctionCallee f = GetFunction(Type()->LlvmType(), { thunk->getType(), ptrTy, int64Ty },
+	                                     "__Spawn");
+	return builder.CreateCall(f, { thunk, ctx, arg }, "thread");
+    }
+
+    ErrorType FunctionJoin::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!CastToInt64(args[0]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionJoin::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value*         t = args[0]->CodeGen();
+	llvm::FunctionCallee f = GetFunction(Type()->LlvmType(), { t->getType() }, "__Join");
+	return builder.CreateCall(f, { t });
+    }
+
+    ErrorType FunctionAtomicInc::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!IsAtomicVariable(args[0]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionAtomicInc::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	auto var = llvm::dyn_cast<AddressableAST>(args[0]);
+	ICE_IF(!var, "Expected variable here... Semantics not working?");
+	// Subranges may be stored narrower than their value type, so operate on the storage width.
+	llvm::Value* one = ToStorage(var->Type(), MakeConstant(1, var->Type()));
+	return builder.CreateAtomicRMW(op, var->Address(), one, llvm::MaybeAlign(),
+	                               llvm::AtomicOrdering::SequentiallyConsistent);
+    }
+
+    // atomiccas(v, expected, newvalue): Set v to newvalue if it is expected, return true if it was.
+    ErrorType FunctionAtomicCas::Semantics()
+    {
+	if (args.size() != 3)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!IsAtomicVariable(args[0]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	for (size_t i = 1; i < 3; i++)
+	{
+	    if (!args[0]->Type()->CompatibleType(args[i]->Type()))
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	    args[i] = Recast(args[i], args[0]->Type());
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionAtomicCas::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	auto var = llvm::dyn_cast<AddressableAST>(args[0]);
+	ICE_IF(!var, "Expected variable here... Semantics not working?");
+	llvm::Value* expected = ToStorage(var->Type(), args[1]->CodeGen());
+	llvm::Value* newValue = ToStorage(var->Type(), args[2]->CodeGen());
+	llvm::Value* res = builder.CreateAtomicCmpXchg(var->Address(), expected, newValue, llvm::MaybeAlign(),
+	                                               llvm::AtomicOrdering::SequentiallyConsistent,
+	                                               llvm::AtomicOrdering::SequentiallyConsistent);
+	return builder.CreateExtractValue(res, 1, "cas");
+    }
+
+    ErrorType FunctionMakeChannel::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!CastToInt64(args[0]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionMakeChannel::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value*         n = args[0]->CodeGen();
+	llvm::FunctionCallee f = GetFunction(Type()->LlvmType(), { n->getType() }, "__ChanCreate");
+	return builder.CreateCall(f, { n }, "chan");
+    }
+
+    // send(chan, value) and closechannel(chan)
+    ErrorType FunctionSend::Semantics()
+    {
+	size_t count = (name == "send") ? 2 : 1;
+	if (args.size() != count)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	for (auto& a : args)
+	{
+	    if (!CastToInt64(a))
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionSend::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	std::vector<llvm::Value*> argValues;
+	std::vector<llvm::Type*>  argTypes;
+	for (auto a : args)
+	{
+	    argValues.push_back(a->CodeGen());
+	    argTypes.push_back(argValues.back()->getType());
+	}
+	std::string          fname = (name == "send") ? "__ChanSend" : "__ChanClose";
+	llvm::FunctionCallee f = GetFunction(Type()->LlvmType(), argTypes, fname);
+	return builder.CreateCall(f, argValues);
+    }
+
+    // receive(chan, v): Wait for a value, return false if the channel is closed and empty.
+    // Channels carry 64-bit values, so v must be a longint.
+    ErrorType FunctionReceive::Semantics()
+    {
+	if (args.size() != 2)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!CastToInt64(args[0]) || !llvm::isa<Types::Int64Decl>(args[1]->Type()) ||
+	    !llvm::isa<AddressableAST>(args[1]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionReceive::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	auto var = llvm::dyn_cast<AddressableAST>(args[1]);
+	ICE_IF(!var, "Expected variable here... Semantics not working?");
+	llvm::Value*         c = args[0]->CodeGen();
+	llvm::Type*          int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	llvm::Value*         v = var->Address();
+	llvm::FunctionCallee f = GetFunction(Type()->LlvmType(), { int64Ty, v->getType() }, "__ChanReceive");
+	return builder.CreateCall(f, { c, v }, "recv");
+    }
+
+    // shuffle(a, i0, i1, ...) or shuffle(a, b, i0, i1, ...), where the lanes of b are numbered
+    // after those of a. The indices must be constants, and give the size of the result.
+    FunctionShuffle::FunctionShuffle(const std::string& fn, ArgList& a) : FunctionBase(fn, a), resType(0)
+    {
+	auto vty = llvm::dyn_cast_or_null<Types::VectorDecl>(args.empty() ? 0 : args[0]->Type());
+	if (vty && args.size() > FirstIndex())
+	{
+	    resType = new Types::VectorDecl(vty->SubType(), args.size() - FirstIndex());
+	}
+    }
+
+    size_t FunctionShuffle::FirstIndex() const
+    {
+	return (args.size() > 1 && llvm::isa<Types::VectorDecl>(args[1]->Type())) ? 2 : 1;
+    }
+
+    ErrorType FunctionShuffle::Semantics()
+    {
+	if (args.size() < 3)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	auto vty = llvm::dyn_cast<Types::VectorDecl>(args[0]->Type());
+	if (!vty || !resType)
+	{
+	    return ErrorType::WrongArgType;
+	}
+	size_t lanes = vty->Count();
+	if (FirstIndex() == 2)
+	{
+	    if (*args[1]->Type() != *vty)
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	    lanes *= 2;
+	}
+	if (args.size() - FirstIndex() < 2)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	for (size_t i = FirstIndex(); i < args.size(); i++)
+	{
+	    auto index = llvm::dyn_cast<IntegerExprAST>(args[i]);
+	    if (!index || index->Int() >= lanes)
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionShuffle::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	std::vector<int> mask;
+	for (size_t i = FirstIndex(); i < args.size(); i++)
+	{
+	    mask.push_back(llvm::cast<IntegerExprAST>(args[i])->Int());
+	}
+	llvm::Value* a = args[0]->CodeGen();
+	if (FirstIndex() == 2)
+	{
+	    return builder.CreateShuffleVector(a, args[1]->CodeGen(), mask, "shuffle");
+	}
+	return builder.CreateShuffleVector(a, mask, "shuffle");
+    }
+
+    ErrorType FunctionVectorReduce::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	auto vty = llvm::dyn_cast<Types::VectorDecl>(args[0]->Type());
+	if (!vty)
+	{
+	    return ErrorType::WrongArgType;
+	}
+	// any and all take a mask, the others a numeric vector.
+	bool isMask = llvm::isa<Types::BoolDecl>(vty->SubType());
+	if (isMask != (id == llvm::Intrinsic::vector_reduce_or || id == llvm::Intrinsic::vector_reduce_and))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    Types::TypeDecl* FunctionVectorReduce::Type() const
+    {
+	if (auto vty = llvm::dyn_cast<Types::VectorDecl>(args[0]->Type()))
+	{
+	    return vty->SubType();
+	}
+	return args[0]->Type();
+    }
+
+    llvm::Value* FunctionVectorReduce::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value* v = args[0]->CodeGen();
+	if (llvm::isa<Types::RealDecl>(Type()))
+	{
+	    llvm::Type*     realTy = Type()->LlvmType();
+	    llvm::CallInst* res;
+	    switch (id)
+	    {
+	    case llvm::Intrinsic::vector_reduce_add:
+		res = builder.CreateFAddReduce(llvm::ConstantFP::get(realTy, -0.0), v);
+		break;
+	    case llvm::Intrinsic::vector_reduce_mul:
+		res = builder.CreateFMulReduce(llvm::ConstantFP::get(realTy, 1.0), v);
+		break;
+	    case llvm::Intrinsic::vector_reduce_smin:
+		return builder.CreateFPMinReduce(v);
+	    case llvm::Intrinsic::vector_reduce_smax:
+		return builder.CreateFPMaxReduce(v);
+	    default:
+		ICE("Unknown reduction");
+	    }
+	    // Without reassoc the lanes are added in order, which can't be done in parallel.
+	    res->setHasAllowReassoc(true);
+	    return res;
+	}
+
+	switch (id)
+	{
+	case llvm::Intrinsic::vector_reduce_add:
+	    return builder.CreateAddReduce(v);
+	case llvm::Intrinsic::vector_reduce_mul:
+	    return builder.CreateMulReduce(v);
+	case llvm::Intrinsic::vector_reduce_smin:
+	    return builder.CreateIntMinReduce(v, !IsUnsigned(Type()));
+	case llvm::Intrinsic::vector_reduce_smax:
+	    return builder.CreateIntMaxReduce(v, !IsUnsigned(Type()));
+	case llvm::Intrinsic::vector_reduce_or:
+	    return builder.CreateOrReduce(v);
+	case llvm::Intrinsic::vector_reduce_and:
+	    return builder.CreateAndReduce(v);
+	default:
+	    break;
+	}
+	ICE("Unknown reduction");
+    }
+
+    // select(mask, a, b) picks the lanes of a where the mask is true, and those of b elsewhere.
+    ErrorType FunctionSelect::Semantics()
+    {
+	if (args.size() != 3)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	auto mty = llvm::dyn_cast<Types::VectorDecl>(args[0]->Type());
+	auto vty = llvm::dyn_cast<Types::VectorDecl>(args[1]->Type());
+	if (!mty || !vty || !llvm::isa<Types::BoolDecl>(mty->SubType()) || mty->Count() != vty->Count())
+	{
+	    return ErrorType::WrongArgType;
+	}
+	if (!vty->CompatibleType(args[2]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	args[2] = Recast(args[2], vty);
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionSelect::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value* mask = args[0]->CodeGen();
+	llvm::Value* a = args[1]->CodeGen();
+	llvm::Value* b = args[2]->CodeGen();
+	return builder.CreateSelect(mask, a, b, "select");
+    }
+
+    // likely(cond) and unlikely(cond) return cond, telling the optimiser which way it usually goes.
+    ErrorType FunctionExpect::Semantics()
+    {
+	if (args.size() != 1)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!llvm::isa<Types::BoolDecl>(args[0]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionExpect::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value* v = args[0]->CodeGen();
+	llvm::Value* e = llvm::ConstantInt::get(v->getType(), expected);
+	return builder.CreateIntrinsic(llvm::Intrinsic::expect, { v->getType() }, { v, e }, 0, "expect");
+    }
+
+    // Generates the functions that sort elements of one type with one comparison. The comparison
+    // is emitted inline, or as a direct call to the Pascal function, so that it can be inlined.
+    class SortGenerator
+    {
+    public:
+	SortGenerator(llvm::IRBuilder<>& b, Types::TypeDecl* ty, const PrototypeAST* p, llvm::Function* fn);
+	// sort(ctx, base, n): introsort, with insertion sort for the last few elements.
+	llvm::Function* Sort();
+	// merge(ctx, a, na, b, nb, out): stable merge of two sorted runs.
+	llvm::Function* Merge();
+
+    private:
+	llvm::Function* Create(const std::string& suffix, const std::vector<llvm::Type*>& argTys);
+	llvm::Value*    Less(llvm::Value* ctx, llvm::Value* a, llvm::Value* b);
+	llvm::Value*    Elem(llvm::Value* base, llvm::Value* index);
+	void            Copy(llvm::Value* dest, llvm::Value* src);
+	void            Swap(llvm::Value* a, llvm::Value* b);
+	llvm::Value*    Load(llvm::Value* var) { return builder.CreateLoad(int64Ty, var); }
+	llvm::BasicBlock* Block(const std::string& name);
+	llvm::Function* Insertion();
+	llvm::Function* SiftDown();
+	llvm::Function* HeapSort();
+	llvm::Function* IntroSort();
+	void            MedianToFirst(llvm::Value* ctx, llvm::Value* base, llvm::Value* n);
+
+	llvm::IRBuilder<>&  builder;
+	Types::TypeDecl*    elemTy;
+	const PrototypeAST* proto;
+	llvm::Function*     lessFn;
+	llvm::Type*         storeTy;
+	llvm::Type*         int64Ty;
+	llvm::Type*         ptrTy;
+	std::string         prefix;
+	llvm::Function*     fn;
+    };
+
+    SortGenerator::SortGenerator(llvm::IRBuilder<>& b, Types::TypeDecl* ty, const PrototypeAST* p,
+                                 llvm::Function* f)
+        : builder(b), elemTy(ty), proto(p), lessFn(f), storeTy(ty->StorageType()),
+          int64Ty(Types::Get<Types::Int64Decl>()->LlvmType()), ptrTy(Types::GetVoidPtrType()), fn(0)
+    {
+	if (lessFn)
+	{
+	    prefix = lessFn->getName().str() + ".sort";
+	}
+	else
+	{
+	    std::string              name;
+	    llvm::raw_string_ostream os(name);
+	    storeTy->print(os);
+	    prefix = "sort." + os.str();
+	}
+    }
+
+    // Returns null if the function already exists, otherwise leaves the builder in its entry block.
+    llvm::Function* SortGenerator::Create(const std::string& suffix, const std::vector<llvm::Type*>& argTys)
+    {
+	if (theModule->getFunction(prefix + suffix))
+	{
+	    return 0;
+	}
+	llvm::Type*         voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+	llvm::FunctionType* ft = llvm::FunctionType::get(voidTy, argTys, false);
+	fn = llvm::Function::Create(ft, llvm::Function::InternalLinkage, prefix + suffix, theModule);
+	builder.SetInsertPoint(llvm::BasicBlock::Create(theContext, "entry", fn));
+	builder.SetCurrentDebugLocation(llvm::DebugLoc());
+	return fn;
+    }
+
+    llvm::BasicBlock* SortGenerator::Block(const std::string& name)
+    {
+	return llvm::BasicBlock::Create(theContext, name, fn);
+    }
+
+    llvm::Value* SortGenerator::Elem(llvm::Value* base, llvm::Value* index)
+    {
+	return builder.CreateGEP(storeTy, base, index);
+    }
+
+    void SortGenerator::Copy(llvm::Value* dest, llvm::Value* src)
+    {
+	builder.CreateStore(builder.CreateLoad(storeTy, src), dest);
+    }
+
+    void SortGenerator::Swap(llvm::Value* a, llvm::Value* b)
+    {
+	llvm::Value* x = builder.CreateLoad(storeTy, a);
+	llvm::Value* y = builder.CreateLoad(storeTy, b);
+	builder.CreateStore(y, a);
+	builder.CreateStore(x, b);
+    }
+
+    // a and b point to the elements to compare.
+    llvm::Value* SortGenerator::Less(llvm::Value* ctx, llvm::Value* a, llvm::Value* b)
+    {
+	if (!lessFn)
+	{
+	    if (llvm::isa<Types::StringDecl>(elemTy))
+	    {
+		llvm::Type*          intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+		llvm::FunctionCallee f = GetFunction(intTy, { ptrTy, ptrTy }, "__StrCompare");
+		return builder.CreateICmpSLT(builder.CreateCall(f, { a, b }), MakeIntegerConstant(0));
+	    }
+	    return builder.CreateFCmpOLT(builder.CreateLoad(storeTy, a), builder.CreateLoad(storeTy, b));
+	}
+
+	std::vector<llvm::Value*>  callArgs;
+	const std::vector<VarDef>& protoArgs = proto->Args();
+	if (protoArgs.size() == 3)
+	{
+	    callArgs.push_back(ctx);
+	}
+	for (auto v : { a, b })
+	{
+	    const VarDef& arg = protoArgs[callArgs.size()];
+	    if (arg.IsRef() || IsCompound(arg.Type()))
+	    {
+		callArgs.push_back(v);
+	    }
+	    else
+	    {
+		callArgs.push_back(FromStorage(elemTy, builder.CreateLoad(storeTy, v)));
+	    }
+	}
+	llvm::CallInst* call = builder.CreateCall(lessFn, callArgs);
+	call->setAttributes(lessFn->getAttributes());
+	return call;
+    }
+
+    llvm::Function* SortGenerator::Insertion()
+    {
+	std::string name = prefix + ".insertion";
+	if (llvm::Function* f = theModule->getFunction(name))
+	{
+	    return f;
+	}
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Function*                       f = Create(".insertion", { ptrTy, ptrTy, int64Ty });
+	auto                                  ai = f->arg_begin();
+	llvm::Value*                          ctx = &*ai++;
+	llvm::Value*                          base = &*ai++;
+	llvm::Value*                          n = &*ai;
+	llvm::Value*                          tmp = builder.CreateAlloca(storeTy, 0, "tmp");
+	llvm::Value*                          iVar = builder.CreateAlloca(int64Ty, 0, "i");
+	llvm::Value*                          jVar = builder.CreateAlloca(int64Ty, 0, "j");
+	llvm::Constant*                       one = llvm::ConstantInt::get(int64Ty, 1);
+	llvm::BasicBlock*                     outer = Block("outer");
+	llvm::BasicBlock*                     body = Block("body");
+	llvm::BasicBlock*                     inner = Block("inner");
+	llvm::BasicBlock*                     compare = Block("compare");
+	llvm::BasicBlock*                     shift = Block("shift");
+	llvm::BasicBlock*                     place = Block("place");
+	llvm::BasicBlock*                     done = Block("done");
+
+	builder.CreateStore(one, iVar);
+	builder.CreateBr(outer);
+
+	builder.SetInsertPoint(outer);
+	builder.CreateCondBr(builder.CreateICmpSLT(Load(iVar), n), body, done);
+
+	builder.SetInsertPoint(body);
+	llvm::Value* i = Load(iVar);
+	Copy(tmp, Elem(base, i));
+	builder.CreateStore(i, jVar);
+	builder.CreateBr(inner);
+
+	builder.SetInsertPoint(inner);
+	builder.CreateCondBr(builder.CreateICmpSGT(Load(jVar), llvm::ConstantInt::get(int64Ty, 0)), compare,
+	                     place);
+
+	builder.SetInsertPoint(compare);
+	llvm::Value* j = Load(jVar);
+	llvm::Value* prev = Elem(base, builder.CreateSub(j, one));
+	builder.CreateCondBr(Less(ctx, tmp, prev), shift, place);
+
+	builder.SetInsertPoint(shift);
+	Copy(Elem(base, j), prev);
+	builder.CreateStore(builder.CreateSub(j, one), jVar);
+	builder.CreateBr(inner);
+
+	builder.SetInsertPoint(place);
+	Copy(Elem(base, Load(jVar)), tmp);
+	builder.CreateStore(builder.CreateAdd(Load(iVar), one), iVar);
+	builder.CreateBr(outer);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRetVoid();
+	return f;
+    }
+
+    // siftdown(ctx, base, root, n): move base[root] down the heap of n elements.
+    llvm::Function* SortGenerator::SiftDown()
+    {
+	std::string name = prefix + ".siftdown";
+	if (llvm::Function* f = theModule->getFunction(name))
+	{
+	    return f;
+	}
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Function*                       f = Create(".siftdown", { ptrTy, ptrTy, int64Ty, int64Ty });
+	auto                                  ai = f->arg_begin();
+	llvm::Value*                          ctx = &*ai++;
+	llvm::Value*                          base = &*ai++;
+	llvm::Value*                          root = &*ai++;
+	llvm::Value*                          n = &*ai;
+	llvm::Value*                          rootVar = builder.CreateAlloca(int64Ty, 0, "root");
+	llvm::Value*                          childVar = builder.CreateAlloca(int64Ty, 0, "child");
+	llvm::Constant*                       one = llvm::ConstantInt::get(int64Ty, 1);
+	llvm::BasicBlock*                     loop = Block("loop");
+	llvm::BasicBlock*                     body = Block("body");
+	llvm::BasicBlock*                     right = Block("right");
+	llvm::BasicBlock*                     takeRight = Block("takeright");
+	llvm::BasicBlock*                     pick = Block("pick");
+	llvm::BasicBlock*                     swap = Block("swap");
+	llvm::BasicBlock*                     done = Block("done");
+
+	builder.CreateStore(root, rootVar);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(loop);
+	llvm::Value* r = Load(rootVar);
+	llvm::Value* child = builder.CreateAdd(builder.CreateShl(r, one), one);
+	builder.CreateStore(child, childVar);
+	builder.CreateCondBr(builder.CreateICmpSLT(child, n), body, done);
+
+	builder.SetInsertPoint(body);
+	llvm::Value* next = builder.CreateAdd(child, one);
+	builder.CreateCondBr(builder.CreateICmpSLT(next, n), right, pick);
+
+	builder.SetInsertPoint(right);
+	builder.CreateCondBr(Less(ctx, Elem(base, child), Elem(base, next)), takeRight, pick);
+
+	builder.SetInsertPoint(takeRight);
+	builder.CreateStore(next, childVar);
+	builder.CreateBr(pick);
+
+	builder.SetInsertPoint(pick);
+	llvm::Value* c = Load(childVar);
+	builder.CreateCondBr(Less(ctx, Elem(base, r), Elem(base, c)), swap, done);
+
+	builder.SetInsertPoint(swap);
+	Swap(Elem(base, r), Elem(base, c));
+	builder.CreateStore(c, rootVar);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRetVoid();
+	return f;
+    }
+
+    // Used when quicksort partitions badly, to keep the worst case at n log n.
+    llvm::Function* SortGenerator::HeapSort()
+    {
+	std::string name = prefix + ".heapsort";
+	if (llvm::Function* f = theModule->getFunction(name))
+	{
+	    return f;
+	}
+	llvm::Function*                       siftDown = SiftDown();
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Function*                       f = Create(".heapsort", { ptrTy, ptrTy, int64Ty });
+	auto                                  ai = f->arg_begin();
+	llvm::Value*                          ctx = &*ai++;
+	llvm::Value*                          base = &*ai++;
+	llvm::Value*                          n = &*ai;
+	llvm::Value*                          iVar = builder.CreateAlloca(int64Ty, 0, "i");
+	llvm::Constant*                       zero = llvm::ConstantInt::get(int64Ty, 0);
+	llvm::Constant*                       one = llvm::ConstantInt::get(int64Ty, 1);
+	llvm::BasicBlock*                     build = Block("build");
+	llvm::BasicBlock*                     buildBody = Block("buildbody");
+	llvm::BasicBlock*                     extractStart = Block("extractstart");
+	llvm::BasicBlock*                     extract = Block("extract");
+	llvm::BasicBlock*                     extractBody = Block("extractbody");
+	llvm::BasicBlock*                     done = Block("done");
+
+	builder.CreateStore(builder.CreateAShr(n, one), iVar);
+	builder.CreateBr(build);
+
+	builder.SetInsertPoint(build);
+	builder.CreateCondBr(builder.CreateICmpSGT(Load(iVar), zero), buildBody, extractStart);
+
+	builder.SetInsertPoint(buildBody);
+	llvm::Value* i = builder.CreateSub(Load(iVar), one);
+	builder.CreateStore(i, iVar);
+	builder.CreateCall(siftDown, { ctx, base, i, n });
+	builder.CreateBr(build);
+
+	builder.SetInsertPoint(extractStart);
+	builder.CreateStore(n, iVar);
+	builder.CreateBr(extract);
+
+	builder.SetInsertPoint(extract);
+	builder.CreateCondBr(builder.CreateICmpSGT(Load(iVar), one), extractBody, done);
+
+	builder.SetInsertPoint(extractBody);
+	llvm::Value* last = builder.CreateSub(Load(iVar), one);
+	builder.CreateStore(last, iVar);
+	Swap(Elem(base, zero), Elem(base, last));
+	builder.CreateCall(siftDown, { ctx, base, zero, last });
+	builder.CreateBr(extract);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRetVoid();
+	return f;
+    }
+
+    // Move the median of base[1], base[n/2] and base[n-1] to base[0], to use as the pivot.
+    void SortGenerator::MedianToFirst(llvm::Value* ctx, llvm::Value* base, llvm::Value* n)
+    {
+	llvm::Constant*   one = llvm::ConstantInt::get(int64Ty, 1);
+	llvm::Value*      first = Elem(base, llvm::ConstantInt::get(int64Ty, 0));
+	llvm::Value*      a = Elem(base, one);
+	llvm::Value*      b = Elem(base, builder.CreateAShr(n, one));
+	llvm::Value*      c = Elem(base, builder.CreateSub(n, one));
+	llvm::BasicBlock* aLessB = Block("alessb");
+	llvm::BasicBlock* aLessBNotC = Block("alessbnotc");
+	llvm::BasicBlock* bLessA = Block("blessa");
+	llvm::BasicBlock* bLessANotC = Block("blessanotc");
+	llvm::BasicBlock* swapA = Block("swapa");
+	llvm::BasicBlock* swapB = Block("swapb");
+	llvm::BasicBlock* swapC = Block("swapc");
+	llvm::BasicBlock* join = Block("join");
+
+	builder.CreateCondBr(Less(ctx, a, b), aLessB, bLessA);
+
+	builder.SetInsertPoint(aLessB);
+	builder.CreateCondBr(Less(ctx, b, c), swapB, aLessBNotC);
+
+	builder.SetInsertPoint(aLessBNotC);
+	builder.CreateCondBr(Less(ctx, a, c), swapC, swapA);
+
+	builder.SetInsertPoint(bLessA);
+	builder.CreateCondBr(Less(ctx, a, c), swapA, bLessANotC);
+
+	builder.SetInsertPoint(bLessANotC);
+	builder.CreateCondBr(Less(ctx, b, c), swapC, swapB);
+
+	for (auto [block, v] : { std::pair{ swapA, a }, std::pair{ swapB, b }, std::pair{ swapC, c } })
+	{
+	    builder.SetInsertPoint(block);
+	    Swap(first, v);
+	    builder.CreateBr(join);
+	}
+	builder.SetInsertPoint(join);
+    }
+
+    // introsort(ctx, base, n, depth): quicksort down to runs of SmallSort elements, which are
+    // left for the final insertion sort. After depth bad partitions, it switches to heapsort.
+    llvm::Function* SortGenerator::IntroSort()
+    {
+	const int   SmallSort = 16;
+	std::string name = prefix + ".introsort";
+	if (llvm::Function* f = theModule->getFunction(name))
+	{
+	    return f;
+	}
+	llvm::Function*                       heapSort = HeapSort();
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Function* f = Create(".introsort", { ptrTy, ptrTy, int64Ty, int64Ty });
+	auto            ai = f->arg_begin();
+	llvm::Value*    ctx = &*ai++;
+	llvm::Value*    base = &*ai++;
+	llvm::Value*    n = &*ai++;
+	llvm::Value*    depth = &*ai;
+	llvm::Value*    nVar = builder.CreateAlloca(int64Ty, 0, "n");
+	llvm::Value*    depthVar = builder.CreateAlloca(int64Ty, 0, "depth");
+	llvm::Value*    loVar = builder.CreateAlloca(int64Ty, 0, "lo");
+	llvm::Value*    hiVar = builder.CreateAlloca(int64Ty, 0, "hi");
+	llvm::Constant* zero = llvm::ConstantInt::get(int64Ty, 0);
+	llvm::Constant* one = llvm::ConstantInt::get(int64Ty, 1);
+	llvm::Value*    pivot = Elem(base, zero);
+	llvm::BasicBlock* loop = Block("loop");
+	llvm::BasicBlock* body = Block("body");
+	llvm::BasicBlock* heap = Block("heap");
+	llvm::BasicBlock* partition = Block("partition");
+	llvm::BasicBlock* scanLo = Block("scanlo");
+	llvm::BasicBlock* compareLo = Block("comparelo");
+	llvm::BasicBlock* incLo = Block("inclo");
+	llvm::BasicBlock* startHi = Block("starthi");
+	llvm::BasicBlock* scanHi = Block("scanhi");
+	llvm::BasicBlock* compareHi = Block("comparehi");
+	llvm::BasicBlock* decHi = Block("dechi");
+	llvm::BasicBlock* check = Block("check");
+	llvm::BasicBlock* swap = Block("swap");
+	llvm::BasicBlock* cut = Block("cut");
+	llvm::BasicBlock* done = Block("done");
+
+	builder.CreateStore(n, nVar);
+	builder.CreateStore(depth, depthVar);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(loop);
+	builder.CreateCondBr(builder.CreateICmpSGT(Load(nVar), llvm::ConstantInt::get(int64Ty, SmallSort)),
+	                     body, done);
+
+	builder.SetInsertPoint(body);
+	builder.CreateCondBr(builder.CreateICmpEQ(Load(depthVar), zero), heap, partition);
+
+	builder.SetInsertPoint(heap);
+	builder.CreateCall(heapSort, { ctx, base, Load(nVar) });
+	builder.CreateBr(done);
+
+	builder.SetInsertPoint(partition);
+	builder.CreateStore(builder.CreateSub(Load(depthVar), one), depthVar);
+	llvm::Value* count = Load(nVar);
+	MedianToFirst(ctx, base, count);
+	builder.CreateStore(one, loVar);
+	builder.CreateStore(count, hiVar);
+	builder.CreateBr(scanLo);
+
+	// With the median as pivot, the scans stop at the ends by themselves. The bounds checks
+	// are there for comparison functions that aren't a strict order.
+	builder.SetInsertPoint(scanLo);
+	llvm::Value* lo = Load(loVar);
+	builder.CreateCondBr(builder.CreateICmpSLT(lo, Load(nVar)), compareLo, startHi);
+
+	builder.SetInsertPoint(compareLo);
+	builder.CreateCondBr(Less(ctx, Elem(base, lo), pivot), incLo, startHi);
+
+	builder.SetInsertPoint(incLo);
+	builder.CreateStore(builder.CreateAdd(lo, one), loVar);
+	builder.CreateBr(scanLo);
+
+	builder.SetInsertPoint(startHi);
+	builder.CreateStore(builder.CreateSub(Load(hiVar), one), hiVar);
+	builder.CreateBr(scanHi);
+
+	builder.SetInsertPoint(scanHi);
+	llvm::Value* hi = Load(hiVar);
+	builder.CreateCondBr(builder.CreateICmpSGT(hi, zero), compareHi, check);
+
+	builder.SetInsertPoint(compareHi);
+	builder.CreateCondBr(Less(ctx, pivot, Elem(base, hi)), decHi, check);
+
+	builder.SetInsertPoint(decHi);
+	builder.CreateStore(builder.CreateSub(hi, one), hiVar);
+	builder.CreateBr(scanHi);
+
+	builder.SetInsertPoint(check);
+	lo = Load(loVar);
+	hi = Load(hiVar);
+	builder.CreateCondBr(builder.CreateICmpSLT(lo, hi), swap, cut);
+
+	builder.SetInsertPoint(swap);
+	Swap(Elem(base, lo), Elem(base, hi));
+	builder.CreateStore(builder.CreateAdd(lo, one), loVar);
+	builder.CreateBr(scanLo);
+
+	// Recurse on the right part, and carry on with the left part.
+	builder.SetInsertPoint(cut);
+	lo = Load(loVar);
+	builder.CreateCall(f, { ctx, Elem(base, lo), builder.CreateSub(Load(nVar), lo), Load(depthVar) });
+	builder.CreateStore(lo, nVar);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRetVoid();
+	return f;
+    }
+
+    llvm::Function* SortGenerator::Sort()
+    {
+	std::string name = prefix;
+	if (llvm::Function* f = theModule->getFunction(name))
+	{
+	    return f;
+	}
+	llvm::Function*                       introSort = IntroSort();
+	llvm::Function*                       insertion = Insertion();
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Function*                       f = Create("", { ptrTy, ptrTy, int64Ty });
+	auto                                  ai = f->arg_begin();
+	llvm::Value*                          ctx = &*ai++;
+	llvm::Value*                          base = &*ai++;
+	llvm::Value*                          n = &*ai;
+	llvm::BasicBlock*                     sort = Block("sort");
+	llvm::BasicBlock*                     done = Block("done");
+
+	builder.CreateCondBr(builder.CreateICmpSGT(n, llvm::ConstantInt::get(int64Ty, 1)), sort, done);
+
+	// Allow 2 * log2(n) levels of partitioning before giving up on quicksort.
+	builder.SetInsertPoint(sort);
+	llvm::Value* zeros = builder.CreateBinaryIntrinsic(llvm::Intrinsic::ctlz, n, builder.getFalse());
+	llvm::Value* log2 = builder.CreateSub(llvm::ConstantInt::get(int64Ty, 63), zeros);
+	builder.CreateCall(introSort, { ctx, base, n, builder.CreateShl(log2, 1) });
+	builder.CreateCall(insertion, { ctx, base, n });
+	builder.CreateBr(done);
+
+	builder.SetInsertPoint(done);
+	builder.CreateRetVoid();
+	return f;
+    }
+
+    llvm::Function* SortGenerator::Merge()
+    {
+	std::string name = prefix + ".merge";
+	if (llvm::Function* f = theModule->getFunction(name))
+	{
+	    return f;
+	}
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Function* f = Create(".merge", { ptrTy, ptrTy, int64Ty, ptrTy, int64Ty, ptrTy });
+	auto            ai = f->arg_begin();
+	llvm::Value*    ctx = &*ai++;
+	llvm::Value*    a = &*ai++;
+	llvm::Value*    na = &*ai++;
+	llvm::Value*    b = &*ai++;
+	llvm::Value*    nb = &*ai++;
+	llvm::Value*    out = &*ai;
+	llvm::Value*    iVar = builder.CreateAlloca(int64Ty, 0, "i");
+	llvm::Value*    jVar = builder.CreateAlloca(int64Ty, 0, "j");
+	llvm::Value*    kVar = builder.CreateAlloca(int64Ty, 0, "k");
+	llvm::Constant* zero = llvm::ConstantInt::get(int64Ty, 0);
+	llvm::Constant* one = llvm::ConstantInt::get(int64Ty, 1);
+	llvm::BasicBlock* loop = Block("loop");
+	llvm::BasicBlock* checkB = Block("checkb");
+	llvm::BasicBlock* body = Block("body");
+	llvm::BasicBlock* takeA = Block("takea");
+	llvm::BasicBlock* takeB = Block("takeb");
+	llvm::BasicBlock* tail = Block("tail");
+
+	builder.CreateStore(zero, iVar);
+	builder.CreateStore(zero, jVar);
+	builder.CreateStore(zero, kVar);
+	builder.CreateBr(loop);
+
+	builder.SetInsertPoint(loop);
+	builder.CreateCondBr(builder.CreateICmpSLT(Load(iVar), na), checkB, tail);
+
+	builder.SetInsertPoint(checkB);
+	builder.CreateCondBr(builder.CreateICmpSLT(Load(jVar), nb), body, tail);
+
+	// Take from b only if it is strictly less, so equal elements keep their order.
+	builder.SetInsertPoint(body);
+	builder.CreateCondBr(Less(ctx, Elem(b, Load(jVar)), Elem(a, Load(iVar))), takeB, takeA);
+
+	for (auto [block, src, var] : { std::tuple{ takeA, a, iVar }, std::tuple{ takeB, b, jVar } })
+	{
+	    builder.SetInsertPoint(block);
+	    llvm::Value* idx = Load(var);
+	    llvm::Value* k = Load(kVar);
+	    Copy(Elem(out, k), Elem(src, idx));
+	    builder.CreateStore(builder.CreateAdd(idx, one), var);
+	    builder.CreateStore(builder.CreateAdd(k, one), kVar);
+	    builder.CreateBr(loop);
+	}
+
+	builder.SetInsertPoint(tail);
+	const llvm::DataLayout& dl = theModule->getDataLayout();
+	llvm::Constant*         size = llvm::ConstantInt::get(int64Ty, dl.getTypeAllocSize(storeTy));
+	llvm::Align             align = dl.getABITypeAlign(storeTy);
+	llvm::Value*            i = Load(iVar);
+	llvm::Value*            j = Load(jVar);
+	llvm::Value*            k = Load(kVar);
+	llvm::Value*            restA = builder.CreateSub(na, i);
+	builder.CreateMemCpy(Elem(out, k), align, Elem(a, i), align, builder.CreateMul(restA, size));
+	builder.CreateMemCpy(Elem(out, builder.CreateAdd(k, restA)), align, Elem(b, j), align,
+	                     builder.CreateMul(builder.CreateSub(nb, j), size));
+	builder.CreateRetVoid();
+	return f;
+    }
+
+    FunctionExprAST* FunctionSort::LessFunction() const
+    {
+	if (args.size() == 2 || args.size() == 4)
+	{
+	    return llvm::dyn_cast<FunctionExprAST>(args.back());
+	}
+	return 0;
+    }
+
+    Types::TypeDecl* FunctionSort::ElementType() const
+    {
+	return llvm::cast<Types::CompoundDecl>(args[0]->Type())->SubType();
+    }
+
+    // sort(arr), sort(arr, less), sort(arr, lo, hi) or sort(arr, lo, hi, less), where arr is a
+    // one-dimensional array and less is a function(a, b: T): boolean on its elements. Without less,
+    // the elements must be integral, real or strings.
+    ErrorType FunctionSort::Semantics()
+    {
+	if (args.size() < 1 || args.size() > 4)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!llvm::isa<AddressableAST>(args[0]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	if (auto aty = llvm::dyn_cast<Types::ArrayDecl>(args[0]->Type()))
+	{
+	    if (aty->getKind() != Types::TypeDecl::TK_Array || aty->Ranges().size() != 1 ||
+	        aty->BitsPerElement() || aty->IsSoA())
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	}
+	else if (!llvm::isa<Types::HeapArrayDecl>(args[0]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	if (args.size() >= 3 && (!CastToInt64(args[1]) || !CastToInt64(args[2])))
+	{
+	    return ErrorType::WrongArgType;
+	}
+
+	Types::TypeDecl* elemTy = ElementType();
+	if (args.size() == 1 || args.size() == 3)
+	{
+	    if (!IsIntegral(elemTy) && !llvm::isa<Types::RealDecl, Types::StringDecl>(elemTy))
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	    return ErrorType::Ok;
+	}
+
+	FunctionExprAST* fnArg = LessFunction();
+	if (!fnArg || !llvm::isa<Types::BoolDecl>(fnArg->Proto()->Type()) || fnArg->Proto()->HasSelf())
+	{
+	    return ErrorType::WrongArgType;
+	}
+	const std::vector<VarDef>& protoArgs = fnArg->Proto()->Args();
+	size_t                     closureArgs = (fnArg->Proto()->Function()->ClosureType()) ? 1 : 0;
+	if (protoArgs.size() - closureArgs != 2)
+	{
+	    return ErrorType::WrongArgType;
+	}
+	for (size_t i = closureArgs; i < protoArgs.size(); i++)
+	{
+	    // Elements are passed straight from the array, so they must look the same in memory.
+	    Types::TypeDecl* ty = protoArgs[i].Type();
+	    if (!ty->SameAs(elemTy) || llvm::isa<Types::HeapArrayDecl>(ty) ||
+	        (protoArgs[i].IsRef() && IsIntegral(ty) && ty->StorageType() != elemTy->StorageType()))
+	    {
+		return ErrorType::WrongArgType;
+	    }
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionSort::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	Types::TypeDecl* elemTy = ElementType();
+	llvm::Type*      elemStoreTy = elemTy->StorageType();
+	llvm::Type*      ptrTy = Types::GetVoidPtrType();
+	llvm::Type*      intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	llvm::Type*      int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	llvm::Type*      voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+	llvm::Value*     arr = llvm::cast<AddressableAST>(args[0])->Address();
+	llvm::Value*     data = arr;
+	llvm::Value*     low = llvm::ConstantInt::get(int64Ty, 0);
+	llvm::Value*     count;
+	if (auto aty = llvm::dyn_cast<Types::ArrayDecl>(args[0]->Type()))
+	{
+	    Types::Range* r = aty->Ranges()[0]->GetRange();
+	    low = llvm::ConstantInt::get(int64Ty, r->Start());
+	    count = llvm::ConstantInt::get(int64Ty, r->Size());
+	}
+	else
+	{
+	    llvm::Type* arrTy = args[0]->Type()->LlvmType();
+	    data = builder.CreateLoad(ptrTy, builder.CreateStructGEP(arrTy, arr, 0), "data");
+	    count = builder.CreateLoad(int64Ty, builder.CreateStructGEP(arrTy, arr, 1), "len");
+	}
+	if (args.size() >= 3)
+	{
+	    llvm::Value* lo = args[1]->CodeGen();
+	    llvm::Value* hi = args[2]->CodeGen();
+	    // An empty slice, with hi < lo, is fine anywhere, e.g. sort(a, low, low - 1).
+	    if (rangeCheck)
+	    {
+		llvm::Function*   fn = builder.GetInsertBlock()->getParent();
+		llvm::BasicBlock* checkBB = llvm::BasicBlock::Create(theContext, "checkslice", fn);
+		llvm::BasicBlock* doneBB = llvm::BasicBlock::Create(theContext, "slice", fn);
+		builder.CreateCondBr(builder.CreateICmpSGE(hi, lo), checkBB, doneBB);
+		builder.SetInsertPoint(checkBB);
+		CreateRangeCheck(args[1]->Loc(), lo, low, count);
+		CreateRangeCheck(args[2]->Loc(), hi, low, count);
+		builder.CreateBr(doneBB);
+		builder.SetInsertPoint(doneBB);
+	    }
+	    data = builder.CreateGEP(elemStoreTy, data, builder.CreateSub(lo, low), "first");
+	    count = builder.CreateAdd(builder.CreateSub(hi, lo), llvm::ConstantInt::get(int64Ty, 1), "count");
+	    // Sorting an empty slice does nothing.
+	    llvm::Value* zero = llvm::ConstantInt::get(int64Ty, 0);
+	    count = builder.CreateSelect(builder.CreateICmpSLT(count, zero), zero, count, "count");
+	}
+
+	const llvm::DataLayout& dl = theModule->getDataLayout();
+	uint64_t                size = dl.getTypeAllocSize(elemStoreTy);
+	FunctionExprAST*        fnArg = LessFunction();
+	if (!fnArg && IsIntegral(elemTy))
+	{
+	    bool isSigned = !IsUnsigned(elemTy);
+	    if (auto rty = llvm::dyn_cast<Types::RangeDecl>(elemTy))
+	    {
+		isSigned = rty->Start() < 0;
+	    }
+	    llvm::FunctionCallee f = GetFunction(voidTy, { ptrTy, int64Ty, intTy, intTy }, "__RadixSort");
+	    return builder.CreateCall(
+	        f, { data, count, MakeIntegerConstant(size), MakeIntegerConstant(isSigned) });
+	}
+
+	const PrototypeAST* proto = 0;
+	llvm::Function*     lessFn = 0;
+	llvm::Value*        ctx = llvm::Constant::getNullValue(ptrTy);
+	if (fnArg)
+	{
+	    proto = fnArg->Proto();
+	    lessFn = llvm::dyn_cast<llvm::Function>(fnArg->CodeGen());
+	    ICE_IF(!lessFn, "Expected a function for sort");
+	    FunctionAST* fn = proto->Function();
+	    if (Types::TypeDecl* closureTy = fn->ClosureType())
+	    {
+		std::vector<VariableExprAST*> vf;
+		for (auto u : fn->UsedVars())
+		{
+		    vf.push_back(new VariableExprAST(fn->Loc(), u.Name(), u.Type()));
+		}
+		ctx = (new ClosureAST(fn->Loc(), closureTy, vf))->CodeGen();
+	    }
+	}
+
+	SortGenerator        gen(builder, elemTy, proto, lessFn);
+	llvm::Function*      sort = gen.Sort();
+	llvm::Function*      merge = gen.Merge();
+	llvm::Value*         sizeVal = llvm::ConstantInt::get(int64Ty, size);
+	llvm::FunctionCallee f =
+	    GetFunction(voidTy, { ptrTy, ptrTy, ptrTy, ptrTy, int64Ty, int64Ty }, "__Sort");
+	return builder.CreateCall(f, { sort, merge, ctx, data, count, sizeVal });
+    }
+
+    // The untyped variable arguments of fillchar, move and comparemem. Dynamic arrays, maps,
+    // bigints and files own memory elsewhere, which a byte copy would share or leak, and elements
+    // of bit packed and {$soa} arrays have no address of their own.
+    static bool IsMemoryVariable(ExprAST* arg)
+    {
+	auto ae = llvm::dyn_cast<ArrayExprAST>(arg);
+	return llvm::isa<AddressableAST>(arg) && !(ae && (ae->IsBitPacked() || ae->IsSoA())) &&
+	       !Types::IsManaged(arg->Type()) && !llvm::isa<Types::FileDecl>(arg->Type());
+    }
+
+    // The operand that fillchar and move write to must be a variable: strings are read-only
+    // constants, and function results, sets and type casts are temporaries.
+    static bool IsWritableMemoryVariable(ExprAST* arg)
+    {
+	return IsMemoryVariable(arg) &&
+	       llvm::isa<VariableExprAST, ArrayExprAST, DynArrayExprAST, HeapArrayExprAST, PointerExprAST,
+	                 FilePointerExprAST, FieldExprAST, VariantFieldExprAST>(arg);
+    }
+
+    // fillchar(x, count, value): Set count bytes of x to value.
+    ErrorType FunctionFillChar::Semantics()
+    {
+	if (args.size() != 3)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!IsWritableMemoryVariable(args[0]) || !CastToInt64(args[1]) || !IsIntegral(args[2]->Type()))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionFillChar::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value* dest = llvm::cast<AddressableAST>(args[0])->Address();
+	llvm::Value* count = args[1]->CodeGen();
+	llvm::Type*  charTy = Types::Get<Types::CharDecl>()->LlvmType();
+	llvm::Value* value = builder.CreateIntCast(args[2]->CodeGen(), charTy, false);
+	return builder.CreateMemSet(dest, value, count, KnownAlignment(args[0]));
+    }
+
+    // move(src, dest, count): Copy count bytes from src to dest, which may overlap.
+    ErrorType FunctionMove::Semantics()
+    {
+	if (args.size() != 3)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!IsMemoryVariable(args[0]) || !IsWritableMemoryVariable(args[1]) || !CastToInt64(args[2]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionMove::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value* src = llvm::cast<AddressableAST>(args[0])->Address();
+	llvm::Value* dest = llvm::cast<AddressableAST>(args[1])->Address();
+	llvm::Value* count = args[2]->CodeGen();
+	return builder.CreateMemMove(dest, KnownAlignment(args[1]), src, KnownAlignment(args[0]), count);
+    }
+
+    // comparemem(a, b, count): True if the first count bytes of a and b are the same.
+    ErrorType FunctionCompareMem::Semantics()
+    {
+	if (args.size() != 3)
+	{
+	    return ErrorType::WrongArgCount;
+	}
+	if (!IsMemoryVariable(args[0]) || !IsMemoryVariable(args[1]) || !CastToInt64(args[2]))
+	{
+	    return ErrorType::WrongArgType;
+	}
+	return ErrorType::Ok;
+    }
+
+    llvm::Value* FunctionCompareMem::CodeGen(llvm::IRBuilder<>& builder)
+    {
+	llvm::Value*         a = llvm::cast<AddressableAST>(args[0])->Address();
+	llvm::Value*         b = llvm::cast<AddressableAST>(args[1])->Address();
+	llvm::Value*         count = args[2]->CodeGen();
+	llvm::Type*          ptrTy = Types::GetVoidPtrType();
+	llvm::Type*          intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	llvm::Type*          sizeTy = Types::GetIndexType()->LlvmType();
+	llvm::FunctionCallee f = GetFunction(intTy, { ptrTy, ptrTy, sizeTy }, "memcmp");
+	count = builder.CreateIntCast(count, sizeTy, false);
+	return builder.CreateIsNull(builder.CreateCall(f, { a, b, count }), "same");
+    }
+
     void AddBIFCreator(const std::string& name, CreateBIFObject createFunc)
     {
 	ICE_IF(BIFMap.find(name) != BIFMap.end(), "Already registered function");
@@ -1852,6 +3662,13 @@ namespace Builtin
 	return BIFMap.find(name) != BIFMap.end();
     }
 
+    // Arguments that name a procedure, rather than call it.
+    bool IsFunctionArg(std::string name, unsigned argNo)
+    {
+	strlower(name);
+	return (name == "spawn" && argNo == 0) || (name == "sort" && (argNo == 1 || argNo == 3));
+    }
+
     FunctionBase* CreateBuiltinFunction(std::string name, ArgList& args)
     {
 	strlower(name);
@@ -1885,6 +3702,10 @@ namespace Builtin
 	AddBIFCreator("dispose", NEW(Dispose));
 	AddBIFCreator("halt", NEW(Halt));
 	AddBIFCreator("length", NEW(Length));
+	AddBIFCreator("high", NEW(High));
+	AddBIFCreator("setlength", NEW(SetLength));
+	AddBIFCreator("include", NEW2(MapKey, "Insert"));
+	AddBIFCreator("exclude", NEW2(MapKey, "Remove"));
 	AddBIFCreator("popcnt", NEW(Popcnt));
 	AddBIFCreator("card", NEW(Popcnt));
 	AddBIFCreator("assign", NEW(Assign));
@@ -1948,5 +3769,28 @@ namespace Builtin
 	AddBIFCreator("polar", NEW(Polar));
 	AddBIFCreator("frac", NEW2(Float, "__frac"));
 	AddBIFCreator("int", NEW(IntConvert));
+	AddBIFCreator("spawn", NEW(Spawn));
+	AddBIFCreator("join", NEW(Join));
+	AddBIFCreator("atomicinc", NEW2(AtomicInc, llvm::AtomicRMWInst::Add));
+	AddBIFCreator("atomicdec", NEW2(AtomicInc, llvm::AtomicRMWInst::Sub));
+	AddBIFCreator("atomiccas", NEW(AtomicCas));
+	AddBIFCreator("makechannel", NEW(MakeChannel));
+	AddBIFCreator("send", NEW(Send));
+	AddBIFCreator("closechannel", NEW(Send));
+	AddBIFCreator("receive", NEW(Receive));
+	AddBIFCreator("shuffle", NEW(Shuffle));
+	AddBIFCreator("select", NEW(Select));
+	AddBIFCreator("reduceadd", NEW2(VectorReduce, llvm::Intrinsic::vector_reduce_add));
+	AddBIFCreator("reducemul", NEW2(VectorReduce, llvm::Intrinsic::vector_reduce_mul));
+	AddBIFCreator("reducemin", NEW2(VectorReduce, llvm::Intrinsic::vector_reduce_smin));
+	AddBIFCreator("reducemax", NEW2(VectorReduce, llvm::Intrinsic::vector_reduce_smax));
+	AddBIFCreator("any", NEW2(VectorReduce, llvm::Intrinsic::vector_reduce_or));
+	AddBIFCreator("all", NEW2(VectorReduce, llvm::Intrinsic::vector_reduce_and));
+	AddBIFCreator("likely", NEW2(Expect, true));
+	AddBIFCreator("unlikely", NEW2(Expect, false));
+	AddBIFCreator("sort", NEW(Sort));
+	AddBIFCreator("fillchar", NEW(FillChar));
+	AddBIFCreator("move", NEW(Move));
+	AddBIFCreator("comparemem", NEW(CompareMem));
     }
 } // namespace Builtin
@@ -28,7 +28,10 @@ namespace Builtin
 	virtual Types::TypeDecl* Type() const = 0;
 	virtual ErrorType        Semantics() = 0;
 	virtual void             accept(ASTVisitor& v);
+	// The result as a constant expression, or null if it isn't known at compile time.
+	virtual ExprAST*         Fold() { return 0; }
 	const std::string&       Name() const { return name; }
+	std::vector<ExprAST*>&   Args() { return args; }
 	virtual ~FunctionBase() {}
 
     protected:
@@ -37,6 +40,7 @@ namespace Builtin
     };
 
     bool          IsBuiltin(std::string funcname);
+    bool          IsFunctionArg(std::string funcname, unsigned argNo);
     void          InitBuiltins();
     FunctionBase* CreateBuiltinFunction(std::string name, const std::vector<ExprAST*>& args);
 } // namespace Builtin
@@ -0,0 +1,696 @@
+#include "constfold.h"
+#include "options.h"
+#include "trace.h"
+#include "visitor.h"
+#include <algorithm>
+#include <functional>
+#include <llvm/ADT/APInt.h>
+
+static bool IsConstantInt(ExprAST* e)
+{
+    return llvm::isa<IntegerExprAST>(e) && IsIntegral(e->Type());
+}
+
+static bool IsConstantBool(ExprAST* e, bool& value)
+{
+    if (auto i = llvm::dyn_cast_or_null<IntegerExprAST>(e))
+    {
+	if (llvm::isa<Types::BoolDecl>(i->Type()))
+	{
+	    value = i->Int() & 1;
+	    return true;
+	}
+    }
+    return false;
+}
+
+static int64_t ConstantIntValue(IntegerExprAST* e, bool isUnsigned)
+{
+    llvm::APInt v = ConstantIntValue(e);
+    return isUnsigned ? v.getZExtValue() : v.getSExtValue();
+}
+
+static ExprAST* MakeBoolExpr(const Location& w, bool v)
+{
+    return new IntegerExprAST(w, v, Types::Get<Types::BoolDecl>());
+}
+
+static bool IsConstantString(ExprAST* e, std::string& str)
+{
+    if (auto s = llvm::dyn_cast<StringExprAST>(e))
+    {
+	str = s->Str();
+	return true;
+    }
+    if (auto c = llvm::dyn_cast<CharExprAST>(e))
+    {
+	str = std::string(1, c->Int());
+	return true;
+    }
+    return false;
+}
+
+// Same type as the parser gives a string literal.
+static ExprAST* MakeStringExpr(const Location& w, const std::string& str)
+{
+    std::vector<Types::RangeBaseDecl*> rv = { new Types::RangeDecl(new Types::Range(0, str.size() - 1),
+	                                                           Types::Get<Types::IntegerDecl>()) };
+    return new StringExprAST(w, str, new Types::ArrayDecl(Types::Get<Types::CharDecl>(), rv));
+}
+
+// Same result as __StrCompare in the runtime.
+static int CompareStrings(const std::string& a, const std::string& b)
+{
+    size_t shortest = std::min(a.size(), b.size());
+    for (size_t i = 0; i < shortest; i++)
+    {
+	if (a[i] != b[i])
+	{
+	    return (unsigned char)a[i] - (unsigned char)b[i];
+	}
+    }
+    return (int)a.size() - (int)b.size();
+}
+
+static bool CompareResult(Token::TokenType op, int cmp, bool& res)
+{
+    switch (op)
+    {
+    case Token::Equal:
+	res = cmp == 0;
+	return true;
+    case Token::NotEqual:
+	res = cmp != 0;
+	return true;
+    case Token::LessThan:
+	res = cmp < 0;
+	return true;
+    case Token::LessOrEqual:
+	res = cmp <= 0;
+	return true;
+    case Token::GreaterThan:
+	res = cmp > 0;
+	return true;
+    case Token::GreaterOrEqual:
+	res = cmp >= 0;
+	return true;
+    default:
+	return false;
+    }
+}
+
+class GotoTargetFinder : public ASTVisitor
+{
+public:
+    GotoTargetFinder() : found(false) {}
+    void visit(ExprAST* e) override
+    {
+	if (auto l = llvm::dyn_cast<LabelExprAST>(e))
+	{
+	    found = found || l->IsGotoTarget();
+	}
+    }
+
+    bool found;
+};
+
+// Code with a label that is the target of a goto can't be removed, even if it's not reachable
+// from the statement before it.
+static bool HasGotoTarget(ExprAST* e)
+{
+    if (!e)
+    {
+	return false;
+    }
+    GotoTargetFinder finder;
+    e->accept(finder);
+    return finder.found;
+}
+
+class ConstantFolder : public ASTVisitor
+{
+public:
+    void visit(ExprAST* e) override;
+
+private:
+    ExprAST* Fold(ExprAST* e);
+    ExprAST* FoldValue(ExprAST* e);
+    ExprAST* FoldBinary(BinaryExprAST* b);
+    ExprAST* FoldIntBinary(BinaryExprAST* b);
+    ExprAST* FoldRealBinary(BinaryExprAST* b);
+    ExprAST* FoldStringBinary(BinaryExprAST* b);
+    ExprAST* FoldSetBinary(BinaryExprAST* b);
+    ExprAST* FoldUnary(UnaryExprAST* u);
+    ExprAST* FoldTypeCast(TypeCastAST* t);
+    ExprAST* FoldBuiltin(BuiltinExprAST* b);
+    ExprAST* Prune(ExprAST* stmt);
+    ExprAST* PruneBody(ExprAST* body);
+    bool     SetBits(ExprAST* e, std::vector<bool>& bits);
+};
+
+ExprAST* ConstantFolder::Fold(ExprAST* e)
+{
+    if (auto b = llvm::dyn_cast<BinaryExprAST>(e))
+    {
+	return FoldBinary(b);
+    }
+    if (auto u = llvm::dyn_cast<UnaryExprAST>(e))
+    {
+	return FoldUnary(u);
+    }
+    if (auto t = llvm::dyn_cast<TypeCastAST>(e))
+    {
+	return FoldTypeCast(t);
+    }
+    if (auto b = llvm::dyn_cast<BuiltinExprAST>(e))
+    {
+	return FoldBuiltin(b);
+    }
+    return e;
+}
+
+// As Fold, but a string literal only replaces an expression where the code generation for the
+// surrounding statement or operator already deals with literals.
+ExprAST* ConstantFolder::FoldValue(ExprAST* e)
+{
+    ExprAST* res = Fold(e);
+    if (llvm::isa<StringExprAST>(res) && !llvm::isa<StringExprAST>(e))
+    {
+	return e;
+    }
+    return res;
+}
+
+ExprAST* ConstantFolder::FoldBinary(BinaryExprAST* b)
+{
+    b->lhs = Fold(b->lhs);
+    b->rhs = Fold(b->rhs);
+
+    ExprAST* l = b->lhs;
+    ExprAST* r = b->rhs;
+    if (llvm::isa<SetExprAST>(r) || (r->Type() && llvm::isa<Types::SetDecl>(r->Type())))
+    {
+	return FoldSetBinary(b);
+    }
+    if (llvm::isa<StringExprAST, CharExprAST>(l) && llvm::isa<StringExprAST, CharExprAST>(r) &&
+        !(llvm::isa<CharExprAST>(l) && llvm::isa<CharExprAST>(r) && b->oper.IsCompare()))
+    {
+	return FoldStringBinary(b);
+    }
+    if (IsConstantInt(l) && IsConstantInt(r) && l->Type()->LlvmType() == r->Type()->LlvmType())
+    {
+	return FoldIntBinary(b);
+    }
+    if (llvm::isa<RealExprAST>(l) && llvm::isa<RealExprAST>(r))
+    {
+	return FoldRealBinary(b);
+    }
+    return b;
+}
+
+// Uses the same operations as IntegerBinExpr, so the result is what the generated code would give.
+ExprAST* ConstantFolder::FoldIntBinary(BinaryExprAST* b)
+{
+    llvm::APInt      l = ConstantIntValue(llvm::cast<IntegerExprAST>(b->lhs));
+    llvm::APInt      r = ConstantIntValue(llvm::cast<IntegerExprAST>(b->rhs));
+    bool             isUnsigned = IsUnsigned(b->rhs->Type());
+    const Location&  loc = b->Loc();
+    Types::TypeDecl* ty = b->Type();
+
+    switch (b->oper.GetToken())
+    {
+    case Token::Equal:
+	return MakeBoolExpr(loc, l == r);
+    case Token::NotEqual:
+	return MakeBoolExpr(loc, l != r);
+    case Token::LessThan:
+	return MakeBoolExpr(loc, isUnsigned ? l.ult(r) : l.slt(r));
+    case Token::LessOrEqual:
+	return MakeBoolExpr(loc, isUnsigned ? l.ule(r) : l.sle(r));
+    case Token::GreaterThan:
+	return MakeBoolExpr(loc, isUnsigned ? l.ugt(r) : l.sgt(r));
+    case Token::GreaterOrEqual:
+	return MakeBoolExpr(loc, isUnsigned ? l.uge(r) : l.sge(r));
+    default:
+	break;
+    }
+
+    if (!ty || ty->LlvmType() != b->lhs->Type()->LlvmType())
+    {
+	return b;
+    }
+
+    switch (b->oper.GetToken())
+    {
+    case Token::Plus:
+	return MakeIntegerExpr(loc, l + r, ty);
+    case Token::Minus:
+	return MakeIntegerExpr(loc, l - r, ty);
+    case Token::Multiply:
+	return MakeIntegerExpr(loc, l * r, ty);
+    case Token::Div:
+    case Token::Mod:
+	// Leave it to the generated code to deal with division by zero and overflow.
+	if (r.isZero() || (l.isMinSignedValue() && r.isAllOnes()))
+	{
+	    return b;
+	}
+	return MakeIntegerExpr(loc, (b->oper.GetToken() == Token::Div) ? l.sdiv(r) : l.srem(r), ty);
+    case Token::Shr:
+    case Token::Shl:
+	if (r.uge(l.getBitWidth()))
+	{
+	    return b;
+	}
+	return MakeIntegerExpr(loc, (b->oper.GetToken() == Token::Shr) ? l.lshr(r) : l.shl(r), ty);
+    case Token::Xor:
+	return MakeIntegerExpr(loc, l ^ r, ty);
+    case Token::And:
+    case Token::And_Then:
+	return MakeIntegerExpr(loc, l & r, ty);
+    case Token::Or:
+    case Token::Or_Else:
+	return MakeIntegerExpr(loc, l | r, ty);
+    default:
+	break;
+    }
+    return b;
+}
+
+ExprAST* ConstantFolder::FoldRealBinary(BinaryExprAST* b)
+{
+    double          l = llvm::cast<RealExprAST>(b->lhs)->Value();
+    double          r = llvm::cast<RealExprAST>(b->rhs)->Value();
+    const Location& loc = b->Loc();
+
+    // The comparisons are ordered, so anything involving a NaN is false.
+    switch (b->oper.GetToken())
+    {
+    case Token::Equal:
+	return MakeBoolExpr(loc, l == r);
+    case Token::NotEqual:
+	return MakeBoolExpr(loc, l < r || l > r);
+    case Token::LessThan:
+	return MakeBoolExpr(loc, l < r);
+    case Token::LessOrEqual:
+	return MakeBoolExpr(loc, l <= r);
+    case Token::GreaterThan:
+	return MakeBoolExpr(loc, l > r);
+    case Token::GreaterOrEqual:
+	return MakeBoolExpr(loc, l >= r);
+    default:
+	break;
+    }
+
+    if (!b->Type()->LlvmType()->isDoubleTy())
+    {
+	return b;
+    }
+
+    switch (b->oper.GetToken())
+    {
+    case Token::Plus:
+	return new RealExprAST(loc, l + r);
+    case Token::Minus:
+	return new RealExprAST(loc, l - r);
+    case Token::Multiply:
+	// A contracted multiply-add rounds once, so folding the multiply would change the result.
+	if (fpContract == FPContractOn)
+	{
+	    return b;
+	}
+	return new RealExprAST(loc, l * r);
+    case Token::Divide:
+	return new RealExprAST(loc, l / r);
+    default:
+	break;
+    }
+    return b;
+}
+
+ExprAST* ConstantFolder::FoldStringBinary(BinaryExprAST* b)
+{
+    std::string l;
+    std::string r;
+    if (!IsConstantString(b->lhs, l) || !IsConstantString(b->rhs, r))
+    {
+	return b;
+    }
+
+    if (b->oper.GetToken() == Token::Plus)
+    {
+	std::string str = l + r;
+	// Shorter strings are chars, longer ones don't fit in a string.
+	if (str.size() < 2 || str.size() > 255)
+	{
+	    return b;
+	}
+	return MakeStringExpr(b->Loc(), str);
+    }
+
+    bool res;
+    if (CompareResult(b->oper.GetToken(), CompareStrings(l, r), res))
+    {
+	return MakeBoolExpr(b->Loc(), res);
+    }
+    return b;
+}
+
+// Set the bits of a constant set the same way as SetExprAST::MakeConstantSetArray.
+bool ConstantFolder::SetBits(ExprAST* e, std::vector<bool>& bits)
+{
+    auto s = llvm::dyn_cast<SetExprAST>(e);
+    if (!s || !llvm::isa<Types::SetDecl>(s->Type()))
+    {
+	return false;
+    }
+
+    Types::Range* range = s->Type()->GetRange();
+    int64_t       start = range->Start();
+    int64_t       size = range->Size();
+    bits.assign(size, false);
+    for (auto v : s->values)
+    {
+	ExprAST* lowExpr = v;
+	ExprAST* highExpr = v;
+	if (auto r = llvm::dyn_cast<RangeExprAST>(v))
+	{
+	    lowExpr = r->LowExpr();
+	    highExpr = r->HighExpr();
+	}
+	if (!IsConstantInt(lowExpr) || !IsConstantInt(highExpr))
+	{
+	    return false;
+	}
+	bool    isUnsigned = IsUnsigned(lowExpr->Type());
+	int64_t low = ConstantIntValue(llvm::cast<IntegerExprAST>(lowExpr), isUnsigned) - start;
+	int64_t high = ConstantIntValue(llvm::cast<IntegerExprAST>(highExpr), isUnsigned) - start;
+	for (int64_t i = std::max<int64_t>(low, 0); i <= std::min(high, size - 1); i++)
+	{
+	    bits[i] = true;
+	}
+    }
+    return true;
+}
+
+ExprAST* ConstantFolder::FoldSetBinary(BinaryExprAST* b)
+{
+    std::vector<bool> r;
+    if (!SetBits(b->rhs, r))
+    {
+	return b;
+    }
+
+    if (b->oper.GetToken() == Token::In)
+    {
+	if (!IsConstantInt(b->lhs))
+	{
+	    return b;
+	}
+	bool    isUnsigned = IsUnsigned(b->lhs->Type());
+	int64_t index = ConstantIntValue(llvm::cast<IntegerExprAST>(b->lhs), isUnsigned) -
+	                b->rhs->Type()->GetRange()->Start();
+	if (index < 0 || index >= (int64_t)r.size())
+	{
+	    return b;
+	}
+	return MakeBoolExpr(b->Loc(), r[index]);
+    }
+
+    std::vector<bool> l;
+    if (!SetBits(b->lhs, l) || *b->lhs->Type() != *b->rhs->Type())
+    {
+	return b;
+    }
+
+    // Subset, as __SetContains in the runtime.
+    auto contains = [](const std::vector<bool>& x, const std::vector<bool>& y)
+    {
+	for (size_t i = 0; i < x.size(); i++)
+	{
+	    if (x[i] && !y[i])
+	    {
+		return false;
+	    }
+	}
+	return true;
+    };
+
+    std::vector<bool> res(l.size());
+    switch (b->oper.GetToken())
+    {
+    case Token::Equal:
+	return MakeBoolExpr(b->Loc(), l == r);
+    case Token::NotEqual:
+	return MakeBoolExpr(b->Loc(), l != r);
+    case Token::LessOrEqual:
+	return MakeBoolExpr(b->Loc(), contains(l, r));
+    case Token::GreaterOrEqual:
+	return MakeBoolExpr(b->Loc(), contains(r, l));
+    case Token::GreaterThan:
+	return MakeBoolExpr(b->Loc(), !contains(l, r));
+    case Token::LessThan:
+	return MakeBoolExpr(b->Loc(), !contains(r, l));
+    case Token::Plus:
+	std::transform(l.begin(), l.end(), r.begin(), res.begin(), std::logical_or<bool>());
+	break;
+    case Token::Minus:
+	std::transform(l.begin(), l.end(), r.begin(), res.begin(), [](bool x, bool y) { return x && !y; });
+	break;
+    case Token::Multiply:
+	std::transform(l.begin(), l.end(), r.begin(), res.begin(), std::logical_and<bool>());
+	break;
+    case Token::SymDiff:
+	std::transform(l.begin(), l.end(), r.begin(), res.begin(), std::not_equal_to<bool>());
+	break;
+    default:
+	return b;
+    }
+
+    auto setTy = llvm::dyn_cast<Types::SetDecl>(b->Type());
+    if (!setTy || *setTy != *b->lhs->Type())
+    {
+	return b;
+    }
+    Types::TypeDecl*      elemTy = setTy->SubType();
+    unsigned              width = elemTy->LlvmType()->getIntegerBitWidth();
+    int64_t               start = setTy->GetRange()->Start();
+    std::vector<ExprAST*> values;
+    for (size_t i = 0; i < res.size(); i++)
+    {
+	if (res[i])
+	{
+	    llvm::APInt v(64, start + i);
+	    values.push_back(MakeIntegerExpr(b->Loc(), v.trunc(width), elemTy));
+	}
+    }
+    return new SetExprAST(b->Loc(), values, setTy);
+}
+
+ExprAST* ConstantFolder::FoldUnary(UnaryExprAST* u)
+{
+    u->rhs = Fold(u->rhs);
+
+    if (IsConstantInt(u->rhs) && u->Type()->LlvmType() == u->rhs->Type()->LlvmType())
+    {
+	llvm::APInt v = ConstantIntValue(llvm::cast<IntegerExprAST>(u->rhs));
+	switch (u->oper.GetToken())
+	{
+	case Token::Minus:
+	    return MakeIntegerExpr(u->Loc(), -v, u->Type());
+	case Token::Not:
+	    return MakeIntegerExpr(u->Loc(), ~v, u->Type());
+	default:
+	    break;
+	}
+    }
+    if (auto r = llvm::dyn_cast<RealExprAST>(u->rhs))
+    {
+	if (u->oper.GetToken() == Token::Minus)
+	{
+	    return new RealExprAST(u->Loc(), -r->Value());
+	}
+    }
+    return u;
+}
+
+// Integer conversions, as in TypeCastAST::CodeGen.
+ExprAST* ConstantFolder::FoldTypeCast(TypeCastAST* t)
+{
+    t->expr = Fold(t->expr);
+
+    if (!IsConstantInt(t->expr))
+    {
+	return t;
+    }
+    auto             e = llvm::cast<IntegerExprAST>(t->expr);
+    Types::TypeDecl* ty = t->Type();
+    if (llvm::isa<Types::RealDecl>(ty) && ty->LlvmType()->isDoubleTy())
+    {
+	return new RealExprAST(t->Loc(), ConstantIntValue(e).getSExtValue());
+    }
+    if (IsIntegral(ty))
+    {
+	llvm::APInt v = ConstantIntValue(e);
+	unsigned    width = ty->LlvmType()->getIntegerBitWidth();
+	if (width < v.getBitWidth())
+	{
+	    return t;
+	}
+	return MakeIntegerExpr(t->Loc(), IsUnsigned(ty) ? v.zext(width) : v.sext(width), ty);
+    }
+    return t;
+}
+
+ExprAST* ConstantFolder::FoldBuiltin(BuiltinExprAST* b)
+{
+    for (auto& a : b->bif->Args())
+    {
+	a = FoldValue(a);
+    }
+    if (ExprAST* e = b->bif->Fold())
+    {
+	return e;
+    }
+    return b;
+}
+
+// Replace an if-statement with a constant condition by the branch that is taken, and remove
+// while-loops that are never entered. Returns null if nothing is left.
+ExprAST* ConstantFolder::Prune(ExprAST* stmt)
+{
+    bool cond;
+    if (auto ifExpr = llvm::dyn_cast_or_null<IfExprAST>(stmt))
+    {
+	if (IsConstantBool(ifExpr->cond, cond) && !HasGotoTarget(cond ? ifExpr->other : ifExpr->then))
+	{
+	    return cond ? ifExpr->then : ifExpr->other;
+	}
+    }
+    if (auto whileExpr = llvm::dyn_cast_or_null<WhileExprAST>(stmt))
+    {
+	if (IsConstantBool(whileExpr->cond, cond) && !cond && !HasGotoTarget(whileExpr->body))
+	{
+	    return 0;
+	}
+    }
+    return stmt;
+}
+
+ExprAST* ConstantFolder::PruneBody(ExprAST* body)
+{
+    if (ExprAST* e = Prune(body))
+    {
+	return e;
+    }
+    return new BlockAST(body->Loc(), {});
+}
+
+void ConstantFolder::visit(ExprAST* e)
+{
+    if (auto b = llvm::dyn_cast<BinaryExprAST>(e))
+    {
+	b->lhs = Fold(b->lhs);
+	b->rhs = Fold(b->rhs);
+    }
+    else if (auto u = llvm::dyn_cast<UnaryExprAST>(e))
+    {
+	u->rhs = Fold(u->rhs);
+    }
+    else if (auto t = llvm::dyn_cast<TypeCastAST>(e))
+    {
+	t->expr = Fold(t->expr);
+    }
+    else if (auto b = llvm::dyn_cast<BuiltinExprAST>(e))
+    {
+	for (auto& a : b->bif->Args())
+	{
+	    a = FoldValue(a);
+	}
+    }
+    else if (auto c = llvm::dyn_cast<CallExprAST>(e))
+    {
+	for (auto& a : c->Args())
+	{
+	    a = FoldValue(a);
+	}
+    }
+    else if (auto a = llvm::dyn_cast<AssignExprAST>(e))
+    {
+	ExprAST* rhs = Fold(a->rhs);
+	if (auto s = llvm::dyn_cast<StringExprAST>(rhs))
+	{
+	    // The literal is copied as is, so it must fit.
+	    auto sty = llvm::dyn_cast<Types::StringDecl>(a->lhs->Type());
+	    if (s != a->rhs && (!sty || s->Str().size() > (size_t)sty->Capacity()))
+	    {
+		rhs = a->rhs;
+	    }
+	}
+	a->rhs = rhs;
+    }
+    else if (auto w = llvm::dyn_cast<WriteAST>(e))
+    {
+	for (auto& arg : w->args)
+	{
+	    arg.expr = Fold(arg.expr);
+	    if (arg.width)
+	    {
+		arg.width = FoldValue(arg.width);
+	    }
+	    if (arg.precision)
+	    {
+		arg.precision = FoldValue(arg.precision);
+	    }
+	}
+    }
+    else if (auto c = llvm::dyn_cast<CaseExprAST>(e))
+    {
+	c->expr = FoldValue(c->expr);
+    }
+    else if (auto i = llvm::dyn_cast<IfExprAST>(e))
+    {
+	i->cond = Fold(i->cond);
+	i->then = Prune(i->then);
+	i->other = Prune(i->other);
+    }
+    else if (auto w = llvm::dyn_cast<WhileExprAST>(e))
+    {
+	w->cond = Fold(w->cond);
+	w->body = PruneBody(w->body);
+    }
+    else if (auto r = llvm::dyn_cast<RepeatExprAST>(e))
+    {
+	r->cond = Fold(r->cond);
+	r->body = PruneBody(r->body);
+    }
+    else if (auto f = llvm::dyn_cast<ForExprAST>(e))
+    {
+	// A for-in loop has no end, and start is the set or array to loop over.
+	if (f->end)
+	{
+	    f->start = FoldValue(f->start);
+	    f->end = FoldValue(f->end);
+	}
+	f->body = PruneBody(f->body);
+    }
+    else if (auto b = llvm::dyn_cast<BlockAST>(e))
+    {
+	std::vector<ExprAST*> content;
+	for (auto s : b->Content())
+	{
+	    if (ExprAST* p = Prune(s))
+	    {
+		content.push_back(p);
+	    }
+	}
+	b->Content() = content;
+    }
+}
+
+void FoldConstants(ExprAST* ast)
+{
+    TIME_TRACE();
+    ConstantFolder folder;
+    ast->accept(folder);
+}
@@ -0,0 +1,10 @@
+#ifndef CONSTFOLD_H
+#define CONSTFOLD_H
+
+#include "expr.h"
+
+// Replace expressions with constant operands by their value, and remove statements that can
+// never run. Must be called after semantic analysis, as it relies on the final types.
+void FoldConstants(ExprAST* ast);
+
+#endif
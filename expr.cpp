@@ -6,6 +6,7 @@
 #include "types.h"
 #include <llvm/ADT/APFloat.h>
 #include <llvm/ADT/APSInt.h>
+#include <llvm/Analysis/ValueTracking.h>
 #include <llvm/CodeGen/CommandFlags.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constants.h>
@@ -14,13 +15,16 @@
 #include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/raw_os_ostream.h>
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <iostream>
 #include <map>
+#include <set>
 #include <sstream>
 
 #if !NDEBUG
@@ -71,6 +75,8 @@ typedef Stack<llvm::Value*>        VarStack;
 typedef StackWrapper<llvm::Value*> VarStackWrapper;
 
 const size_t MEMCPY_THRESHOLD = 16;
+// Weight of the expected side of a branch, against 1 for the other side (same as llvm.expect).
+const uint32_t LIKELY_WEIGHT = 2000;
 
 extern llvm::Module* theModule;
 
@@ -81,6 +87,7 @@ static llvm::IRBuilder<>         builder(theContext);
 static int                       errCnt;
 static std::vector<VTableAST*>   vtableBackPatchList;
 static std::vector<FunctionAST*> unitInit;
+static FunctionCompleteHook      functionComplete;
 
 // Debug stack. We just use push_back and pop_back to make it like a stack.
 static std::vector<DebugInfo*> debugStack;
@@ -150,6 +157,42 @@ llvm::FunctionCallee GetFunction(llvm::Type* resTy, const std::vector<llvm::Type
     return theModule->getOrInsertFunction(name, ft);
 }
 
+// Functions that end the program, such as halt, panic and range errors. They are cold and don't return,
+// so the optimiser moves the paths that call them out of line, away from the code that normally runs.
+llvm::FunctionCallee GetErrorFunction(const std::vector<llvm::Type*>& args, const std::string& name)
+{
+    llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), args, name);
+    if (auto fn = llvm::dyn_cast<llvm::Function>(f.getCallee()))
+    {
+	fn->addFnAttr(llvm::Attribute::Cold);
+	fn->addFnAttr(llvm::Attribute::NoReturn);
+	fn->addFnAttr(llvm::Attribute::NoUnwind);
+    }
+    return f;
+}
+
+// Name of the floating point intrinsic llvm.<name> for the type ty, e.g. llvm.sqrt.f32.
+std::string FloatIntrinsicName(const std::string& name, llvm::Type* ty)
+{
+    if (ty->isFloatTy())
+    {
+	return "llvm." + name + ".f32";
+    }
+    if (ty->isX86_FP80Ty())
+    {
+	return "llvm." + name + ".f80";
+    }
+    if (ty->isFP128Ty())
+    {
+	return "llvm." + name + ".f128";
+    }
+    if (ty->isPPC_FP128Ty())
+    {
+	return "llvm." + name + ".ppcf128";
+    }
+    return "llvm." + name + ".f64";
+}
+
 static llvm::FunctionCallee GetFunction(Types::TypeDecl* res, const std::vector<llvm::Type*>& args,
                                         llvm::Value* callee)
 {
@@ -179,7 +222,7 @@ static llvm::AllocaInst* CreateNamedAlloca(llvm::Function* fn, Types::TypeDecl*
     llvm::IRBuilder<> bld(&fn->getEntryBlock(), fn->getEntryBlock().begin());
 
     ICE_IF(!ty, "Must have type passed in");
-    llvm::Type* type = ty->LlvmType();
+    llvm::Type* type = ty->StorageType();
 
     llvm::AllocaInst* a = bld.CreateAlloca(type, 0, name);
     size_t            align = std::max(ty->AlignSize(), MIN_ALIGN);
@@ -200,7 +243,12 @@ static llvm::AllocaInst* CreateAlloca(llvm::Function* fn, const VarDef& var)
 	fc->EnsureSized();
     }
 
-    return CreateNamedAlloca(fn, var.Type(), var.Name());
+    llvm::AllocaInst* a = CreateNamedAlloca(fn, var.Type(), var.Name());
+    if (a->getAlign().value() < var.Align())
+    {
+	a->setAlignment(llvm::Align(var.Align()));
+    }
+    return a;
 }
 
 llvm::AllocaInst* CreateTempAlloca(Types::TypeDecl* ty)
@@ -229,10 +277,34 @@ llvm::Value* MakeAddressable(ExprAST* e)
 
     llvm::Value* v = CreateTempAlloca(e->Type());
     ICE_IF(!v, "Code generation failed");
-    builder.CreateStore(store, v);
+    builder.CreateStore(ToStorage(e->Type(), store), v);
     return v;
 }
 
+llvm::Value* ToStorage(const Types::TypeDecl* ty, llvm::Value* v)
+{
+    llvm::Type* storeTy = ty->StorageType();
+    if (storeTy == ty->LlvmType())
+    {
+	return v;
+    }
+    return builder.CreateTrunc(v, storeTy);
+}
+
+llvm::Value* FromStorage(const Types::TypeDecl* ty, llvm::Value* v)
+{
+    llvm::Type* valueTy = ty->LlvmType();
+    if (v->getType() == valueTy)
+    {
+	return v;
+    }
+    if (ty->GetRange()->Start() < 0)
+    {
+	return builder.CreateSExt(v, valueTy);
+    }
+    return builder.CreateZExt(v, valueTy);
+}
+
 void ExprAST::dump() const
 {
     std::cerr << "Node=" << reinterpret_cast<const void*>(this) << ": ";
@@ -261,6 +333,22 @@ llvm::Constant* MakeConstant(uint64_t val, Types::TypeDecl* ty)
     return llvm::ConstantInt::get(ty->LlvmType(), val);
 }
 
+// The value of a constant integer expression, as wide as its type.
+llvm::APInt ConstantIntValue(IntegerExprAST* e)
+{
+    return llvm::APInt(64, e->Int()).zextOrTrunc(e->Type()->LlvmType()->getIntegerBitWidth());
+}
+
+ExprAST* MakeIntegerExpr(const Location& w, const llvm::APInt& v, Types::TypeDecl* ty)
+{
+    if (llvm::isa<Types::CharDecl>(ty))
+    {
+	return new CharExprAST(w, v.getZExtValue());
+    }
+    bool zext = IsUnsigned(ty) || v.getBitWidth() == 1;
+    return new IntegerExprAST(w, zext ? v.getZExtValue() : v.getSExtValue(), ty);
+}
+
 llvm::Constant* MakeIntegerConstant(int val)
 {
     return MakeConstant(val, Types::Get<Types::IntegerDecl>());
@@ -341,7 +429,7 @@ static llvm::Value* LoadOrMemcpy(llvm::Value* src, Types::TypeDecl* ty)
 	return dest;
     }
 
-    llvm::Type*  srcTy = ty->LlvmType();
+    llvm::Type*  srcTy = ty->StorageType();
     llvm::Value* v = builder.CreateLoad(srcTy, src, "src");
     builder.CreateStore(v, dest);
     return dest;
@@ -417,6 +505,50 @@ llvm::Value* CharExprAST::CodeGen()
     return MakeCharConstant(val);
 }
 
+// Fields of a packed record, and anything inside them, may not be aligned.
+bool IsPackedComponent(const ExprAST* e)
+{
+    ExprAST* base;
+    if (auto fe = llvm::dyn_cast<FieldExprAST>(e))
+    {
+	base = fe->Base();
+    }
+    else if (auto vfe = llvm::dyn_cast<VariantFieldExprAST>(e))
+    {
+	base = vfe->Base();
+    }
+    else if (auto ae = llvm::dyn_cast<ArrayExprAST>(e))
+    {
+	base = ae->Base();
+    }
+    else
+    {
+	return false;
+    }
+    auto rd = llvm::dyn_cast<Types::RecordDecl>(base->Type());
+    return (rd && rd->IsPacked()) || IsPackedComponent(base);
+}
+
+static llvm::MaybeAlign AlignmentOf(const ExprAST* e)
+{
+    if (IsPackedComponent(e))
+    {
+	return llvm::Align(1);
+    }
+    return llvm::MaybeAlign();
+}
+
+// The alignment of the address of e that its type guarantees.
+llvm::Align KnownAlignment(const ExprAST* e)
+{
+    if (IsPackedComponent(e))
+    {
+	return llvm::Align(1);
+    }
+    const llvm::DataLayout dl(theModule);
+    return dl.getABITypeAlign(e->Type()->StorageType());
+}
+
 llvm::Value* AddressableAST::CodeGen()
 {
     TRACE();
@@ -425,8 +557,8 @@ llvm::Value* AddressableAST::CodeGen()
 
     llvm::Value* v = Address();
     ICE_IF(!v, "Expected to get an address");
-    llvm::Type* ty = Type()->LlvmType();
-    return builder.CreateLoad(ty, v, Name());
+    llvm::Type* ty = Type()->StorageType();
+    return FromStorage(Type(), builder.CreateAlignedLoad(ty, v, AlignmentOf(this), Name()));
 }
 
 void VariableExprAST::DoDump() const
@@ -477,29 +609,11 @@ void ArrayExprAST::DoDump() const
     }
 }
 
-static Types::TypeDecl* FindIndexType(const std::vector<ExprAST*>& indices)
-{
-    ICE_IF(indices.size() == 0, "Expect at least one index");
-    Types::TypeDecl* type = indices[0]->Type();
-    size_t           size = type->Size();
-    for (size_t i = 1; i < indices.size(); i++)
-    {
-	if (size < indices[i]->Type()->Size())
-	{
-	    type = indices[i]->Type();
-	}
-    }
-    return type;
-}
-
-llvm::Value* ArrayExprAST::Address()
+// Index of the element from the start of the array, as if it was one-dimensional.
+llvm::Value* ArrayExprAST::Index()
 {
-    TRACE();
-    llvm::Value* v = MakeAddressable(expr);
-    ICE_IF(!v, "Expected variable to have an address");
-    EnsureSized();
     llvm::Value*     totalIndex = 0;
-    Types::TypeDecl* indexType = FindIndexType(indices);
+    Types::TypeDecl* indexType = Types::GetIndexType();
     for (size_t i = 0; i < indices.size(); i++)
     {
 	auto range = llvm::dyn_cast<RangeReduceAST>(indices[i]);
@@ -519,11 +633,138 @@ llvm::Value* ArrayExprAST::Address()
 	    totalIndex = builder.CreateAdd(totalIndex, index);
 	}
     }
-    llvm::Type* elemTy = Type()->LlvmType();
+    return totalIndex;
+}
+
+llvm::Value* ArrayExprAST::Address()
+{
+    TRACE();
+    llvm::Value* v = MakeAddressable(expr);
+    ICE_IF(!v, "Expected variable to have an address");
+    EnsureSized();
+    ICE_IF(IsBitPacked(), "Element of packed array has no address");
+    if (IsSoA())
+    {
+	// Reading a whole element: gather the fields into a temporary record.
+	llvm::Value* tmp = CreateTempAlloca(Type());
+	CopySoA(tmp, Index(), false);
+	return tmp;
+    }
+    llvm::Value* totalIndex = Index();
+    llvm::Type*  elemTy = Type()->StorageType();
     v = builder.CreateGEP(elemTy, v, totalIndex, "valueindex");
     return v;
 }
 
+bool ArrayExprAST::IsBitPacked() const
+{
+    auto aty = llvm::dyn_cast<Types::ArrayDecl>(expr->Type());
+    return aty && aty->BitsPerElement();
+}
+
+bool ArrayExprAST::IsSoA() const
+{
+    auto aty = llvm::dyn_cast<Types::ArrayDecl>(expr->Type());
+    return aty && aty->IsSoA();
+}
+
+llvm::Value* ArrayExprAST::FieldAddress(int element)
+{
+    llvm::Value* v = MakeAddressable(expr);
+    ICE_IF(!v, "Expected variable to have an address");
+    llvm::Type* ty = expr->Type()->LlvmType();
+    return builder.CreateGEP(ty, v, { MakeIntegerConstant(0), MakeIntegerConstant(element), Index() },
+                             "soaindex");
+}
+
+void ArrayExprAST::CopySoA(llvm::Value* rec, llvm::Value* index, bool toArray)
+{
+    auto         rd = llvm::cast<Types::RecordDecl>(Type());
+    llvm::Value* v = MakeAddressable(expr);
+    ICE_IF(!v, "Expected variable to have an address");
+    llvm::Type*  ty = expr->Type()->LlvmType();
+    llvm::Type*  recTy = rd->LlvmType();
+    llvm::Value* zero = MakeIntegerConstant(0);
+    for (int i = 0; i < rd->FieldCount(); i++)
+    {
+	llvm::Type*  fieldTy = rd->GetElement(i)->StorageType();
+	llvm::Value* column = builder.CreateGEP(ty, v, { zero, MakeIntegerConstant(i), index });
+	llvm::Value* field = builder.CreateGEP(recTy, rec, { zero, MakeIntegerConstant(rd->StructIndex(i)) });
+	llvm::Value* src = (toArray) ? field : column;
+	llvm::Value* dest = (toArray) ? column : field;
+	builder.CreateStore(builder.CreateLoad(fieldTy, src), dest);
+    }
+}
+
+llvm::Value* ArrayExprAST::CodeGen()
+{
+    if (!IsBitPacked())
+    {
+	return AddressableAST::CodeGen();
+    }
+    TRACE();
+    BasicDebugInfo(this);
+    llvm::Value* v = MakeAddressable(expr);
+    ICE_IF(!v, "Expected variable to have an address");
+    return LoadBitPacked(llvm::cast<Types::ArrayDecl>(expr->Type()), v, Index());
+}
+
+llvm::Value* ArrayExprAST::AssignBitPacked(llvm::Value* value)
+{
+    llvm::Value* v = MakeAddressable(expr);
+    ICE_IF(!v, "Expected variable to have an address");
+    StoreBitPacked(llvm::cast<Types::ArrayDecl>(expr->Type()), v, Index(), value);
+    return value;
+}
+
+// Elements of a bit-packed array never straddle a byte, so find the byte holding element number index, and
+// the position of the element's bits within that byte.
+static llvm::Value* BitPackedByte(Types::ArrayDecl* ty, llvm::Value* base, llvm::Value* index,
+                                  llvm::Value*& shift)
+{
+    llvm::Type*  int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Type*  byteTy = llvm::Type::getInt8Ty(theContext);
+    llvm::Value* bitIndex = builder.CreateZExtOrTrunc(index, int64Ty);
+    bitIndex = builder.CreateMul(bitIndex, llvm::ConstantInt::get(int64Ty, ty->BitsPerElement()));
+    llvm::Value* byteIndex = builder.CreateLShr(bitIndex, 3);
+    shift = builder.CreateTrunc(builder.CreateAnd(bitIndex, 7), byteTy);
+    return builder.CreateGEP(byteTy, base, byteIndex, "packedbyte");
+}
+
+llvm::Value* LoadBitPacked(Types::ArrayDecl* ty, llvm::Value* base, llvm::Value* index)
+{
+    llvm::Value* shift;
+    llvm::Value* bytePtr = BitPackedByte(ty, base, index, shift);
+    llvm::Type*  byteTy = llvm::Type::getInt8Ty(theContext);
+    llvm::Value* v = builder.CreateLoad(byteTy, bytePtr);
+    v = builder.CreateLShr(v, shift);
+    v = builder.CreateAnd(v, (1 << ty->BitsPerElement()) - 1);
+    Types::TypeDecl* elemTy = ty->SubType();
+    v = builder.CreateZExtOrTrunc(v, elemTy->LlvmType(), "unpacked");
+    if (int64_t start = elemTy->GetRange()->Start())
+    {
+	v = builder.CreateAdd(v, MakeConstant(start, elemTy));
+    }
+    return v;
+}
+
+void StoreBitPacked(Types::ArrayDecl* ty, llvm::Value* base, llvm::Value* index, llvm::Value* v)
+{
+    llvm::Value* shift;
+    llvm::Value* bytePtr = BitPackedByte(ty, base, index, shift);
+    llvm::Type*  byteTy = llvm::Type::getInt8Ty(theContext);
+    if (int64_t start = ty->SubType()->GetRange()->Start())
+    {
+	v = builder.CreateSub(v, MakeConstant(start, ty->SubType()));
+    }
+    v = builder.CreateShl(builder.CreateZExtOrTrunc(v, byteTy), shift);
+    llvm::Value* ones = llvm::ConstantInt::get(byteTy, (1 << ty->BitsPerElement()) - 1);
+    llvm::Value* mask = builder.CreateShl(ones, shift);
+    llvm::Value* old = builder.CreateLoad(byteTy, bytePtr);
+    old = builder.CreateAnd(old, builder.CreateNot(mask));
+    builder.CreateStore(builder.CreateOr(old, v), bytePtr);
+}
+
 void ArrayExprAST::accept(ASTVisitor& v)
 {
     for (auto i : indices)
@@ -549,13 +790,110 @@ llvm::Value* DynArrayExprAST::Address()
     llvm::Value* idx = index->CodeGen();
 
     llvm::Type* dynTy = Types::DynArrayDecl::GetArrayType(Type());
-    llvm::Type* elemTy = Type()->LlvmType();
+    llvm::Type* elemTy = Type()->StorageType();
     llvm::Type* elemPtrTy = llvm::PointerType::getUnqual(elemTy);
     v = builder.CreateGEP(dynTy, v, MakeIntegerConstant(0), "ptr");
     v = builder.CreateLoad(elemPtrTy, v, "ptrLoad");
     return builder.CreateGEP(elemTy, v, idx, "valueIndex");
 }
 
+// Stop with a range error unless low <= index < low + count. All three are 64-bit integers.
+void CreateRangeCheck(const Location& loc, llvm::Value* index, llvm::Value* low, llvm::Value* count)
+{
+    llvm::Type*       sizeTy = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Value*      offset = builder.CreateSub(index, low);
+    llvm::Value*      cmp = builder.CreateICmpUGE(offset, count, "rangecheck");
+    llvm::Function*   theFunction = builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* oorBlock = llvm::BasicBlock::Create(theContext, "out_of_range", theFunction);
+    llvm::BasicBlock* contBlock = llvm::BasicBlock::Create(theContext, "continue", theFunction);
+    llvm::MDNode*     weights = llvm::MDBuilder(theContext).createBranchWeights(1, LIKELY_WEIGHT);
+    builder.CreateCondBr(cmp, oorBlock, contBlock, weights);
+
+    builder.SetInsertPoint(oorBlock);
+    llvm::Type*               intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+    llvm::Type*               charTy = Types::Get<Types::CharDecl>()->LlvmType();
+    llvm::Type*               strTy = llvm::PointerType::getUnqual(charTy);
+    llvm::Value*              end = builder.CreateAdd(low, count);
+    llvm::Value*              high = builder.CreateSub(end, llvm::ConstantInt::get(sizeTy, 1));
+    std::vector<llvm::Value*> args = { builder.CreateGlobalStringPtr(loc.FileName()),
+	                               MakeIntegerConstant(loc.LineNumber()), low, high, index };
+    std::vector<llvm::Type*>  argTypes = { strTy, intTy, sizeTy, sizeTy, sizeTy };
+    builder.CreateCall(GetErrorFunction(argTypes, "range_error"), args, "");
+    builder.CreateUnreachable();
+    builder.SetInsertPoint(contBlock);
+}
+
+llvm::Value* HeapArrayExprAST::Address()
+{
+    TRACE();
+    llvm::Value* v = MakeAddressable(expr);
+    ICE_IF(!v, "Expected variable to have an address");
+    EnsureSized();
+
+    llvm::Type*  sizeTy = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Value* idx = index->CodeGen();
+    if (IsUnsigned(index->Type()))
+    {
+	idx = builder.CreateZExt(idx, sizeTy, "zext");
+    }
+    else
+    {
+	idx = builder.CreateSExt(idx, sizeTy, "sext");
+    }
+
+    llvm::Type* arrTy = expr->Type()->LlvmType();
+    if (rangeCheck)
+    {
+	llvm::Value* len = builder.CreateLoad(sizeTy, builder.CreateStructGEP(arrTy, v, 1), "len");
+	CreateRangeCheck(Loc(), idx, llvm::ConstantInt::get(sizeTy, 0), len);
+    }
+
+    llvm::Type*  elemTy = Type()->StorageType();
+    llvm::Value* data = builder.CreateLoad(llvm::PointerType::getUnqual(elemTy),
+                                           builder.CreateStructGEP(arrTy, v, 0), "data");
+    return builder.CreateGEP(elemTy, data, idx, "valueIndex");
+}
+
+void HeapArrayExprAST::accept(ASTVisitor& v)
+{
+    index->accept(v);
+    expr->accept(v);
+    v.visit(this);
+}
+
+void HeapArrayExprAST::DoDump() const
+{
+    std::cerr << "HeapArray: ";
+    expr->DoDump();
+    std::cerr << "[";
+    index->DoDump();
+    std::cerr << "]";
+}
+
+llvm::Value* MapExprAST::Address()
+{
+    TRACE();
+    auto         mty = llvm::cast<Types::MapDecl>(map->Type());
+    llvm::Value* slot = CallMapKeyFunc("Insert", map, key, Types::GetVoidPtrType());
+    return builder.CreateStructGEP(mty->SlotType(), slot, 1, "value");
+}
+
+void MapExprAST::accept(ASTVisitor& v)
+{
+    key->accept(v);
+    map->accept(v);
+    v.visit(this);
+}
+
+void MapExprAST::DoDump() const
+{
+    std::cerr << "Map: ";
+    map->DoDump();
+    std::cerr << "[";
+    key->DoDump();
+    std::cerr << "]";
+}
+
 void DynArrayExprAST::accept(ASTVisitor& v)
 {
     index->accept(v);
@@ -578,14 +916,32 @@ void FieldExprAST::DoDump() const
     expr->DoDump();
 }
 
+// Records may store their fields in a different order from the declaration.
+static int StructIndex(const Types::TypeDecl* ty, int element)
+{
+    if (auto rd = llvm::dyn_cast<Types::RecordDecl>(ty))
+    {
+	return rd->StructIndex(element);
+    }
+    return element;
+}
+
 llvm::Value* FieldExprAST::Address()
 {
     TRACE();
     EnsureSized();
+    if (auto ae = llvm::dyn_cast<ArrayExprAST>(expr))
+    {
+	if (ae->IsSoA())
+	{
+	    return ae->FieldAddress(element);
+	}
+    }
     llvm::Value* v = MakeAddressable(expr);
     ICE_IF(!v, "Expected MakeAddressable to have a value");
     llvm::Type* ty = expr->Type()->LlvmType();
-    return builder.CreateGEP(ty, v, { MakeIntegerConstant(0), MakeIntegerConstant(element) }, "valueindex");
+    int         index = StructIndex(expr->Type(), element);
+    return builder.CreateGEP(ty, v, { MakeIntegerConstant(0), MakeIntegerConstant(index) }, "valueindex");
 }
 
 void FieldExprAST::accept(ASTVisitor& v)
@@ -606,7 +962,8 @@ llvm::Value* VariantFieldExprAST::Address()
     EnsureSized();
     llvm::Value* v = MakeAddressable(expr);
     llvm::Type*  ty = expr->Type()->LlvmType();
-    v = builder.CreateGEP(ty, v, { MakeIntegerConstant(0), MakeIntegerConstant(element) }, "valueindex");
+    int          index = StructIndex(expr->Type(), element);
+    v = builder.CreateGEP(ty, v, { MakeIntegerConstant(0), MakeIntegerConstant(index) }, "valueindex");
     return builder.CreateBitCast(v, llvm::PointerType::getUnqual(Type()->LlvmType()));
 }
 
@@ -839,6 +1196,229 @@ llvm::Value* CallStrFunc(const std::string& name, ExprAST* lhs, ExprAST* rhs, Ty
     return builder.CreateCall(f, { lV, rV }, twine);
 }
 
+// Call one of the runtime functions for "array of T", adding the element size and nesting depth that
+// they all take after the given arguments.
+llvm::Value* CallHeapArrayFunc(const std::string& name, const Types::HeapArrayDecl* ty,
+                               std::vector<llvm::Value*> args)
+{
+    TRACE();
+    llvm::Type* sizeTy = Types::Get<Types::Int64Decl>()->LlvmType();
+    args.push_back(llvm::ConstantInt::get(sizeTy, ty->InnerType()->Size()));
+    args.push_back(MakeIntegerConstant(ty->Depth()));
+    std::vector<llvm::Type*> argTypes;
+    for (auto a : args)
+    {
+	argTypes.push_back(a->getType());
+    }
+    llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), argTypes,
+                                         "__DynArray" + name);
+    return builder.CreateCall(f, args);
+}
+
+// The result of a call or a conversion is a new dynamic array, map or bigint, which the receiver
+// takes over rather than copies.
+static bool IsOwnedValue(ExprAST* e)
+{
+    // A call is addressable, but what it returns belongs to nobody else.
+    if (llvm::isa<CallExprAST>(e))
+    {
+	return true;
+    }
+    // A conversion makes a new value, unless it only retypes a managed value that is owned elsewhere.
+    if (auto tc = llvm::dyn_cast<TypeCastAST>(e))
+    {
+	ExprAST* inner = tc->Expr();
+	return !Types::IsManaged(inner->Type()) || IsOwnedValue(inner);
+    }
+    return !llvm::isa<AddressableAST>(e);
+}
+
+static llvm::Value* MixHash(llvm::Value* h)
+{
+    llvm::Type* int64Ty = h->getType();
+    h = builder.CreateXor(h, builder.CreateLShr(h, 33));
+    h = builder.CreateMul(h, llvm::ConstantInt::get(int64Ty, 0xff51afd7ed558ccdULL));
+    return builder.CreateXor(h, builder.CreateLShr(h, 33));
+}
+
+// Hash of the key of type ty at p. Only the characters of a string and the fields of a record are
+// hashed, so unused characters and padding don't matter.
+static llvm::Value* HashKey(Types::TypeDecl* ty, llvm::Value* p)
+{
+    llvm::Type* int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    if (llvm::isa<Types::StringDecl>(ty))
+    {
+	llvm::Type*          charTy = Types::Get<Types::CharDecl>()->LlvmType();
+	llvm::Type*          ptrTy = Types::GetVoidPtrType();
+	llvm::Value*         len = builder.CreateZExt(builder.CreateLoad(charTy, p), int64Ty, "len");
+	llvm::Value*         chars = builder.CreateGEP(charTy, p, MakeIntegerConstant(1));
+	llvm::FunctionCallee f = GetFunction(int64Ty, { ptrTy, int64Ty }, "__MapHashBytes");
+	return builder.CreateCall(f, { chars, len });
+    }
+    if (auto rd = llvm::dyn_cast<Types::RecordDecl>(ty))
+    {
+	llvm::Value* h = llvm::ConstantInt::get(int64Ty, 0);
+	for (int i = 0; i < rd->FieldCount(); i++)
+	{
+	    llvm::Value* f = builder.CreateStructGEP(rd->LlvmType(), p, rd->StructIndex(i));
+	    h = builder.CreateMul(h, llvm::ConstantInt::get(int64Ty, 0x9e3779b97f4a7c15ULL));
+	    h = builder.CreateAdd(h, HashKey(rd->GetElement(i)->SubType(), f));
+	}
+	return h;
+    }
+    llvm::Value* v = builder.CreateLoad(ty->StorageType(), p);
+    return MixHash(builder.CreateZExt(v, int64Ty));
+}
+
+static llvm::Value* KeysEqual(Types::TypeDecl* ty, llvm::Value* a, llvm::Value* b)
+{
+    if (llvm::isa<Types::StringDecl>(ty))
+    {
+	llvm::Type*          intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	llvm::Type*          ptrTy = Types::GetVoidPtrType();
+	llvm::FunctionCallee f = GetFunction(intTy, { ptrTy, ptrTy }, "__StrCompare");
+	return builder.CreateICmpEQ(builder.CreateCall(f, { a, b }), MakeIntegerConstant(0));
+    }
+    if (auto rd = llvm::dyn_cast<Types::RecordDecl>(ty))
+    {
+	llvm::Value* eq = MakeBooleanConstant(true);
+	for (int i = 0; i < rd->FieldCount(); i++)
+	{
+	    llvm::Value* fa = builder.CreateStructGEP(rd->LlvmType(), a, rd->StructIndex(i));
+	    llvm::Value* fb = builder.CreateStructGEP(rd->LlvmType(), b, rd->StructIndex(i));
+	    eq = builder.CreateAnd(eq, KeysEqual(rd->GetElement(i)->SubType(), fa, fb));
+	}
+	return eq;
+    }
+    llvm::Type* storeTy = ty->StorageType();
+    return builder.CreateICmpEQ(builder.CreateLoad(storeTy, a), builder.CreateLoad(storeTy, b));
+}
+
+static llvm::Function* CreateMapFunction(llvm::Type* resTy, const std::vector<llvm::Type*>& args,
+                                         const std::string& name)
+{
+    llvm::FunctionType* ft = llvm::FunctionType::get(resTy, args, false);
+    llvm::Function*     fn = llvm::Function::Create(ft, llvm::Function::InternalLinkage, name, theModule);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(theContext, "entry", fn));
+    builder.SetCurrentDebugLocation(llvm::DebugLoc());
+    return fn;
+}
+
+// uint64_t hash(const void* key), called inline by the compiled code, and by the runtime when it
+// grows the table.
+static llvm::Function* MapHashFunction(Types::TypeDecl* keyTy)
+{
+    static std::map<Types::TypeDecl*, llvm::Function*> hashFns;
+    llvm::Function*&                                   fn = hashFns[keyTy];
+    if (!fn)
+    {
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Type*                           int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	fn = CreateMapFunction(int64Ty, { Types::GetVoidPtrType() }, "map.hash");
+	builder.CreateRet(HashKey(keyTy, fn->arg_begin()));
+    }
+    return fn;
+}
+
+// The runtime's description of a map type: the functions to hash and compare keys, and the size
+// of the keys and of the slots. Integral keys are compared by the runtime itself.
+static llvm::Constant* MapTypeInfo(const Types::MapDecl* mty)
+{
+    static std::map<const Types::MapDecl*, llvm::GlobalVariable*> infos;
+    llvm::GlobalVariable*&                                        gv = infos[mty];
+    if (gv)
+    {
+	return gv;
+    }
+    Types::TypeDecl* keyTy = mty->KeyType();
+    llvm::Type*      ptrTy = Types::GetVoidPtrType();
+    llvm::Type*      int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Constant*  equal = llvm::Constant::getNullValue(ptrTy);
+    if (!IsIntegral(keyTy))
+    {
+	llvm::IRBuilderBase::InsertPointGuard guard(builder);
+	llvm::Type*                           intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	llvm::Function*                       fn = CreateMapFunction(intTy, { ptrTy, ptrTy }, "map.equal");
+	auto                                  args = fn->arg_begin();
+	llvm::Value*                          eq = KeysEqual(keyTy, args, args + 1);
+	builder.CreateRet(builder.CreateZExt(eq, intTy));
+	equal = fn;
+    }
+    const llvm::DataLayout& dl = theModule->getDataLayout();
+    llvm::StructType*       infoTy = llvm::StructType::get(ptrTy, ptrTy, int64Ty, int64Ty);
+    llvm::Constant*         info = llvm::ConstantStruct::get(
+        infoTy, { MapHashFunction(keyTy), equal,
+                  llvm::ConstantInt::get(int64Ty, dl.getTypeAllocSize(keyTy->StorageType())),
+                  llvm::ConstantInt::get(int64Ty, dl.getTypeAllocSize(mty->SlotType())) });
+    gv = new llvm::GlobalVariable(*theModule, infoTy, true, llvm::GlobalValue::InternalLinkage, info,
+                                  "map.type");
+    return gv;
+}
+
+// The key is passed to the runtime in memory, with the layout of the key type. A shorter string
+// is copied, as the runtime copies the whole key into the slot.
+static llvm::Value* MapKeyAddress(ExprAST* key, Types::TypeDecl* keyTy)
+{
+    if (llvm::isa<Types::StringDecl>(keyTy))
+    {
+	llvm::Value*     s = MakeStringFromExpr(key, keyTy);
+	Types::TypeDecl* ty = key->Type();
+	if ((llvm::isa<Types::StringDecl>(ty) || llvm::isa<Types::CharDecl>(ty)) && !ty->SameAs(keyTy))
+	{
+	    llvm::Type*  ptrTy = Types::GetVoidPtrType();
+	    llvm::Type*  voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+	    llvm::Value* v = CreateTempAlloca(keyTy);
+	    builder.CreateCall(GetFunction(voidTy, { ptrTy, ptrTy }, "__StrAssign"), { v, s });
+	    s = v;
+	}
+	return s;
+    }
+    if (IsIntegral(keyTy))
+    {
+	llvm::Value* v = CreateTempAlloca(keyTy);
+	builder.CreateStore(ToStorage(keyTy, key->CodeGen()), v);
+	return v;
+    }
+    return MakeAddressable(key);
+}
+
+// Call one of the runtime functions that look up a key: Find, Insert or Remove.
+llvm::Value* CallMapKeyFunc(const std::string& name, ExprAST* map, ExprAST* key, llvm::Type* resTy)
+{
+    TRACE();
+    auto                 mty = llvm::cast<Types::MapDecl>(map->Type());
+    llvm::Type*          ptrTy = Types::GetVoidPtrType();
+    llvm::Type*          int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Value*         m = MakeAddressable(map);
+    llvm::Value*         k = MapKeyAddress(key, mty->KeyType());
+    llvm::Value*         hash = builder.CreateCall(MapHashFunction(mty->KeyType()), { k }, "hash");
+    llvm::FunctionCallee f = GetFunction(resTy, { ptrTy, ptrTy, ptrTy, int64Ty }, "__Map" + name);
+    return builder.CreateCall(f, { m, MapTypeInfo(mty), k, hash });
+}
+
+// Call the runtime function to free, assign or clone a dynamic array, a map or a bigint.
+llvm::Value* CallManagedFunc(const std::string& name, const Types::TypeDecl* ty,
+                             std::vector<llvm::Value*> args)
+{
+    if (auto hty = llvm::dyn_cast<Types::HeapArrayDecl>(ty))
+    {
+	return CallHeapArrayFunc(name, hty, args);
+    }
+    std::string prefix = "__Big";
+    if (auto mty = llvm::dyn_cast<Types::MapDecl>(ty))
+    {
+	args.push_back(MapTypeInfo(mty));
+	prefix = "__Map";
+    }
+    std::vector<llvm::Type*> argTypes;
+    for (auto a : args)
+    {
+	argTypes.push_back(a->getType());
+    }
+    llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), argTypes, prefix + name);
+    return builder.CreateCall(f, args);
+}
+
 static llvm::Value* CallStrCat(ExprAST* lhs, ExprAST* rhs)
 {
     TRACE();
@@ -899,6 +1479,15 @@ Types::TypeDecl* BinaryExprAST::Type() const
 {
     if (oper.IsCompare())
     {
+	// Comparing vectors gives a vector of booleans.
+	if (auto vty = llvm::dyn_cast_or_null<Types::VectorDecl>(lhs->Type()))
+	{
+	    return vty->MaskType();
+	}
+	if (auto vty = llvm::dyn_cast_or_null<Types::VectorDecl>(rhs->Type()))
+	{
+	    return vty->MaskType();
+	}
 	return Types::Get<Types::BoolDecl>();
     }
 
@@ -1106,7 +1695,7 @@ static llvm::Value* PowerInt(llvm::Value* base, llvm::Value* exp, Types::TypeDec
 
     llvm::Constant* one = MakeIntegerConstant(1);
     llvm::Constant* zero = MakeIntegerConstant(0);
-    llvm::Value*    res = CreateTempAlloca(ty);
+    llvm::Value*    res = CreateTempAlloca(Types::Get<Types::IntegerDecl>());
     builder.CreateStore(one, res);
     llvm::Type* intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
 
@@ -1239,7 +1828,7 @@ static llvm::Value* DoubleBinExpr(llvm::Value* l, llvm::Value* r, const Token& o
     case Token::Power:
     {
 	llvm::Type*               ty = type->LlvmType();
-	llvm::FunctionCallee      f = GetFunction(ty, { ty, ty }, "llvm.pow.f64");
+	llvm::FunctionCallee      f = GetFunction(ty, { ty, ty }, FloatIntrinsicName("pow", ty));
 	std::vector<llvm::Value*> args = { l, r };
 
 	return builder.CreateCall(f, args, "powtmp");
@@ -1386,6 +1975,120 @@ static llvm::Value* ComplexBinExpr(llvm::Value* l, llvm::Value* r, const Token&
     ICE("Unexpected complex expression");
 }
 
+// Address of a bigint operand. A new value, such as the result of another operation, is put
+// in a temporary, which is added to temps for the caller to free once it's done with it.
+static llvm::Value* BigIntOperand(ExprAST* e, std::vector<llvm::Value*>& temps)
+{
+    if (!IsOwnedValue(e))
+    {
+	return llvm::cast<AddressableAST>(e)->Address();
+    }
+    llvm::Value* v = CreateTempAlloca(Types::Get<Types::BigIntDecl>());
+    builder.CreateStore(e->CodeGen(), v);
+    temps.push_back(v);
+    return v;
+}
+
+static void FreeBigIntTemps(const std::vector<llvm::Value*>& temps)
+{
+    for (auto t : temps)
+    {
+	CallManagedFunc("Free", Types::Get<Types::BigIntDecl>(), { t });
+    }
+}
+
+static llvm::Value* BigIntBinExpr(ExprAST* lhs, ExprAST* rhs, const Token& oper)
+{
+    static const std::map<Token::TokenType, std::string> funcs = {
+	{ Token::Plus, "Add" }, { Token::Minus, "Sub" }, { Token::Multiply, "Mul" },
+	{ Token::Div, "Div" },  { Token::Mod, "Mod" },
+    };
+
+    Types::TypeDecl*          bigTy = Types::Get<Types::BigIntDecl>();
+    llvm::Type*               ptrTy = Types::GetVoidPtrType();
+    llvm::Type*               voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+    std::vector<llvm::Value*> temps;
+    llvm::Value*              l = BigIntOperand(lhs, temps);
+    llvm::Value*              res;
+    if (oper.GetToken() == Token::Pow)
+    {
+	llvm::Type*          int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	llvm::FunctionCallee f = GetFunction(voidTy, { ptrTy, ptrTy, int64Ty }, "__BigPow");
+	llvm::Value*         tmp = CreateTempAlloca(bigTy);
+	builder.CreateCall(f, { tmp, l, rhs->CodeGen() });
+	res = builder.CreateLoad(bigTy->LlvmType(), tmp);
+    }
+    else
+    {
+	llvm::Value* r = BigIntOperand(rhs, temps);
+	auto         it = funcs.find(oper.GetToken());
+	if (it == funcs.end())
+	{
+	    llvm::Type*          intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	    llvm::FunctionCallee f = GetFunction(intTy, { ptrTy, ptrTy }, "__BigCompare");
+	    res = MakeStrCompare(oper.GetToken(), builder.CreateCall(f, { l, r }, "cmp"));
+	}
+	else
+	{
+	    llvm::FunctionCallee f = GetFunction(voidTy, { ptrTy, ptrTy, ptrTy }, "__Big" + it->second);
+	    llvm::Value*         tmp = CreateTempAlloca(bigTy);
+	    builder.CreateCall(f, { tmp, l, r });
+	    res = builder.CreateLoad(bigTy->LlvmType(), tmp);
+	}
+    }
+    FreeBigIntTemps(temps);
+    return res;
+}
+
+// Generate a * b + c, a * b - c, c + a * b and c - a * b as llvm.fmuladd, which the backend
+// turns into a fused multiply-add where the target has one. Returns null for other expressions.
+llvm::Value* BinaryExprAST::FusedMulAdd()
+{
+    Token::TokenType op = oper.GetToken();
+    Types::TypeDecl* ty = Type();
+    if (auto vty = llvm::dyn_cast<Types::VectorDecl>(ty))
+    {
+	ty = vty->SubType();
+    }
+    if ((op != Token::Plus && op != Token::Minus) || !llvm::isa<Types::RealDecl>(ty))
+    {
+	return 0;
+    }
+
+    auto mul = llvm::dyn_cast<BinaryExprAST>(lhs);
+    bool mulFirst = mul && mul->oper.GetToken() == Token::Multiply;
+    if (!mulFirst)
+    {
+	mul = llvm::dyn_cast<BinaryExprAST>(rhs);
+	if (!mul || mul->oper.GetToken() != Token::Multiply)
+	{
+	    return 0;
+	}
+    }
+    if (!mul->Type()->SameAs(Type()))
+    {
+	return 0;
+    }
+
+    // Keep the left to right order of evaluation.
+    llvm::Value* c = (mulFirst) ? 0 : lhs->CodeGen();
+    llvm::Value* a = mul->lhs->CodeGen();
+    llvm::Value* b = mul->rhs->CodeGen();
+    if (mulFirst)
+    {
+	c = rhs->CodeGen();
+	if (op == Token::Minus)
+	{
+	    c = builder.CreateFNeg(c);
+	}
+    }
+    else if (op == Token::Minus)
+    {
+	a = builder.CreateFNeg(a);
+    }
+    return builder.CreateIntrinsic(llvm::Intrinsic::fmuladd, { a->getType() }, { a, b, c }, 0, "fmuladd");
+}
+
 llvm::Value* BinaryExprAST::CodeGen()
 {
     TRACE();
@@ -1397,6 +2100,12 @@ llvm::Value* BinaryExprAST::CodeGen()
 	this->dump();
     }
 
+    if (oper.GetToken() == Token::In && llvm::isa<Types::MapDecl>(rhs->Type()))
+    {
+	llvm::Value* slot = CallMapKeyFunc("Find", rhs, lhs, Types::GetVoidPtrType());
+	return builder.CreateIsNotNull(slot, "found");
+    }
+
     if (llvm::isa<SetExprAST>(rhs) || llvm::isa<SetExprAST>(lhs) ||
         (rhs->Type() && llvm::isa<Types::SetDecl>(rhs->Type())) ||
         (lhs->Type() && llvm::isa<Types::SetDecl>(lhs->Type())))
@@ -1453,6 +2162,11 @@ llvm::Value* BinaryExprAST::CodeGen()
 	break;
     }
 
+    if (llvm::isa<Types::BigIntDecl>(lhs->Type()))
+    {
+	return BigIntBinExpr(lhs, rhs, oper);
+    }
+
     if (llvm::isa<Types::ComplexDecl>(lhs->Type()))
     {
 	llvm::Value* la = MakeAddressable(lhs);
@@ -1474,6 +2188,14 @@ llvm::Value* BinaryExprAST::CodeGen()
 	return Error(this, "Unknown token: " + oper.ToString());
     }
 
+    if (fpContract == FPContractOn)
+    {
+	if (llvm::Value* v = FusedMulAdd())
+	{
+	    return v;
+	}
+    }
+
     llvm::Value* l = lhs->CodeGen();
     llvm::Value* r = rhs->CodeGen();
 
@@ -1483,8 +2205,8 @@ llvm::Value* BinaryExprAST::CodeGen()
     llvm::Type*                  rty = r->getType();
     ICE_IF(rty != lty, "Expect same types");
 
-    // Can compare for (in)equality with pointers and integers
-    if (rty->isIntegerTy() || rty->isPointerTy())
+    // Can compare for (in)equality with pointers and integers (or vectors of integers)
+    if (rty->isIntOrIntVectorTy() || rty->isPointerTy())
     {
 	switch (oper.GetToken())
 	{
@@ -1497,13 +2219,13 @@ llvm::Value* BinaryExprAST::CodeGen()
 	}
     }
 
-    if (rty->isIntegerTy())
+    if (rty->isIntOrIntVectorTy())
     {
 	auto v = IntegerBinExpr(l, r, oper, Type(), IsUnsigned(rhs->Type()));
 	ICE_IF(!v, "Binary expression should be valid");
 	return v;
     }
-    if (rty->isDoubleTy())
+    if (rty->getScalarType()->isFloatingPointTy())
     {
 	auto v = DoubleBinExpr(l, r, oper, Type());
 	ICE_IF(!v, "Binary expression should be valid");
@@ -1530,9 +2252,22 @@ llvm::Value* UnaryExprAST::CodeGen()
 
     BasicDebugInfo(this);
 
-    llvm::Value*       r = rhs->CodeGen();
-    llvm::Type::TypeID rty = r->getType()->getTypeID();
-    if (rty == llvm::Type::IntegerTyID)
+    if (llvm::isa<Types::BigIntDecl>(rhs->Type()) && oper.GetToken() == Token::Minus)
+    {
+	llvm::Type*               ptrTy = Types::GetVoidPtrType();
+	llvm::Type*               voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+	std::vector<llvm::Value*> temps;
+	llvm::Value*              v = BigIntOperand(rhs, temps);
+	llvm::FunctionCallee      f = GetFunction(voidTy, { ptrTy, ptrTy }, "__BigNeg");
+	llvm::Value*              res = CreateTempAlloca(rhs->Type());
+	builder.CreateCall(f, { res, v });
+	FreeBigIntTemps(temps);
+	return builder.CreateLoad(rhs->Type()->LlvmType(), res);
+    }
+
+    llvm::Value* r = rhs->CodeGen();
+    llvm::Type*  rty = r->getType()->getScalarType();
+    if (rty->isIntegerTy())
     {
 	switch (oper.GetToken())
 	{
@@ -1544,7 +2279,7 @@ llvm::Value* UnaryExprAST::CodeGen()
 	    break;
 	}
     }
-    if (rty == llvm::Type::DoubleTyID)
+    if (rty->isFloatingPointTy())
     {
 	if (oper.GetToken() == Token::Minus)
 	{
@@ -1574,8 +2309,35 @@ void CallExprAST::DoDump() const
     std::cerr << ")";
 }
 
+// A dynamic array given to a conformant array parameter by value is a copy, released after the call.
+using Release = std::pair<Types::HeapArrayDecl*, llvm::Value*>;
+
+// The dynamic arrays, maps and bigints returned by calls that only needed an address, such as
+// length(f()) or f()[i]. Nothing else owns them, so the calling function frees them when it returns.
+static std::vector<std::pair<Types::TypeDecl*, llvm::Value*>> callResults;
+
+// Describe the elements of the dynamic array at v as a conformant array indexed from zero.
+static llvm::Value* ConformantFromHeapArray(Types::TypeDecl* confTy, Types::HeapArrayDecl* hty,
+                                            llvm::Value* v)
+{
+    llvm::Type*  arrTy = hty->LlvmType();
+    llvm::Type*  dynTy = Types::DynArrayDecl::GetArrayType(hty->SubType());
+    llvm::Type*  ptrTy = llvm::PointerType::getUnqual(hty->SubType()->StorageType());
+    llvm::Type*  sizeTy = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Type*  intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+    llvm::Value* data = builder.CreateLoad(ptrTy, builder.CreateStructGEP(arrTy, v, 0), "data");
+    llvm::Value* len = builder.CreateLoad(sizeTy, builder.CreateStructGEP(arrTy, v, 1), "len");
+    llvm::Value* high = builder.CreateTrunc(builder.CreateSub(len, llvm::ConstantInt::get(sizeTy, 1)), intTy);
+
+    llvm::Value* x = CreateTempAlloca(confTy);
+    builder.CreateStore(data, builder.CreateStructGEP(dynTy, x, 0));
+    builder.CreateStore(MakeIntegerConstant(0), builder.CreateStructGEP(dynTy, x, 1));
+    builder.CreateStore(high, builder.CreateStructGEP(dynTy, x, 2));
+    return x;
+}
+
 static std::vector<llvm::Value*> CreateArgList(const std::vector<ExprAST*>& args,
-                                               const std::vector<VarDef>&   vdef)
+                                               const std::vector<VarDef>& vdef, std::vector<Release>& release)
 {
     std::vector<llvm::Value*> argsV;
     unsigned                  index = 0;
@@ -1607,7 +2369,7 @@ static std::vector<llvm::Value*> CreateArgList(const std::vector<ExprAST*>& args
 		{
 		    if (IsCompound(i->Type()))
 		    {
-			if (vi)
+			if (vi && !llvm::isa<CallExprAST>(i))
 			{
 			    v = LoadOrMemcpy(vi->Address(), vi->Type());
 			}
@@ -1627,10 +2389,24 @@ static std::vector<llvm::Value*> CreateArgList(const std::vector<ExprAST*>& args
 	    }
 	}
 	ICE_IF(!v, "Expect argument here");
-	if (llvm::isa<Types::DynArrayDecl>(vdef[index].Type()))
+	auto hty = llvm::dyn_cast<Types::HeapArrayDecl>(i->Type());
+	bool isTemp = IsOwnedValue(i);
+	if (hty && llvm::isa<Types::DynArrayDecl>(vdef[index].Type()))
+	{
+	    if (!vdef[index].IsRef())
+	    {
+		if (!isTemp)
+		{
+		    CallHeapArrayFunc("Clone", hty, { v });
+		}
+		release.push_back({ hty, v });
+	    }
+	    v = ConformantFromHeapArray(vdef[index].Type(), hty, v);
+	}
+	else if (llvm::isa<Types::DynArrayDecl>(vdef[index].Type()))
 	{
 	    auto        aty = llvm::dyn_cast<Types::ArrayDecl>(i->Type());
-	    llvm::Type* elemTy = aty->SubType()->LlvmType();
+	    llvm::Type* elemTy = aty->SubType()->StorageType();
 	    llvm::Type* ptrTy = llvm::PointerType::getUnqual(elemTy);
 
 	    llvm::Type* dynTy = Types::DynArrayDecl::GetArrayType(aty->SubType());
@@ -1652,6 +2428,11 @@ static std::vector<llvm::Value*> CreateArgList(const std::vector<ExprAST*>& args
 	    builder.CreateStore(high, hPtr);
 	    v = x;
 	}
+	else if (Types::IsManaged(i->Type()) && !vdef[index].IsRef() && !isTemp)
+	{
+	    // The function owns a dynamic array or map passed by value, and releases it when it returns.
+	    CallManagedFunc("Clone", i->Type(), { v });
+	}
 	argsV.push_back(v);
 	index++;
     }
@@ -1718,20 +2499,103 @@ llvm::Value* CallExprAST::CodeGen()
     ICE_IF(vdef.size() != args.size(), "Incorrect number of arguments for function");
 
     std::vector<llvm::Type*>  argTypes = CreateArgTypes(vdef);
-    std::vector<llvm::Value*> argsV = CreateArgList(args, vdef);
+    std::vector<Release>      release;
+    std::vector<llvm::Value*> argsV = CreateArgList(args, vdef, release);
     llvm::AttributeList       attrList = CreateAttrList(vdef);
 
     const char*      res = "";
     Types::TypeDecl* resType = proto->Type();
     if (!llvm::isa<Types::VoidDecl>(resType))
     {
-	res = "calltmp";
+	res = "calltmp";
+    }
+    llvm::FunctionCallee f = GetFunction(resType, argTypes, calleF);
+    std::string          problem = (tailCall) ? TailCallProblem(f.getFunctionType(), argsV) : "";
+    if (tailCall && problem.empty() && !release.empty())
+    {
+	problem = "arguments need work after the call";
+    }
+    if (!problem.empty())
+    {
+	Error(this, "Can't make tail call to '" + proto->Name() + "': " + problem);
+    }
+    llvm::CallInst* inst = builder.CreateCall(f, argsV, res);
+    inst->setAttributes(attrList);
+    for (auto r : release)
+    {
+	CallHeapArrayFunc("Free", r.first, { r.second });
+    }
+
+    if (tailCall && problem.empty())
+    {
+	inst->setTailCallKind(llvm::CallInst::TCK_MustTail);
+	if (llvm::isa<Types::VoidDecl>(resType))
+	{
+	    builder.CreateRetVoid();
+	}
+	else
+	{
+	    builder.CreateRet(inst);
+	}
+	// Whatever follows is never reached, but still needs a block to go in.
+	llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+	builder.SetInsertPoint(llvm::BasicBlock::Create(theContext, "aftertail", theFunction));
+    }
+    return inst;
+}
+
+llvm::Value* CallExprAST::Address()
+{
+    TRACE();
+    llvm::AllocaInst* a = CreateTempAlloca(Type());
+    if (Types::IsManaged(Type()))
+    {
+	// Start out empty, and release the previous result when a loop comes round again.
+	llvm::IRBuilder<> bld(a->getParent(), std::next(a->getIterator()));
+	bld.CreateStore(llvm::Constant::getNullValue(a->getAllocatedType()), a);
+	CallManagedFunc("Free", Type(), { a });
+	callResults.push_back({ Type(), a });
+    }
+    llvm::Value* v = CodeGen();
+    ICE_IF(!v, "Expected call to produce a value");
+    builder.CreateStore(ToStorage(Type(), v), a);
+    return a;
+}
+
+// A tail call reuses the caller's stack frame, so the callee must have the same signature, and can't be
+// given anything that lives in the caller's frame.
+std::string CallExprAST::TailCallProblem(llvm::FunctionType* ft, const std::vector<llvm::Value*>& argsV) const
+{
+    llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+    if (ft != theFunction->getFunctionType())
+    {
+	return "arguments or result differ from the calling function";
     }
-    llvm::FunctionCallee f = GetFunction(resType, argTypes, calleF);
-    llvm::CallInst*      inst = builder.CreateCall(f, argsV, res);
-    inst->setAttributes(attrList);
-
-    return inst;
+    if (!callerOwned.empty())
+    {
+	return "'" + callerOwned + "' must be released when the calling function returns";
+    }
+    if (!callResults.empty())
+    {
+	return "a call result must be released when the calling function returns";
+    }
+    const std::vector<VarDef>& vdef = proto->Args();
+    for (size_t i = 0; i < vdef.size(); i++)
+    {
+	if (vdef[i].IsClosure())
+	{
+	    return "it needs a closure";
+	}
+	if (!vdef[i].IsRef() && IsCompound(vdef[i].Type()))
+	{
+	    return "argument '" + vdef[i].Name() + "' is copied by value";
+	}
+	if (vdef[i].IsRef() && llvm::isa<llvm::AllocaInst>(llvm::getUnderlyingObject(argsV[i])))
+	{
+	    return "argument '" + vdef[i].Name() + "' refers to a local variable";
+	}
+    }
+    return "";
 }
 
 void CallExprAST::accept(ASTVisitor& v)
@@ -1927,7 +2791,7 @@ void PrototypeAST::CreateArgumentAlloca()
 	else
 	{
 	    a = CreateAlloca(llvmFunc, args[idx]);
-	    builder.CreateStore(&*ai, a);
+	    builder.CreateStore(ToStorage(args[idx].Type(), &*ai), a);
 	}
 	if (!variables.Add(args[idx].Name(), a))
 	{
@@ -1962,6 +2826,10 @@ void PrototypeAST::CreateArgumentAlloca()
     if (!llvm::isa<Types::VoidDecl>(type))
     {
 	llvm::AllocaInst* a = CreateAlloca(llvmFunc, VarDef(resname, type));
+	if (Types::IsManaged(type))
+	{
+	    builder.CreateStore(llvm::Constant::getNullValue(type->LlvmType()), a);
+	}
 	if (!variables.Add(resname, a))
 	{
 	    Error(this, "Duplicate function result name '" + resname + "'.");
@@ -2050,7 +2918,15 @@ bool PrototypeAST::IsMatchWithoutClosure(const PrototypeAST* rhs) const
 
 FunctionAST::FunctionAST(const Location& w, PrototypeAST* prot, const std::vector<VarDeclAST*>& v,
                          BlockAST* b)
-    : ExprAST(w, EK_Function), proto(prot), varDecls(v), body(b), parent(0), closureType(0)
+    : ExprAST(w, EK_Function)
+    , proto(prot)
+    , varDecls(v)
+    , body(b)
+    , parent(0)
+    , closureType(0)
+    , fastMathSetting(FastMathDefault)
+    , temperature(Normal)
+    , tailCalls(false)
 {
     ICE_IF(!proto->IsForward() && !body, "Function should be forward declared or have body");
     if (!proto->IsForward())
@@ -2101,6 +2977,83 @@ static llvm::DISubroutineType* CreateFunctionType(DebugInfo& di, PrototypeAST* p
     return di.builder->createSubroutineType(di.builder->getOrCreateTypeArray(eltTys));
 }
 
+bool FunctionAST::IsFastMath() const
+{
+    if (fastMathSetting != FastMathDefault)
+    {
+	return fastMathSetting == FastMathOn;
+    }
+    if (parent)
+    {
+	return parent->IsFastMath();
+    }
+    return fastMath;
+}
+
+// Fast-math flags for the floating point operations in a function, and the matching
+// function attributes, so that the backend also uses them.
+static llvm::FastMathFlags ApplyFastMath(llvm::Function* fn, bool fast)
+{
+    llvm::FastMathFlags fmf;
+    if (fast)
+    {
+	fmf.setFast();
+	fn->addFnAttr("unsafe-fp-math", "true");
+	fn->addFnAttr("no-infs-fp-math", "true");
+	fn->addFnAttr("no-signed-zeros-fp-math", "true");
+	fn->addFnAttr("approx-func-fp-math", "true");
+    }
+    if (fast || noHonorNaNs)
+    {
+	fmf.setNoNaNs();
+	fn->addFnAttr("no-nans-fp-math", "true");
+    }
+    if (fpContract == FPContractFast)
+    {
+	fmf.setAllowContract();
+    }
+    return fmf;
+}
+
+// Find the calls in tail position: the last statement of the body, or of the branches of an if-statement in
+// that position. In a function, that is an assignment of a call to the function result. A non-empty
+// owned is a variable that the calling function releases on return, which rules out a tail call.
+static void MarkTailCalls(ExprAST* e, const PrototypeAST* proto, const std::string& owned)
+{
+    if (!e)
+    {
+	return;
+    }
+    if (auto block = llvm::dyn_cast<BlockAST>(e))
+    {
+	if (!block->IsEmpty())
+	{
+	    MarkTailCalls(block->Content().back(), proto, owned);
+	}
+    }
+    else if (auto ifExpr = llvm::dyn_cast<IfExprAST>(e))
+    {
+	MarkTailCalls(ifExpr->Then(), proto, owned);
+	MarkTailCalls(ifExpr->Else(), proto, owned);
+    }
+    else if (auto call = llvm::dyn_cast<CallExprAST>(e))
+    {
+	if (llvm::isa<Types::VoidDecl>(proto->Type()))
+	{
+	    call->SetTailCall(owned);
+	}
+    }
+    else if (auto assign = llvm::dyn_cast<AssignExprAST>(e))
+    {
+	auto var = llvm::dyn_cast<VariableExprAST>(assign->Lhs());
+	auto call = llvm::dyn_cast<CallExprAST>(assign->Rhs());
+	if (var && call && var->Name() == proto->ResName())
+	{
+	    call->SetTailCall(owned);
+	}
+    }
+}
+
 llvm::Function* FunctionAST::CodeGen(const std::string& namePrefix)
 {
     TRACE();
@@ -2115,6 +3068,19 @@ llvm::Function* FunctionAST::CodeGen(const std::string& namePrefix)
 	return theFunction;
     }
 
+    llvm::IRBuilderBase::FastMathFlagGuard fmfGuard(builder);
+    llvm::FastMathFlags                    fmf = ApplyFastMath(theFunction, IsFastMath());
+    if (temperature == Hot)
+    {
+	theFunction->addFnAttr(llvm::Attribute::Hot);
+    }
+    else if (temperature == Cold)
+    {
+	// Calls to it are treated as unlikely, and the function itself is optimised for size.
+	theFunction->addFnAttr(llvm::Attribute::Cold);
+	theFunction->addFnAttr(llvm::Attribute::OptimizeForSize);
+    }
+
     if (debugInfo)
     {
 	DebugInfo&              di = GetDebugInfo();
@@ -2163,6 +3129,32 @@ llvm::Function* FunctionAST::CodeGen(const std::string& namePrefix)
 	di.EmitLocation(body->Loc());
     }
     builder.SetInsertPoint(bb, ip);
+    builder.setFastMathFlags(fmf);
+    // The dynamic arrays, maps and bigints owned by the function. The result is handed over to the caller.
+    std::vector<VarDef> owned;
+    for (auto& a : proto->Args())
+    {
+	if (!a.IsRef() && !a.IsClosure() && Types::IsManaged(a.Type()))
+	{
+	    owned.push_back(a);
+	}
+    }
+    for (auto d : varDecls)
+    {
+	for (auto& v : d->Vars())
+	{
+	    if (Types::IsManaged(v.Type()))
+	    {
+		owned.push_back(v);
+	    }
+	}
+    }
+    if (tailCalls)
+    {
+	MarkTailCalls(body, proto, owned.empty() ? "" : owned.front().Name());
+    }
+    std::vector<std::pair<Types::TypeDecl*, llvm::Value*>> outerResults;
+    std::swap(outerResults, callResults);
     llvm::Value* block = body->CodeGen();
     ICE_IF(!block && !body->IsEmpty(), "Failed to generate function body");
 
@@ -2172,6 +3164,15 @@ llvm::Function* FunctionAST::CodeGen(const std::string& namePrefix)
 	DebugInfo& di = GetDebugInfo();
 	di.EmitLocation(endLoc);
     }
+    for (auto& v : owned)
+    {
+	CallManagedFunc("Free", v.Type(), { variables.Find(v.Name()) });
+    }
+    for (auto& r : callResults)
+    {
+	CallManagedFunc("Free", r.first, { r.second });
+    }
+    callResults = std::move(outerResults);
     if (llvm::isa<Types::VoidDecl>(proto->Type()))
     {
 	builder.CreateRetVoid();
@@ -2181,8 +3182,8 @@ llvm::Function* FunctionAST::CodeGen(const std::string& namePrefix)
 	std::string  shortname = proto->ResName();
 	llvm::Value* v = variables.Find(shortname);
 	ICE_IF(!v, "Expect function result 'variable' to exist");
-	llvm::Type*  ty = proto->Type()->LlvmType();
-	llvm::Value* retVal = builder.CreateLoad(ty, v, shortname);
+	llvm::Type*  ty = proto->Type()->StorageType();
+	llvm::Value* retVal = FromStorage(proto->Type(), builder.CreateLoad(ty, v, shortname));
 	builder.CreateRet(retVal);
     }
 
@@ -2192,7 +3193,7 @@ llvm::Function* FunctionAST::CodeGen(const std::string& namePrefix)
 	di.lexicalBlocks.pop_back();
     }
 
-    if (!debugInfo && body && emitType != LlvmIr)
+    if (!debugInfo && !fastCompile && body && emitType != LlvmIr)
     {
 	llvm::raw_os_ostream err(std::cerr);
 #if !NDEBUG
@@ -2274,6 +3275,15 @@ llvm::Value* AssignExprAST::AssignStr()
     }
 
     ICE_IF(!llvm::isa<Types::StringDecl>(rhs->Type()), "Expect string for rhs expression");
+    if (valueFirst)
+    {
+	llvm::Type*          ptrTy = Types::GetVoidPtrType();
+	llvm::FunctionCallee f =
+	    GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), { ptrTy, ptrTy }, "__StrAssign");
+	llvm::Value* v = CreateTempAlloca(rhs->Type());
+	builder.CreateCall(f, { v, MakeAddressable(rhs) });
+	return builder.CreateCall(f, { lhsv->Address(), v });
+    }
     return CallStrFunc("Assign", lhs, rhs, Types::Get<Types::VoidDecl>(), "");
 }
 
@@ -2288,6 +3298,22 @@ llvm::Value* AssignExprAST::AssignSet()
     return v;
 }
 
+// Assigning a dynamic array or map copies the content. The result of a function call is already a
+// copy, so it replaces the old content without copying again.
+llvm::Value* AssignExprAST::AssignManaged()
+{
+    Types::TypeDecl* ty = lhs->Type();
+    llvm::Value*     dest = llvm::cast<AddressableAST>(lhs)->Address();
+    if (!IsOwnedValue(rhs))
+    {
+	return CallManagedFunc("Assign", ty, { dest, llvm::cast<AddressableAST>(rhs)->Address() });
+    }
+    llvm::Value* v = rhs->CodeGen();
+    CallManagedFunc("Free", ty, { dest });
+    builder.CreateStore(v, dest);
+    return v;
+}
+
 llvm::Value* AssignExprAST::CodeGen()
 {
     TRACE();
@@ -2307,6 +3333,11 @@ llvm::Value* AssignExprAST::CodeGen()
 	return AssignSet();
     }
 
+    if (Types::IsManaged(lhsv->Type()))
+    {
+	return AssignManaged();
+    }
+
     if (llvm::isa<StringExprAST>(rhs) && Types::IsCharArray(lhs->Type()))
     {
 	auto str = llvm::dyn_cast<StringExprAST>(rhs);
@@ -2320,26 +3351,65 @@ llvm::Value* AssignExprAST::CodeGen()
 	return builder.CreateMemCpy(dest1, dest_align, v, src_align, str->Str().size());
     }
 
+    if (auto ae = llvm::dyn_cast<ArrayExprAST>(lhs))
+    {
+	if (ae->IsBitPacked())
+	{
+	    return ae->AssignBitPacked(rhs->CodeGen());
+	}
+	if (ae->IsSoA())
+	{
+	    llvm::Value* src = MakeAddressable(rhs);
+	    ae->CopySoA(src, ae->Index(), true);
+	    return src;
+	}
+    }
+
+    if (valueFirst && !llvm::isa<Types::VectorDecl>(rhs->Type()))
+    {
+	llvm::Value* v = rhs->CodeGen();
+	builder.CreateAlignedStore(ToStorage(lhs->Type(), v), lhsv->Address(), AlignmentOf(lhs));
+	return v;
+    }
+
     llvm::Value* dest = lhsv->Address();
 
+    // Storing a vector to an array (or slice) only guarantees the alignment of the elements.
+    if (auto vty = llvm::dyn_cast<Types::VectorDecl>(rhs->Type()))
+    {
+	if (!llvm::isa<Types::VectorDecl>(lhs->Type()))
+	{
+	    llvm::Value* v = rhs->CodeGen();
+	    builder.CreateAlignedStore(v, dest, llvm::Align(vty->SubType()->AlignSize()));
+	    return v;
+	}
+    }
+
+    // Clearing a whole array or record, as with default() of a type without an initial value.
+    auto init = llvm::dyn_cast<InitValueAST>(rhs);
+    if (init && init->IsZero() && lhs->Type()->StorageType()->isAggregateType())
+    {
+	llvm::Value* zero = MakeConstant(0, Types::Get<Types::CharDecl>());
+	return builder.CreateMemSet(dest, zero, lhs->Type()->Size(), KnownAlignment(lhs));
+    }
+
     // If rhs is a simple variable, and "large", then use memcpy on it!
     size_t size = rhs->Type()->Size();
-    if (!disableMemcpyOpt && size >= MEMCPY_THRESHOLD)
+    if (!disableMemcpyOpt && size >= MEMCPY_THRESHOLD &&
+        !llvm::isa<Types::VectorDecl, Types::RealDecl>(lhs->Type()))
     {
 	if (auto rhsv = llvm::dyn_cast<AddressableAST>(rhs))
 	{
 	    if (rhsv->Type() == lhsv->Type())
 	    {
 		llvm::Value* src = rhsv->Address();
-		llvm::Align  dest_align{ std::max(AlignOfType(dest->getType()), MIN_ALIGN) };
-		llvm::Align  src_align{ std::max(AlignOfType(src->getType()), MIN_ALIGN) };
-		return builder.CreateMemCpy(dest, dest_align, src, src_align, size);
+		return builder.CreateMemCpy(dest, KnownAlignment(lhs), src, KnownAlignment(rhs), size);
 	    }
 	}
     }
 
     llvm::Value* v = rhs->CodeGen();
-    builder.CreateStore(v, dest);
+    builder.CreateAlignedStore(ToStorage(lhs->Type(), v), dest, AlignmentOf(lhs));
     return v;
 }
 
@@ -2422,6 +3492,10 @@ llvm::Value* IfExprAST::CodeGen()
 
 void ForExprAST::DoDump() const
 {
+    if (parallelFn)
+    {
+	std::cerr << "parallel ";
+    }
     std::cerr << "for: " << std::endl;
     start->DoDump();
     if (stepDown)
@@ -2445,9 +3519,74 @@ void ForExprAST::accept(ASTVisitor& v)
 	end->accept(v);
     }
     body->accept(v);
+    for (auto r : reductions)
+    {
+	r.var->accept(v);
+    }
     v.visit(this);
 }
 
+// Attach the loop hints as llvm.loop metadata to the branch back to the start of the loop. If the
+// optimiser can't do what was asked for, it warns about it.
+static void AddLoopMetadata(llvm::Instruction* backEdge, const LoopHints& hints)
+{
+    std::vector<llvm::Metadata*> md = { nullptr };
+    auto                         addFlag = [&](const char* name)
+    { md.push_back(llvm::MDNode::get(theContext, llvm::MDString::get(theContext, name))); };
+    auto addValue = [&](const char* name, llvm::Constant* v)
+    {
+	md.push_back(llvm::MDNode::get(
+	    theContext, { llvm::MDString::get(theContext, name), llvm::ConstantAsMetadata::get(v) }));
+    };
+    llvm::Type* i32Ty = llvm::Type::getInt32Ty(theContext);
+
+    switch (hints.unroll)
+    {
+    case LoopHints::Hint::Default:
+	break;
+    case LoopHints::Hint::Enable:
+	if (hints.unrollCount)
+	{
+	    addValue("llvm.loop.unroll.count", llvm::ConstantInt::get(i32Ty, hints.unrollCount));
+	}
+	else
+	{
+	    addFlag("llvm.loop.unroll.enable");
+	}
+	break;
+    case LoopHints::Hint::Full:
+	addFlag("llvm.loop.unroll.full");
+	break;
+    case LoopHints::Hint::Disable:
+	addFlag("llvm.loop.unroll.disable");
+	break;
+    }
+    if (hints.vectorize != LoopHints::Hint::Default)
+    {
+	addValue("llvm.loop.vectorize.enable",
+	         llvm::ConstantInt::getBool(theContext, hints.vectorize == LoopHints::Hint::Enable));
+    }
+    if (hints.width)
+    {
+	addValue("llvm.loop.vectorize.width", llvm::ConstantInt::get(i32Ty, hints.width));
+    }
+    if (hints.interleave)
+    {
+	addValue("llvm.loop.interleave.count", llvm::ConstantInt::get(i32Ty, hints.interleave));
+    }
+    if (hints.distribute)
+    {
+	addValue("llvm.loop.distribute.enable", llvm::ConstantInt::getTrue(theContext));
+    }
+
+    if (md.size() > 1)
+    {
+	llvm::MDNode* loopID = llvm::MDNode::getDistinct(theContext, md);
+	loopID->replaceOperandWith(0, loopID);
+	backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+    }
+}
+
 llvm::Value* ForExprAST::ForInGen()
 {
     llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
@@ -2520,7 +3659,7 @@ llvm::Value* ForExprAST::ForInGen()
 
     llvm::Value* sumVar = builder.CreateAdd(builder.CreateAdd(pos, builder.CreateShl(idxPhi, shift)),
                                             MakeIntegerConstant(rangeStart));
-    llvm::Value* sumT = builder.CreateTrunc(sumVar, variable->Type()->LlvmType());
+    llvm::Value* sumT = builder.CreateTrunc(sumVar, variable->Type()->StorageType());
     builder.CreateStore(sumT, var);
 
     ICE_IF(!body->CodeGen(), "Failed to generate loop body");
@@ -2528,7 +3667,7 @@ llvm::Value* ForExprAST::ForInGen()
     bitset = builder.CreateAnd(phi, builder.CreateNot(builder.CreateShl(one, pos)));
     isZero = builder.CreateICmpEQ(bitset, zero);
     phi->addIncoming(bitset, loopBB);
-    builder.CreateCondBr(isZero, nextLoopBB, loopBB);
+    AddLoopMetadata(builder.CreateCondBr(isZero, nextLoopBB, loopBB), hints);
 
     builder.SetInsertPoint(nextLoopBB);
     index = builder.CreateAdd(idxPhi, one);
@@ -2540,6 +3679,57 @@ llvm::Value* ForExprAST::ForInGen()
     return afterBB;
 }
 
+// The runtime steps through the slots that are in use, and the key is copied from each one to the
+// loop variable. Adding or removing keys in the loop body may skip or repeat keys.
+llvm::Value* ForExprAST::ForInMapGen()
+{
+    llvm::Function*  theFunction = builder.GetInsertBlock()->getParent();
+    auto             mty = llvm::cast<Types::MapDecl>(start->Type());
+    Types::TypeDecl* keyTy = mty->KeyType();
+    Types::TypeDecl* varTy = variable->Type();
+    llvm::Type*      ptrTy = Types::GetVoidPtrType();
+    llvm::Type*      int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::Value*     m = MakeAddressable(start);
+    llvm::Value*     var = variable->Address();
+    ICE_IF(!var, "Expected variable here");
+    llvm::Value* pos = CreateTempAlloca(Types::Get<Types::Int64Decl>());
+    builder.CreateStore(llvm::ConstantInt::get(int64Ty, 0), pos);
+
+    llvm::FunctionCallee next = GetFunction(ptrTy, { ptrTy, ptrTy, ptrTy }, "__MapNext");
+    llvm::BasicBlock*    loopBB = llvm::BasicBlock::Create(theContext, "loop", theFunction);
+    llvm::BasicBlock*    bodyBB = llvm::BasicBlock::Create(theContext, "body", theFunction);
+    llvm::BasicBlock*    afterBB = llvm::BasicBlock::Create(theContext, "afterloop", theFunction);
+    builder.CreateBr(loopBB);
+
+    builder.SetInsertPoint(loopBB);
+    llvm::Value* slot = builder.CreateCall(next, { m, MapTypeInfo(mty), pos }, "slot");
+    builder.CreateCondBr(builder.CreateIsNull(slot), afterBB, bodyBB);
+
+    builder.SetInsertPoint(bodyBB);
+    if (IsIntegral(keyTy))
+    {
+	llvm::Value* k = FromStorage(keyTy, builder.CreateLoad(keyTy->StorageType(), slot));
+	k = builder.CreateIntCast(k, varTy->LlvmType(), !IsUnsigned(keyTy));
+	builder.CreateStore(ToStorage(varTy, k), var);
+    }
+    else if (llvm::isa<Types::StringDecl>(keyTy))
+    {
+	llvm::Type* voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+	builder.CreateCall(GetFunction(voidTy, { ptrTy, ptrTy }, "__StrAssign"), { var, slot });
+    }
+    else
+    {
+	llvm::Align align{ MIN_ALIGN };
+	builder.CreateMemCpy(var, align, slot, align, keyTy->Size());
+    }
+    ICE_IF(!body->CodeGen(), "Failed to generate loop body");
+    AddLoopMetadata(builder.CreateBr(loopBB), hints);
+
+    builder.SetInsertPoint(afterBB);
+    BasicDebugInfo(this);
+    return afterBB;
+}
+
 llvm::Value* ForExprAST::CodeGen()
 {
     TRACE();
@@ -2548,9 +3738,18 @@ llvm::Value* ForExprAST::CodeGen()
     // for x in set has no end.
     if (!end)
     {
+	if (llvm::isa<Types::MapDecl>(start->Type()))
+	{
+	    return ForInMapGen();
+	}
 	return ForInGen();
     }
 
+    if (parallelFn)
+    {
+	return ParallelGen();
+    }
+
     llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
     llvm::Value*    var = variable->Address();
     ICE_IF(!var, "Expected variable here");
@@ -2560,7 +3759,7 @@ llvm::Value* ForExprAST::CodeGen()
     llvm::Value* endV = end->CodeGen();
     ICE_IF(!endV, "Expected end to generate code");
     llvm::Value* stepVal = MakeConstant((stepDown) ? -1 : 1, start->Type());
-    builder.CreateStore(startV, var);
+    builder.CreateStore(ToStorage(variable->Type(), startV), var);
 
     llvm::BasicBlock* beforeBB = llvm::BasicBlock::Create(theContext, "before", theFunction);
     llvm::BasicBlock* loopBB = llvm::BasicBlock::Create(theContext, "loop", theFunction);
@@ -2568,7 +3767,8 @@ llvm::Value* ForExprAST::CodeGen()
     llvm::BasicBlock* afterBB = llvm::BasicBlock::Create(theContext, "afterloop", theFunction);
 
     llvm::Type*  ty = variable->Type()->LlvmType();
-    llvm::Value* curVar = builder.CreateLoad(ty, var, variable->Name());
+    llvm::Value* curVar = builder.CreateLoad(variable->Type()->StorageType(), var, variable->Name());
+    curVar = FromStorage(variable->Type(), curVar);
 
     builder.CreateBr(beforeBB);
     builder.SetInsertPoint(beforeBB);
@@ -2631,9 +3831,9 @@ llvm::Value* ForExprAST::CodeGen()
     builder.CreateBr(continueBB);
     builder.SetInsertPoint(continueBB);
     curVar = builder.CreateAdd(phi, stepVal, "nextvar");
-    builder.CreateStore(curVar, var);
+    builder.CreateStore(ToStorage(variable->Type(), curVar), var);
     phi->addIncoming(curVar, continueBB);
-    builder.CreateCondBr(endCond, loopBB, afterBB);
+    AddLoopMetadata(builder.CreateCondBr(endCond, loopBB, afterBB), hints);
 
     BasicDebugInfo(this);
 
@@ -2642,6 +3842,195 @@ llvm::Value* ForExprAST::CodeGen()
     return afterBB;
 }
 
+static llvm::Constant* ReductionIdentity(ForExprAST::ReduceOp op, Types::TypeDecl* ty)
+{
+    llvm::Type* llvmTy = ty->LlvmType();
+    if (llvm::isa<Types::RealDecl>(ty))
+    {
+	switch (op)
+	{
+	case ForExprAST::ReduceOp::Add:
+	    return llvm::ConstantFP::get(llvmTy, 0.0);
+	case ForExprAST::ReduceOp::Mul:
+	    return llvm::ConstantFP::get(llvmTy, 1.0);
+	case ForExprAST::ReduceOp::Min:
+	    return llvm::ConstantFP::getInfinity(llvmTy, false);
+	case ForExprAST::ReduceOp::Max:
+	    return llvm::ConstantFP::getInfinity(llvmTy, true);
+	}
+    }
+    unsigned bits = llvmTy->getIntegerBitWidth();
+    switch (op)
+    {
+    case ForExprAST::ReduceOp::Add:
+	return llvm::ConstantInt::get(llvmTy, 0);
+    case ForExprAST::ReduceOp::Mul:
+	return llvm::ConstantInt::get(llvmTy, 1);
+    case ForExprAST::ReduceOp::Min:
+	return llvm::ConstantInt::get(llvmTy, IsUnsigned(ty) ? llvm::APInt::getMaxValue(bits)
+	                                                     : llvm::APInt::getSignedMaxValue(bits));
+    case ForExprAST::ReduceOp::Max:
+	return llvm::ConstantInt::get(llvmTy, IsUnsigned(ty) ? llvm::APInt::getMinValue(bits)
+	                                                     : llvm::APInt::getSignedMinValue(bits));
+    }
+    ICE("Unknown reduction operator");
+}
+
+static llvm::Value* ReductionCombine(ForExprAST::ReduceOp op, Types::TypeDecl* ty, llvm::Value* a,
+                                     llvm::Value* b)
+{
+    if (llvm::isa<Types::RealDecl>(ty))
+    {
+	switch (op)
+	{
+	case ForExprAST::ReduceOp::Add:
+	    return builder.CreateFAdd(a, b, "redadd");
+	case ForExprAST::ReduceOp::Mul:
+	    return builder.CreateFMul(a, b, "redmul");
+	case ForExprAST::ReduceOp::Min:
+	    return builder.CreateMinNum(a, b, "redmin");
+	case ForExprAST::ReduceOp::Max:
+	    return builder.CreateMaxNum(a, b, "redmax");
+	}
+    }
+    llvm::Value* sel;
+    switch (op)
+    {
+    case ForExprAST::ReduceOp::Add:
+	return builder.CreateAdd(a, b, "redadd");
+    case ForExprAST::ReduceOp::Mul:
+	return builder.CreateMul(a, b, "redmul");
+    case ForExprAST::ReduceOp::Min:
+	sel = IsUnsigned(ty) ? builder.CreateICmpULT(a, b, "sel") : builder.CreateICmpSLT(a, b, "sel");
+	return builder.CreateSelect(sel, a, b, "redmin");
+    case ForExprAST::ReduceOp::Max:
+	sel = IsUnsigned(ty) ? builder.CreateICmpUGT(a, b, "sel") : builder.CreateICmpSGT(a, b, "sel");
+	return builder.CreateSelect(sel, a, b, "redmax");
+    }
+    ICE("Unknown reduction operator");
+}
+
+/* The runtime calls the thunk as thunk(ctx, lo, hi) for each chunk of the iteration space.
+ * ctx holds the closure of the outlined body and the address of each reduction variable.
+ * Reductions are accumulated in locals for the chunk, and merged under the runtime's lock.
+ */
+llvm::Function* ForExprAST::ParallelThunk(llvm::StructType* ctxTy)
+{
+    TRACE();
+    llvm::IRBuilderBase::InsertPointGuard guard(builder);
+    builder.SetCurrentDebugLocation(llvm::DebugLoc());
+
+    llvm::Function* bodyFn = parallelFn->Proto()->LlvmFunction();
+    ICE_IF(!bodyFn, "Expected parallel body to be generated already");
+
+    llvm::Type*         voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+    llvm::Type*         ptrTy = Types::GetVoidPtrType();
+    llvm::Type*         int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    llvm::FunctionType* ft = llvm::FunctionType::get(voidTy, { ptrTy, int64Ty, int64Ty }, false);
+    llvm::Function*     thunk = llvm::Function::Create(ft, llvm::Function::InternalLinkage,
+                                                       bodyFn->getName() + ".thunk", theModule);
+    llvm::BasicBlock*   bb = llvm::BasicBlock::Create(theContext, "entry", thunk);
+    builder.SetInsertPoint(bb);
+
+    auto         ai = thunk->arg_begin();
+    llvm::Value* ctx = &*ai++;
+    llvm::Value* lo = &*ai++;
+    llvm::Value* hi = &*ai;
+
+    std::vector<llvm::Value*> args;
+    if (parallelFn->ClosureType())
+    {
+	llvm::Value* p = builder.CreateGEP(ctxTy, ctx, { MakeIntegerConstant(0), MakeIntegerConstant(0) });
+	args.push_back(builder.CreateLoad(ptrTy, p, "closure"));
+    }
+    llvm::Type* varTy = variable->Type()->LlvmType();
+    args.push_back(builder.CreateTrunc(lo, varTy, "lo"));
+    args.push_back(builder.CreateTrunc(hi, varTy, "hi"));
+
+    std::vector<llvm::Value*> accs;
+    for (auto r : reductions)
+    {
+	Types::TypeDecl* ty = r.var->Type();
+	llvm::Value*     acc = builder.CreateAlloca(ty->StorageType(), 0, r.var->Name());
+	builder.CreateStore(ToStorage(ty, ReductionIdentity(r.op, ty)), acc);
+	accs.push_back(acc);
+	args.push_back(acc);
+    }
+    builder.CreateCall(bodyFn, args);
+
+    if (!reductions.empty())
+    {
+	llvm::FunctionCallee lock = GetFunction(voidTy, {}, "__ParForLock");
+	llvm::FunctionCallee unlock = GetFunction(voidTy, {}, "__ParForUnlock");
+	builder.CreateCall(lock);
+	for (size_t i = 0; i < reductions.size(); i++)
+	{
+	    Types::TypeDecl* ty = reductions[i].var->Type();
+	    llvm::Type*      llvmTy = ty->StorageType();
+	    llvm::Value*     p = builder.CreateGEP(ctxTy, ctx,
+	                                           { MakeIntegerConstant(0), MakeIntegerConstant(i + 1) });
+	    llvm::Value*     dest = builder.CreateLoad(ptrTy, p);
+	    llvm::Value*     partial = FromStorage(ty, builder.CreateLoad(llvmTy, accs[i]));
+	    llvm::Value*     old = FromStorage(ty, builder.CreateLoad(llvmTy, dest));
+	    builder.CreateStore(ToStorage(ty, ReductionCombine(reductions[i].op, ty, old, partial)), dest);
+	}
+	builder.CreateCall(unlock);
+    }
+    builder.CreateRetVoid();
+    return thunk;
+}
+
+llvm::Value* ForExprAST::ParallelGen()
+{
+    TRACE();
+    llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+
+    llvm::Value* startV = start->CodeGen();
+    ICE_IF(!startV, "Expected start to generate code");
+    llvm::Value* endV = end->CodeGen();
+    ICE_IF(!endV, "Expected end to generate code");
+    if (stepDown)
+    {
+	std::swap(startV, endV);
+    }
+    llvm::Type* int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+    bool        isSigned = !IsUnsigned(start->Type());
+    startV = builder.CreateIntCast(startV, int64Ty, isSigned, "start");
+    endV = builder.CreateIntCast(endV, int64Ty, isSigned, "end");
+
+    llvm::Type*              ptrTy = Types::GetVoidPtrType();
+    std::vector<llvm::Type*> fields(reductions.size() + 1, ptrTy);
+    llvm::StructType*        ctxTy = llvm::StructType::get(theContext, fields);
+
+    llvm::IRBuilder<> bld(&theFunction->getEntryBlock(), theFunction->getEntryBlock().begin());
+    llvm::Value*      ctx = bld.CreateAlloca(ctxTy, 0, "parctx");
+
+    if (Types::TypeDecl* closureTy = parallelFn->ClosureType())
+    {
+	std::vector<VariableExprAST*> vf;
+	for (auto u : parallelFn->UsedVars())
+	{
+	    vf.push_back(new VariableExprAST(Loc(), u.Name(), u.Type()));
+	}
+	ClosureAST*  closure = new ClosureAST(Loc(), closureTy, vf);
+	llvm::Value* p = builder.CreateGEP(ctxTy, ctx, { MakeIntegerConstant(0), MakeIntegerConstant(0) });
+	builder.CreateStore(closure->CodeGen(), p);
+    }
+    for (size_t i = 0; i < reductions.size(); i++)
+    {
+	llvm::Value* p = builder.CreateGEP(ctxTy, ctx,
+	                                   { MakeIntegerConstant(0), MakeIntegerConstant(i + 1) });
+	builder.CreateStore(reductions[i].var->Address(), p);
+    }
+
+    llvm::Function*      thunk = ParallelThunk(ctxTy);
+    llvm::Type*          voidTy = Types::Get<Types::VoidDecl>()->LlvmType();
+    llvm::FunctionCallee f = GetFunction(voidTy, { thunk->getType(), ptrTy, int64Ty, int64Ty, int64Ty },
+                                         "__ParFor");
+    llvm::Value*         chunk = llvm::ConstantInt::get(int64Ty, chunkSize);
+    return builder.CreateCall(f, { thunk, ctx, startV, endV, chunk });
+}
+
 void WhileExprAST::DoDump() const
 {
     std::cerr << "While: ";
@@ -2673,7 +4062,7 @@ llvm::Value* WhileExprAST::CodeGen()
     builder.SetInsertPoint(bodyBB);
     ICE_IF(!body->CodeGen(), "Failed body codegeneration");
     BasicDebugInfo(this);
-    builder.CreateBr(preBodyBB);
+    AddLoopMetadata(builder.CreateBr(preBodyBB), hints);
 
     builder.SetInsertPoint(afterBB);
 
@@ -2712,7 +4101,7 @@ llvm::Value* RepeatExprAST::CodeGen()
     ICE_IF(!condv, "Failed condition codegen");
     llvm::Value* endCond = builder.CreateICmpNE(condv, MakeBooleanConstant(0), "untilcond");
     BasicDebugInfo(this);
-    builder.CreateCondBr(endCond, afterBB, bodyBB);
+    AddLoopMetadata(builder.CreateCondBr(endCond, afterBB, bodyBB), hints);
 
     builder.SetInsertPoint(afterBB);
 
@@ -2779,6 +4168,20 @@ void WriteAST::accept(ASTVisitor& v)
     v.visit(this);
 }
 
+// Runtime read and write functions for reals are named after the type.
+static std::string RealSuffix(Types::TypeDecl* ty)
+{
+    if (llvm::isa<Types::SingleDecl>(ty))
+    {
+	return "single";
+    }
+    if (llvm::isa<Types::ExtendedDecl>(ty))
+    {
+	return "extended";
+    }
+    return "real";
+}
+
 static llvm::FunctionCallee CreateWriteFunc(Types::TypeDecl* ty, llvm::Type* fty, WriteAST::WriteKind kind)
 {
     std::string              suffix;
@@ -2812,7 +4215,7 @@ static llvm::FunctionCallee CreateWriteFunc(Types::TypeDecl* ty, llvm::Type* fty
 	argTypes.push_back(ty->LlvmType());
 	argTypes.push_back(intTy);
 	argTypes.push_back(intTy);
-	suffix = "real";
+	suffix = RealSuffix(ty);
     }
     else if (llvm::isa<Types::StringDecl>(ty))
     {
@@ -2829,6 +4232,12 @@ static llvm::FunctionCallee CreateWriteFunc(Types::TypeDecl* ty, llvm::Type* fty
 	argTypes.push_back(intTy);
 	suffix = "chars";
     }
+    else if (llvm::isa<Types::BigIntDecl>(ty))
+    {
+	argTypes.push_back(Types::GetVoidPtrType());
+	argTypes.push_back(intTy);
+	suffix = "bigint";
+    }
     else
     {
 #if !NDEBUG
@@ -2870,6 +4279,7 @@ llvm::Value* WriteAST::CodeGen()
     {
 	std::vector<llvm::Value*> argsV;
 	llvm::FunctionCallee      fn;
+	std::vector<llvm::Value*> temps;
 	argsV.push_back(dst);
 	if (isText)
 	{
@@ -2914,6 +4324,10 @@ llvm::Value* WriteAST::CodeGen()
 		    v = MakeIntegerConstant(type->Size());
 		}
 	    }
+	    else if (llvm::isa<Types::BigIntDecl>(type))
+	    {
+		v = BigIntOperand(arg.expr, temps);
+	    }
 	    else
 	    {
 		v = arg.expr->CodeGen();
@@ -2964,6 +4378,7 @@ llvm::Value* WriteAST::CodeGen()
 	    fn = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), { dstTy, voidPtrTy }, "__write_bin");
 	}
 	v = builder.CreateCall(fn, argsV, "");
+	FreeBigIntTemps(temps);
     }
     if (kind == WriteKind::WriteLn)
     {
@@ -3028,7 +4443,7 @@ static llvm::FunctionCallee CreateReadFunc(Types::TypeDecl* ty, llvm::Type* fty,
     }
     else if (llvm::isa<Types::RealDecl>(ty))
     {
-	suffix = "real";
+	suffix = RealSuffix(ty);
     }
     else if (llvm::isa<Types::BoolDecl>(ty))
     {
@@ -3042,6 +4457,10 @@ static llvm::FunctionCallee CreateReadFunc(Types::TypeDecl* ty, llvm::Type* fty,
     {
 	suffix = "chars";
     }
+    else if (llvm::isa<Types::BigIntDecl>(ty))
+    {
+	suffix = "bigint";
+    }
     else
     {
 	return Error(0, "Invalid type argument for read");
@@ -3085,13 +4504,33 @@ llvm::Value* ReadAST::CodeGen()
 	ICE_IF(!vexpr, "Argument for read/readln should be a variable");
 
 	Types::TypeDecl* ty = vexpr->Type();
-	v = vexpr->Address();
+	// An element of a {$soa} array is read into a temporary record, and copied back after.
+	auto         soa = llvm::dyn_cast<ArrayExprAST>(arg);
+	llvm::Value* soaIndex = 0;
+	if (soa && soa->IsSoA())
+	{
+	    soaIndex = soa->Index();
+	    v = CreateTempAlloca(ty);
+	    soa->CopySoA(v, soaIndex, false);
+	}
+	else
+	{
+	    v = vexpr->Address();
+	}
 	ICE_IF(!v, "Could not evaluate address of expression for read");
+	llvm::Value* soaTmp = v;
 
 	llvm::FunctionCallee fn;
+	llvm::Value*         narrow = 0;
 	if (isText)
 	{
 	    fn = CreateReadFunc(ty, srcTy, kind);
+	    // A subrange stored in fewer bits is read as an integer, and then narrowed.
+	    if (ty->StorageType() != ty->LlvmType())
+	    {
+		narrow = v;
+		v = CreateTempAlloca(Types::Get<Types::IntegerDecl>());
+	    }
 	}
 	else
 	{
@@ -3103,6 +4542,15 @@ llvm::Value* ReadAST::CodeGen()
 
 	ICE_IF(!fn, "Failed to generate function");
 	v = builder.CreateCall(fn, argsV, "");
+	if (narrow)
+	{
+	    llvm::Value* x = builder.CreateLoad(ty->LlvmType(), argsV.back());
+	    builder.CreateStore(ToStorage(ty, x), narrow);
+	}
+	if (soaIndex)
+	{
+	    soa->CopySoA(soaTmp, soaIndex, true);
+	}
     }
     if (kind == ReadKind::ReadLn)
     {
@@ -3132,7 +4580,7 @@ void VarDeclAST::DoDump() const
 
 llvm::Value* VarDeclAST::CodeGenGlobal(VarDef var)
 {
-    llvm::Type*  ty = var.Type()->LlvmType();
+    llvm::Type*  ty = var.Type()->StorageType();
     llvm::Value* v = 0;
     if (auto fc = llvm::dyn_cast<Types::FieldCollection>(var.Type()))
     {
@@ -3159,7 +4607,7 @@ llvm::Value* VarDeclAST::CodeGenGlobal(VarDef var)
     }
     else if (ExprAST* iv = var.Init())
     {
-	init = llvm::dyn_cast<llvm::Constant>(iv->CodeGen());
+	init = llvm::dyn_cast<llvm::Constant>(ToStorage(var.Type(), iv->CodeGen()));
 	ICE_IF(!init, "Expected intializer to be constant");
     }
     else
@@ -3169,9 +4617,8 @@ llvm::Value* VarDeclAST::CodeGenGlobal(VarDef var)
     llvm::GlobalValue::LinkageTypes linkage = (var.IsExternal() ? llvm::GlobalValue::ExternalLinkage
                                                                 : llvm::Function::InternalLinkage);
 
-    llvm::GlobalVariable*  gv = new llvm::GlobalVariable(*theModule, ty, false, linkage, init, var.Name());
-    const llvm::DataLayout dl(theModule);
-    size_t                 al = std::max(size_t(4), dl.getPrefTypeAlign(ty).value());
+    llvm::GlobalVariable* gv = new llvm::GlobalVariable(*theModule, ty, false, linkage, init, var.Name());
+    size_t                al = std::max({ size_t(4), var.Type()->AlignSize(), var.Align() });
     gv->setAlignment(llvm::Align(al));
     v = gv;
     if (debugInfo)
@@ -3211,7 +4658,11 @@ llvm::Value* VarDeclAST::CodeGenLocal(VarDef var)
     else if (ExprAST* iv = var.Init())
     {
 	llvm::Value* init = iv->CodeGen();
-	builder.CreateStore(init, v);
+	builder.CreateStore(ToStorage(var.Type(), init), v);
+    }
+    else if (Types::IsManaged(var.Type()))
+    {
+	builder.CreateStore(llvm::Constant::getNullValue(var.Type()->LlvmType()), v);
     }
     if (debugInfo)
     {
@@ -3269,6 +4720,18 @@ llvm::Value* VarDeclAST::CodeGen()
     return v;
 }
 
+void VarDeclAST::accept(ASTVisitor& v)
+{
+    for (auto var : vars)
+    {
+	if (ExprAST* init = var.Init())
+	{
+	    init->accept(v);
+	}
+    }
+    v.visit(this);
+}
+
 void LabelExprAST::DoDump() const
 {
     bool first = true;
@@ -3285,6 +4748,15 @@ void LabelExprAST::DoDump() const
 	}
 	first = false;
     }
+    for (auto l : labelStrings)
+    {
+	if (!first)
+	{
+	    std::cerr << ", ";
+	}
+	std::cerr << "'" << l << "'";
+	first = false;
+    }
     std::cerr << ": ";
     stmt->DoDump();
 }
@@ -3374,6 +4846,113 @@ static uint64_t Distance(std::pair<int, int> p)
     return -p.first - -p.second;
 }
 
+namespace
+{
+    struct StringLabel
+    {
+	const std::string* str;
+	llvm::BasicBlock*  bb;
+    };
+} // namespace
+
+// The position where the labels differ the most, so that a switch on it splits them into the
+// most groups.
+static size_t DistinguishingByte(const std::vector<StringLabel>& labels, size_t len)
+{
+    size_t best = 0;
+    size_t bestCount = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+	std::set<char> seen;
+	for (auto l : labels)
+	{
+	    seen.insert((*l.str)[i]);
+	}
+	if (seen.size() > bestCount)
+	{
+	    best = i;
+	    bestCount = seen.size();
+	}
+    }
+    return best;
+}
+
+// Labels of the same length form a trie, switching on one distinguishing byte at a time until
+// a single label is left. Only that label is then compared against the whole string.
+static void StringLabelSwitch(llvm::Value* chars, size_t len, const std::vector<StringLabel>& labels,
+                              llvm::BasicBlock* defaultBB)
+{
+    llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+    auto            charTy = llvm::cast<llvm::IntegerType>(Types::Get<Types::CharDecl>()->LlvmType());
+    if (labels.size() == 1)
+    {
+	if (!len)
+	{
+	    builder.CreateBr(labels[0].bb);
+	    return;
+	}
+	llvm::Type*          intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+	llvm::Type*          sizeTy = Types::GetIndexType()->LlvmType();
+	llvm::Type*          ptrTy = Types::GetVoidPtrType();
+	llvm::FunctionCallee f = GetFunction(intTy, { ptrTy, ptrTy, sizeTy }, "memcmp");
+	llvm::Value*         label = builder.CreateGlobalStringPtr(*labels[0].str, "label");
+	llvm::Value*         size = llvm::ConstantInt::get(sizeTy, len);
+	llvm::Value*         cmp = builder.CreateCall(f, { chars, label, size });
+	builder.CreateCondBr(builder.CreateIsNull(cmp, "match"), labels[0].bb, defaultBB);
+	return;
+    }
+
+    size_t                                   pos = DistinguishingByte(labels, len);
+    std::map<char, std::vector<StringLabel>> groups;
+    for (auto l : labels)
+    {
+	groups[(*l.str)[pos]].push_back(l);
+    }
+    llvm::Value*      ptr = builder.CreateGEP(charTy, chars, MakeIntegerConstant(pos));
+    llvm::Value*      c = builder.CreateLoad(charTy, ptr);
+    llvm::SwitchInst* sw = builder.CreateSwitch(c, defaultBB, groups.size());
+    for (auto& g : groups)
+    {
+	llvm::BasicBlock* bb = llvm::BasicBlock::Create(theContext, "strcase", theFunction);
+	sw->addCase(llvm::ConstantInt::get(charTy, g.first), bb);
+	builder.SetInsertPoint(bb);
+	StringLabelSwitch(chars, len, g.second, defaultBB);
+    }
+}
+
+// Switch on the length of the string first, then on the bytes that tell the labels of that
+// length apart, so that a selector is compared with at most one label.
+void CaseExprAST::StringCaseCodeGen(llvm::Value* str, llvm::BasicBlock* defaultBB,
+                                    const std::vector<std::pair<LabelExprAST*, llvm::BasicBlock*>>& labbb)
+{
+    llvm::Function* theFunction = builder.GetInsertBlock()->getParent();
+    auto            charTy = llvm::cast<llvm::IntegerType>(Types::Get<Types::CharDecl>()->LlvmType());
+
+    std::map<size_t, std::vector<StringLabel>> byLength;
+    for (auto& ll : labbb)
+    {
+	for (auto& l : ll.first->LabelStrings())
+	{
+	    // Longer than any string can be, so it never matches.
+	    if (l.size() <= 255)
+	    {
+		byLength[l.size()].push_back({ &l, ll.second });
+	    }
+	}
+    }
+
+    llvm::Value*      len = builder.CreateLoad(charTy, str, "len");
+    llvm::Value*      chars = builder.CreateGEP(charTy, str, MakeIntegerConstant(1), "chars");
+    llvm::SwitchInst* sw = builder.CreateSwitch(len, defaultBB, byLength.size());
+    for (auto& g : byLength)
+    {
+	llvm::BasicBlock* bb = llvm::BasicBlock::Create(theContext, "strlen", theFunction);
+	sw->addCase(llvm::ConstantInt::get(charTy, g.first), bb);
+	builder.SetInsertPoint(bb);
+	StringLabelSwitch(chars, g.first, g.second, defaultBB);
+    }
+}
+
 llvm::Value* CaseExprAST::CodeGen()
 {
     TRACE();
@@ -3382,7 +4961,8 @@ llvm::Value* CaseExprAST::CodeGen()
 
     BasicDebugInfo(this);
 
-    llvm::Value* v = expr->CodeGen();
+    bool         isString = llvm::isa<Types::StringDecl>(expr->Type());
+    llvm::Value* v = (isString) ? MakeAddressable(expr) : expr->CodeGen();
     llvm::Type*  ty = v->getType();
 
     llvm::BasicBlock* bb = builder.GetInsertBlock();
@@ -3403,36 +4983,43 @@ llvm::Value* CaseExprAST::CodeGen()
     }
 
     builder.SetInsertPoint(bb);
-    for (auto ll : labbb)
+    if (isString)
+    {
+	StringCaseCodeGen(v, defaultBB, labbb);
+    }
+    else
     {
-	for (auto val : ll.first->LabelValues())
+	for (auto ll : labbb)
 	{
-	    if (Distance(val) > MaxRangeInSwitch)
+	    for (auto val : ll.first->LabelValues())
 	    {
-		llvm::BasicBlock* next = llvm::BasicBlock::Create(theContext, "next", theFunction);
-		llvm::BasicBlock* maybe = llvm::BasicBlock::Create(theContext, "maybe", theFunction);
-		llvm::Value*      lt = builder.CreateICmpSLT(v, MakeIntegerConstant(val.first), "lt");
-		builder.CreateCondBr(lt, next, maybe);
-		builder.SetInsertPoint(maybe);
-		llvm::Value* gt = builder.CreateICmpSGT(v, MakeIntegerConstant(val.second), "gt");
-		builder.CreateCondBr(gt, next, ll.second);
-		builder.SetInsertPoint(next);
+		if (Distance(val) > MaxRangeInSwitch)
+		{
+		    llvm::BasicBlock* next = llvm::BasicBlock::Create(theContext, "next", theFunction);
+		    llvm::BasicBlock* maybe = llvm::BasicBlock::Create(theContext, "maybe", theFunction);
+		    llvm::Value*      lt = builder.CreateICmpSLT(v, MakeIntegerConstant(val.first), "lt");
+		    builder.CreateCondBr(lt, next, maybe);
+		    builder.SetInsertPoint(maybe);
+		    llvm::Value* gt = builder.CreateICmpSGT(v, MakeIntegerConstant(val.second), "gt");
+		    builder.CreateCondBr(gt, next, ll.second);
+		    builder.SetInsertPoint(next);
+		}
 	    }
 	}
-    }
 
-    llvm::SwitchInst* sw = builder.CreateSwitch(v, defaultBB, labels.size());
+	llvm::SwitchInst* sw = builder.CreateSwitch(v, defaultBB, labels.size());
 
-    for (auto ll : labbb)
-    {
-	for (auto val : ll.first->LabelValues())
+	for (auto ll : labbb)
 	{
-	    if (Distance(val) <= MaxRangeInSwitch)
+	    for (auto val : ll.first->LabelValues())
 	    {
-		for (int i = val.first; i <= val.second; i++)
+		if (Distance(val) <= MaxRangeInSwitch)
 		{
-		    auto intTy = llvm::dyn_cast<llvm::IntegerType>(ty);
-		    sw->addCase(llvm::ConstantInt::get(intTy, i), ll.second);
+		    for (int i = val.first; i <= val.second; i++)
+		    {
+			auto intTy = llvm::dyn_cast<llvm::IntegerType>(ty);
+			sw->addCase(llvm::ConstantInt::get(intTy, i), ll.second);
+		    }
 		}
 	    }
 	}
@@ -3708,6 +5295,17 @@ void RangeReduceAST::DoDump() const
     std::cerr << "]";
 }
 
+// Convert an array index to the pointer-width integer used for address arithmetic.
+static llvm::Value* ConvertIndex(llvm::Value* index, Types::TypeDecl* ty)
+{
+    llvm::Type* indexTy = Types::GetIndexType()->LlvmType();
+    if (IsUnsigned(ty))
+    {
+	return builder.CreateZExtOrTrunc(index, indexTy, "zext");
+    }
+    return builder.CreateSExtOrTrunc(index, indexTy, "sext");
+}
+
 llvm::Value* RangeReduceAST::CodeGen()
 {
     TRACE();
@@ -3721,27 +5319,16 @@ llvm::Value* RangeReduceAST::CodeGen()
 	llvm::Value* low = variables.FindTopLevel(dr->LowName());
 	low = builder.CreateLoad(ty, low, "low");
 	index = builder.CreateSub(index, low);
+	return builder.CreateSExtOrTrunc(index, Types::GetIndexType()->LlvmType(), "sext");
     }
-    else
+
+    auto rr = llvm::dyn_cast<Types::RangeDecl>(range);
+    ICE_IF(!rr, "This should be a RangeDecl");
+    // Convert first, so that the offset from the start doesn't overflow the type of the index.
+    index = ConvertIndex(index, expr->Type());
+    if (int64_t start = rr->Start())
     {
-	auto rr = llvm::dyn_cast<Types::RangeDecl>(range);
-	ICE_IF(!rr, "This should be a RangeDecl");
-	if (int start = rr->Start())
-	{
-	    index = builder.CreateSub(index, MakeConstant(start, expr->Type()));
-	}
-	llvm::Type* intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
-	if (ty->getPrimitiveSizeInBits() < intTy->getPrimitiveSizeInBits())
-	{
-	    if (IsUnsigned(expr->Type()))
-	    {
-		index = builder.CreateZExt(index, intTy, "zext");
-	    }
-	    else
-	    {
-		index = builder.CreateSExt(index, intTy, "sext");
-	    }
-	}
+	index = builder.CreateSub(index, MakeConstant(start, Types::GetIndexType()));
     }
     return index;
 }
@@ -3763,51 +5350,48 @@ llvm::Value* RangeCheckAST::CodeGen()
     ICE_IF(!index, "Expected expression to generate code");
     ICE_IF(!index->getType()->isIntegerTy(), "Index is supposed to be integral type");
 
-    llvm::Value* orig_index = index;
-    llvm::Type*  intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+    Types::TypeDecl* indexType = Types::GetIndexType();
+    llvm::Type*      intTy = Types::Get<Types::IntegerDecl>()->LlvmType();
+    llvm::Type*      int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
 
     auto rr = llvm::dyn_cast<Types::RangeDecl>(range);
     ICE_IF(rr, "Expect a rangedecl here");
-    int start = rr->Start();
-    if (start)
+    // Check in the wider of the two types, so that an index is never truncated into range.
+    if (index->getType()->getPrimitiveSizeInBits() < indexType->LlvmType()->getPrimitiveSizeInBits())
     {
-	index = builder.CreateSub(index, MakeConstant(start, expr->Type()));
+	index = ConvertIndex(index, expr->Type());
     }
-    if (index->getType()->getPrimitiveSizeInBits() < intTy->getPrimitiveSizeInBits())
+    llvm::Type*  checkTy = index->getType();
+    llvm::Value* orig_index = index;
+    int64_t      start = rr->Start();
+    if (start)
     {
-	if (IsUnsigned(expr->Type()))
-	{
-	    index = builder.CreateZExt(index, intTy, "zext");
-	    orig_index = builder.CreateZExt(orig_index, intTy, "zext");
-	}
-	else
-	{
-	    index = builder.CreateSExt(index, intTy, "sext");
-	    orig_index = builder.CreateSExt(orig_index, intTy, "sext");
-	}
+	index = builder.CreateSub(index, llvm::ConstantInt::get(checkTy, start));
     }
-    int               end = rr->GetRange()->Size();
-    llvm::Value*      cmp = builder.CreateICmpUGE(index, MakeIntegerConstant(end), "rangecheck");
+    uint64_t          end = rr->GetRange()->Size();
+    llvm::Value*      cmp = builder.CreateICmpUGE(index, llvm::ConstantInt::get(checkTy, end), "rangecheck");
     llvm::Function*   theFunction = builder.GetInsertBlock()->getParent();
     llvm::BasicBlock* oorBlock = llvm::BasicBlock::Create(theContext, "out_of_range", theFunction);
     llvm::BasicBlock* contBlock = llvm::BasicBlock::Create(theContext, "continue", theFunction);
-    builder.CreateCondBr(cmp, oorBlock, contBlock);
+    llvm::MDNode*     weights = llvm::MDBuilder(theContext).createBranchWeights(1, LIKELY_WEIGHT);
+    builder.CreateCondBr(cmp, oorBlock, contBlock, weights);
 
     builder.SetInsertPoint(oorBlock);
+    llvm::Type*               strTy = llvm::PointerType::getUnqual(Types::Get<Types::CharDecl>()->LlvmType());
     std::vector<llvm::Value*> args = { builder.CreateGlobalStringPtr(Loc().FileName()),
-	                               MakeIntegerConstant(Loc().LineNumber()), MakeIntegerConstant(start),
-	                               MakeIntegerConstant(end), orig_index };
-    std::vector<llvm::Type*>  argTypes = {
-        llvm::PointerType::getUnqual(Types::Get<Types::CharDecl>()->LlvmType()), intTy, intTy, intTy, intTy
-    };
+	                               MakeIntegerConstant(Loc().LineNumber()),
+	                               llvm::ConstantInt::get(int64Ty, start),
+	                               llvm::ConstantInt::get(int64Ty, end),
+	                               builder.CreateSExtOrTrunc(orig_index, int64Ty) };
+    std::vector<llvm::Type*>  argTypes = { strTy, intTy, int64Ty, int64Ty, int64Ty };
 
-    llvm::FunctionCallee fn = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(), argTypes, "range_error");
+    llvm::FunctionCallee fn = GetErrorFunction(argTypes, "range_error");
 
     builder.CreateCall(fn, args, "");
     builder.CreateUnreachable();
 
     builder.SetInsertPoint(contBlock);
-    return index;
+    return ConvertIndex(index, expr->Type());
 }
 
 void TypeCastAST::DoDump() const
@@ -3879,17 +5463,62 @@ static llvm::Value* ConvertSet(ExprAST* expr, Types::TypeDecl* type)
     return dest;
 }
 
+// Load a vector from an array, or broadcast a scalar to all lanes.
+static llvm::Value* ConvertToVector(ExprAST* expr, Types::VectorDecl* vty)
+{
+    Types::TypeDecl* current = expr->Type();
+    Types::TypeDecl* elemTy = vty->SubType();
+    if (llvm::isa<Types::ArrayDecl>(current))
+    {
+	llvm::Value* src = MakeAddressable(expr);
+	return builder.CreateAlignedLoad(vty->LlvmType(), src, llvm::Align(elemTy->AlignSize()), "vec");
+    }
+
+    llvm::Value* v = expr->CodeGen();
+    if (llvm::isa<Types::RealDecl>(elemTy) && IsIntegral(current))
+    {
+	v = builder.CreateSIToFP(v, elemTy->LlvmType(), "tofp");
+    }
+    else if (llvm::isa<Types::RealDecl>(elemTy))
+    {
+	v = builder.CreateFPCast(v, elemTy->LlvmType(), "fpcast");
+    }
+    else if (v->getType() != elemTy->LlvmType())
+    {
+	v = builder.CreateIntCast(v, elemTy->LlvmType(), !IsUnsigned(current));
+    }
+    return builder.CreateVectorSplat(vty->Count(), v, "splat");
+}
+
 llvm::Value* TypeCastAST::CodeGen()
 {
     Types::TypeDecl* current = expr->Type();
+    if (auto vty = llvm::dyn_cast<Types::VectorDecl>(type))
+    {
+	return ConvertToVector(expr, vty);
+    }
     if (llvm::isa<Types::ComplexDecl>(type))
     {
 	llvm::Value* res = Address();
 	llvm::Type*  cmplxTy = Types::Get<Types::ComplexDecl>()->LlvmType();
 	return builder.CreateLoad(cmplxTy, res);
     }
+    if (llvm::isa<Types::BigIntDecl>(type))
+    {
+	llvm::Type*          int64Ty = Types::Get<Types::Int64Decl>()->LlvmType();
+	llvm::FunctionCallee f = GetFunction(Types::Get<Types::VoidDecl>()->LlvmType(),
+	                                     { Types::GetVoidPtrType(), int64Ty }, "__BigFromInt");
+	llvm::Value*         v = builder.CreateIntCast(expr->CodeGen(), int64Ty, !IsUnsigned(current));
+	llvm::Value*         res = CreateTempAlloca(type);
+	builder.CreateCall(f, { res, v });
+	return builder.CreateLoad(type->LlvmType(), res);
+    }
     if (llvm::isa<Types::RealDecl>(type))
     {
+	if (llvm::isa<Types::RealDecl>(current))
+	{
+	    return builder.CreateFPCast(expr->CodeGen(), type->LlvmType(), "fpcast");
+	}
 	return builder.CreateSIToFP(expr->CodeGen(), type->LlvmType(), "tofp");
     }
 
@@ -3940,6 +5569,13 @@ llvm::Value* TypeCastAST::Address()
 	return MakeAddressable(expr);
     }
 
+    if (llvm::isa<Types::VectorDecl, Types::BigIntDecl>(type))
+    {
+	llvm::Value* res = CreateTempAlloca(type);
+	builder.CreateStore(CodeGen(), res);
+	return res;
+    }
+
     if (llvm::isa<Types::ComplexDecl>(type))
     {
 	llvm::Value* res = CreateTempAlloca(Types::Get<Types::ComplexDecl>());
@@ -3954,6 +5590,10 @@ llvm::Value* TypeCastAST::Address()
 	{
 	    re = builder.CreateSIToFP(expr->CodeGen(), realTy, "tofp");
 	}
+	else
+	{
+	    re = builder.CreateFPCast(re, realTy, "fpcast");
+	}
 	llvm::Value* im = MakeRealConstant(0.0);
 
 	builder.CreateStore(re, builder.CreateGEP(cmplxTy, res, { zero, zero }));
@@ -3990,13 +5630,25 @@ llvm::Value* TypeCastAST::Address()
     return builder.CreateBitCast(v, llvm::PointerType::getUnqual(type->LlvmType()));
 }
 
+// Sizes that don't fit in an integer are longint. This is asked before code generation,
+// so a record that points to itself may still need its layout resolving.
+Types::TypeDecl* SizeOfExprAST::Type() const
+{
+    typeToSize->LlvmType();
+    if (typeToSize->Size() > INT32_MAX)
+    {
+	return Types::Get<Types::Int64Decl>();
+    }
+    return ExprAST::Type();
+}
+
 llvm::Value* SizeOfExprAST::CodeGen()
 {
     TRACE();
 
     BasicDebugInfo(this);
 
-    return MakeIntegerConstant(typeToSize->Size());
+    return MakeConstant(typeToSize->Size(), Type());
 }
 
 void SizeOfExprAST::DoDump() const
@@ -4153,6 +5805,41 @@ void UnitAST::accept(ASTVisitor& v)
     v.visit(this);
 }
 
+void SetFunctionCompleteHook(FunctionCompleteHook hook)
+{
+    functionComplete = hook;
+}
+
+// Nested functions are generated as part of the enclosing one, so they are complete too.
+static void CompletedFunctions(FunctionAST* fn, std::vector<llvm::Function*>& funcs)
+{
+    for (auto sub : fn->SubFunctions())
+    {
+	CompletedFunctions(sub, funcs);
+    }
+    llvm::Function* f = fn->Proto()->LlvmFunction();
+    if (f && !f->isDeclaration())
+    {
+	funcs.push_back(f);
+    }
+}
+
+static void FunctionComplete(FunctionAST* fn)
+{
+    if (!functionComplete)
+    {
+	return;
+    }
+    std::vector<llvm::Function*> funcs;
+    CompletedFunctions(fn, funcs);
+    if (!funcs.empty())
+    {
+	// The hook may take the code away, so nothing must be left pointing into it.
+	builder.ClearInsertionPoint();
+	functionComplete(funcs);
+    }
+}
+
 llvm::Value* UnitAST::CodeGen()
 {
     TRACE();
@@ -4174,10 +5861,15 @@ llvm::Value* UnitAST::CodeGen()
     for (auto a : code)
     {
 	ICE_IF(!a->CodeGen(), "Failed to generate code for unit body");
+	if (auto fn = llvm::dyn_cast<FunctionAST>(a))
+	{
+	    FunctionComplete(fn);
+	}
     }
     if (initFunc)
     {
 	initFunc->CodeGen();
+	FunctionComplete(initFunc);
 	if (initFunc->Proto()->Name() != "__PascalMain")
 	{
 	    unitInit.push_back(initFunc);
@@ -4278,6 +5970,10 @@ static llvm::Constant* MakeCharArray(Types::TypeDecl* type, const ExprAST* value
 
 llvm::Value* InitValueAST::CodeGen()
 {
+    if (IsZero())
+    {
+	return llvm::Constant::getNullValue(type->LlvmType());
+    }
     if (auto set = llvm::dyn_cast<SetExprAST>(values[0]))
     {
 	return set->MakeConstantSetArray();
@@ -4332,50 +6028,230 @@ void InitValueAST::DoDump() const
     }
 }
 
-llvm::Value* InitArrayAST::CodeGen()
+namespace
 {
-    auto aty = llvm::dyn_cast<Types::ArrayDecl>(type);
-    ICE_IF(!aty, "Expected array type here");
-    ICE_IF(aty->Ranges().size() != 1, "Expect only 1D arrays right now");
-    Types::Range*                range = aty->Ranges()[0]->GetRange();
-    size_t                       size = range->Size();
-    std::vector<llvm::Constant*> initArr(size);
-    llvm::Constant*              otherwise = 0;
-    for (auto v : values)
+    // The elements of a constant array, in the order they are stored. Elements that fit in a
+    // ConstantDataArray, and the elements of bit packed arrays, go in a buffer of bytes, laid out
+    // as in memory, rather than one llvm::Constant each.
+    class ArrayConstant
     {
-	auto c = llvm::dyn_cast<llvm::Constant>(v.Value()->CodeGen());
-	switch (v.Kind())
+    public:
+	ArrayConstant(llvm::Type* elemTy, size_t count, Types::ArrayDecl* packed = 0)
+	    : elemTy(elemTy), count(count), bits(0), bitsStart(0), elemSize(0)
 	{
-	case ArrayInit::InitKind::Range:
-	    for (int64_t i = v.Start(); i <= v.End(); i++)
+	    if (packed && packed->BitsPerElement())
+	    {
+		bits = packed->BitsPerElement();
+		bitsStart = packed->SubType()->GetRange()->Start();
+		bytes.resize((count * bits + 7) / CHAR_BIT);
+	    }
+	    else if (llvm::ConstantDataSequential::isElementTypeCompatible(elemTy))
+	    {
+		elemSize = elemTy->getPrimitiveSizeInBits() / CHAR_BIT;
+		bytes.resize(count * elemSize);
+	    }
+	    else
 	    {
-		initArr[i - range->Start()] = c;
+		elems.resize(count);
 	    }
+	}
+	size_t          Count() const { return count; }
+	void            Set(size_t index, llvm::Constant* c);
+	llvm::Constant* Element(size_t index) const;
+	llvm::Constant* Get(llvm::Type* ty) const;
+
+    private:
+	llvm::Type*                  elemTy;
+	size_t                       count;
+	unsigned                     bits;
+	int64_t                      bitsStart;
+	size_t                       elemSize;
+	std::vector<char>            bytes;
+	std::vector<llvm::Constant*> elems;
+    };
+} // namespace
+
+void ArrayConstant::Set(size_t index, llvm::Constant* c)
+{
+    ICE_IF(index >= count, "Array initializer out of range");
+    if (bits)
+    {
+	uint64_t mask = (1 << bits) - 1;
+	uint64_t v = (c->getUniqueInteger().getSExtValue() - bitsStart) & mask;
+	size_t   bit = index * bits;
+	char&    byte = bytes[bit / CHAR_BIT];
+	byte = (byte & ~(mask << (bit % CHAR_BIT))) | (v << (bit % CHAR_BIT));
+    }
+    else if (elemSize)
+    {
+	auto        fp = llvm::dyn_cast<llvm::ConstantFP>(c);
+	llvm::APInt value = (fp) ? fp->getValueAPF().bitcastToAPInt() : c->getUniqueInteger();
+	uint64_t    v = value.getZExtValue();
+	// Stored as a host integer of the same size, which is the layout ConstantDataArray uses.
+	char* p = &bytes[index * elemSize];
+	switch (elemSize)
+	{
+	case 1:
+	    *p = v;
+	    break;
+	case 2:
+	{
+	    uint16_t v16 = v;
+	    memcpy(p, &v16, sizeof(v16));
+	    break;
+	}
+	case 4:
+	{
+	    uint32_t v32 = v;
+	    memcpy(p, &v32, sizeof(v32));
+	    break;
+	}
+	default:
+	    memcpy(p, &v, sizeof(v));
+	    break;
+	}
+    }
+    else
+    {
+	elems[index] = c;
+    }
+}
+
+llvm::Constant* ArrayConstant::Element(size_t index) const
+{
+    ICE_IF(bits || elemSize, "Elements are only kept for aggregate types");
+    return (elems[index]) ? elems[index] : llvm::Constant::getNullValue(elemTy);
+}
+
+// Elements without an initializer are zero. All zero gives a zeroinitializer.
+llvm::Constant* ArrayConstant::Get(llvm::Type* ty) const
+{
+    if (bits)
+    {
+	llvm::Type* byteTy = llvm::Type::getInt8Ty(theContext);
+	return llvm::ConstantDataArray::getRaw({ bytes.data(), bytes.size() }, bytes.size(), byteTy);
+    }
+    if (elemSize)
+    {
+	return llvm::ConstantDataArray::getRaw({ bytes.data(), bytes.size() }, count, elemTy);
+    }
+    std::vector<llvm::Constant*> init(count);
+    for (size_t i = 0; i < count; i++)
+    {
+	init[i] = Element(i);
+    }
+    return llvm::ConstantArray::get(llvm::cast<llvm::ArrayType>(ty), init);
+}
+
+static void FillArray(InitArrayAST* ia, ArrayConstant& arr, size_t first);
+
+// Put value in count rows, from row number row, of an array whose rows are rowSize elements
+// long and start at element first. A row is just one element for one-dimensional arrays.
+static void FillRows(Types::ArrayDecl* aty, ArrayConstant& arr, size_t first, size_t row, size_t count,
+                     size_t rowSize, ExprAST* value)
+{
+    auto ia = llvm::dyn_cast<InitArrayAST>(value);
+    if (rowSize > 1 && ia)
+    {
+	for (size_t r = row; r < row + count; r++)
+	{
+	    FillArray(ia, arr, first + r * rowSize);
+	}
+	return;
+    }
+    llvm::Value* v = value->CodeGen();
+    if (rowSize == 1)
+    {
+	v = ToStorage(aty->SubType(), v);
+    }
+    auto c = llvm::dyn_cast<llvm::Constant>(v);
+    ICE_IF(!c, "Expected array initializer to be a constant");
+    for (size_t r = row; r < row + count; r++)
+    {
+	if (rowSize == 1)
+	{
+	    arr.Set(first + r, c);
+	    continue;
+	}
+	for (size_t i = 0; i < rowSize; i++)
+	{
+	    llvm::Constant* elem = c->getAggregateElement(i);
+	    ICE_IF(!elem, "Expected array row to be an aggregate constant");
+	    arr.Set(first + r * rowSize + i, elem);
+	}
+    }
+}
+
+// Fill in the elements of ia, which start at element first of arr. The otherwise value goes in
+// all elements, and then the other values over the top of that.
+static void FillArray(InitArrayAST* ia, ArrayConstant& arr, size_t first)
+{
+    auto                                      aty = llvm::cast<Types::ArrayDecl>(ia->Type());
+    const std::vector<Types::RangeBaseDecl*>& ranges = aty->Ranges();
+    Types::Range*                             range = ranges[0]->GetRange();
+    size_t                                    rowSize = 1;
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+	rowSize *= ranges[i]->GetRange()->Size();
+    }
+    for (auto v : ia->Values())
+    {
+	if (v.Kind() == ArrayInit::InitKind::Otherwise)
+	{
+	    FillRows(aty, arr, first, 0, range->Size(), rowSize, v.Value());
+	}
+    }
+    for (auto v : ia->Values())
+    {
+	switch (v.Kind())
+	{
+	case ArrayInit::InitKind::Range:
+	{
+	    size_t count = v.End() - v.Start() + 1;
+	    FillRows(aty, arr, first, v.Start() - range->Start(), count, rowSize, v.Value());
 	    break;
+	}
 	case ArrayInit::InitKind::Single:
-	    initArr[v.Start() - range->Start()] = c;
+	    FillRows(aty, arr, first, v.Start() - range->Start(), 1, rowSize, v.Value());
 	    break;
 	case ArrayInit::InitKind::Otherwise:
-	    ICE_IF(otherwise, "Expected only one otherwise initializer");
-	    otherwise = c;
 	    break;
 	default:
 	    ICE("Unknown initializer kind");
 	}
     }
-    for (auto& i : initArr)
+}
+
+llvm::Value* InitArrayAST::CodeGen()
+{
+    auto aty = llvm::dyn_cast<Types::ArrayDecl>(type);
+    ICE_IF(!aty, "Expected array type here");
+    size_t size = 1;
+    for (auto r : aty->Ranges())
+    {
+	size *= r->GetRange()->Size();
+    }
+    ArrayConstant arr(aty->SubType()->StorageType(), size, aty);
+    FillArray(this, arr, 0);
+
+    if (aty->IsSoA())
     {
-	if (!i)
+	// Each field of the records goes in an array of its own.
+	auto                         rd = llvm::cast<Types::RecordDecl>(aty->SubType());
+	auto                         sty = llvm::cast<llvm::StructType>(type->LlvmType());
+	std::vector<llvm::Constant*> columns;
+	for (int f = 0; f < rd->FieldCount(); f++)
 	{
-	    i = otherwise;
+	    ArrayConstant column(rd->GetElement(f)->StorageType(), size);
+	    for (size_t i = 0; i < size; i++)
+	    {
+		column.Set(i, arr.Element(i)->getAggregateElement(rd->StructIndex(f)));
+	    }
+	    columns.push_back(column.Get(sty->getElementType(f)));
 	}
+	return llvm::ConstantStruct::get(sty, columns);
     }
-
-    auto arrty = llvm::dyn_cast<llvm::ArrayType>(type->LlvmType());
-
-    llvm::Constant* init = llvm::ConstantArray::get(arrty,
-                                                    llvm::ArrayRef<llvm::Constant*>(initArr.data(), size));
-    return init;
+    return arr.Get(type->LlvmType());
 }
 
 void InitArrayAST::DoDump() const
@@ -4406,17 +6282,26 @@ llvm::Value* InitRecordAST::CodeGen()
 {
     auto fty = llvm::dyn_cast<Types::FieldCollection>(type);
     ICE_IF(!fty, "Expected field collection type here");
-    std::vector<llvm::Constant*> initArr(fty->FieldCount());
+    auto                         ty = llvm::dyn_cast<llvm::StructType>(type->LlvmType());
+    std::vector<llvm::Constant*> initArr(ty->getNumElements());
 
     for (auto v : values)
     {
-	auto c = llvm::dyn_cast<llvm::Constant>(v.Value()->CodeGen());
+	llvm::Value* c = v.Value()->CodeGen();
 	for (auto e : v.Elements())
 	{
-	    initArr[e] = c;
+	    initArr[StructIndex(type, e)] =
+	        llvm::dyn_cast<llvm::Constant>(ToStorage(fty->GetElement(e)->SubType(), c));
+	}
+    }
+    // Padding inserted for {$align N}, and fields not given a value.
+    for (size_t i = 0; i < initArr.size(); i++)
+    {
+	if (!initArr[i])
+	{
+	    initArr[i] = llvm::Constant::getNullValue(ty->getElementType(i));
 	}
     }
-    auto ty = llvm::dyn_cast<llvm::StructType>(type->LlvmType());
 
     llvm::Constant* init = llvm::ConstantStruct::get(ty, initArr);
     return init;
@@ -4441,7 +6326,7 @@ void InitRecordAST::DoDump() const
 llvm::Value* ArraySliceAST::Address()
 {
     auto         aty = llvm::dyn_cast<Types::ArrayDecl>(origType);
-    llvm::Type*  elemTy = aty->SubType()->LlvmType();
+    llvm::Type*  elemTy = aty->SubType()->StorageType();
     llvm::Value* v = MakeAddressable(expr);
     llvm::Value* low = range->Low();
     auto         r = llvm::dyn_cast<Types::RangeDecl>(aty->Ranges()[0]);
@@ -7,11 +7,13 @@
 #include "token.h"
 #include "types.h"
 #include "visitor.h"
+#include <llvm/ADT/APInt.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Value.h>
 #include <llvm/Support/Casting.h>
+#include <functional>
 #include <set>
 #include <string>
 #include <vector>
@@ -55,6 +57,26 @@ private:
     ExprAST*         value;
 };
 
+// Loop transformations asked for by directives such as {$unroll 4} or {$vectorize width=8},
+// passed on to LLVM as llvm.loop metadata.
+struct LoopHints
+{
+    enum class Hint
+    {
+	Default,
+	Enable,
+	Disable,
+	Full,
+    };
+
+    Hint     unroll = Hint::Default;
+    unsigned unrollCount = 0;
+    Hint     vectorize = Hint::Default;
+    unsigned width = 0;
+    unsigned interleave = 0;
+    bool     distribute = false;
+};
+
 const size_t MIN_ALIGN = 4;
 
 class ExprAST : public Visitable<ExprAST>
@@ -77,6 +99,8 @@ public:
 	EK_VariableExpr,
 	EK_ArrayExpr,
 	EK_DynArrayExpr,
+	EK_HeapArrayExpr,
+	EK_MapExpr,
 	EK_PointerExpr,
 	EK_FilePointerExpr,
 	EK_FieldExpr,
@@ -147,6 +171,7 @@ public:
     }
     void         DoDump() const override;
     llvm::Value* CodeGen() override;
+    double       Value() const { return val; }
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_RealExpr; }
 
 private:
@@ -234,6 +259,7 @@ private:
 class SetExprAST : public AddressableAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     SetExprAST(const Location& w, const std::vector<ExprAST*>& v, Types::TypeDecl* ty)
@@ -284,10 +310,20 @@ public:
     ArrayExprAST(const Location& w, ExprAST* v, const std::vector<ExprAST*>& inds,
                  const std::vector<Types::RangeBaseDecl*>& r, Types::TypeDecl* ty);
     void DoDump() const override;
-    // Don't need CodeGen, just calculate address and use parent CodeGen
+    // Only elements of bit-packed arrays need their own CodeGen, the rest use the parent CodeGen.
+    llvm::Value* CodeGen() override;
     llvm::Value* Address() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_ArrayExpr; }
     void         accept(ASTVisitor& v) override;
+    ExprAST*     Base() const { return expr; }
+    bool         IsBitPacked() const;
+    llvm::Value* AssignBitPacked(llvm::Value* v);
+    // Elements of {$soa} arrays are not stored as records, so a field is found from the field number,
+    // and a whole element is copied field by field to or from the record at rec.
+    bool         IsSoA() const;
+    llvm::Value* FieldAddress(int element);
+    void         CopySoA(llvm::Value* rec, llvm::Value* index, bool toArray);
+    llvm::Value* Index();
 
 private:
     ExprAST*                       expr;
@@ -314,6 +350,47 @@ private:
     Types::DynRangeDecl* range;
 };
 
+// Element of an "array of T". Indices start at zero, and are checked against the current length.
+class HeapArrayExprAST : public AddressableAST
+{
+    friend class TypeCheckVisitor;
+
+public:
+    HeapArrayExprAST(const Location& w, ExprAST* v, ExprAST* idx, Types::TypeDecl* ty)
+        : AddressableAST(w, EK_HeapArrayExpr, ty), expr(v), index(idx)
+    {
+    }
+    static bool  classof(const ExprAST* e) { return e->getKind() == EK_HeapArrayExpr; }
+    void         DoDump() const override;
+    llvm::Value* Address() override;
+    void         accept(ASTVisitor& v) override;
+
+private:
+    ExprAST* expr;
+    ExprAST* index;
+};
+
+// Value of key in a map. Like an element of an array, it always refers to a value: if the key isn't
+// in the map, it's added with a zero value.
+class MapExprAST : public AddressableAST
+{
+    friend class TypeCheckVisitor;
+
+public:
+    MapExprAST(const Location& w, ExprAST* m, ExprAST* k, Types::TypeDecl* ty)
+        : AddressableAST(w, EK_MapExpr, ty), map(m), key(k)
+    {
+    }
+    static bool  classof(const ExprAST* e) { return e->getKind() == EK_MapExpr; }
+    void         DoDump() const override;
+    llvm::Value* Address() override;
+    void         accept(ASTVisitor& v) override;
+
+private:
+    ExprAST* map;
+    ExprAST* key;
+};
+
 class PointerExprAST : public AddressableAST
 {
 public:
@@ -357,6 +434,7 @@ public:
     llvm::Value* Address() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_FieldExpr; }
     void         accept(ASTVisitor& v) override;
+    ExprAST*     Base() const { return expr; }
 
 private:
     ExprAST* expr;
@@ -374,6 +452,7 @@ public:
     llvm::Value* Address() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_VariantFieldExpr; }
     void         accept(ASTVisitor& v) override;
+    ExprAST*     Base() const { return expr; }
 
 private:
     ExprAST* expr;
@@ -383,6 +462,7 @@ private:
 class BinaryExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     BinaryExprAST(Token op, ExprAST* l, ExprAST* r)
@@ -407,6 +487,7 @@ private:
     llvm::Value* CallSetFunc(const std::string& name, bool resTyIsSet);
     llvm::Value* CallStrFunc(const std::string& name);
     llvm::Value* CallArrFunc(const std::string& name, size_t size);
+    llvm::Value* FusedMulAdd();
 
 private:
     Token    oper;
@@ -417,6 +498,7 @@ private:
 class UnaryExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     UnaryExprAST(const Location& w, Token op, ExprAST* r)
@@ -483,12 +565,18 @@ private:
 class AssignExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
-    AssignExprAST(const Location& w, ExprAST* l, ExprAST* r) : ExprAST(w, EK_AssignExpr), lhs(l), rhs(r) {}
+    AssignExprAST(const Location& w, ExprAST* l, ExprAST* r)
+        : ExprAST(w, EK_AssignExpr), lhs(l), rhs(r), valueFirst(false)
+    {
+    }
     void         DoDump() const override;
     llvm::Value* CodeGen() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_AssignExpr; }
+    ExprAST*     Lhs() const { return lhs; }
+    ExprAST*     Rhs() const { return rhs; }
     void         accept(ASTVisitor& v) override
     {
 	lhs->accept(v);
@@ -499,8 +587,11 @@ public:
 private:
     llvm::Value* AssignStr();
     llvm::Value* AssignSet();
+    llvm::Value* AssignManaged();
     ExprAST*     lhs;
     ExprAST*     rhs;
+    // Finding the address of lhs may move the values in a map that rhs reads from.
+    bool         valueFirst;
 };
 
 class FunctionAST;
@@ -515,6 +606,7 @@ public:
     FunctionAST*               Function() { return func; }
     static bool                classof(const ExprAST* e) { return e->getKind() == EK_VarDecl; }
     const std::vector<VarDef>& Vars() { return vars; }
+    void                       accept(ASTVisitor& v) override;
 
 private:
     llvm::Value* CodeGenGlobal(VarDef var);
@@ -594,8 +686,28 @@ public:
     static bool             classof(const ExprAST* e) { return e->getKind() == EK_Function; }
     void                    accept(ASTVisitor& v) override;
     void                    EndLoc(const Location& loc) { endLoc = loc; }
+    // Set by {$fastmath on/off}, otherwise the enclosing function's (or global) setting is used.
+    void SetFastMath(bool on) { fastMathSetting = (on) ? FastMathOn : FastMathOff; }
+    bool IsFastMath() const;
+    // Set by {$hot} or {$cold} before the function or procedure.
+    enum Temperature
+    {
+	Normal,
+	Hot,
+	Cold,
+    };
+    void SetTemperature(Temperature t) { temperature = t; }
+    // Set by {$tailcall}: calls in tail position must be compiled as tail calls.
+    void SetTailCalls() { tailCalls = true; }
 
 private:
+    enum FastMathSetting
+    {
+	FastMathDefault,
+	FastMathOn,
+	FastMathOff,
+    };
+
     PrototypeAST*             proto;
     std::vector<VarDeclAST*>  varDecls;
     BlockAST*                 body;
@@ -604,6 +716,9 @@ private:
     FunctionAST*              parent;
     Types::TypeDecl*          closureType;
     Location                  endLoc;
+    FastMathSetting           fastMathSetting;
+    Temperature               temperature;
+    bool                      tailCalls;
 };
 
 class FunctionExprAST : public ExprAST
@@ -629,28 +744,39 @@ class CallExprAST : public AddressableAST
 
 public:
     CallExprAST(const Location& w, ExprAST* c, const std::vector<ExprAST*>& a, const PrototypeAST* p)
-        : AddressableAST(w, EK_CallExpr, p->Type()), proto(p), callee(c), args(a)
+        : AddressableAST(w, EK_CallExpr, p->Type()), proto(p), callee(c), args(a), tailCall(false)
     {
 	ICE_IF(!proto, "Should have prototype!");
     }
     void                   DoDump() const override;
     llvm::Value*           CodeGen() override;
+    llvm::Value*           Address() override;
     static bool            classof(const ExprAST* e) { return e->getKind() == EK_CallExpr; }
     const PrototypeAST*    Proto() { return proto; }
     ExprAST*               Callee() const { return callee; }
     std::vector<ExprAST*>& Args() { return args; }
     void                   accept(ASTVisitor& v) override;
+    void                   SetTailCall(const std::string& owned)
+    {
+	tailCall = true;
+	callerOwned = owned;
+    }
 
 private:
+    std::string TailCallProblem(llvm::FunctionType* ft, const std::vector<llvm::Value*>& argsV) const;
+
     const PrototypeAST*   proto;
     ExprAST*              callee;
     std::vector<ExprAST*> args;
+    bool                  tailCall;
+    std::string           callerOwned;
 };
 
 // Builtin function call
 class BuiltinExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     BuiltinExprAST(const Location& w, Builtin::FunctionBase* b)
@@ -661,6 +787,8 @@ public:
     llvm::Value* CodeGen() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_BuiltinExpr; }
     void         accept(ASTVisitor& v) override;
+    // Arguments may be converted by semantic analysis, so the function knows the type best.
+    Types::TypeDecl* Type() const override { return bif->Type(); }
 
 private:
     Builtin::FunctionBase* bif;
@@ -669,6 +797,7 @@ private:
 class IfExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     IfExprAST(const Location& w, ExprAST* c, ExprAST* t, ExprAST* e)
@@ -679,6 +808,8 @@ public:
     llvm::Value* CodeGen() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_IfExpr; }
     void         accept(ASTVisitor& v) override;
+    ExprAST*     Then() const { return then; }
+    ExprAST*     Else() const { return other; }
 
 private:
     ExprAST* cond;
@@ -690,34 +821,77 @@ class ForExprAST : public ExprAST
 {
 public:
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
     ForExprAST(const Location& w, VariableExprAST* v, ExprAST* s, ExprAST* e, bool down, ExprAST* b)
-        : ExprAST(w, EK_ForExpr), variable(v), start(s), stepDown(down), end(e), body(b)
+        : ExprAST(w, EK_ForExpr)
+        , variable(v)
+        , start(s)
+        , stepDown(down)
+        , end(e)
+        , body(b)
+        , parallelFn(nullptr)
+        , chunkSize(0)
     {
     }
     // for-in-set
     ForExprAST(const Location& w, VariableExprAST* v, ExprAST* s, ExprAST* b)
-        : ExprAST(w, EK_ForExpr), variable(v), start(s), stepDown(false), end(nullptr), body(b)
+        : ExprAST(w, EK_ForExpr)
+        , variable(v)
+        , start(s)
+        , stepDown(false)
+        , end(nullptr)
+        , body(b)
+        , parallelFn(nullptr)
+        , chunkSize(0)
+    {
+    }
+    enum class ReduceOp
+    {
+	Add,
+	Mul,
+	Min,
+	Max,
+    };
+    struct Reduction
+    {
+	ReduceOp         op;
+	VariableExprAST* var;
+    };
+    // {$parallel} for: The body is outlined into fn, which the runtime calls for each chunk.
+    void SetParallel(FunctionAST* fn, const std::vector<Reduction>& r, int chunk)
     {
+	parallelFn = fn;
+	reductions = r;
+	chunkSize = chunk;
     }
+    void         SetLoopHints(const LoopHints& h) { hints = h; }
     void         DoDump() const override;
     llvm::Value* CodeGen() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_ForExpr; }
     void         accept(ASTVisitor& v) override;
 
 private:
-    llvm::Value* ForInGen();
+    llvm::Value*    ForInGen();
+    llvm::Value*    ForInMapGen();
+    llvm::Value*    ParallelGen();
+    llvm::Function* ParallelThunk(llvm::StructType* ctxTy);
 
 private:
-    VariableExprAST* variable;
-    ExprAST*         start;
-    bool             stepDown; // true for "downto"
-    ExprAST*         end;
-    ExprAST*         body;
+    VariableExprAST*       variable;
+    ExprAST*               start;
+    bool                   stepDown; // true for "downto"
+    ExprAST*               end;
+    ExprAST*               body;
+    FunctionAST*           parallelFn;
+    std::vector<Reduction> reductions;
+    int                    chunkSize;
+    LoopHints              hints;
 };
 
 class WhileExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     WhileExprAST(const Location& w, ExprAST* c, ExprAST* b) : ExprAST(w, EK_WhileExpr), cond(c), body(b) {}
@@ -725,15 +899,18 @@ public:
     llvm::Value* CodeGen() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_WhileExpr; }
     void         accept(ASTVisitor& v) override;
+    void         SetLoopHints(const LoopHints& h) { hints = h; }
 
 private:
-    ExprAST* cond;
-    ExprAST* body;
+    ExprAST*  cond;
+    ExprAST*  body;
+    LoopHints hints;
 };
 
 class RepeatExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     RepeatExprAST(const Location& w, ExprAST* c, ExprAST* b) : ExprAST(w, EK_RepeatExpr), cond(c), body(b)
@@ -744,15 +921,18 @@ public:
     llvm::Value* CodeGen() override;
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_RepeatExpr; }
     void         accept(ASTVisitor& v) override;
+    void         SetLoopHints(const LoopHints& h) { hints = h; }
 
 private:
-    ExprAST* cond;
-    ExprAST* body;
+    ExprAST*  cond;
+    ExprAST*  body;
+    LoopHints hints;
 };
 
 class WriteAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     enum class WriteKind
@@ -816,8 +996,9 @@ class LabelExprAST : public ExprAST
     friend class TypeCheckVisitor;
 
 public:
-    LabelExprAST(const Location& w, const std::vector<std::pair<int, int>>& lab, ExprAST* st)
-        : ExprAST(w, EK_LabelExpr), labelValues(lab), stmt(st)
+    LabelExprAST(const Location& w, const std::vector<std::pair<int, int>>& lab, ExprAST* st,
+                 const std::vector<std::string>& str = {})
+        : ExprAST(w, EK_LabelExpr), labelValues(lab), labelStrings(str), stmt(st)
     {
     }
     void                                    DoDump() const override;
@@ -826,15 +1007,19 @@ public:
     static bool                             classof(const ExprAST* e) { return e->getKind() == EK_LabelExpr; }
     void                                    accept(ASTVisitor& v) override;
     const std::vector<std::pair<int, int>>& LabelValues() { return labelValues; }
+    const std::vector<std::string>&         LabelStrings() { return labelStrings; }
+    bool                                    IsGotoTarget() const { return !stmt; }
 
 private:
     std::vector<std::pair<int, int>> labelValues;
+    std::vector<std::string>         labelStrings;
     ExprAST*                         stmt;
 };
 
 class CaseExprAST : public ExprAST
 {
     friend class TypeCheckVisitor;
+    friend class ConstantFolder;
 
 public:
     CaseExprAST(const Location& w, ExprAST* e, const std::vector<LabelExprAST*>& lab, ExprAST* other)
@@ -846,6 +1031,10 @@ public:
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_CaseExpr; }
     void         accept(ASTVisitor& v) override;
 
+private:
+    void StringCaseCodeGen(llvm::Value* str, llvm::BasicBlock* defaultBB,
+                           const std::vector<std::pair<LabelExprAST*, llvm::BasicBlock*>>& labbb);
+
 private:
     ExprAST*                   expr;
     std::vector<LabelExprAST*> labels;
@@ -908,6 +1097,8 @@ public:
 
 class TypeCastAST : public AddressableAST
 {
+    friend class ConstantFolder;
+
 public:
     TypeCastAST(const Location& w, ExprAST* e, const Types::TypeDecl* t)
         : AddressableAST(w, EK_TypeCastExpr, const_cast<Types::TypeDecl*>(t)), expr(e){};
@@ -935,6 +1126,7 @@ public:
     }
     void             DoDump() const override;
     llvm::Value*     CodeGen() override;
+    Types::TypeDecl* Type() const override;
     static bool      classof(const ExprAST* e) { return e->getKind() == EK_SizeOfExpr; }
 
 private:
@@ -1046,6 +1238,8 @@ public:
     static bool  classof(const ExprAST* e) { return e->getKind() == EK_InitValue; }
     llvm::Value* CodeGen() override;
     void         DoDump() const override;
+    // No values means all zero, the default of a type without an initial value.
+    bool         IsZero() const { return values.empty(); }
 
 private:
     std::vector<ExprAST*> values;
@@ -1060,9 +1254,10 @@ public:
         : ExprAST(w, EK_InitArray, ty), values(v)
     {
     }
-    static bool  classof(const ExprAST* e) { return e->getKind() == EK_InitArray; }
-    llvm::Value* CodeGen() override;
-    void         DoDump() const override;
+    static bool                   classof(const ExprAST* e) { return e->getKind() == EK_InitArray; }
+    llvm::Value*                  CodeGen() override;
+    void                          DoDump() const override;
+    const std::vector<ArrayInit>& Values() const { return values; }
 
 private:
     std::vector<ArrayInit> values;
@@ -1123,16 +1318,41 @@ private:
 llvm::Constant*      MakeIntegerConstant(int val);
 llvm::Constant*      MakeBooleanConstant(int val);
 llvm::Constant*      MakeConstant(uint64_t val, Types::TypeDecl* ty);
+llvm::APInt          ConstantIntValue(IntegerExprAST* e);
+ExprAST*             MakeIntegerExpr(const Location& w, const llvm::APInt& v, Types::TypeDecl* ty);
 llvm::Value*         MakeAddressable(ExprAST* e);
+llvm::Align          KnownAlignment(const ExprAST* e);
+bool                 IsPackedComponent(const ExprAST* e);
+llvm::Value*         ToStorage(const Types::TypeDecl* ty, llvm::Value* v);
+llvm::Value*         FromStorage(const Types::TypeDecl* ty, llvm::Value* v);
 llvm::Value*         MakeStringFromExpr(ExprAST* e, Types::TypeDecl* ty);
 void                 BackPatch();
+int                  GetErrors();
+llvm::Value*         LoadBitPacked(Types::ArrayDecl* ty, llvm::Value* base, llvm::Value* index);
+void                 StoreBitPacked(Types::ArrayDecl* ty, llvm::Value* base, llvm::Value* index,
+                                    llvm::Value* v);
 llvm::FunctionCallee GetFunction(llvm::Type* resTy, const std::vector<llvm::Type*>& args,
                                  const std::string& name);
+llvm::FunctionCallee GetErrorFunction(const std::vector<llvm::Type*>& args, const std::string& name);
+void                 CreateRangeCheck(const Location& loc, llvm::Value* index, llvm::Value* low,
+                                      llvm::Value* count);
+std::string          FloatIntrinsicName(const std::string& name, llvm::Type* ty);
 ExprAST*             Recast(ExprAST* a, const Types::TypeDecl* ty);
 size_t               AlignOfType(llvm::Type* ty);
 llvm::AllocaInst*    CreateTempAlloca(Types::TypeDecl* ty);
 llvm::Value*         MakeStrCompare(Token::TokenType oper, llvm::Value* v);
 llvm::Value*         CallStrFunc(const std::string& name, ExprAST* lhs, ExprAST* rhs, Types::TypeDecl* resTy,
                                  const std::string& twine);
+llvm::Value*         CallHeapArrayFunc(const std::string& name, const Types::HeapArrayDecl* ty,
+                                       std::vector<llvm::Value*> args);
+llvm::Value*         CallManagedFunc(const std::string& name, const Types::TypeDecl* ty,
+                                     std::vector<llvm::Value*> args);
+llvm::Value*         CallMapKeyFunc(const std::string& name, ExprAST* map, ExprAST* key, llvm::Type* resTy);
+bool                 RecastMapKey(ExprAST*& key, const Types::MapDecl* mty);
+
+// Called for each top-level function as soon as its code is complete, with the functions nested in it
+// first and the top-level function last.
+using FunctionCompleteHook = std::function<void(const std::vector<llvm::Function*>&)>;
+void SetFunctionCompleteHook(FunctionCompleteHook hook);
 
 #endif
@@ -1,6 +1,7 @@
 #include "binary.h"
 #include "builtin.h"
 #include "callgraph.h"
+#include "constfold.h"
 #include "constants.h"
 #include "lexer.h"
 #include "options.h"
@@ -26,17 +27,24 @@
 std::string   libpath;
 llvm::Module* theModule;
 
-int      verbosity;
-bool     timetrace;
-bool     disableMemcpyOpt;
-OptLevel optimization = O1;
-bool     rangeCheck;
-bool     debugInfo;
-bool     callGraph;
-Model    model = m64;
-bool     caseInsensitive = true;
-EmitType emitType;
-Standard standard = none;
+int        verbosity;
+bool       timetrace;
+bool       disableMemcpyOpt;
+OptLevel   optimization = O1;
+bool       rangeCheck;
+bool       debugInfo;
+bool       callGraph;
+Model      model = m64;
+bool       caseInsensitive = true;
+EmitType   emitType;
+Standard   standard = none;
+VecLib     vecLib = NoVecLib;
+bool       fastMath;
+bool       noHonorNaNs;
+FPContract fpContract = FPContractOff;
+bool       reorderFields;
+bool       fastCompile;
+bool       streamCompile;
 
 // Command line option definitions.
 static llvm::cl::opt<std::string> InputFilename(llvm::cl::Positional, llvm::cl::Required,
@@ -86,48 +94,102 @@ static llvm::cl::opt<Standard, true> StandardOpt("std", llvm::cl::desc("ISO stan
                                                                   clEnumVal(iso10206, "ISO-10206 mode")),
                                                  llvm::cl::location(standard));
 
-static void RunOptimisationPasses(llvm::Module& theModule)
+static llvm::cl::opt<VecLib, true> VecLibOpt(
+    "fveclib", llvm::cl::desc("Vector library for math functions in vectorised loops"),
+    llvm::cl::values(clEnumValN(NoVecLib, "none", "No vector library"),
+                     clEnumValN(LibmVec, "libmvec", "GNU libmvec"), clEnumValN(Sleef, "sleef", "SLEEF"),
+                     clEnumValN(SVML, "svml", "Intel SVML"),
+                     clEnumValN(Runtime, "runtime", "Vector functions in the lacsap runtime")),
+    llvm::cl::location(vecLib));
+
+// Not -ffast-math, as that is taken by an LLVM backend.
+static llvm::cl::opt<bool, true> FastMathOpt("fastmath",
+                                             llvm::cl::desc("Allow optimisations that break IEEE rules"),
+                                             llvm::cl::location(fastMath));
+
+static llvm::cl::opt<bool, true> NoHonorNaNsOpt("fno-honor-nans",
+                                                llvm::cl::desc("Assume no arguments or results are NaN"),
+                                                llvm::cl::location(noHonorNaNs));
+
+static llvm::cl::opt<FPContract, true> FPContractOpt(
+    "ffp-contract", llvm::cl::desc("Form fused multiply-add:"),
+    llvm::cl::values(clEnumValN(FPContractOff, "off", "Never"),
+                     clEnumValN(FPContractOn, "on", "Within an expression"),
+                     clEnumValN(FPContractFast, "fast", "Anywhere")),
+    llvm::cl::location(fpContract));
+
+static llvm::cl::opt<bool, true> ReorderFieldsOpt(
+    "freorder-fields", llvm::cl::desc("Reorder fields of records to reduce padding"),
+    llvm::cl::location(reorderFields));
+
+static llvm::cl::opt<bool, true> StreamCompileOpt(
+    "fstream", llvm::cl::desc("Optimise and emit each top-level function as soon as it is generated"),
+    llvm::cl::location(streamCompile));
+
+static llvm::cl::opt<bool, true> FastCompileOpt(
+    "Ofast-compile", llvm::cl::desc("Minimise compile time rather than code quality (implies -O0)"),
+    llvm::cl::location(fastCompile));
+
+static llvm::OptimizationLevel LlvmOptimizationLevel()
 {
-    llvm::OptimizationLevel opt;
-    switch (OptimizationLevel)
+    switch (optimization)
     {
     case O0:
-	opt = llvm::OptimizationLevel::O0;
-	break;
+	return llvm::OptimizationLevel::O0;
     case O1:
-	opt = llvm::OptimizationLevel::O1;
-	break;
+	return llvm::OptimizationLevel::O1;
     case O2:
-	opt = llvm::OptimizationLevel::O2;
-	break;
+	return llvm::OptimizationLevel::O2;
     case O3:
-	opt = llvm::OptimizationLevel::O3;
-	break;
+	return llvm::OptimizationLevel::O3;
     default:
 	std::cerr << "Unknown optimisaton level" << std::endl;
 	std::exit(1);
-	break;
     }
+}
 
-    if (opt != llvm::OptimizationLevel::O0)
+class Optimiser
+{
+public:
+    Optimiser(llvm::Module& m, llvm::OptimizationLevel opt)
+        : level(opt)
+        , triple(m.getTargetTriple())
+        , tm(CreateTargetMachine(triple))
+        , tlii(CreateTargetLibraryInfo(triple))
+        , pb(tm.get())
     {
-	llvm::PassBuilder pb;
-
-	llvm::LoopAnalysisManager     lam;
-	llvm::FunctionAnalysisManager fam;
-	llvm::CGSCCAnalysisManager    cgam;
-	llvm::ModuleAnalysisManager   mam;
-
+	// Let the vectoriser know the target, and which math functions have vector versions.
+	fam.registerPass([&] { return llvm::TargetLibraryAnalysis(*tlii); });
 	pb.registerModuleAnalyses(mam);
 	pb.registerCGSCCAnalyses(cgam);
 	pb.registerFunctionAnalyses(fam);
 	pb.registerLoopAnalyses(lam);
 	pb.crossRegisterProxies(lam, fam, cgam, mam);
+    }
 
-	llvm::ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(opt);
-	mpm.run(theModule, mam);
+    // Cached analyses are dropped afterwards, as -fstream runs this on modules that are freed once emitted.
+    void RunModulePasses(llvm::Module& m)
+    {
+	TIME_TRACE();
+	llvm::ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(level);
+	mpm.run(m, mam);
+	lam.clear();
+	fam.clear();
+	cgam.clear();
+	mam.clear();
     }
-}
+
+private:
+    llvm::OptimizationLevel                      level;
+    llvm::Triple                                 triple;
+    std::unique_ptr<llvm::TargetMachine>         tm;
+    std::unique_ptr<llvm::TargetLibraryInfoImpl> tlii;
+    llvm::PassBuilder                            pb;
+    llvm::LoopAnalysisManager                    lam;
+    llvm::FunctionAnalysisManager                fam;
+    llvm::CGSCCAnalysisManager                   cgam;
+    llvm::ModuleAnalysisManager                  mam;
+};
 
 static int Compile(const std::string& fileName)
 {
@@ -160,6 +222,8 @@ static int Compile(const std::string& fileName)
 	return 1;
     }
 
+    FoldConstants(ast);
+
     if (emitType == AST)
     {
 	ast->dump();
@@ -172,6 +236,29 @@ static int Compile(const std::string& fileName)
 	CallGraph(ast, p);
     }
 
+    std::unique_ptr<Optimiser> optimiser;
+    llvm::OptimizationLevel    opt = LlvmOptimizationLevel();
+    if (opt != llvm::OptimizationLevel::O0)
+    {
+	optimiser = std::make_unique<Optimiser>(*theModule, opt);
+    }
+    // Each top-level function goes to an object file of its own, and its IR is freed, as soon as it
+    // is complete. The module passes then only see what is left: globals, the main program and helpers.
+    // Debug information refers to types that are only completed at the end, so -g keeps one module.
+    if (streamCompile && emitType == Exe && !debugInfo)
+    {
+	SetFunctionCompleteHook(
+	    [&](const std::vector<llvm::Function*>& funcs)
+	    {
+		std::unique_ptr<llvm::Module> m = MoveToModule(theModule, funcs);
+		if (optimiser)
+		{
+		    optimiser->RunModulePasses(*m);
+		}
+		CreateStreamedObject(m.get(), fileName);
+	    });
+    }
+
     {
 	TIME_TRACE();
 	if (!ast->CodeGen())
@@ -183,6 +270,12 @@ static int Compile(const std::string& fileName)
 	BackPatch();
     }
 
+    if (int e = GetErrors())
+    {
+	std::cerr << "Errors in code generation: " << e << ".\nExiting..." << std::endl;
+	return 1;
+    }
+
 #if !NDEBUG
     if (verbosity)
     {
@@ -190,7 +283,10 @@ static int Compile(const std::string& fileName)
     }
 #endif
 
-    RunOptimisationPasses(*theModule);
+    if (optimiser)
+    {
+	optimiser->RunModulePasses(*theModule);
+    }
     if (!CreateBinary(theModule, fileName, EmitSelection))
     {
 	return 1;
@@ -202,6 +298,10 @@ int main(int argc, char** argv)
 {
     libpath = GetPath(argv[0]);
     llvm::cl::ParseCommandLineOptions(argc, argv);
+    if (fastCompile)
+    {
+	optimization = O0;
+    }
     int res = Compile(InputFilename);
     return res;
 }
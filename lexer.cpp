@@ -248,7 +248,34 @@ static const SingleCharToken singleCharTokenTable[] = {
     { '@', Token::At },
 };
 
+// Comments starting with '$' are compiler directives, e.g. {$parallel}. They are
+// stored (without the '$') and attached to the next token.
+void Lexer::AddDirective(const std::string& text)
+{
+    if (text.empty() || text[0] != '$')
+    {
+	return;
+    }
+    std::string::size_type first = text.find_first_not_of(" \t\n", 1);
+    std::string::size_type last = text.find_last_not_of(" \t\n");
+    if (first != std::string::npos)
+    {
+	directives.push_back(text.substr(first, last - first + 1));
+    }
+}
+
 Token Lexer::GetToken()
+{
+    Token token = ReadToken();
+    if (!directives.empty())
+    {
+	token.SetDirectives(directives);
+	directives.clear();
+    }
+    return token;
+}
+
+Token Lexer::ReadToken()
 {
     int             ch = CurChar();
     const Location& w = Where();
@@ -262,17 +289,25 @@ Token Lexer::GetToken()
 
 	if (ch == '{')
 	{
+	    std::string text;
 	    while ((ch = NextChar()) != EOF && ch != '}')
-		;
+	    {
+		text += static_cast<char>(ch);
+	    }
 	    ch = NextChar();
+	    AddDirective(text);
 	}
 	if (ch == '(' && PeekChar() == '*')
 	{
 	    NextChar(); /* Skip first * */
+	    std::string text;
 	    while ((ch = NextChar()) != EOF && !(ch == '*' && PeekChar() == ')'))
-		;
+	    {
+		text += static_cast<char>(ch);
+	    }
 	    NextChar();
 	    ch = NextChar();
+	    AddDirective(text);
 	}
 	// C++ style comments.
 	if (ch == '/' && PeekChar() == '/')
@@ -283,7 +318,7 @@ Token Lexer::GetToken()
 	    } while (ch != '\n' && ch != EOF);
 	}
 
-    } while (isspace(ch));
+    } while (isspace(ch) || ch == '{');
 
     // EOF -> return now...
     if (ch == EOF)
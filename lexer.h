@@ -9,6 +9,7 @@
 #include <exception>
 #include <fstream>
 #include <string>
+#include <vector>
 
 class Lexer
 {
@@ -23,8 +24,10 @@ private:
     int PeekChar();
     int GetChar();
 
+    Token ReadToken();
     Token NumberToken();
     Token StringToken();
+    void  AddDirective(const std::string& text);
 
     Location Where() const { return source; }
 
@@ -33,6 +36,8 @@ private:
     int     curChar;
     int     nextChar;
     int     curValid;
+
+    std::vector<std::string> directives;
 };
 
 #endif
@@ -1,8 +1,26 @@
 #include "location.h"
+#include "utils.h"
+#include <algorithm>
+#include <limits>
 
 std::string Location::to_string() const
 {
-    return fname + ":" + std::to_string(lineNum) + ":" + std::to_string(column) + ":";
+    return FileName() + ":" + std::to_string(LineNumber()) + ":" + std::to_string(Column()) + ":";
+}
+
+const std::string& Location::FileName() const
+{
+    return GetSourceManager().FileName(offset);
+}
+
+unsigned int Location::LineNumber() const
+{
+    return GetSourceManager().LineAndColumn(offset).first;
+}
+
+unsigned int Location::Column() const
+{
+    return GetSourceManager().LineAndColumn(offset).second;
 }
 
 std::ostream& operator<<(std::ostream& os, const Location& loc)
@@ -10,3 +28,61 @@ std::ostream& operator<<(std::ostream& os, const Location& loc)
     os << loc.to_string();
     return os;
 }
+
+size_t SourceManager::AddFile(const std::string& name, uint32_t size)
+{
+    uint32_t start = (files.empty()) ? 1 : files.back().end + 1;
+    ICE_IF(size >= std::numeric_limits<uint32_t>::max() - start, "Too much source for 32-bit locations");
+    files.push_back({ name, start + size, { start } });
+    return files.size() - 1;
+}
+
+void SourceManager::AddLine(size_t file, uint32_t start)
+{
+    files[file].lineStarts.push_back(start);
+}
+
+uint32_t SourceManager::LineStart(size_t file, uint32_t line) const
+{
+    const std::vector<uint32_t>& lineStarts = files[file].lineStarts;
+    if (line == 0 || line > lineStarts.size())
+    {
+	return lineStarts[0];
+    }
+    return lineStarts[line - 1];
+}
+
+const SourceManager::File* SourceManager::FindFile(uint32_t offset) const
+{
+    auto it = std::lower_bound(files.begin(), files.end(), offset,
+                               [](const File& f, uint32_t off) { return f.end < off; });
+    if (!offset || it == files.end())
+    {
+	return 0;
+    }
+    return &*it;
+}
+
+const std::string& SourceManager::FileName(uint32_t offset) const
+{
+    static const std::string none;
+    const File*              f = FindFile(offset);
+    return (f) ? f->name : none;
+}
+
+std::pair<unsigned int, unsigned int> SourceManager::LineAndColumn(uint32_t offset) const
+{
+    const File* f = FindFile(offset);
+    if (!f)
+    {
+	return { 0, 0 };
+    }
+    auto line = std::upper_bound(f->lineStarts.begin(), f->lineStarts.end(), offset) - 1;
+    return { line - f->lineStarts.begin() + 1, offset - *line + 1 };
+}
+
+SourceManager& GetSourceManager()
+{
+    static SourceManager sm;
+    return sm;
+}
@@ -1,28 +1,59 @@
 #ifndef LOCATION_H
 #define LOCATION_H
 
+#include <cstdint>
 #include <ostream>
 #include <string>
+#include <vector>
 
+// A position in the source, as an offset into the range of offsets the SourceManager gave
+// its file. The file name, line and column are looked up from the offset when needed.
 class Location
 {
 public:
-    Location(const std::string& file = "", int line = 0, int col = 0)
-        : fname(file), lineNum(line), column(col)
-    {
-    }
-    std::string to_string() const;
-    std::string FileName() const { return fname; }
-    operator bool() const { return fname != "" || lineNum != 0; }
-    unsigned int LineNumber() const { return lineNum; }
-    unsigned int Column() const { return column; }
+    Location() : offset(0) {}
+    explicit Location(uint32_t offset) : offset(offset) {}
+    std::string        to_string() const;
+    const std::string& FileName() const;
+    operator bool() const { return offset != 0; }
+    unsigned int LineNumber() const;
+    unsigned int Column() const;
 
 private:
-    std::string  fname;
-    unsigned int lineNum;
-    unsigned int column;
+    uint32_t offset;
 };
 
 std::ostream& operator<<(std::ostream& os, const Location& loc);
 
+// Each source file gets a range of offsets, one per character and one for the end of the
+// file, following on from the previous file. Offset zero is not in any file, so that a
+// default Location is not a position. The start of each line is added as the file is read.
+class SourceManager
+{
+public:
+    // Returns the index of the file.
+    size_t   AddFile(const std::string& name, uint32_t size);
+    void     AddLine(size_t file, uint32_t start);
+    uint32_t FileStart(size_t file) const { return files[file].lineStarts[0]; }
+    // The start of the file for lines that have not been read.
+    uint32_t LineStart(size_t file, uint32_t line) const;
+
+    const std::string& FileName(uint32_t offset) const;
+    // Line and column, both counting from 1.
+    std::pair<unsigned int, unsigned int> LineAndColumn(uint32_t offset) const;
+
+private:
+    struct File
+    {
+	std::string           name;
+	uint32_t              end;
+	std::vector<uint32_t> lineStarts;
+    };
+    const File* FindFile(uint32_t offset) const;
+
+    std::vector<File> files;
+};
+
+SourceManager& GetSourceManager();
+
 #endif
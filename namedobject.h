@@ -51,7 +51,7 @@ public:
     };
 
     VarDef(const std::string& nm, Types::TypeDecl* ty, Flags f = Flags::None)
-        : NamedObject(NK_Var, nm, ty), flags(f), init(0)
+        : NamedObject(NK_Var, nm, ty), flags(f), init(0), align(0)
     {
 	ICE_IF(!ty, "Expect a type!");
 	ICE_IF((static_cast<int>(flags) & ~static_cast<int>(Flags::All)) != 0, "Unexpected flags set");
@@ -63,11 +63,15 @@ public:
     Flags       GetFlags() const { return flags; }
     ExprAST*    Init() { return init; }
     void        SetInit(ExprAST* i) { init = i; }
+    // Alignment given with {$align N}, or zero.
+    size_t      Align() const { return align; }
+    void        SetAlign(size_t a) { align = a; }
     static bool classof(const NamedObject* e) { return e->getKind() == NK_Var; }
 
 private:
     Flags    flags;
     ExprAST* init;
+    size_t   align;
 };
 
 constexpr VarDef::Flags operator&(const VarDef::Flags a, const VarDef::Flags b)
@@ -31,6 +31,22 @@ enum Standard
     iso10206,
 };
 
+enum FPContract
+{
+    FPContractOff,
+    FPContractOn,
+    FPContractFast,
+};
+
+enum VecLib
+{
+    NoVecLib,
+    LibmVec,
+    Sleef,
+    SVML,
+    Runtime,
+};
+
 extern int         verbosity;
 extern bool        timetrace;
 extern bool        disableMemcpyOpt;
@@ -42,5 +58,12 @@ extern Model       model;
 extern bool        caseInsensitive;
 extern EmitType    emitType;
 extern Standard    standard;
+extern VecLib      vecLib;
+extern bool        fastMath;
+extern bool        noHonorNaNs;
+extern FPContract  fpContract;
+extern bool        reorderFields;
+extern bool        fastCompile;
+extern bool        streamCompile;
 extern std::string libpath;
 #endif
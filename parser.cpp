@@ -85,6 +85,10 @@ public:
     ExprAST* ParseRepeat();
     ExprAST* ParseIfExpr();
     ExprAST* ParseForExpr();
+    ExprAST* ParseParallelFor(const Location& loc, VariableExprAST* varExpr, ExprAST* start, ExprAST* end,
+                              bool down, const std::string& args, const LoopHints& hints);
+    bool     ParseLoopHints(const Token& token, LoopHints& hints);
+    bool     ParseAlignDirective(const Token& token, size_t& align);
     ExprAST* ParseWhile();
     ExprAST* ParseCaseExpr();
     ExprAST* ParseWithBlock();
@@ -138,16 +142,19 @@ public:
     Types::TypeDecl* ParseType(const std::string& name, Forwarding maybeForwarded, Types::Schema* schema = 0);
     Types::EnumDecl*    ParseEnumDef();
     Types::PointerDecl* ParsePointerType(Forwarding maybeForwarded);
-    Types::TypeDecl*    ParseArrayDecl(Types::Schema* schema = 0);
+    Types::TypeDecl*    ParseArrayDecl(Types::Schema* schema = 0, bool packed = false);
+    Types::VectorDecl*  ParseVectorDecl();
+    Types::MapDecl*     ParseMapDecl();
     bool                ParseFields(std::vector<Types::FieldDecl*>& fields, Types::VariantDecl*& variant,
                                     Token::TokenType type);
-    Types::RecordDecl*  ParseRecordDecl();
+    Types::RecordDecl*  ParseRecordDecl(bool packed);
     Types::FileDecl*    ParseFileDecl();
     Types::SetDecl*     ParseSetDecl(Types::Schema* schema);
     Types::StringDecl*  ParseStringDecl();
     Types::VariantDecl* ParseVariantDecl(Types::FieldDecl*& markerField);
     int64_t             ParseConstantValue(Token::TokenType& tt, Types::TypeDecl*& type);
-    bool                ParseArgs(const NamedObject* def, std::vector<ExprAST*>& args);
+    bool                ParseArgs(const NamedObject* def, std::vector<ExprAST*>& args,
+                                  const std::string& builtinName = "");
     unsigned            ParseStringSize(Token::TokenType end);
 
     // Helper for syntax checking
@@ -163,6 +170,7 @@ public:
 
     // Helper functions for expression evaluation
     bool     IsCall(const NamedObject* def);
+    bool     IsFunctionName();
     ExprAST* MakeCallExpr(const NamedObject* def, std::vector<ExprAST*>& args);
     ExprAST* MakeSimpleCall(ExprAST* expr, const PrototypeAST* proto, const std::vector<ExprAST*>& args);
     ExprAST* MakeSelfCall(ExprAST* self, Types::MemberFuncDecl* mf, Types::ClassDecl* cd,
@@ -202,6 +210,9 @@ private:
     int                       errCnt;
     Stack<const NamedObject*> nameStack;
     std::vector<ExprAST*>     ast;
+    // Functions created by the parser (e.g. outlined parallel loop bodies), one level per function body.
+    std::vector<std::vector<FunctionAST*>> outlined;
+    int                                    outlinedCount;
 };
 
 using NameWrapper = StackWrapper<const NamedObject*>;
@@ -241,6 +252,88 @@ static ExpectConsuming ShouldConsume(Token::TokenType t, const TerminatorList& l
     ICE("Someone looked for a token that isn't in the list?");
 }
 
+// Find directive "name" attached to token. On success, args is the rest of the directive text.
+static bool FindDirective(const Token& token, const std::string& name, std::string& args)
+{
+    for (auto d : token.Directives())
+    {
+	std::string::size_type pos = d.find_first_of(" \t(");
+	std::string            dirName = d.substr(0, pos);
+	strlower(dirName);
+	if (dirName == name)
+	{
+	    args = (pos == std::string::npos) ? "" : d.substr(pos);
+	    return true;
+	}
+    }
+    return false;
+}
+
+static std::string Trim(const std::string& str)
+{
+    std::string::size_type first = str.find_first_not_of(" \t");
+    if (first == std::string::npos)
+    {
+	return "";
+    }
+    return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+}
+
+// Split directive arguments of the form "name(value) name=value name" into (name, value) pairs.
+// Names are lowercased, values are returned as written.
+static std::vector<std::pair<std::string, std::string>> SplitDirectiveArgs(const std::string& args)
+{
+    std::vector<std::pair<std::string, std::string>> result;
+    std::string::size_type                           pos = 0;
+    for (;;)
+    {
+	pos = args.find_first_not_of(" \t,", pos);
+	if (pos == std::string::npos)
+	{
+	    return result;
+	}
+	std::string::size_type end = args.find_first_of(" \t,(=", pos);
+	std::string            name = args.substr(pos, end - pos);
+	std::string            value;
+	strlower(name);
+	pos = args.find_first_not_of(" \t", end);
+	if (pos != std::string::npos && args[pos] == '(')
+	{
+	    end = args.find(')', pos);
+	    value = Trim(args.substr(pos + 1, end - pos - 1));
+	    pos = (end == std::string::npos) ? end : end + 1;
+	}
+	else if (pos != std::string::npos && args[pos] == '=')
+	{
+	    pos = args.find_first_not_of(" \t", pos + 1);
+	    end = args.find_first_of(" \t,", pos);
+	    value = (pos == std::string::npos) ? "" : args.substr(pos, end - pos);
+	    pos = end;
+	}
+	else
+	{
+	    pos = end;
+	}
+	result.push_back({ name, value });
+	if (pos == std::string::npos)
+	{
+	    return result;
+	}
+    }
+}
+
+// Returns the value of str if it is a positive integer, otherwise zero.
+static unsigned PositiveNumber(const std::string& str)
+{
+    char*         end;
+    unsigned long n = strtoul(str.c_str(), &end, 10);
+    if (str.empty() || *end || n > UINT_MAX)
+    {
+	return 0;
+    }
+    return n;
+}
+
 class ListConsumer
 {
 public:
@@ -460,8 +553,42 @@ ExprAST* Parser::ParseSizeOfExpr()
     return expr;
 }
 
+// All zero bytes are a valid value of ty, unless it holds an object's vtable pointer or a subrange
+// that excludes 0.
+static bool ZeroIsValid(const Types::TypeDecl* ty)
+{
+    if (auto rd = llvm::dyn_cast<Types::RangeDecl>(ty))
+    {
+	return rd->Start() <= 0 && rd->End() >= 0;
+    }
+    if (auto ad = llvm::dyn_cast<Types::ArrayDecl>(ty))
+    {
+	return ZeroIsValid(ad->SubType());
+    }
+    auto cd = llvm::dyn_cast<Types::ClassDecl>(ty);
+    if (cd && cd->VTableType(true))
+    {
+	return false;
+    }
+    if (auto fc = llvm::dyn_cast<Types::FieldCollection>(ty))
+    {
+	for (int i = 0; i < fc->FieldCount(); i++)
+	{
+	    const Types::FieldDecl* fd = fc->GetElement(i);
+	    if (!fd->IsStatic() && !ZeroIsValid(fd->SubType()))
+	    {
+		return false;
+	    }
+	}
+	auto rd = llvm::dyn_cast<Types::RecordDecl>(ty);
+	return !rd || !rd->Variant() || ZeroIsValid(rd->Variant());
+    }
+    return true;
+}
+
 ExprAST* Parser::ParseDefaultExpr()
 {
+    const Location loc = CurrentToken().Loc();
     AssertToken(Token::Default);
     if (!Expect(Token::LeftParen, ExpectConsume))
     {
@@ -483,6 +610,21 @@ ExprAST* Parser::ParseDefaultExpr()
     if (ty)
     {
 	expr = ty->Init();
+	if (!expr)
+	{
+	    if (ZeroIsValid(ty))
+	    {
+		expr = new InitValueAST(loc, ty, {});
+	    }
+	    else if (auto rd = llvm::dyn_cast<Types::RangeDecl>(ty))
+	    {
+		expr = new IntegerExprAST(loc, rd->Start(), ty);
+	    }
+	    else
+	    {
+		return Error("Type has no default value");
+	    }
+	}
     }
     if (!Expect(Token::RightParen, ExpectConsume))
     {
@@ -684,6 +826,11 @@ int64_t Parser::ParseConstantValue(Token::TokenType& tt, Types::TypeDecl*& type)
     return result;
 }
 
+static bool IsIntegerConst(const Constants::ConstDecl* c)
+{
+    return llvm::isa<Types::IntegerDecl>(c->Type()) || llvm::isa<Types::Int64Decl>(c->Type());
+}
+
 Types::RangeBaseDecl* Parser::ParseRange(Types::TypeDecl*& type, Token::TokenType endToken,
                                          Token::TokenType altToken, Types::Schema* schema)
 {
@@ -702,7 +849,16 @@ Types::RangeBaseDecl* Parser::ParseRange(Types::TypeDecl*& type, Token::TokenTyp
 	    int64_t end = Constants::ToInt(endC);
 
 	    type = startC->Type();
-	    ICE_IF(type != endC->Type(), "Expect same type on both sides");
+	    // An integer range that doesn't fit in 32 bits is a longint range.
+	    if (IsIntegerConst(startC) && IsIntegerConst(endC) &&
+	        (start < INT32_MIN || end > INT32_MAX || type != endC->Type()))
+	    {
+		type = Types::Get<Types::Int64Decl>();
+	    }
+	    else
+	    {
+		ICE_IF(type != endC->Type(), "Expect same type on both sides");
+	    }
 	    if (end <= start)
 	    {
 		return Error("Invalid range specification");
@@ -1484,10 +1640,30 @@ Types::PointerDecl* Parser::ParsePointerType(Forwarding maybeForwarded)
     return 0;
 }
 
-Types::TypeDecl* Parser::ParseArrayDecl(Types::Schema* schema)
+// {$soa} before array, of a record, stores each field of the records in an array of its own.
+Types::TypeDecl* Parser::ParseArrayDecl(Types::Schema* schema, bool packed)
 {
     TRACE();
+    const Token arrToken = CurrentToken();
     AssertToken(Token::Array);
+    std::string unused;
+    bool        soa = FindDirective(arrToken, "soa", unused);
+    if (AcceptToken(Token::Of))
+    {
+	if (packed || schema || soa)
+	{
+	    return Error("A dynamic array can't be packed, a schema or {$soa}");
+	}
+	if (Types::TypeDecl* ty = ParseType("", NoForwarding))
+	{
+	    if (llvm::isa<Types::MapDecl, Types::BigIntDecl>(ty))
+	    {
+		return Error("Elements of a dynamic array can't be maps or bigints");
+	    }
+	    return new Types::HeapArrayDecl(ty);
+	}
+	return 0;
+    }
     if (Expect(Token::LeftSquare, ExpectConsume))
     {
 	std::vector<Types::RangeBaseDecl*> rv;
@@ -1523,6 +1699,18 @@ Types::TypeDecl* Parser::ParseArrayDecl(Types::Schema* schema)
 	{
 	    if (Types::TypeDecl* ty = ParseType("", NoForwarding))
 	    {
+		if (Types::IsManaged(ty) && !dr)
+		{
+		    return Error("Elements of a fixed size array can't be dynamic arrays, maps or bigints");
+		}
+		if (soa)
+		{
+		    auto rd = llvm::dyn_cast<Types::RecordDecl>(ty);
+		    if (!rd || rd->Variant() || rd->IsPacked() || packed || dr || schema)
+		    {
+			return Error("{$soa} needs a fixed size array of records without variant part");
+		    }
+		}
 		if (dr)
 		{
 		    return new Types::DynArrayDecl(ty, dr);
@@ -1532,13 +1720,93 @@ Types::TypeDecl* Parser::ParseArrayDecl(Types::Schema* schema)
 		{
 		    return new Types::SchemaArrayDecl(ty, rv);
 		}
-		return new Types::ArrayDecl(ty, rv);
+		auto ad = new Types::ArrayDecl(ty, rv);
+		if (packed)
+		{
+		    ad->SetPacked();
+		}
+		if (soa)
+		{
+		    ad->SetSoA();
+		}
+		return ad;
 	    }
 	}
     }
     return 0;
 }
 
+// Parse "vector[N] of type", where N is a constant.
+Types::VectorDecl* Parser::ParseVectorDecl()
+{
+    TRACE();
+    AssertToken(Token::Identifier);
+    if (!Expect(Token::LeftSquare, ExpectConsume))
+    {
+	return 0;
+    }
+    const Constants::ConstDecl* cd = ParseConstExpr({ Token::RightSquare });
+    if (!cd)
+    {
+	return 0;
+    }
+    if (!IsIntegral(cd->Type()))
+    {
+	return Error("Expected integer constant for vector size");
+    }
+    int64_t count = Constants::ToInt(cd);
+    if (count < 2 || count > 1024)
+    {
+	return Error("Vector size should be between 2 and 1024");
+    }
+    if (!Expect(Token::RightSquare, ExpectConsume) || !Expect(Token::Of, ExpectConsume))
+    {
+	return 0;
+    }
+    Types::TypeDecl* ty = ParseType("", NoForwarding);
+    if (!ty)
+    {
+	return 0;
+    }
+    if (!llvm::isa<Types::IntegerDecl, Types::Int64Decl, Types::RealDecl, Types::BoolDecl>(ty))
+    {
+	return Error("Vector elements should be integer, longint, real or boolean");
+    }
+    return new Types::VectorDecl(ty, count);
+}
+
+// map of K to V
+// hashset of K
+Types::MapDecl* Parser::ParseMapDecl()
+{
+    TRACE();
+    bool isSet = CurrentToken().GetIdentName() == "hashset";
+    AssertToken(Token::Identifier);
+    AssertToken(Token::Of);
+    Types::TypeDecl* keyTy = ParseType("", NoForwarding);
+    if (!keyTy)
+    {
+	return 0;
+    }
+    if (!Types::MapDecl::IsKeyType(keyTy))
+    {
+	return Error("Keys should be ordinal, string, or records of those types");
+    }
+    Types::TypeDecl* valueTy = 0;
+    if (!isSet)
+    {
+	if (!Expect(Token::To, ExpectConsume) || !(valueTy = ParseType("", NoForwarding)))
+	{
+	    return 0;
+	}
+	if (Types::IsManaged(valueTy) || llvm::isa<Types::FileDecl>(valueTy))
+	{
+	    return Error("Map values can't be dynamic arrays, maps, bigints or files");
+	}
+    }
+    return new Types::MapDecl(keyTy, valueTy);
+}
+
 // Parse Variant declaration:
 // CASE [name:] typename OF
 //   constant: ({identifier {, identifier}: typename;});
@@ -1774,6 +2042,15 @@ bool Parser::ParseFields(std::vector<Types::FieldDecl*>& fields, Types::VariantD
 	    // Cope with empty classes - but not empty Record!
 	    if (!isClass || CurrentToken().GetToken() != Token::End)
 	    {
+		size_t align;
+		if (!ParseAlignDirective(CurrentToken(), align))
+		{
+		    return false;
+		}
+		if (align && isClass)
+		{
+		    return ErrorT(bool, "Align directive is not supported on class fields");
+		}
 		CCNames ccv(Token::Colon);
 		if (!ParseSeparatedList(*this, ccv))
 		{
@@ -1782,6 +2059,11 @@ bool Parser::ParseFields(std::vector<Types::FieldDecl*>& fields, Types::VariantD
 		ICE_IF(ccv.Names().empty(), "Should have some names here...");
 		if (Types::TypeDecl* ty = ParseType("", NoForwarding))
 		{
+		    if (Types::IsManaged(ty))
+		    {
+			return ErrorT(bool,
+			              "A dynamic array, map or bigint can't be a field of a record or class");
+		    }
 		    if (AcceptToken(Token::Value))
 		    {
 			ExprAST* init = ParseInitValue(ty);
@@ -1809,7 +2091,9 @@ bool Parser::ParseFields(std::vector<Types::FieldDecl*>& fields, Types::VariantD
 			    AssertToken(Token::Semicolon);
 			    AssertToken(Token::Static);
 			}
-			fields.push_back(new Types::FieldDecl(n, ty, isStatic, access));
+			auto fd = new Types::FieldDecl(n, ty, isStatic, access);
+			fd->SetAlign(align);
+			fields.push_back(fd);
 		    }
 		}
 		else
@@ -1826,9 +2110,35 @@ bool Parser::ParseFields(std::vector<Types::FieldDecl*>& fields, Types::VariantD
     return true;
 }
 
-Types::RecordDecl* Parser::ParseRecordDecl()
+// {$align n} before a record, field or variable aligns it to n bytes, where n is a power of two.
+// Sets align to zero when there is no such directive.
+bool Parser::ParseAlignDirective(const Token& token, size_t& align)
 {
+    std::string args;
+    align = 0;
+    if (FindDirective(token, "align", args))
+    {
+	align = PositiveNumber(Trim(args));
+	if (!align || (align & (align - 1)))
+	{
+	    return ErrorT(bool, "Expected a power of two in align directive");
+	}
+    }
+    return true;
+}
+
+// {$reorder} before record, or -freorder-fields, lets the compiler choose the order of the fields.
+Types::RecordDecl* Parser::ParseRecordDecl(bool packed)
+{
+    const Token recToken = CurrentToken();
     AssertToken(Token::Record);
+    size_t      align;
+    std::string unused;
+    bool        reorder = FindDirective(recToken, "reorder", unused);
+    if (!ParseAlignDirective(recToken, align))
+    {
+	return 0;
+    }
     std::vector<Types::FieldDecl*> fields;
     Types::VariantDecl*            variant;
     if (ParseFields(fields, variant, Token::Record))
@@ -1850,6 +2160,19 @@ Types::RecordDecl* Parser::ParseRecordDecl()
 	    index++;
 	}
 	auto rd = new Types::RecordDecl(fields, variant);
+	if (packed)
+	{
+	    rd->SetPacked();
+	}
+	if (reorder && (packed || variant))
+	{
+	    return Error("Cannot reorder the fields of a packed or variant record");
+	}
+	if ((reorder || reorderFields) && !packed && !variant)
+	{
+	    rd->SetReorder();
+	}
+	rd->SetAlign(align);
 	if (init.size())
 	{
 	    auto ir = new InitRecordAST(Location(), rd, init);
@@ -1867,6 +2190,10 @@ Types::FileDecl* Parser::ParseFileDecl()
     {
 	if (Types::TypeDecl* type = ParseType("", NoForwarding))
 	{
+	    if (Types::IsManaged(type))
+	    {
+		return Error("Can't have a file of dynamic arrays, maps or bigints");
+	    }
 	    return new Types::FileDecl(type);
 	}
     }
@@ -2024,7 +2351,8 @@ Types::TypeDecl* Parser::ParseType(const std::string& name, Forwarding maybeForw
 {
     TRACE();
     Token::TokenType tt = CurrentToken().GetToken();
-    if (AcceptToken(Token::Packed))
+    bool             packed = AcceptToken(Token::Packed);
+    if (packed)
     {
 	tt = CurrentToken().GetToken();
 	if (tt != Token::Array && tt != Token::Record && tt != Token::Set && tt != Token::File)
@@ -2062,6 +2390,18 @@ Types::TypeDecl* Parser::ParseType(const std::string& name, Forwarding maybeForw
 
     case Token::Identifier:
     {
+	// "vector" is not a reserved word, so only treat it as such if it's not otherwise declared.
+	if (CurrentToken().GetIdentName() == "vector" && PeekToken() == Token::LeftSquare &&
+	    !nameStack.Find("vector"))
+	{
+	    return ParseVectorDecl();
+	}
+	// Nor are "map" and "hashset".
+	const std::string& ident = CurrentToken().GetIdentName();
+	if ((ident == "map" || ident == "hashset") && PeekToken() == Token::Of && !nameStack.Find(ident))
+	{
+	    return ParseMapDecl();
+	}
 	if (!GetEnumValue(GetIdentifier(NoExpectConsume)))
 	{
 	    if (Types::TypeDecl* ty = ParseSimpleType(false))
@@ -2084,10 +2424,10 @@ Types::TypeDecl* Parser::ParseType(const std::string& name, Forwarding maybeForw
     }
 
     case Token::Array:
-	return ParseArrayDecl(schema);
+	return ParseArrayDecl(schema, packed);
 
     case Token::Record:
-	return ParseRecordDecl();
+	return ParseRecordDecl(packed);
 
     case Token::Class:
 	return ParseClassDecl(name);
@@ -2343,6 +2683,42 @@ ExprAST* Parser::ParseArrayExpr(ExprAST* expr, Types::TypeDecl*& type)
 
 	    return new DynArrayExprAST(CurrentToken().Loc(), expr, indices[0], dty->Range(), dty->SubType());
 	}
+	else if (auto hty = llvm::dyn_cast<Types::HeapArrayDecl>(type))
+	{
+	    if (llvm::isa<RangeExprAST>(indices[0]))
+	    {
+		return Error("Can't take a slice of a dynamic array");
+	    }
+	    type = hty->SubType();
+	    expr = new HeapArrayExprAST(CurrentToken().Loc(), expr, indices[0], type);
+	    taken++;
+	    indices.erase(indices.begin());
+	}
+	else if (auto mty = llvm::dyn_cast<Types::MapDecl>(type))
+	{
+	    if (mty->IsSet())
+	    {
+		return Error("A hashset has no values, use 'in' to look for a key");
+	    }
+	    type = mty->SubType();
+	    expr = new MapExprAST(CurrentToken().Loc(), expr, indices[0], type);
+	    taken++;
+	    indices.erase(indices.begin());
+	}
+	else if (auto vty = llvm::dyn_cast<Types::VectorDecl>(type))
+	{
+	    // Vector lanes are numbered from zero.
+	    if (indices.size() != 1)
+	    {
+		return Error("Too many indices");
+	    }
+	    if (llvm::isa<Types::BoolDecl>(vty->SubType()))
+	    {
+		return Error("Can't index a vector of boolean");
+	    }
+	    type = vty->SubType();
+	    return new ArrayExprAST(CurrentToken().Loc(), expr, indices, { vty->IndexRange() }, type);
+	}
 	else
 	{
 	    auto adecl = llvm::dyn_cast<Types::ArrayDecl>(type);
@@ -2352,6 +2728,10 @@ ExprAST* Parser::ParseArrayExpr(ExprAST* expr, Types::TypeDecl*& type)
 	    }
 	    if ((range = llvm::dyn_cast<RangeExprAST>(indices[0])) && (indices.size() == 1))
 	    {
+		if (adecl->IsSoA())
+		{
+		    return Error("Can't take a slice of a {$soa} array");
+		}
 		if (adecl->Ranges().size() == 1)
 		{
 		    expr = new ArraySliceAST(CurrentToken().Loc(), expr, range, adecl);
@@ -2625,6 +3005,23 @@ ExprAST* Parser::ParsePointerExpr(ExprAST* expr, Types::TypeDecl*& type)
     return Error("Expected pointer expression");
 }
 
+// A function or function pointer on its own, rather than an expression that calls it.
+bool Parser::IsFunctionName()
+{
+    if (CurrentToken().GetToken() != Token::Identifier)
+    {
+	return false;
+    }
+    const NamedObject* def = nameStack.Find(CurrentToken().GetIdentName());
+    if (!llvm::isa_and_nonnull<FuncDef>(def) &&
+        !(llvm::isa_and_nonnull<VarDef>(def) && llvm::isa<Types::FuncPtrDecl>(def->Type())))
+    {
+	return false;
+    }
+    Token::TokenType next = PeekToken();
+    return next == Token::Comma || next == Token::RightParen;
+}
+
 bool Parser::IsCall(const NamedObject* def)
 {
     ICE_IF(!def, "Expected def to be non-NULL");
@@ -2653,7 +3050,7 @@ bool Parser::IsCall(const NamedObject* def)
     return false;
 }
 
-bool Parser::ParseArgs(const NamedObject* def, std::vector<ExprAST*>& args)
+bool Parser::ParseArgs(const NamedObject* def, std::vector<ExprAST*>& args, const std::string& builtinName)
 {
     TRACE();
 
@@ -2685,6 +3082,10 @@ bool Parser::ParseArgs(const NamedObject* def, std::vector<ExprAST*>& args)
 		}
 		isFuncArg = llvm::isa<Types::FuncPtrDecl>(funcArgs[argNo].Type());
 	    }
+	    else if (!def)
+	    {
+		isFuncArg = Builtin::IsFunctionArg(builtinName, argNo) && IsFunctionName();
+	    }
 	    ExprAST* arg = 0;
 	    if (isFuncArg)
 	    {
@@ -2866,7 +3267,7 @@ ExprAST* Parser::ParseCallOrVariableExpr(const Token& token)
     // Have to check twice for `def` as we need args for both
     // builtin and regular functions.
     std::vector<ExprAST*> args;
-    if (!ParseArgs(def, args))
+    if (!ParseArgs(def, args, idName))
     {
 	return 0;
     }
@@ -3048,14 +3449,20 @@ public:
         : ListConsumer{ { Token::Comma, Token::Semicolon, { Token::Otherwise, NoExpectConsume } },
 	                { Token::RightSquare },
 	                ListConsumer::AllowEmpty::Yes }
-        , type(ty)
+        , elemType(ty->SubType())
     {
+	// Each value of a multidimensional array is a row, an array of the remaining dimensions.
+	const std::vector<Types::RangeBaseDecl*>& ranges = ty->Ranges();
+	if (ranges.size() > 1)
+	{
+	    elemType = new Types::ArrayDecl(ty->SubType(), { ranges.begin() + 1, ranges.end() });
+	}
     }
     bool Consume(Parser& parser) override
     {
 	if (parser.AcceptToken(Token::Otherwise))
 	{
-	    ExprAST* e = parser.ParseInitValue(type->SubType());
+	    ExprAST* e = parser.ParseInitValue(elemType);
 	    list.push_back({ e });
 	    return true;
 	}
@@ -3088,7 +3495,7 @@ public:
 		hasEnd = true;
 	    }
 	    parser.Expect(Token::Colon, ExpectConsume);
-	    ExprAST* e = parser.ParseInitValue(type->SubType());
+	    ExprAST* e = parser.ParseInitValue(elemType);
 	    if (!e)
 	    {
 		return false;
@@ -3109,7 +3516,7 @@ public:
 
 private:
     std::vector<ArrayInit> list;
-    Types::ArrayDecl*      type;
+    Types::TypeDecl*       elemType;
 };
 
 class CCRecordInitList : public ListConsumer
@@ -3175,6 +3582,10 @@ ExprAST* Parser::ParseInitValue(Types::TypeDecl* ty)
     TRACE();
 
     const Location loc = CurrentToken().Loc();
+    if (Types::IsManaged(ty))
+    {
+	return Error("A dynamic array, map or bigint can't have an initial value");
+    }
     if (llvm::isa<Types::SetDecl>(ty))
     {
 	if (ExprAST* e = ParseSetExpr(ty))
@@ -3252,7 +3663,12 @@ VarDeclAST* Parser::ParseVarDecls()
     do
     {
 	bool    good = false;
+	size_t  align;
 	CCNames ccv(Token::Colon);
+	if (!ParseAlignDirective(CurrentToken(), align))
+	{
+	    return 0;
+	}
 	if (ParseSeparatedList(*this, ccv))
 	{
 	    if (Types::TypeDecl* type = ParseType("", NoForwarding))
@@ -3260,6 +3676,7 @@ VarDeclAST* Parser::ParseVarDecls()
 		for (auto n : ccv.Names())
 		{
 		    VarDef v(n, type);
+		    v.SetAlign(align);
 		    varList.push_back(v);
 		    if (!nameStack.Add(new VarDef(v)))
 		    {
@@ -3565,12 +3982,34 @@ FunctionAST* Parser::ParseDefinition(int level)
 {
     TRACE();
 
+    Token         defToken = CurrentToken();
     PrototypeAST* proto = ParsePrototype(false);
     if (!proto || !Expect(Token::Semicolon, ExpectConsume))
     {
 	return 0;
     }
 
+    // {$fastmath on} or {$fastmath off} before the function or procedure.
+    std::string fastMathArgs;
+    bool        hasFastMath = FindDirective(defToken, "fastmath", fastMathArgs);
+    fastMathArgs = Trim(fastMathArgs);
+    strlower(fastMathArgs);
+    if (hasFastMath && fastMathArgs != "on" && fastMathArgs != "off")
+    {
+	return Error("Expected 'on' or 'off' for fastmath directive");
+    }
+
+    // {$hot} or {$cold} before the function or procedure.
+    std::string unused;
+    bool        isHot = FindDirective(defToken, "hot", unused);
+    bool        isCold = FindDirective(defToken, "cold", unused);
+    if (isHot && isCold)
+    {
+	return Error("Function can't be both hot and cold");
+    }
+    // {$tailcall} makes calls in tail position guaranteed tail calls.
+    bool tailCalls = FindDirective(defToken, "tailcall", unused);
+
     const Location&    loc = CurrentToken().Loc();
     const std::string& name = proto->Name();
     NamedObject*       nmObj = 0;
@@ -3709,7 +4148,14 @@ FunctionAST* Parser::ParseDefinition(int level)
 	    Location endLoc;
 	    ICE_IF(body, "Multiple body declarations for function?");
 
-	    if (!(body = ParseBlock(endLoc)) || !Expect(Token::Semicolon, ExpectConsume))
+	    outlined.push_back({});
+	    body = ParseBlock(endLoc);
+	    for (auto fn : outlined.back())
+	    {
+		subFunctions.push_back(fn);
+	    }
+	    outlined.pop_back();
+	    if (!body || !Expect(Token::Semicolon, ExpectConsume))
 	    {
 		return 0;
 	    }
@@ -3719,6 +4165,18 @@ FunctionAST* Parser::ParseDefinition(int level)
 	    {
 		proto->SetFunction(fn);
 	    }
+	    if (hasFastMath)
+	    {
+		fn->SetFastMath(fastMathArgs == "on");
+	    }
+	    if (isHot || isCold)
+	    {
+		fn->SetTemperature((isHot) ? FunctionAST::Hot : FunctionAST::Cold);
+	    }
+	    if (tailCalls)
+	    {
+		fn->SetTailCalls();
+	    }
 	    for (auto s : subFunctions)
 	    {
 		s->SetParent(fn);
@@ -3767,11 +4225,71 @@ ExprAST* Parser::ParseIfExpr()
     return new IfExprAST(loc, cond, then, elseExpr);
 }
 
+// Loop directives, given before for, while and repeat:
+// {$unroll [n|full]} {$nounroll} {$vectorize [width=n]} {$novectorize} {$interleave n} {$distribute}
+// and, for for-loops only, {$parallel}. Anything else is reported, so a misspelling isn't ignored.
+bool Parser::ParseLoopHints(const Token& token, LoopHints& hints)
+{
+    for (auto d : token.Directives())
+    {
+	std::string::size_type pos = d.find_first_of(" \t(");
+	std::string            name = d.substr(0, pos);
+	std::string            args = (pos == std::string::npos) ? "" : Trim(d.substr(pos));
+	strlower(name);
+	strlower(args);
+	if (name == "unroll")
+	{
+	    hints.unroll = (args == "full") ? LoopHints::Hint::Full : LoopHints::Hint::Enable;
+	    if (!args.empty() && args != "full" && !(hints.unrollCount = PositiveNumber(args)))
+	    {
+		return ErrorT(bool, "Expected 'full' or a positive count in unroll directive");
+	    }
+	}
+	else if (name == "nounroll")
+	{
+	    hints.unroll = LoopHints::Hint::Disable;
+	}
+	else if (name == "vectorize")
+	{
+	    hints.vectorize = LoopHints::Hint::Enable;
+	    for (auto clause : SplitDirectiveArgs(args))
+	    {
+		if (clause.first != "width" || !(hints.width = PositiveNumber(clause.second)))
+		{
+		    return ErrorT(bool, "Expected 'width=n' in vectorize directive");
+		}
+	    }
+	}
+	else if (name == "novectorize")
+	{
+	    hints.vectorize = LoopHints::Hint::Disable;
+	}
+	else if (name == "interleave")
+	{
+	    if (!(hints.interleave = PositiveNumber(args)))
+	    {
+		return ErrorT(bool, "Expected a positive count in interleave directive");
+	    }
+	}
+	else if (name == "distribute")
+	{
+	    hints.distribute = true;
+	}
+    }
+    return true;
+}
+
 ExprAST* Parser::ParseForExpr()
 {
     TRACE();
+    const Token forToken = CurrentToken();
     AssertToken(Token::For);
     const Location loc = CurrentToken().Loc();
+    LoopHints      hints;
+    if (!ParseLoopHints(forToken, hints))
+    {
+	return 0;
+    }
 
     std::string varName = GetIdentifier(ExpectConsume);
     if (varName.empty())
@@ -3807,9 +4325,16 @@ ExprAST* Parser::ParseForExpr()
 	    ExprAST* end = ParseExpression();
 	    if (end && Expect(Token::Do, ExpectConsume))
 	    {
+		std::string parArgs;
+		if (FindDirective(forToken, "parallel", parArgs))
+		{
+		    return ParseParallelFor(loc, varExpr, start, end, down, parArgs, hints);
+		}
 		if (ExprAST* body = ParseStatement())
 		{
-		    return new ForExprAST(loc, varExpr, start, end, down, body);
+		    ForExprAST* forExpr = new ForExprAST(loc, varExpr, start, end, down, body);
+		    forExpr->SetLoopHints(hints);
+		    return forExpr;
 		}
 	    }
 	}
@@ -3822,7 +4347,9 @@ ExprAST* Parser::ParseForExpr()
 	    {
 		if (ExprAST* body = ParseStatement())
 		{
-		    return new ForExprAST(loc, varExpr, start, body);
+		    ForExprAST* forExpr = new ForExprAST(loc, varExpr, start, body);
+		    forExpr->SetLoopHints(hints);
+		    return forExpr;
 		}
 	    }
 	}
@@ -3830,17 +4357,135 @@ ExprAST* Parser::ParseForExpr()
     return 0;
 }
 
+/* {$parallel [reduction(op: var, ...)] [chunk(n)]} for i := a to b do body
+ * The body is outlined into a nested procedure "parfor.N(lo, hi; var reductions...)" that runs
+ * "for i := lo to hi do body" with a local i. BuildClosures then takes care of the variables
+ * used from the enclosing function, and the runtime scheduler calls it for chunks of a..b.
+ */
+ExprAST* Parser::ParseParallelFor(const Location& loc, VariableExprAST* varExpr, ExprAST* start, ExprAST* end,
+                                  bool down, const std::string& args, const LoopHints& hints)
+{
+    TRACE();
+    Types::TypeDecl*                   ty = varExpr->Type();
+    std::vector<VarDef>                fnArgs{ VarDef("par.lo", ty), VarDef("par.hi", ty) };
+    std::vector<ForExprAST::Reduction> reductions;
+    int                                chunk = 0;
+    for (auto clause : SplitDirectiveArgs(args))
+    {
+	if (clause.first == "reduction")
+	{
+	    std::string::size_type colon = clause.second.find(':');
+	    if (colon == std::string::npos)
+	    {
+		return Error("Expected 'reduction(op: variables)' in parallel directive");
+	    }
+	    std::string op = Trim(clause.second.substr(0, colon));
+	    strlower(op);
+	    ForExprAST::ReduceOp reduceOp;
+	    if (op == "+")
+	    {
+		reduceOp = ForExprAST::ReduceOp::Add;
+	    }
+	    else if (op == "*")
+	    {
+		reduceOp = ForExprAST::ReduceOp::Mul;
+	    }
+	    else if (op == "min")
+	    {
+		reduceOp = ForExprAST::ReduceOp::Min;
+	    }
+	    else if (op == "max")
+	    {
+		reduceOp = ForExprAST::ReduceOp::Max;
+	    }
+	    else
+	    {
+		return Error("Unknown reduction operator '" + op + "', expected +, *, min or max");
+	    }
+	    for (auto v : SplitDirectiveArgs(clause.second.substr(colon + 1)))
+	    {
+		const NamedObject* def = nameStack.Find(v.first);
+		if (!def || !llvm::isa<VarDef>(def))
+		{
+		    return Error("Reduction of '" + v.first + "' must be a variable");
+		}
+		if (!IsNumeric(def->Type()) || llvm::isa<Types::ComplexDecl>(def->Type()))
+		{
+		    return Error("Reduction variable '" + v.first + "' must be integer or real");
+		}
+		if (def->Name() == varExpr->Name())
+		{
+		    return Error("Loop variable can't be used as reduction variable");
+		}
+		reductions.push_back({ reduceOp, new VariableExprAST(loc, def) });
+		fnArgs.push_back(VarDef(def->Name(), def->Type(), VarDef::Flags::Reference));
+	    }
+	}
+	else if (clause.first == "chunk")
+	{
+	    chunk = strtol(clause.second.c_str(), nullptr, 10);
+	    if (chunk <= 0)
+	    {
+		return Error("Chunk size in parallel directive should be a positive integer");
+	    }
+	}
+	else
+	{
+	    return Error("Unknown clause '" + clause.first + "' in parallel directive");
+	}
+    }
+
+    outlined.push_back({});
+    ExprAST*                  body = ParseStatement();
+    std::vector<FunctionAST*> subFunctions = outlined.back();
+    outlined.pop_back();
+    if (!body)
+    {
+	return 0;
+    }
+    ICE_IF(outlined.empty(), "Parallel for outside of function body?");
+
+    VariableExprAST* lo = new VariableExprAST(loc, "par.lo", ty);
+    VariableExprAST* hi = new VariableExprAST(loc, "par.hi", ty);
+    VariableExprAST* inner = new VariableExprAST(loc, varExpr->Name(), ty);
+    ForExprAST*      innerFor = new ForExprAST(loc, inner, lo, hi, false, body);
+    BlockAST*        block = new BlockAST(loc, { innerFor });
+    VarDeclAST*      loopVar = new VarDeclAST(loc, { VarDef(varExpr->Name(), ty) });
+    std::string      name = "parfor." + std::to_string(++outlinedCount);
+    PrototypeAST*    proto = new PrototypeAST(loc, name, fnArgs, Types::Get<Types::VoidDecl>(), "", 0);
+    FunctionAST*     fn = new FunctionAST(loc, proto, { loopVar }, block);
+    innerFor->SetLoopHints(hints);
+    for (auto s : subFunctions)
+    {
+	s->SetParent(fn);
+    }
+    fn->AddSubFunctions(subFunctions);
+    fn->EndLoc(loc);
+    outlined.back().push_back(fn);
+
+    ForExprAST* forExpr = new ForExprAST(loc, varExpr, start, end, down, new BlockAST(loc, {}));
+    forExpr->SetParallel(fn, reductions, chunk);
+    return forExpr;
+}
+
 ExprAST* Parser::ParseWhile()
 {
     TRACE();
     const Location loc = CurrentToken().Loc();
+    LoopHints      hints;
+    if (!ParseLoopHints(CurrentToken(), hints))
+    {
+	return 0;
+    }
     AssertToken(Token::While);
     ExprAST* cond = ParseExpression();
     if (cond && Expect(Token::Do, ExpectConsume))
     {
 	if (ExprAST* stmt = ParseStatement())
 	{
-	    return new WhileExprAST(loc, cond, stmt);
+	    WhileExprAST* whileExpr = new WhileExprAST(loc, cond, stmt);
+	    whileExpr->SetLoopHints(hints);
+	    return whileExpr;
 	}
     }
     return 0;
@@ -3850,6 +4495,11 @@ ExprAST* Parser::ParseRepeat()
 {
     TRACE();
     const Location loc = CurrentToken().Loc();
+    LoopHints      hints;
+    if (!ParseLoopHints(CurrentToken(), hints))
+    {
+	return 0;
+    }
     AssertToken(Token::Repeat);
     std::vector<ExprAST*> v;
     const Location        loc2 = CurrentToken().Loc();
@@ -3868,7 +4518,9 @@ ExprAST* Parser::ParseRepeat()
 
     if (ExprAST* cond = ParseExpression())
     {
-	return new RepeatExprAST(loc, cond, new BlockAST(loc2, v));
+	RepeatExprAST* repeatExpr = new RepeatExprAST(loc, cond, new BlockAST(loc2, v));
+	repeatExpr->SetLoopHints(hints);
+	return repeatExpr;
     }
     return 0;
 }
@@ -3885,8 +4537,12 @@ ExprAST* Parser::ParseCaseExpr()
     }
     std::vector<LabelExprAST*>       labels;
     std::vector<std::pair<int, int>> ranges;
+    std::vector<std::string>         strings;
     ExprAST*                         otherwise{ nullptr };
     Types::TypeDecl*                 type{ nullptr };
+    Types::TypeDecl*                 selTy = expr->Type();
+    // Single characters are strings too when the selector is a string.
+    bool isString = selTy && Types::IsStringLike(selTy) && !llvm::isa<Types::CharDecl>(selTy);
 
     do
     {
@@ -3897,7 +4553,7 @@ ExprAST* Parser::ParseCaseExpr()
 	    {
 		return Error("An 'otherwise' or 'else' already used in this case block");
 	    }
-	    if (ranges.size())
+	    if (ranges.size() || strings.size())
 	    {
 		return Error("Can't have multiple case labels with 'otherwise' or 'else' case label");
 	    }
@@ -3912,33 +4568,58 @@ ExprAST* Parser::ParseCaseExpr()
 	else
 	{
 	    const Constants::ConstDecl* cd = ParseConstExpr({ Token::Comma, Token::Colon, Token::DotDot });
-	    int                         value = Constants::ToInt(cd);
-	    if (type)
+	    if (!cd)
+	    {
+		return 0;
+	    }
+	    auto sc = llvm::dyn_cast<Constants::StringConstDecl>(cd);
+	    auto cc = llvm::dyn_cast<Constants::CharConstDecl>(cd);
+	    if (sc || (isString && cc))
 	    {
-		if (type != cd->Type())
+		if (!isString)
 		{
-		    return Error("Expected case labels to have same type");
+		    return Error("Expected case labels to have same type as the selector");
+		}
+		strings.push_back((sc) ? sc->Value() : std::string(1, cc->Value()));
+		if (CurrentToken().GetToken() == Token::DotDot)
+		{
+		    return Error("Can't have a range of string case labels");
 		}
 	    }
-	    else
+	    else if (isString)
 	    {
-		type = cd->Type();
+		return Error("Expected case labels to have same type as the selector");
 	    }
-	    int end = value;
-	    if (AcceptToken(Token::DotDot))
+	    else
 	    {
-		cd = ParseConstExpr({ Token::Comma, Token::Colon });
-		if (type != cd->Type())
+		int value = Constants::ToInt(cd);
+		if (type)
 		{
-		    return Error("Expected case labels to have same type");
+		    if (type != cd->Type())
+		    {
+			return Error("Expected case labels to have same type");
+		    }
 		}
-		end = Constants::ToInt(cd);
-		if (end <= value)
+		else
 		{
-		    return Error("Expected case label range to be low..high");
+		    type = cd->Type();
 		}
+		int end = value;
+		if (AcceptToken(Token::DotDot))
+		{
+		    cd = ParseConstExpr({ Token::Comma, Token::Colon });
+		    if (type != cd->Type())
+		    {
+			return Error("Expected case labels to have same type");
+		    }
+		    end = Constants::ToInt(cd);
+		    if (end <= value)
+		    {
+			return Error("Expected case label range to be low..high");
+		    }
+		}
+		ranges.push_back({ value, end });
 	    }
-	    ranges.push_back({ value, end });
 	}
 
 	switch (CurrentToken().GetToken())
@@ -3952,8 +4633,9 @@ ExprAST* Parser::ParseCaseExpr()
 	    NextToken();
 	    const Location locColon = CurrentToken().Loc();
 	    ExprAST*       s = ParseStatement();
-	    labels.push_back(new LabelExprAST(locColon, ranges, s));
+	    labels.push_back(new LabelExprAST(locColon, ranges, s, strings));
 	    ranges.clear();
+	    strings.clear();
 	    if (!ExpectSemicolonOrEnd())
 	    {
 		return 0;
@@ -4615,7 +5297,10 @@ ExprAST* Parser::ParseUnit(ParserType type)
 	{
 	    const Location loc = CurrentToken().Loc();
 	    Location       endLoc;
-	    BlockAST*      body = ParseBlock(endLoc);
+	    outlined.push_back({});
+	    BlockAST*                 body = ParseBlock(endLoc);
+	    std::vector<FunctionAST*> subFunctions = outlined.back();
+	    outlined.pop_back();
 	    if (!body)
 	    {
 		return 0;
@@ -4623,6 +5308,11 @@ ExprAST* Parser::ParseUnit(ParserType type)
 	    PrototypeAST* proto = new PrototypeAST(loc, initName, std::vector<VarDef>(),
 	                                           Types::Get<Types::VoidDecl>(), "", 0);
 	    initFunction = new FunctionAST(loc, proto, {}, body);
+	    for (auto s : subFunctions)
+	    {
+		s->SetParent(initFunction);
+	    }
+	    initFunction->AddSubFunctions(subFunctions);
 	    initFunction->EndLoc(endLoc);
 	    if (!Expect(Token::Period, ExpectConsume))
 	    {
@@ -4674,7 +5364,7 @@ ExprAST* Parser::Parse(ParserType type)
     return ParseUnit(type);
 }
 
-Parser::Parser(Source& source) : lexer(source), nextTokenValid(false), errCnt(0)
+Parser::Parser(Source& source) : lexer(source), nextTokenValid(false), errCnt(0), outlinedCount(0)
 {
     const llvm::fltSemantics& sem = llvm::APFloat::IEEEdouble();
     double                    maxReal = llvm::APFloat::getLargest(sem).convertToDouble();
@@ -4684,11 +5374,14 @@ Parser::Parser(Source& source) : lexer(source), nextTokenValid(false), errCnt(0)
           AddType("longint", Types::Get<Types::Int64Decl>()) &&
           AddType("int64", Types::Get<Types::Int64Decl>()) &&
           AddType("real", Types::Get<Types::RealDecl>()) && AddType("char", Types::Get<Types::CharDecl>()) &&
+          nameStack.AddOverridable(new TypeDef("single", Types::Get<Types::SingleDecl>())) &&
+          nameStack.AddOverridable(new TypeDef("extended", Types::Get<Types::ExtendedDecl>())) &&
           AddType("text", Types::Get<Types::TextDecl>()) &&
           AddType("boolean", Types::Get<Types::BoolDecl>()) &&
           AddType("timestamp", Types::GetTimeStampType()) &&
           AddType("bindingtype", Types::GetBindingType()) &&
           AddType("complex", Types::Get<Types::ComplexDecl>()) &&
+          nameStack.AddOverridable(new TypeDef("bigint", Types::Get<Types::BigIntDecl>())) &&
           nameStack.Add(new EnumDef("false", 0, Types::Get<Types::BoolDecl>())) &&
           nameStack.Add(new EnumDef("true", 1, Types::Get<Types::BoolDecl>())) &&
           AddConst("maxint", new Constants::IntConstDecl(unknownLoc, INT_MAX)) &&
@@ -5,7 +5,7 @@
  * Memory allocation functions
  *******************************************
  */
-void* __new(int size)
+void* __new(size_t size)
 {
     return malloc(size);
 }
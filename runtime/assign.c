@@ -1,3 +1,4 @@
+#define _XOPEN_SOURCE 700
 #include <string.h>
 #define __USE_POSIX 1
 #include "runtime.h"
@@ -8,6 +9,9 @@
 
 struct FileEntry files[MaxPascalFiles] = {};
 
+/* Protects the allocation of entries in files[]. */
+static pthread_mutex_t filesLock = PTHREAD_MUTEX_INITIALIZER;
+
 /*******************************************
  * InitFiles
  *******************************************
@@ -45,6 +49,7 @@ void SetupFile(File* f, int recSize, int isText)
 void __assign(File* f, char* name)
 {
     int i;
+    pthread_mutex_lock(&filesLock);
     for (i = 0; i < MaxPascalFiles && files[i].inUse; i++)
 	;
     if (i == MaxPascalFiles)
@@ -52,8 +57,18 @@ void __assign(File* f, char* name)
 	fprintf(stderr, "No free files... Exiting\n");
 	exit(1);
     }
-    f->handle = i;
     files[i].inUse = 1;
+    if (!files[i].hasLock)
+    {
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&files[i].lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	files[i].hasLock = 1;
+    }
+    pthread_mutex_unlock(&filesLock);
+    f->handle = i;
     files[i].name = malloc(strlen(name) + 1);
     files[i].fileData = f;
     files[i].readAhead = 0;
@@ -67,9 +82,12 @@ void __assign(File* f, char* name)
 void __assign_unnamed(File* f)
 {
     char       name[] = "lacsap_tmp_file_NNNNNN";
-    static int n = 0;
-    n++;
-    n %= MaxPascalFiles;
+    static int count = 0;
+    pthread_mutex_lock(&filesLock);
+    count++;
+    count %= MaxPascalFiles;
+    int n = count;
+    pthread_mutex_unlock(&filesLock);
     size_t pos = strlen(name) - 1;
     for (int i = 0; i < 6; i++)
     {
@@ -0,0 +1,603 @@
+#include "runtime.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************
+ * Arbitrary precision integers
+ *******************************************
+ * A bigint is a descriptor of an array of limbs on the heap, least significant first.
+ * The absolute value of size is the number of limbs in use, and it is negative for negative
+ * values. The top limb is never zero, so zero has no limbs at all.
+ *
+ * The arithmetic functions store a new value in the result descriptor, which the compiler
+ * passes in uninitialized, so the result never shares limbs with the operands.
+ */
+enum
+{
+    LimbBits = sizeof(Limb) * 8,
+    // Below this many limbs, schoolbook multiplication is faster than Karatsuba.
+    KaratsubaMin = 32,
+    // The largest power of ten in a limb, used to convert that many decimal digits at a time.
+    ChunkDigits = (LimbBits == 64) ? 19 : 9,
+};
+
+static const Limb ChunkBase = (LimbBits == 64) ? (Limb)10000000000000000000ULL : (Limb)1000000000;
+
+static int LeadingZeros(Limb x)
+{
+    return (LimbBits == 64) ? __builtin_clzll(x) : __builtin_clz(x);
+}
+
+static Limb* AllocLimbs(int64_t n)
+{
+    if (!n)
+    {
+	return NULL;
+    }
+    Limb* p = malloc(n * sizeof(Limb));
+    if (!p)
+    {
+	fprintf(stderr, "Out of memory for bigint of %lld limbs... Exiting\n", (long long)n);
+	exit(1);
+    }
+    return p;
+}
+
+static Limb* ZeroLimbs(int64_t n)
+{
+    Limb* p = AllocLimbs(n);
+    if (n)
+    {
+	memset(p, 0, n * sizeof(Limb));
+    }
+    return p;
+}
+
+static int64_t Len(const struct BigInt* a)
+{
+    return (a->size < 0) ? -a->size : a->size;
+}
+
+static int64_t Normalize(const Limb* a, int64_t n)
+{
+    while (n && !a[n - 1])
+    {
+	n--;
+    }
+    return n;
+}
+
+/* Make r the owner of limbs, which has room for capacity limbs and a value in the first n. */
+static void SetResult(struct BigInt* r, Limb* limbs, int64_t n, int neg, int64_t capacity)
+{
+    n = Normalize(limbs, n);
+    if (!n)
+    {
+	free(limbs);
+	limbs = NULL;
+	capacity = 0;
+    }
+    r->limbs = limbs;
+    r->size = (neg) ? -n : n;
+    r->capacity = capacity;
+}
+
+static int CompareMag(const Limb* a, int64_t an, const Limb* b, int64_t bn)
+{
+    if (an != bn)
+    {
+	return (an < bn) ? -1 : 1;
+    }
+    for (int64_t i = an - 1; i >= 0; i--)
+    {
+	if (a[i] != b[i])
+	{
+	    return (a[i] < b[i]) ? -1 : 1;
+	}
+    }
+    return 0;
+}
+
+/* r = a + b, where an >= bn. r has room for an limbs, and the carry out is returned. */
+static Limb AddMag(Limb* r, const Limb* a, int64_t an, const Limb* b, int64_t bn)
+{
+    Limb carry = 0;
+    for (int64_t i = 0; i < an; i++)
+    {
+	DLimb s = (DLimb)a[i] + ((i < bn) ? b[i] : 0) + carry;
+	r[i] = (Limb)s;
+	carry = (Limb)(s >> LimbBits);
+    }
+    return carry;
+}
+
+/* r = a - b, where a >= b. r has room for an limbs. */
+static void SubMag(Limb* r, const Limb* a, int64_t an, const Limb* b, int64_t bn)
+{
+    Limb borrow = 0;
+    for (int64_t i = 0; i < an; i++)
+    {
+	DLimb d = (DLimb)a[i] - ((i < bn) ? b[i] : 0) - borrow;
+	r[i] = (Limb)d;
+	borrow = (Limb)(d >> (2 * LimbBits - 1));
+    }
+}
+
+/* x += y, in place, where the sum fits in xn limbs. */
+static void AddTo(Limb* x, int64_t xn, const Limb* y, int64_t yn)
+{
+    Limb carry = 0;
+    for (int64_t i = 0; i < xn && (i < yn || carry); i++)
+    {
+	DLimb s = (DLimb)x[i] + ((i < yn) ? y[i] : 0) + carry;
+	x[i] = (Limb)s;
+	carry = (Limb)(s >> LimbBits);
+    }
+}
+
+/* x -= y, in place, where x >= y. */
+static void SubFrom(Limb* x, int64_t xn, const Limb* y, int64_t yn)
+{
+    Limb borrow = 0;
+    for (int64_t i = 0; i < xn && (i < yn || borrow); i++)
+    {
+	DLimb d = (DLimb)x[i] - ((i < yn) ? y[i] : 0) - borrow;
+	x[i] = (Limb)d;
+	borrow = (Limb)(d >> (2 * LimbBits - 1));
+    }
+}
+
+/* r = a * b, where r is zeroed by the caller and has room for an + bn limbs. */
+static void MulSchool(Limb* r, const Limb* a, int64_t an, const Limb* b, int64_t bn)
+{
+    for (int64_t i = 0; i < bn; i++)
+    {
+	Limb carry = 0;
+	for (int64_t j = 0; j < an; j++)
+	{
+	    DLimb t = (DLimb)a[j] * b[i] + r[i + j] + carry;
+	    r[i + j] = (Limb)t;
+	    carry = (Limb)(t >> LimbBits);
+	}
+	r[i + an] = carry;
+    }
+}
+
+/* r = a * b, where both have n limbs and r has room for 2n. Splitting each operand in a low
+ * and a high half, the middle part of the product is (a0 + a1)(b0 + b1) - a0 b0 - a1 b1,
+ * so three half size products are needed instead of four.
+ */
+static void Karatsuba(Limb* r, const Limb* a, const Limb* b, int64_t n)
+{
+    if (n < KaratsubaMin)
+    {
+	memset(r, 0, 2 * n * sizeof(Limb));
+	MulSchool(r, a, n, b, n);
+	return;
+    }
+    int64_t h = n / 2;
+    int64_t hh = n - h;
+    Limb*   tmp = AllocLimbs(4 * (hh + 1));
+    Limb*   sa = tmp;
+    Limb*   sb = sa + hh + 1;
+    Limb*   mid = sb + hh + 1;
+
+    Karatsuba(r, a, b, h);
+    Karatsuba(r + 2 * h, a + h, b + h, hh);
+    sa[hh] = AddMag(sa, a + h, hh, a, h);
+    sb[hh] = AddMag(sb, b + h, hh, b, h);
+    Karatsuba(mid, sa, sb, hh + 1);
+    SubFrom(mid, 2 * (hh + 1), r, 2 * h);
+    SubFrom(mid, 2 * (hh + 1), r + 2 * h, 2 * hh);
+    AddTo(r + h, 2 * n - h, mid, Normalize(mid, 2 * (hh + 1)));
+    free(tmp);
+}
+
+/* r = a * b, where r is zeroed and has room for an + bn limbs. */
+static void MulMag(Limb* r, const Limb* a, int64_t an, const Limb* b, int64_t bn)
+{
+    if (an < bn)
+    {
+	const Limb* t = a;
+	a = b;
+	b = t;
+	int64_t tn = an;
+	an = bn;
+	bn = tn;
+    }
+    if (bn < KaratsubaMin)
+    {
+	MulSchool(r, a, an, b, bn);
+	return;
+    }
+    if (an == bn)
+    {
+	Karatsuba(r, a, b, an);
+	return;
+    }
+    // Multiply b by slices of a as long as b, which keeps the Karatsuba products balanced.
+    Limb* t = AllocLimbs(2 * bn);
+    for (int64_t i = 0; i < an; i += bn)
+    {
+	int64_t n = (an - i < bn) ? an - i : bn;
+	memset(t, 0, (n + bn) * sizeof(Limb));
+	MulMag(t, a + i, n, b, bn);
+	AddTo(r + i, an + bn - i, t, n + bn);
+    }
+    free(t);
+}
+
+/* Divide a by d, in place, and return the remainder. */
+static Limb DivSmall(Limb* a, int64_t an, Limb d)
+{
+    DLimb rem = 0;
+    for (int64_t i = an - 1; i >= 0; i--)
+    {
+	DLimb cur = (rem << LimbBits) | a[i];
+	a[i] = (Limb)(cur / d);
+	rem = cur % d;
+    }
+    return (Limb)rem;
+}
+
+/* q = a / b and rem = a % b, for an >= bn >= 2, using Knuth's algorithm D. q has room for
+ * an - bn + 1 limbs and rem for bn.
+ */
+static void DivMag(Limb* q, Limb* rem, const Limb* a, int64_t an, const Limb* b, int64_t bn)
+{
+    // Shift both so that the top bit of the divisor is set, which keeps the estimates close.
+    int   s = LeadingZeros(b[bn - 1]);
+    Limb* v = AllocLimbs(bn);
+    Limb* u = AllocLimbs(an + 1);
+    for (int64_t i = bn - 1; i > 0; i--)
+    {
+	v[i] = (b[i] << s) | ((s) ? b[i - 1] >> (LimbBits - s) : 0);
+    }
+    v[0] = b[0] << s;
+    u[an] = (s) ? a[an - 1] >> (LimbBits - s) : 0;
+    for (int64_t i = an - 1; i > 0; i--)
+    {
+	u[i] = (a[i] << s) | ((s) ? a[i - 1] >> (LimbBits - s) : 0);
+    }
+    u[0] = a[0] << s;
+
+    for (int64_t j = an - bn; j >= 0; j--)
+    {
+	DLimb num = ((DLimb)u[j + bn] << LimbBits) | u[j + bn - 1];
+	DLimb qhat = num / v[bn - 1];
+	DLimb rhat = num % v[bn - 1];
+	while ((qhat >> LimbBits) || qhat * v[bn - 2] > ((rhat << LimbBits) | u[j + bn - 2]))
+	{
+	    qhat--;
+	    rhat += v[bn - 1];
+	    if (rhat >> LimbBits)
+	    {
+		break;
+	    }
+	}
+	Limb carry = 0;
+	Limb borrow = 0;
+	for (int64_t i = 0; i < bn; i++)
+	{
+	    DLimb p = qhat * v[i] + carry;
+	    carry = (Limb)(p >> LimbBits);
+	    DLimb d = (DLimb)u[i + j] - (Limb)p - borrow;
+	    u[i + j] = (Limb)d;
+	    borrow = (Limb)(d >> (2 * LimbBits - 1));
+	}
+	DLimb d = (DLimb)u[j + bn] - carry - borrow;
+	u[j + bn] = (Limb)d;
+	q[j] = (Limb)qhat;
+	// The estimate was one too large, which is rare: add the divisor back.
+	if (d >> (2 * LimbBits - 1))
+	{
+	    q[j]--;
+	    u[j + bn] += AddMag(u + j, u + j, bn, v, bn);
+	}
+    }
+    for (int64_t i = 0; i < bn; i++)
+    {
+	rem[i] = (u[i] >> s) | ((s) ? u[i + 1] << (LimbBits - s) : 0);
+    }
+    free(u);
+    free(v);
+}
+
+static void AddSigned(struct BigInt* r, const struct BigInt* a, const struct BigInt* b, int negateB)
+{
+    int64_t an = Len(a);
+    int64_t bn = Len(b);
+    int     aneg = a->size < 0;
+    int     bneg = (b->size < 0) != negateB;
+    if (aneg == bneg)
+    {
+	const Limb* x = a->limbs;
+	const Limb* y = b->limbs;
+	if (an < bn)
+	{
+	    x = b->limbs;
+	    y = a->limbs;
+	    int64_t t = an;
+	    an = bn;
+	    bn = t;
+	}
+	Limb* limbs = AllocLimbs(an + 1);
+	limbs[an] = AddMag(limbs, x, an, y, bn);
+	SetResult(r, limbs, an + 1, aneg, an + 1);
+	return;
+    }
+    if (CompareMag(a->limbs, an, b->limbs, bn) >= 0)
+    {
+	Limb* limbs = AllocLimbs(an);
+	SubMag(limbs, a->limbs, an, b->limbs, bn);
+	SetResult(r, limbs, an, aneg, an);
+    }
+    else
+    {
+	Limb* limbs = AllocLimbs(bn);
+	SubMag(limbs, b->limbs, bn, a->limbs, an);
+	SetResult(r, limbs, bn, bneg, bn);
+    }
+}
+
+void __BigFromInt(struct BigInt* r, int64_t v)
+{
+    // With 32-bit limbs, the value needs two of them.
+    enum
+    {
+	IntLimbs = sizeof(int64_t) / sizeof(Limb)
+    };
+    Limb*    limbs = AllocLimbs(IntLimbs);
+    uint64_t mag = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+    for (int i = 0; i < IntLimbs; i++)
+    {
+	limbs[i] = (Limb)(mag >> (i * LimbBits));
+    }
+    SetResult(r, limbs, IntLimbs, v < 0, IntLimbs);
+}
+
+void __BigAdd(struct BigInt* r, const struct BigInt* a, const struct BigInt* b)
+{
+    AddSigned(r, a, b, 0);
+}
+
+void __BigSub(struct BigInt* r, const struct BigInt* a, const struct BigInt* b)
+{
+    AddSigned(r, a, b, 1);
+}
+
+void __BigMul(struct BigInt* r, const struct BigInt* a, const struct BigInt* b)
+{
+    int64_t an = Len(a);
+    int64_t bn = Len(b);
+    Limb*   limbs = ZeroLimbs(an + bn);
+    if (an && bn)
+    {
+	MulMag(limbs, a->limbs, an, b->limbs, bn);
+    }
+    SetResult(r, limbs, an + bn, (a->size < 0) != (b->size < 0), an + bn);
+}
+
+/* Division truncates towards zero, and the remainder has the sign of a, as for integers. */
+static void DivMod(struct BigInt* q, struct BigInt* rem, const struct BigInt* a, const struct BigInt* b)
+{
+    int64_t an = Len(a);
+    int64_t bn = Len(b);
+    int     aneg = a->size < 0;
+    if (!bn)
+    {
+	fprintf(stderr, "Division by zero in bigint... Exiting\n");
+	exit(1);
+    }
+    if (an < bn)
+    {
+	Limb* limbs = AllocLimbs(an);
+	if (an)
+	{
+	    memcpy(limbs, a->limbs, an * sizeof(Limb));
+	}
+	SetResult(rem, limbs, an, aneg, an);
+	SetResult(q, NULL, 0, 0, 0);
+	return;
+    }
+    Limb* ql = AllocLimbs(an - bn + 1);
+    Limb* rl = AllocLimbs(bn);
+    if (bn == 1)
+    {
+	memcpy(ql, a->limbs, an * sizeof(Limb));
+	rl[0] = DivSmall(ql, an, b->limbs[0]);
+    }
+    else
+    {
+	DivMag(ql, rl, a->limbs, an, b->limbs, bn);
+    }
+    SetResult(q, ql, an - bn + 1, aneg != (b->size < 0), an - bn + 1);
+    SetResult(rem, rl, bn, aneg, bn);
+}
+
+void __BigDiv(struct BigInt* r, const struct BigInt* a, const struct BigInt* b)
+{
+    struct BigInt rem;
+    DivMod(r, &rem, a, b);
+    free(rem.limbs);
+}
+
+void __BigMod(struct BigInt* r, const struct BigInt* a, const struct BigInt* b)
+{
+    struct BigInt q;
+    DivMod(&q, r, a, b);
+    free(q.limbs);
+}
+
+void __BigNeg(struct BigInt* r, const struct BigInt* a)
+{
+    int64_t n = Len(a);
+    Limb*   limbs = AllocLimbs(n);
+    if (n)
+    {
+	memcpy(limbs, a->limbs, n * sizeof(Limb));
+    }
+    SetResult(r, limbs, n, a->size > 0, n);
+}
+
+/* Square and multiply. A negative exponent gives zero, as for integers. */
+void __BigPow(struct BigInt* r, const struct BigInt* a, int64_t n)
+{
+    struct BigInt result;
+    struct BigInt base = { NULL, 0, 0 };
+    __BigFromInt(&result, (n < 0) ? 0 : 1);
+    __BigAssign(&base, a);
+    while (n > 0)
+    {
+	struct BigInt t;
+	if (n & 1)
+	{
+	    __BigMul(&t, &result, &base);
+	    __BigFree(&result);
+	    result = t;
+	}
+	n >>= 1;
+	if (n)
+	{
+	    __BigMul(&t, &base, &base);
+	    __BigFree(&base);
+	    base = t;
+	}
+    }
+    __BigFree(&base);
+    *r = result;
+}
+
+int __BigCompare(const struct BigInt* a, const struct BigInt* b)
+{
+    int aneg = a->size < 0;
+    if (aneg != (b->size < 0))
+    {
+	return (aneg) ? -1 : 1;
+    }
+    int c = CompareMag(a->limbs, Len(a), b->limbs, Len(b));
+    return (aneg) ? -c : c;
+}
+
+void __BigFree(struct BigInt* a)
+{
+    free(a->limbs);
+    a->limbs = NULL;
+    a->size = 0;
+    a->capacity = 0;
+}
+
+/* Copy src to dest, which is a valid (possibly empty) bigint, reusing its limbs if possible. */
+void __BigAssign(struct BigInt* dest, const struct BigInt* src)
+{
+    if (dest == src)
+    {
+	return;
+    }
+    int64_t n = Len(src);
+    if (n > dest->capacity)
+    {
+	free(dest->limbs);
+	dest->limbs = AllocLimbs(n);
+	dest->capacity = n;
+    }
+    if (n)
+    {
+	memcpy(dest->limbs, src->limbs, n * sizeof(Limb));
+    }
+    dest->size = src->size;
+}
+
+/* Give a (by value) copy of a descriptor its own limbs. */
+void __BigClone(struct BigInt* a)
+{
+    struct BigInt copy = { NULL, 0, 0 };
+    __BigAssign(&copy, a);
+    *a = copy;
+}
+
+/* The decimal digits of a, with a leading '-' if negative. The caller frees the string.
+ * The value is divided by 10^19 (10^9 for 32-bit limbs) at a time, which gives a whole chunk
+ * of digits for each pass over the limbs.
+ */
+char* __BigToString(const struct BigInt* a)
+{
+    int64_t n = Len(a);
+    Limb*   mag = AllocLimbs(n);
+    // Each chunk of digits takes more than LimbBits - 3 bits off the value.
+    Limb*   chunks = AllocLimbs(n * LimbBits / (LimbBits - 3) + 1);
+    int64_t count = 0;
+    if (n)
+    {
+	memcpy(mag, a->limbs, n * sizeof(Limb));
+    }
+    while (n)
+    {
+	chunks[count++] = DivSmall(mag, n, ChunkBase);
+	n = Normalize(mag, n);
+    }
+    char* s = malloc(count * ChunkDigits + 3);
+    if (!s)
+    {
+	fprintf(stderr, "Out of memory converting bigint... Exiting\n");
+	exit(1);
+    }
+    char* p = s;
+    if (a->size < 0)
+    {
+	*p++ = '-';
+    }
+    p += sprintf(p, "%llu", (count) ? (unsigned long long)chunks[count - 1] : 0ULL);
+    for (int64_t i = count - 2; i >= 0; i--)
+    {
+	p += sprintf(p, "%0*llu", ChunkDigits, (unsigned long long)chunks[i]);
+    }
+    free(chunks);
+    free(mag);
+    return s;
+}
+
+/* Set r to the value of the n characters at s: an optional sign followed by decimal digits. */
+void __BigFromString(struct BigInt* r, const char* s, int64_t n)
+{
+    int neg = 0;
+    if (n && (*s == '-' || *s == '+'))
+    {
+	neg = *s == '-';
+	s++;
+	n--;
+    }
+    int64_t size = n / ChunkDigits + 1;
+    Limb*   limbs = ZeroLimbs(size + 1);
+    int64_t used = 0;
+    // The first chunk takes the odd digits, so that the rest are all ChunkDigits long.
+    int64_t len = n % ChunkDigits;
+    if (!len)
+    {
+	len = ChunkDigits;
+    }
+    for (int64_t pos = 0; pos < n; pos += len, len = ChunkDigits)
+    {
+	Limb chunk = 0;
+	Limb scale = 1;
+	for (int64_t i = 0; i < len; i++)
+	{
+	    chunk = chunk * 10 + (s[pos + i] - '0');
+	    scale *= 10;
+	}
+	Limb carry = chunk;
+	for (int64_t i = 0; i < used; i++)
+	{
+	    DLimb t = (DLimb)limbs[i] * scale + carry;
+	    limbs[i] = (Limb)t;
+	    carry = (Limb)(t >> LimbBits);
+	}
+	if (carry)
+	{
+	    limbs[used++] = carry;
+	}
+    }
+    SetResult(r, limbs, used, neg, size + 1);
+}
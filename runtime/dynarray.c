@@ -0,0 +1,132 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************
+ * Dynamic arrays
+ *******************************************
+ * An "array of T" variable is a descriptor holding the elements, how many are in use and how
+ * many there is room for. The compiler indexes data directly, so these functions are only
+ * called to resize, copy and release it.
+ *
+ * For "array of array of T", the elements are descriptors themselves. Depth is the number of
+ * such levels below this one, and size is the size of the innermost element.
+ */
+struct DynArray
+{
+    char*   data;
+    int64_t length;
+    int64_t capacity;
+};
+
+static size_t ElementSize(int64_t size, int depth)
+{
+    return (depth) ? sizeof(struct DynArray) : (size_t)size;
+}
+
+void __DynArrayFree(struct DynArray* a, int64_t size, int depth)
+{
+    if (depth)
+    {
+	struct DynArray* elems = (struct DynArray*)a->data;
+	for (int64_t i = 0; i < a->length; i++)
+	{
+	    __DynArrayFree(&elems[i], size, depth - 1);
+	}
+    }
+    free(a->data);
+    a->data = NULL;
+    a->length = 0;
+    a->capacity = 0;
+}
+
+/* Grow the capacity geometrically, so that a loop extending the array one element at a
+ * time only copies each element a constant number of times on average.
+ */
+static void Reserve(struct DynArray* a, int64_t length, size_t elemSize)
+{
+    if (length <= a->capacity)
+    {
+	return;
+    }
+    int64_t capacity = a->capacity * 2;
+    if (capacity < length)
+    {
+	capacity = length;
+    }
+    char* data = realloc(a->data, capacity * elemSize);
+    if (!data)
+    {
+	fprintf(stderr, "Out of memory growing array to %lld elements... Exiting\n", (long long)length);
+	exit(1);
+    }
+    a->data = data;
+    a->capacity = capacity;
+}
+
+void __DynArraySetLength(struct DynArray* a, int64_t length, int64_t size, int depth)
+{
+    if (length < 0)
+    {
+	fprintf(stderr, "SetLength with negative length %lld... Exiting\n", (long long)length);
+	exit(1);
+    }
+    size_t elemSize = ElementSize(size, depth);
+    if (depth)
+    {
+	struct DynArray* elems = (struct DynArray*)a->data;
+	for (int64_t i = length; i < a->length; i++)
+	{
+	    __DynArrayFree(&elems[i], size, depth - 1);
+	}
+    }
+    Reserve(a, length, elemSize);
+    if (length > a->length)
+    {
+	memset(a->data + a->length * elemSize, 0, (length - a->length) * elemSize);
+    }
+    a->length = length;
+}
+
+/* Copy the content of src to dest, reusing the storage dest already has. */
+void __DynArrayAssign(struct DynArray* dest, const struct DynArray* src, int64_t size, int depth)
+{
+    if (dest == src)
+    {
+	return;
+    }
+    if (depth)
+    {
+	__DynArraySetLength(dest, src->length, size, depth);
+	struct DynArray* d = (struct DynArray*)dest->data;
+	struct DynArray* s = (struct DynArray*)src->data;
+	for (int64_t i = 0; i < src->length; i++)
+	{
+	    __DynArrayAssign(&d[i], &s[i], size, depth - 1);
+	}
+	return;
+    }
+    // No need to keep the old content, so don't let realloc copy it.
+    if (src->length > dest->capacity)
+    {
+	free(dest->data);
+	dest->data = NULL;
+	dest->capacity = 0;
+    }
+    dest->length = 0;
+    Reserve(dest, src->length, size);
+    if (src->length)
+    {
+	memcpy(dest->data, src->data, src->length * size);
+    }
+    dest->length = src->length;
+}
+
+/* Give a (by value) copy of a descriptor its own elements. */
+void __DynArrayClone(struct DynArray* a, int64_t size, int depth)
+{
+    struct DynArray copy = { NULL, 0, 0 };
+    __DynArrayAssign(&copy, a, size, depth);
+    *a = copy;
+}
@@ -15,10 +15,12 @@ void FileError(const char* op)
 
 void __close(File* f)
 {
+    lockFile(f);
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
 	fclose(files[f->handle].file);
 	files[f->handle].file = NULL;
+	unlockFile(f);
 	return;
     }
     FileError("close");
@@ -30,6 +32,7 @@ static void OpenFile(File* f, int recSize, int isText, const char* mode)
     {
 	__assign_unnamed(f);
     }
+    lockFile(f);
     SetupFile(f, recSize, isText);
     if (files[f->handle].inUse)
     {
@@ -40,6 +43,7 @@ static void OpenFile(File* f, int recSize, int isText, const char* mode)
 	files[f->handle].file = fopen(files[f->handle].name, mode);
 	if (files[f->handle].file)
 	{
+	    unlockFile(f);
 	    return;
 	}
     }
@@ -12,7 +12,9 @@ void __put(File* file)
     {
 	f = &files[file->handle];
     }
+    lockFile(file);
     fwrite(file->buffer, file->recordSize, 1, f->file);
+    unlockFile(file);
 }
 
 int __get(File* file)
@@ -22,23 +24,20 @@ int __get(File* file)
     {
 	f = &files[file->handle];
     }
+    lockFile(file);
     if (file->isText)
     {
 	int ch = fgetc(f->file);
 	*file->buffer = ch;
 	f->readAhead = (ch != EOF);
-	return f->readAhead;
     }
     else
     {
-	if (fread(file->buffer, file->recordSize, 1, f->file) > 0)
-	{
-	    f->readAhead = 1;
-	    return 1;
-	}
-	f->readAhead = 0;
+	f->readAhead = fread(file->buffer, file->recordSize, 1, f->file) > 0;
     }
-    return 0;
+    int res = f->readAhead;
+    unlockFile(file);
+    return res;
 }
 
 void __page(File* file)
@@ -48,5 +47,7 @@ void __page(File* file)
     {
 	f = &files[file->handle];
     }
+    lockFile(file);
     fputc('\014', f->file);
+    unlockFile(file);
 }
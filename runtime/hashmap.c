@@ -0,0 +1,296 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*******************************************
+ * Maps and hashsets
+ *******************************************
+ * An open addressing hash table. Each slot has a control byte, which is either Empty, Deleted,
+ * or the low 7 bits of the hash of the key in it. The slots are probed a group of 16 at a time,
+ * comparing all the control bytes of the group at once, so the keys themselves are only
+ * compared when those 7 bits match. The rest of the hash picks the first group to look in.
+ *
+ * The keys and values are stored in the slots. The compiler generates the hash and compare
+ * functions for the key type and describes them in a MapType. Keys that compare equal only
+ * if their bytes are equal have no compare function.
+ */
+typedef uint64_t (*HashFn)(const void* key);
+typedef int (*EqualFn)(const void* a, const void* b);
+
+struct MapType
+{
+    HashFn  hash;
+    EqualFn equal;
+    int64_t keySize;
+    int64_t slotSize;
+};
+
+struct Map
+{
+    uint8_t* ctrl;
+    int64_t  count;
+    char*    slots;
+    int64_t  capacity;
+    int64_t  growthLeft;
+};
+
+enum
+{
+    GroupSize = 16,
+    Empty = 0x80,
+    Deleted = 0xfe,
+};
+
+typedef uint32_t Mask;
+
+#if defined(__SSE2__)
+static Mask MatchByte(const uint8_t* group, uint8_t b)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)b)));
+}
+
+/* Empty and Deleted are the only control bytes with the top bit set. */
+static Mask MatchFree(const uint8_t* group)
+{
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+}
+#else
+static Mask MatchByte(const uint8_t* group, uint8_t b)
+{
+    Mask m = 0;
+    for (int i = 0; i < GroupSize; i++)
+    {
+	m |= (Mask)(group[i] == b) << i;
+    }
+    return m;
+}
+
+static Mask MatchFree(const uint8_t* group)
+{
+    Mask m = 0;
+    for (int i = 0; i < GroupSize; i++)
+    {
+	m |= (Mask)(group[i] >> 7) << i;
+    }
+    return m;
+}
+#endif
+
+/* At most 7/8 of the slots are used, so that a probe always finds an empty slot soon. */
+static int64_t MaxUsed(int64_t capacity)
+{
+    return capacity - capacity / 8;
+}
+
+static int KeyEqual(const struct MapType* t, const void* a, const void* b)
+{
+    if (t->equal)
+    {
+	return t->equal(a, b);
+    }
+    return memcmp(a, b, t->keySize) == 0;
+}
+
+static char* Slot(const struct Map* m, const struct MapType* t, int64_t i)
+{
+    return m->slots + i * t->slotSize;
+}
+
+/* Groups are visited in triangular steps, which reach every group of a power of two table. */
+static int64_t FindFree(const struct Map* m, uint64_t hash)
+{
+    int64_t mask = m->capacity / GroupSize - 1;
+    int64_t g = (hash >> 7) & mask;
+    for (int64_t step = 1;; step++)
+    {
+	Mask match = MatchFree(m->ctrl + g * GroupSize);
+	if (match)
+	{
+	    return g * GroupSize + __builtin_ctz(match);
+	}
+	g = (g + step) & mask;
+    }
+}
+
+static void Resize(struct Map* m, const struct MapType* t, int64_t capacity)
+{
+    struct Map old = *m;
+    m->ctrl = malloc(capacity);
+    m->slots = calloc(capacity, t->slotSize);
+    if (!m->ctrl || !m->slots)
+    {
+	fprintf(stderr, "Out of memory growing map to %lld slots... Exiting\n", (long long)capacity);
+	exit(1);
+    }
+    memset(m->ctrl, Empty, capacity);
+    m->capacity = capacity;
+    m->growthLeft = MaxUsed(capacity) - m->count;
+    for (int64_t i = 0; i < old.capacity; i++)
+    {
+	if (old.ctrl[i] < Empty)
+	{
+	    char*   slot = Slot(&old, t, i);
+	    int64_t j = FindFree(m, t->hash(slot));
+	    m->ctrl[j] = old.ctrl[i];
+	    memcpy(Slot(m, t, j), slot, t->slotSize);
+	}
+    }
+    free(old.ctrl);
+    free(old.slots);
+}
+
+void* __MapFind(const struct Map* m, const struct MapType* t, const void* key, uint64_t hash)
+{
+    if (!m->capacity)
+    {
+	return NULL;
+    }
+    uint8_t h2 = hash & 0x7f;
+    int64_t mask = m->capacity / GroupSize - 1;
+    int64_t g = (hash >> 7) & mask;
+    for (int64_t step = 1;; step++)
+    {
+	const uint8_t* group = m->ctrl + g * GroupSize;
+	for (Mask match = MatchByte(group, h2); match; match &= match - 1)
+	{
+	    char* slot = Slot(m, t, g * GroupSize + __builtin_ctz(match));
+	    if (KeyEqual(t, slot, key))
+	    {
+		return slot;
+	    }
+	}
+	// Inserting stops at the first group with room, so the key can't be further on.
+	if (MatchByte(group, Empty))
+	{
+	    return NULL;
+	}
+	g = (g + step) & mask;
+    }
+}
+
+/* Return the slot of key, adding it with a zero value if it's not already there. */
+void* __MapInsert(struct Map* m, const struct MapType* t, const void* key, uint64_t hash)
+{
+    char* slot = __MapFind(m, t, key, hash);
+    if (slot)
+    {
+	return slot;
+    }
+    if (!m->growthLeft)
+    {
+	// Grow if the map is more than half full, otherwise just clear out the deleted slots.
+	int64_t capacity = m->capacity;
+	if (!capacity || m->count >= MaxUsed(capacity) / 2)
+	{
+	    capacity = (capacity) ? capacity * 2 : GroupSize;
+	}
+	Resize(m, t, capacity);
+    }
+    int64_t i = FindFree(m, hash);
+    if (m->ctrl[i] == Empty)
+    {
+	m->growthLeft--;
+    }
+    m->ctrl[i] = hash & 0x7f;
+    m->count++;
+    slot = Slot(m, t, i);
+    memcpy(slot, key, t->keySize);
+    memset(slot + t->keySize, 0, t->slotSize - t->keySize);
+    return slot;
+}
+
+void __MapRemove(struct Map* m, const struct MapType* t, const void* key, uint64_t hash)
+{
+    char* slot = __MapFind(m, t, key, hash);
+    if (!slot)
+    {
+	return;
+    }
+    int64_t i = (slot - m->slots) / t->slotSize;
+    // If the group has an empty slot, no probe has gone past it, so this slot can be empty too.
+    // Otherwise it has to be marked as deleted, so that probes carry on to the next group.
+    if (MatchByte(m->ctrl + i / GroupSize * GroupSize, Empty))
+    {
+	m->ctrl[i] = Empty;
+	m->growthLeft++;
+    }
+    else
+    {
+	m->ctrl[i] = Deleted;
+    }
+    m->count--;
+}
+
+/* Return the next used slot at or after *pos, and move *pos past it. NULL at the end. */
+void* __MapNext(const struct Map* m, const struct MapType* t, int64_t* pos)
+{
+    for (int64_t i = *pos; i < m->capacity; i++)
+    {
+	if (m->ctrl[i] < Empty)
+	{
+	    *pos = i + 1;
+	    return Slot(m, t, i);
+	}
+    }
+    *pos = m->capacity;
+    return NULL;
+}
+
+void __MapFree(struct Map* m, const struct MapType* t)
+{
+    (void)t;
+    free(m->ctrl);
+    free(m->slots);
+    memset(m, 0, sizeof(*m));
+}
+
+void __MapAssign(struct Map* dest, const struct Map* src, const struct MapType* t)
+{
+    if (dest == src)
+    {
+	return;
+    }
+    __MapFree(dest, t);
+    if (!src->capacity)
+    {
+	return;
+    }
+    *dest = *src;
+    dest->ctrl = malloc(src->capacity);
+    dest->slots = malloc(src->capacity * t->slotSize);
+    if (!dest->ctrl || !dest->slots)
+    {
+	fprintf(stderr, "Out of memory copying map... Exiting\n");
+	exit(1);
+    }
+    memcpy(dest->ctrl, src->ctrl, src->capacity);
+    memcpy(dest->slots, src->slots, src->capacity * t->slotSize);
+}
+
+/* Give a (by value) copy of a descriptor its own table. */
+void __MapClone(struct Map* m, const struct MapType* t)
+{
+    struct Map copy = { NULL, 0, NULL, 0, 0 };
+    __MapAssign(&copy, m, t);
+    *m = copy;
+}
+
+/* Hash for string keys: FNV-1a over the characters, with a final mix so that all bits vary. */
+uint64_t __MapHashBytes(const void* p, int64_t n)
+{
+    const uint8_t* s = p;
+    uint64_t       h = 0xcbf29ce484222325ULL;
+    for (int64_t i = 0; i < n; i++)
+    {
+	h = (h ^ s[i]) * 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
@@ -6,6 +6,7 @@
  */
 extern void __PascalMain(void);
 
+/* Only written before the Pascal code starts, so safe to read from any thread. */
 char** c_argv;
 int    c_argc;
 
@@ -7,8 +7,9 @@
 
 /* Use our own random number gemerator, so that it is consistent regardless
  * of what host system is used. Using linear congruent generator.
+ * Each thread has its own seed, so threads don't race on it.
  */
-static uint64_t rand_seed = 8919118912341193UL;
+static _Thread_local uint64_t rand_seed = 8919118912341193UL;
 
 static const unsigned rand_mul = 1103515245U;
 static const unsigned rand_add = 12345;
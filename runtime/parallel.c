@@ -0,0 +1,243 @@
+#include "runtime.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*******************************************
+ * Parallel for-loops
+ *******************************************
+ * The compiler outlines the body of a {$parallel} for-loop, and calls __ParFor with a
+ * function that runs the loop for lo..hi. The iteration space is split into chunks, which
+ * are initially spread evenly over the worker threads. Each worker takes chunks from the
+ * front of its own queue, and when that is empty, steals the back half of another worker's
+ * queue. The calling thread takes part as worker 0.
+ *
+ * The number of threads is taken from the environment variable LACSAP_THREADS, and
+ * defaults to the number of online processors.
+ */
+typedef void (*ParForBody)(void* ctx, int64_t lo, int64_t hi);
+
+enum
+{
+    MaxThreads = 256,
+    ChunksPerThread = 8,
+};
+
+struct WorkQueue
+{
+    pthread_mutex_t lock;
+    int64_t         next;
+    int64_t         end;
+};
+
+struct ParForJob
+{
+    ParForBody body;
+    void*      ctx;
+    int64_t    start;
+    int64_t    last;
+    int64_t    chunk;
+};
+
+static int              numThreads;
+static struct WorkQueue queues[MaxThreads];
+static struct ParForJob job;
+static unsigned         generation;
+static int              busyWorkers;
+static pthread_mutex_t  poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   startCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   doneCond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t  jobLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t  reduceLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t   poolOnce = PTHREAD_ONCE_INIT;
+
+// Set in worker threads, and while the caller runs a loop. Nested loops run serially.
+static _Thread_local bool inParallel;
+
+static bool TakeChunk(int self, int64_t* chunkNo)
+{
+    struct WorkQueue* q = &queues[self];
+    pthread_mutex_lock(&q->lock);
+    bool found = q->next < q->end;
+    if (found)
+    {
+	*chunkNo = q->next++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
+static bool StealChunks(int self)
+{
+    for (int i = 1; i < numThreads; i++)
+    {
+	struct WorkQueue* victim = &queues[(self + i) % numThreads];
+	pthread_mutex_lock(&victim->lock);
+	int64_t left = victim->end - victim->next;
+	if (left > 0)
+	{
+	    int64_t end = victim->end;
+	    victim->end -= (left + 1) / 2;
+	    int64_t next = victim->end;
+	    pthread_mutex_unlock(&victim->lock);
+
+	    struct WorkQueue* q = &queues[self];
+	    pthread_mutex_lock(&q->lock);
+	    q->next = next;
+	    q->end = end;
+	    pthread_mutex_unlock(&q->lock);
+	    return true;
+	}
+	pthread_mutex_unlock(&victim->lock);
+    }
+    return false;
+}
+
+static void RunChunks(int self)
+{
+    int64_t chunkNo;
+    do
+    {
+	while (TakeChunk(self, &chunkNo))
+	{
+	    int64_t lo = job.start + chunkNo * job.chunk;
+	    int64_t hi = lo + job.chunk - 1;
+	    if (hi > job.last)
+	    {
+		hi = job.last;
+	    }
+	    job.body(job.ctx, lo, hi);
+	}
+    } while (StealChunks(self));
+}
+
+static void* Worker(void* arg)
+{
+    int      self = (int)(intptr_t)arg;
+    unsigned seen = 0;
+
+    inParallel = true;
+    for (;;)
+    {
+	pthread_mutex_lock(&poolLock);
+	while (generation == seen)
+	{
+	    pthread_cond_wait(&startCond, &poolLock);
+	}
+	seen = generation;
+	pthread_mutex_unlock(&poolLock);
+
+	RunChunks(self);
+
+	pthread_mutex_lock(&poolLock);
+	if (--busyWorkers == 0)
+	{
+	    pthread_cond_signal(&doneCond);
+	}
+	pthread_mutex_unlock(&poolLock);
+    }
+    return NULL;
+}
+
+static void StartPool(void)
+{
+    const char* env = getenv("LACSAP_THREADS");
+    numThreads = (env) ? atoi(env) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads < 1)
+    {
+	numThreads = 1;
+    }
+    if (numThreads > MaxThreads)
+    {
+	numThreads = MaxThreads;
+    }
+    for (int i = 0; i < numThreads; i++)
+    {
+	pthread_mutex_init(&queues[i].lock, NULL);
+    }
+    for (int i = 1; i < numThreads; i++)
+    {
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, Worker, (void*)(intptr_t)i) != 0)
+	{
+	    // Carry on with the threads we managed to start.
+	    numThreads = i;
+	    break;
+	}
+	pthread_detach(thread);
+    }
+}
+
+void __ParFor(ParForBody body, void* ctx, int64_t start, int64_t last, int64_t chunk)
+{
+    if (last < start)
+    {
+	return;
+    }
+    pthread_once(&poolOnce, StartPool);
+    // Run serially if there is nothing to share, or the pool is already busy.
+    if (numThreads == 1 || inParallel || pthread_mutex_trylock(&jobLock) != 0)
+    {
+	body(ctx, start, last);
+	return;
+    }
+
+    int64_t count = last - start + 1;
+    if (chunk <= 0)
+    {
+	chunk = count / (numThreads * ChunksPerThread);
+	if (chunk == 0)
+	{
+	    chunk = 1;
+	}
+    }
+    int64_t chunks = (count + chunk - 1) / chunk;
+
+    job.body = body;
+    job.ctx = ctx;
+    job.start = start;
+    job.last = last;
+    job.chunk = chunk;
+    for (int i = 0; i < numThreads; i++)
+    {
+	queues[i].next = chunks * i / numThreads;
+	queues[i].end = chunks * (i + 1) / numThreads;
+    }
+
+    pthread_mutex_lock(&poolLock);
+    busyWorkers = numThreads - 1;
+    generation++;
+    pthread_cond_broadcast(&startCond);
+    pthread_mutex_unlock(&poolLock);
+
+    inParallel = true;
+    RunChunks(0);
+    inParallel = false;
+
+    pthread_mutex_lock(&poolLock);
+    while (busyWorkers != 0)
+    {
+	pthread_cond_wait(&doneCond, &poolLock);
+    }
+    pthread_mutex_unlock(&poolLock);
+    pthread_mutex_unlock(&jobLock);
+}
+
+/* The number of threads a parallel loop started now would use. */
+int __ParForThreads(void)
+{
+    pthread_once(&poolOnce, StartPool);
+    return (inParallel) ? 1 : numThreads;
+}
+
+/* Used by the compiler to merge the partial results of reductions. */
+void __ParForLock(void)
+{
+    pthread_mutex_lock(&reduceLock);
+}
+
+void __ParForUnlock(void)
+{
+    pthread_mutex_unlock(&reduceLock);
+}
@@ -1,8 +1,10 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-void range_error(const char* file, int line, int low, int high, int actual)
+void range_error(const char* file, int line, int64_t low, int64_t high, int64_t actual)
 {
-    fprintf(stderr, "%s:%d: Out of range [expected: %d..%d, got %d]\n", file, line, low, high, actual);
+    fprintf(stderr, "%s:%d: Out of range [expected: %lld..%lld, got %lld]\n", file, line, (long long)low,
+            (long long)high, (long long)actual);
     exit(12);
 }
@@ -57,26 +57,26 @@ static int __get_text(File* file)
  */
 int __eof(File* file)
 {
+    int res = 0;
+    lockFile(file);
     if (!files[file->handle].readAhead)
     {
-	if (!__get_text(file))
-	{
-	    return 1;
-	}
+	res = !__get_text(file);
     }
-    return 0;
+    unlockFile(file);
+    return res;
 }
 
 int __eoln(File* file)
 {
-    if (!files[file->handle].readAhead)
+    int res = 1;
+    lockFile(file);
+    if (files[file->handle].readAhead || __get_text(file))
     {
-	if (!__get_text(file))
-	{
-	    return 1;
-	}
+	res = *file->buffer == '\n';
     }
-    return *file->buffer == '\n';
+    unlockFile(file);
+    return res;
 }
 
 struct interface
@@ -180,13 +180,13 @@ struct interfaceNode
     struct interface*     intf;
 };
 
-static struct interfaceNode* intfList;
+/* Each thread has its own list, as a ReadStr is always started and finished by the same thread. */
+static _Thread_local struct interfaceNode* intfList;
 
 struct interface* __read_S_init(String* str)
 {
     struct interface* intf = malloc(sizeof(struct interface));
     initStr(str, intf);
-    // TODO: Threading will need a lock here.
     struct interfaceNode* intfNode = malloc(sizeof(struct interfaceNode));
     intfNode->intf = intf;
     intfNode->next = intfList;
@@ -316,7 +316,9 @@ void __read_int64(File* file, int64_t* v)
 
     struct interface intf;
     initFile(file, &intf);
+    lockFile(file);
     readint64(&intf, v);
+    unlockFile(file);
 }
 
 void __read_S_int64(String* str, int64_t* v)
@@ -341,6 +343,67 @@ void __read_S_int32(String* str, int* v)
     *v = (int)n;
 }
 
+/* The digits are collected first, as there is no limit to how many there are. */
+static void readbigint(struct interface* intf, struct BigInt* v)
+{
+    intf->fnpreread(intf);
+
+    skip_spaces(intf);
+    int     sign = get_sign(intf);
+    int64_t size = 64;
+    int64_t n = 0;
+    char*   digits = malloc(size);
+    char    ch;
+    while ((ch = intf->fncurrent(intf)) && isdigit(ch))
+    {
+	if (n == size)
+	{
+	    size *= 2;
+	    digits = realloc(digits, size);
+	}
+	if (!digits)
+	{
+	    fprintf(stderr, "Out of memory reading bigint... Exiting\n");
+	    exit(1);
+	}
+	digits[n++] = ch;
+	if (!intf->fngetnext(intf))
+	{
+	    break;
+	}
+    }
+    struct BigInt r;
+    __BigFromString(&r, digits, n);
+    if (sign < 0)
+    {
+	r.size = -r.size;
+    }
+    __BigFree(v);
+    *v = r;
+    free(digits);
+}
+
+void __read_bigint(File* file, struct BigInt* v)
+{
+    if (file->handle >= MaxPascalFiles)
+    {
+	return;
+    }
+
+    struct interface intf;
+    initFile(file, &intf);
+    lockFile(file);
+    readbigint(&intf, v);
+    unlockFile(file);
+}
+
+void __read_S_bigint(String* str, struct BigInt* v)
+{
+    struct interface* intf = findInterface(str);
+    assert(intf && "Expected to find an interface");
+    readbigint(intf, v);
+}
+
 static void readchar(struct interface* intf, char* v)
 {
     intf->fnpreread(intf);
@@ -359,7 +422,9 @@ void __read_chr(File* file, char* v)
     struct interface intf;
     initFile(file, &intf);
 
+    lockFile(file);
     readchar(&intf, v);
+    unlockFile(file);
 }
 
 void __read_S_chr(String* str, char* v)
@@ -434,7 +499,9 @@ void __read_real(File* file, double* v)
     struct interface intf;
     initFile(file, &intf);
 
+    lockFile(file);
     readreal(&intf, v);
+    unlockFile(file);
 }
 
 void __read_S_real(String* str, double* v)
@@ -445,21 +512,48 @@ void __read_S_real(String* str, double* v)
     readreal(intf, v);
 }
 
+/* Single and extended are read as real. The value is left unchanged if nothing is read. */
+void __read_single(File* file, float* v)
+{
+    double d = *v;
+    __read_real(file, &d);
+    *v = d;
+}
+
+void __read_S_single(String* str, float* v)
+{
+    double d = *v;
+    __read_S_real(str, &d);
+    *v = d;
+}
+
+void __read_extended(File* file, long double* v)
+{
+    double d = *v;
+    __read_real(file, &d);
+    *v = d;
+}
+
+void __read_S_extended(String* str, long double* v)
+{
+    double d = *v;
+    __read_S_real(str, &d);
+    *v = d;
+}
+
 void __read_nl(File* file)
 {
-    if (!files[file->handle].readAhead)
+    lockFile(file);
+    if (files[file->handle].readAhead || __get_text(file))
     {
-	if (!__get_text(file))
+	while (*file->buffer != '\n')
 	{
-	    return;
+	    if (!__get_text(file))
+		break;
 	}
+	files[file->handle].readAhead = 0;
     }
-    while (*file->buffer != '\n')
-    {
-	if (!__get_text(file))
-	    break;
-    }
-    files[file->handle].readAhead = 0;
+    unlockFile(file);
 }
 
 static void readstr(struct interface* intf, String* v)
@@ -491,7 +585,9 @@ void __read_str(File* file, String* v)
     struct interface intf;
     initFile(file, &intf);
 
+    lockFile(file);
     readstr(&intf, v);
+    unlockFile(file);
 }
 
 void __read_S_str(String* str, String* v)
@@ -524,7 +620,9 @@ void __read_chars(File* file, char* v)
     struct interface intf;
     initFile(file, &intf);
 
+    lockFile(file);
     readchars(&intf, v);
+    unlockFile(file);
 }
 
 void __read_S_chars(String* str, char* v)
@@ -586,7 +684,9 @@ void __read_bool(File* file, int* b)
     struct interface intf;
     initFile(file, &intf);
 
+    lockFile(file);
     readbool(&intf, b);
+    unlockFile(file);
 }
 
 void __read_S_bool(String* str, int* b)
@@ -13,6 +13,8 @@ void __read_bin(File* file, void* val)
 	fprintf(stderr, "Invalid file used for read binary\n");
 	return;
     }
+    lockFile(file);
     memcpy(val, file->buffer, file->recordSize);
     __get(file);
+    unlockFile(file);
 }
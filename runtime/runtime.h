@@ -1,5 +1,7 @@
 #include <assert.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /*******************************************
@@ -35,6 +37,9 @@ struct FileEntry
     int   readAhead;
     int   readPos;
     int   bufferSize;
+    /* Recursive lock, held while a thread reads from or writes to the file. */
+    pthread_mutex_t lock;
+    int             hasLock;
 };
 
 typedef struct
@@ -43,17 +48,18 @@ typedef struct
     unsigned char str[MaxStringLen + 1];
 } String;
 
+/* The subrange fields are stored as bytes, as the compiler does. */
 struct TimeStamp
 {
-    bool DateValid;
-    bool TimeValid;
-    int  Year;
-    int  Month;
-    int  Day;
-    int  Hour;
-    int  Minute;
-    int  Second;
-    int  MicroSecond;
+    bool          DateValid;
+    bool          TimeValid;
+    int           Year;
+    unsigned char Month;
+    unsigned char Day;
+    unsigned char Hour;
+    unsigned char Minute;
+    unsigned char Second;
+    int           MicroSecond;
 };
 
 struct BindingType
@@ -68,6 +74,23 @@ struct Complex
     double i;
 };
 
+/* A limb is half of the widest integer the C compiler can multiply into. */
+#if defined(__SIZEOF_INT128__)
+typedef uint64_t          Limb;
+typedef unsigned __int128 DLimb;
+#else
+typedef uint32_t Limb;
+typedef uint64_t DLimb;
+#endif
+
+/* The limbs are least significant first, and size is negative for negative values. */
+struct BigInt
+{
+    Limb*     limbs;
+    int64_t   size;
+    int64_t   capacity;
+};
+
 /*******************************************
  * Local variables
  *******************************************
@@ -87,7 +110,8 @@ extern File output;
  */
 void InitFiles();
 void SetupFile(File* f, int recSize, int isText);
-void FileError(const char* op);
+// Cold and noreturn, so that the error paths are kept away from the rest of the I/O code.
+__attribute__((cold, noreturn)) void FileError(const char* op);
 
 /*******************************************
  * File Basics, low level I/O.
@@ -102,9 +126,31 @@ static inline FILE* getFile(File* f)
     return NULL;
 }
 
+static inline void lockFile(File* f)
+{
+    if (f->handle < MaxPascalFiles && files[f->handle].hasLock)
+    {
+	pthread_mutex_lock(&files[f->handle].lock);
+    }
+}
+
+static inline void unlockFile(File* f)
+{
+    if (f->handle < MaxPascalFiles && files[f->handle].hasLock)
+    {
+	pthread_mutex_unlock(&files[f->handle].lock);
+    }
+}
+
 int  __get(File* file);
 void __put(File* file);
 int  __eof(File* file);
 int  __eoln(File* file);
 void __assign(File* f, char* name);
 void __assign_unnamed(File* f);
+
+/* Bigint conversion, used by read and write. */
+char* __BigToString(const struct BigInt* a);
+void  __BigFromString(struct BigInt* r, const char* s, int64_t n);
+void  __BigFree(struct BigInt* a);
+void  __BigAssign(struct BigInt* dest, const struct BigInt* src);
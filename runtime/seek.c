@@ -12,7 +12,9 @@ void __seekwrite(File* f, uint64_t n)
 {
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
+	lockFile(f);
 	fseek(files[f->handle].file, SEEK_SET, n * f->recordSize);
+	unlockFile(f);
 	return;
     }
     FileError("seekwrite");
@@ -22,7 +24,9 @@ void __seekread(File* f, uint64_t n)
 {
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
+	lockFile(f);
 	fseek(files[f->handle].file, SEEK_SET, n * f->recordSize);
+	unlockFile(f);
 	return;
     }
     FileError("seekread");
@@ -32,22 +36,25 @@ void __seekupdate(File* f, uint64_t n)
 {
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
+	lockFile(f);
 	fseek(files[f->handle].file, SEEK_SET, n * f->recordSize);
+	unlockFile(f);
 	return;
     }
     FileError("seekupdate");
 }
 
-/* Note this is not thread-safe, but we don't have threads in Lacsap at present! */
 bool __empty(File* f)
 {
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
 	FILE* file = files[f->handle].file;
-	long  current = ftell(file);
+	lockFile(f);
+	long current = ftell(file);
 	fseek(file, SEEK_END, 0);
 	long len = ftell(file);
 	fseek(file, SEEK_SET, current);
+	unlockFile(f);
 	return (len == 0);
     }
     FileError("empty");
@@ -58,7 +65,9 @@ long __position(File* f)
 {
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
+	lockFile(f);
 	long current = ftell(files[f->handle].file);
+	unlockFile(f);
 	return current / f->recordSize;
     }
     FileError("position");
@@ -70,10 +79,12 @@ long __lastposition(File* f)
     if (files[f->handle].inUse && files[f->handle].file != NULL)
     {
 	FILE* file = files[f->handle].file;
-	long  current = ftell(file);
+	lockFile(f);
+	long current = ftell(file);
 	fseek(file, SEEK_END, 0);
 	long len = ftell(file);
 	fseek(file, SEEK_SET, current);
+	unlockFile(f);
 	return len / f->recordSize;
     }
     FileError("lastposition");
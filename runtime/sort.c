@@ -0,0 +1,272 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*******************************************
+ * Sorting
+ *******************************************
+ * The compiler turns sort() into a sort function specialised for the element type and
+ * comparison, and a matching merge function. Large arrays are split into one slice per
+ * thread, the slices are sorted in parallel, and then merged pairwise, each round of
+ * merges also running in parallel.
+ *
+ * Integral keys without a comparison function are radix sorted here instead, using the
+ * same scheme for large arrays, with merges specialised for the size of the key.
+ */
+typedef void (*SortFn)(void* ctx, void* base, int64_t n);
+typedef void (*MergeFn)(void* ctx, const void* a, int64_t na, const void* b, int64_t nb, void* out);
+typedef void (*ParForBody)(void* ctx, int64_t lo, int64_t hi);
+
+void __ParFor(ParForBody body, void* ctx, int64_t start, int64_t last, int64_t chunk);
+int  __ParForThreads(void);
+
+enum
+{
+    // Below this, the cost of starting the threads and merging is more than the gain.
+    ParallelSortMin = 1 << 16,
+    // Below this, insertion sort beats counting digits.
+    RadixSortMin = 64,
+};
+
+struct SortJob
+{
+    SortFn  sort;
+    MergeFn merge;
+    void*   ctx;
+    char*   src;
+    char*   dst;
+    int64_t n;
+    int64_t size;
+    int64_t slices;
+    int64_t width;
+};
+
+static void* Allocate(int64_t size)
+{
+    void* p = malloc(size);
+    if (!p)
+    {
+	fprintf(stderr, "Out of memory in sort... Exiting\n");
+	exit(1);
+    }
+    return p;
+}
+
+/* Start of slice i, in elements. */
+static int64_t SliceStart(const struct SortJob* job, int64_t i)
+{
+    if (i >= job->slices)
+    {
+	return job->n;
+    }
+    return i * job->n / job->slices;
+}
+
+static void SortSlices(void* ctx, int64_t lo, int64_t hi)
+{
+    struct SortJob* job = ctx;
+    for (int64_t i = lo; i <= hi; i++)
+    {
+	int64_t start = SliceStart(job, i);
+	int64_t end = SliceStart(job, i + 1);
+	job->sort(job->ctx, job->src + start * job->size, end - start);
+    }
+}
+
+/* Merge pairs of runs, each width slices long, from src into dst. */
+static void MergeRuns(void* ctx, int64_t lo, int64_t hi)
+{
+    struct SortJob* job = ctx;
+    for (int64_t i = lo; i <= hi; i++)
+    {
+	int64_t start = SliceStart(job, 2 * i * job->width);
+	int64_t mid = SliceStart(job, (2 * i + 1) * job->width);
+	int64_t end = SliceStart(job, (2 * i + 2) * job->width);
+	if (mid == end)
+	{
+	    memcpy(job->dst + start * job->size, job->src + start * job->size, (end - start) * job->size);
+	}
+	else
+	{
+	    job->merge(job->ctx, job->src + start * job->size, mid - start, job->src + mid * job->size,
+	               end - mid, job->dst + start * job->size);
+	}
+    }
+}
+
+void __Sort(SortFn sort, MergeFn merge, void* ctx, void* base, int64_t n, int64_t size)
+{
+    int threads = (n >= ParallelSortMin) ? __ParForThreads() : 1;
+    if (threads == 1)
+    {
+	sort(ctx, base, n);
+	return;
+    }
+
+    struct SortJob job = { sort, merge, ctx, base, NULL, n, size, 1, 1 };
+    // A power of two, so that every round of merges pairs up runs of the same length.
+    while (job.slices < threads)
+    {
+	job.slices *= 2;
+    }
+    __ParFor(SortSlices, &job, 0, job.slices - 1, 1);
+
+    char* tmp = Allocate(n * size);
+    job.dst = tmp;
+    for (; job.width < job.slices; job.width *= 2)
+    {
+	__ParFor(MergeRuns, &job, 0, (job.slices + 2 * job.width - 1) / (2 * job.width) - 1, 1);
+	char* t = job.src;
+	job.src = job.dst;
+	job.dst = t;
+    }
+    if (job.src != base)
+    {
+	memcpy(base, job.src, n * size);
+    }
+    free(tmp);
+}
+
+/* Keys are compared as unsigned, with the sign bit flipped for signed types. */
+#define RADIX_SORT(U)                                                                             \
+    static void Insertion_##U(U* a, int64_t n, U flip)                                            \
+    {                                                                                             \
+	for (int64_t i = 1; i < n; i++)                                                           \
+	{                                                                                         \
+	    U       x = a[i];                                                                     \
+	    int64_t j = i;                                                                        \
+	    for (; j > 0 && (U)(a[j - 1] ^ flip) > (U)(x ^ flip); j--)                            \
+	    {                                                                                     \
+		a[j] = a[j - 1];                                                                  \
+	    }                                                                                     \
+	    a[j] = x;                                                                             \
+	}                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static void Radix_##U(U* a, int64_t n, U flip)                                                \
+    {                                                                                             \
+	if (n < RadixSortMin)                                                                     \
+	{                                                                                         \
+	    Insertion_##U(a, n, flip);                                                            \
+	    return;                                                                               \
+	}                                                                                         \
+	int64_t count[sizeof(U)][256] = { { 0 } };                                                \
+	for (int64_t i = 0; i < n; i++)                                                           \
+	{                                                                                         \
+	    U k = a[i] ^ flip;                                                                    \
+	    for (unsigned d = 0; d < sizeof(U); d++)                                              \
+	    {                                                                                     \
+		count[d][(k >> (d * 8)) & 0xff]++;                                                \
+	    }                                                                                     \
+	}                                                                                         \
+	U* tmp = Allocate(n * sizeof(U));                                                         \
+	U* src = a;                                                                               \
+	U* dst = tmp;                                                                             \
+	for (unsigned d = 0; d < sizeof(U); d++)                                                  \
+	{                                                                                         \
+	    int64_t* c = count[d];                                                                \
+	    /* Skip digits where all keys are the same, such as the top bytes of small values. */ \
+	    if (c[((U)(src[0] ^ flip) >> (d * 8)) & 0xff] == n)                                   \
+	    {                                                                                     \
+		continue;                                                                         \
+	    }                                                                                     \
+	    int64_t pos = 0;                                                                      \
+	    for (int b = 0; b < 256; b++)                                                         \
+	    {                                                                                     \
+		int64_t t = c[b];                                                                 \
+		c[b] = pos;                                                                       \
+		pos += t;                                                                         \
+	    }                                                                                     \
+	    for (int64_t i = 0; i < n; i++)                                                       \
+	    {                                                                                     \
+		U k = src[i] ^ flip;                                                              \
+		dst[c[(k >> (d * 8)) & 0xff]++] = src[i];                                         \
+	    }                                                                                     \
+	    U* t = src;                                                                           \
+	    src = dst;                                                                            \
+	    dst = t;                                                                              \
+	}                                                                                         \
+	if (src != a)                                                                             \
+	{                                                                                         \
+	    memcpy(a, src, n * sizeof(U));                                                        \
+	}                                                                                         \
+	free(tmp);                                                                                \
+    }                                                                                             \
+                                                                                                  \
+    static void Merge_##U(const U* a, int64_t na, const U* b, int64_t nb, U* out, U flip)         \
+    {                                                                                             \
+	int64_t i = 0;                                                                            \
+	int64_t j = 0;                                                                            \
+	while (i < na && j < nb)                                                                  \
+	{                                                                                         \
+	    *out++ = ((U)(b[j] ^ flip) < (U)(a[i] ^ flip)) ? b[j++] : a[i++];                     \
+	}                                                                                         \
+	memcpy(out, a + i, (na - i) * sizeof(U));                                                 \
+	memcpy(out + (na - i), b + j, (nb - j) * sizeof(U));                                      \
+    }
+
+RADIX_SORT(uint8_t)
+RADIX_SORT(uint16_t)
+RADIX_SORT(uint32_t)
+RADIX_SORT(uint64_t)
+
+struct RadixKey
+{
+    int size;
+    int isSigned;
+};
+
+static uint64_t SignBit(const struct RadixKey* key)
+{
+    return (key->isSigned) ? 1ULL << (key->size * 8 - 1) : 0;
+}
+
+static void RadixSort(void* ctx, void* base, int64_t n)
+{
+    const struct RadixKey* key = ctx;
+    uint64_t               flip = SignBit(key);
+    switch (key->size)
+    {
+    case 1:
+	Radix_uint8_t(base, n, flip);
+	break;
+    case 2:
+	Radix_uint16_t(base, n, flip);
+	break;
+    case 4:
+	Radix_uint32_t(base, n, flip);
+	break;
+    default:
+	Radix_uint64_t(base, n, flip);
+	break;
+    }
+}
+
+static void RadixMerge(void* ctx, const void* a, int64_t na, const void* b, int64_t nb, void* out)
+{
+    const struct RadixKey* key = ctx;
+    uint64_t               flip = SignBit(key);
+    switch (key->size)
+    {
+    case 1:
+	Merge_uint8_t(a, na, b, nb, out, flip);
+	break;
+    case 2:
+	Merge_uint16_t(a, na, b, nb, out, flip);
+	break;
+    case 4:
+	Merge_uint32_t(a, na, b, nb, out, flip);
+	break;
+    default:
+	Merge_uint64_t(a, na, b, nb, out, flip);
+	break;
+    }
+}
+
+/* Sort n integral values of size bytes each. */
+void __RadixSort(void* base, int64_t n, int size, int isSigned)
+{
+    struct RadixKey key = { size, isSigned };
+    __Sort(RadixSort, RadixMerge, &key, base, n, size);
+}
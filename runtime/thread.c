@@ -0,0 +1,206 @@
+#include "runtime.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*******************************************
+ * Threads
+ *******************************************
+ * Spawn runs a procedure on a new thread. The compiler passes a small function that
+ * calls the procedure with its closure (ctx) and optional integer argument. The handle
+ * returned is used to Join the thread, which also releases it.
+ */
+typedef void (*ThreadBody)(void* ctx, int64_t arg);
+
+struct Thread
+{
+    pthread_t  thread;
+    ThreadBody body;
+    void*      ctx;
+    int64_t    arg;
+    unsigned   number;
+};
+
+void __random_set_seed(int64_t seed);
+
+static atomic_uint threadCount;
+
+static void* ThreadStart(void* arg)
+{
+    struct Thread* t = arg;
+    // Give each thread its own, but still repeatable, sequence of random numbers.
+    __random_set_seed(8919118912341193LL + t->number);
+    t->body(t->ctx, t->arg);
+    return NULL;
+}
+
+int64_t __Spawn(ThreadBody body, void* ctx, int64_t arg)
+{
+    struct Thread* t = malloc(sizeof(struct Thread));
+    t->body = body;
+    t->ctx = ctx;
+    t->arg = arg;
+    t->number = atomic_fetch_add(&threadCount, 1) + 1;
+    if (pthread_create(&t->thread, NULL, ThreadStart, t) != 0)
+    {
+	fprintf(stderr, "Could not create thread... Exiting\n");
+	exit(1);
+    }
+    return (int64_t)(intptr_t)t;
+}
+
+void __Join(int64_t handle)
+{
+    struct Thread* t = (struct Thread*)(intptr_t)handle;
+    pthread_join(t->thread, NULL);
+    free(t);
+}
+
+/*******************************************
+ * Channels
+ *******************************************
+ * Bounded multi-producer, multi-consumer queue of integers. Each cell has a sequence
+ * number that tells whether it is ready to be written or read in the current lap,
+ * so senders and receivers only need an atomic increment of their position to claim
+ * a cell. A full (for Send) or empty (for Receive) channel makes the caller yield
+ * until the other side catches up.
+ */
+struct Cell
+{
+    atomic_size_t seq;
+    int64_t       value;
+};
+
+struct Channel
+{
+    size_t        mask;
+    atomic_size_t sendPos;
+    atomic_size_t recvPos;
+    atomic_bool   closed;
+    struct Cell   cells[];
+};
+
+int64_t __ChanCreate(int64_t capacity)
+{
+    // A single cell would be ready for the next lap's send as soon as it is written, so the ring
+    // has at least two.
+    size_t size = 2;
+    while ((int64_t)size < capacity)
+    {
+	size *= 2;
+    }
+    struct Channel* c = malloc(sizeof(struct Channel) + size * sizeof(struct Cell));
+    c->mask = size - 1;
+    atomic_init(&c->sendPos, 0);
+    atomic_init(&c->recvPos, 0);
+    atomic_init(&c->closed, false);
+    for (size_t i = 0; i < size; i++)
+    {
+	atomic_init(&c->cells[i].seq, i);
+    }
+    return (int64_t)(intptr_t)c;
+}
+
+static bool TrySend(struct Channel* c, int64_t value)
+{
+    size_t pos = atomic_load_explicit(&c->sendPos, memory_order_relaxed);
+    for (;;)
+    {
+	struct Cell* cell = &c->cells[pos & c->mask];
+	size_t       seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+	intptr_t     diff = (intptr_t)seq - (intptr_t)pos;
+	if (diff == 0)
+	{
+	    if (atomic_compare_exchange_weak_explicit(&c->sendPos, &pos, pos + 1, memory_order_relaxed,
+	                                              memory_order_relaxed))
+	    {
+		cell->value = value;
+		atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+		return true;
+	    }
+	}
+	else if (diff < 0)
+	{
+	    return false;
+	}
+	else
+	{
+	    pos = atomic_load_explicit(&c->sendPos, memory_order_relaxed);
+	}
+    }
+}
+
+static bool TryReceive(struct Channel* c, int64_t* value)
+{
+    size_t pos = atomic_load_explicit(&c->recvPos, memory_order_relaxed);
+    for (;;)
+    {
+	struct Cell* cell = &c->cells[pos & c->mask];
+	size_t       seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+	intptr_t     diff = (intptr_t)seq - (intptr_t)(pos + 1);
+	if (diff == 0)
+	{
+	    if (atomic_compare_exchange_weak_explicit(&c->recvPos, &pos, pos + 1, memory_order_relaxed,
+	                                              memory_order_relaxed))
+	    {
+		*value = cell->value;
+		atomic_store_explicit(&cell->seq, pos + c->mask + 1, memory_order_release);
+		return true;
+	    }
+	}
+	else if (diff < 0)
+	{
+	    return false;
+	}
+	else
+	{
+	    pos = atomic_load_explicit(&c->recvPos, memory_order_relaxed);
+	}
+    }
+}
+
+static void SendOnClosed(void)
+{
+    fprintf(stderr, "Send on closed channel... Exiting\n");
+    exit(1);
+}
+
+void __ChanSend(int64_t handle, int64_t value)
+{
+    struct Channel* c = (struct Channel*)(intptr_t)handle;
+    if (atomic_load(&c->closed))
+    {
+	SendOnClosed();
+    }
+    while (!TrySend(c, value))
+    {
+	if (atomic_load(&c->closed))
+	{
+	    SendOnClosed();
+	}
+	sched_yield();
+    }
+}
+
+/* Returns false when the channel is closed and all values have been received. */
+bool __ChanReceive(int64_t handle, int64_t* value)
+{
+    struct Channel* c = (struct Channel*)(intptr_t)handle;
+    while (!TryReceive(c, value))
+    {
+	if (atomic_load(&c->closed))
+	{
+	    // Values sent before the close are visible now, so have one last look.
+	    return TryReceive(c, value);
+	}
+	sched_yield();
+    }
+    return true;
+}
+
+void __ChanClose(int64_t handle)
+{
+    struct Channel* c = (struct Channel*)(intptr_t)handle;
+    atomic_store(&c->closed, true);
+}
@@ -0,0 +1,210 @@
+#include "runtime.h"
+#include <math.h>
+#include <stdint.h>
+
+/*******************************************
+ * Vector math
+ *******************************************
+ * Vector versions of the math functions, used by the compiler's vectoriser with
+ * -fveclib=runtime when no vector math library is available. Each is a branch-free
+ * polynomial over all lanes, with the argument reduction and coefficients of fdlibm.
+ * Lanes outside the range the reduction handles (NaN, infinity, huge, subnormal or
+ * non-positive arguments to log) send the whole vector to libm, one lane at a time.
+ * Single precision is computed in double and rounded.
+ */
+typedef double  VecD2 __attribute__((vector_size(16)));
+typedef float   VecF4 __attribute__((vector_size(16)));
+typedef int64_t VecI2 __attribute__((vector_size(16)));
+
+#define SPLAT(v) ((VecD2){ (v), (v) })
+
+static const double shifter = 0x1.8p52;
+static const double ln2Hi = 6.93147180369123816490e-01;
+static const double ln2Lo = 1.90821492927058770002e-10;
+static const double invLn2 = 1.44269504088896338700e+00;
+
+static inline VecD2 Select(VecI2 mask, VecD2 a, VecD2 b)
+{
+    return (VecD2)(((VecI2)a & mask) | ((VecI2)b & ~mask));
+}
+
+static inline VecD2 Abs(VecD2 x)
+{
+    return (VecD2)((VecI2)x & (VecI2){ INT64_MAX, INT64_MAX });
+}
+
+static inline int AnyLane(VecI2 mask)
+{
+    return (mask[0] | mask[1]) != 0;
+}
+
+/* Round x to the nearest integer, both as a double and as the integer itself. */
+static inline VecD2 RoundInt(VecD2 x, VecI2* n)
+{
+    VecD2 t = x + SPLAT(shifter);
+    *n = (VecI2)t - (VecI2)SPLAT(shifter);
+    return t - SPLAT(shifter);
+}
+
+#define SCALAR_D2(func, x) ((VecD2){ func(x[0]), func(x[1]) })
+
+static VecD2 Exp(VecD2 x)
+{
+    if (AnyLane(~(Abs(x) <= SPLAT(708.0))))
+    {
+	return SCALAR_D2(exp, x);
+    }
+    VecI2 n;
+    VecD2 k = RoundInt(x * SPLAT(invLn2), &n);
+    VecD2 r = (x - k * SPLAT(ln2Hi)) - k * SPLAT(ln2Lo);
+    /* Taylor series, |r| <= ln(2)/2. */
+    VecD2 p = SPLAT(1.0 / 6227020800.0);
+    p = p * r + SPLAT(1.0 / 479001600.0);
+    p = p * r + SPLAT(1.0 / 39916800.0);
+    p = p * r + SPLAT(1.0 / 3628800.0);
+    p = p * r + SPLAT(1.0 / 362880.0);
+    p = p * r + SPLAT(1.0 / 40320.0);
+    p = p * r + SPLAT(1.0 / 5040.0);
+    p = p * r + SPLAT(1.0 / 720.0);
+    p = p * r + SPLAT(1.0 / 120.0);
+    p = p * r + SPLAT(1.0 / 24.0);
+    p = p * r + SPLAT(1.0 / 6.0);
+    p = p * r + SPLAT(0.5);
+    p = p * r + SPLAT(1.0);
+    p = p * r + SPLAT(1.0);
+    VecD2 scale = (VecD2)((n + 1023) << 52);
+    return p * scale;
+}
+
+static VecD2 Log(VecD2 x)
+{
+    if (AnyLane(~((x >= SPLAT(0x1p-1022)) & (x <= SPLAT(0x1.fffffffffffffp1023)))))
+    {
+	return SCALAR_D2(log, x);
+    }
+    /* x = 2^k * m, with m in [sqrt(2)/2, sqrt(2)). */
+    VecI2 ix = (VecI2)x + (0x3ff0000000000000 - 0x3fe6a09e00000000);
+    VecI2 k = (ix >> 52) - 1023;
+    VecD2 m = (VecD2)((ix & 0x000fffffffffffff) + 0x3fe6a09e00000000);
+    VecD2 dk = { (double)k[0], (double)k[1] };
+
+    VecD2 f = m - SPLAT(1.0);
+    VecD2 hfsq = SPLAT(0.5) * f * f;
+    VecD2 s = f / (SPLAT(2.0) + f);
+    VecD2 z = s * s;
+    VecD2 w = z * z;
+    VecD2 t1 = w * (SPLAT(3.999999999940941908e-01) +
+                    w * (SPLAT(2.222219843214978396e-01) + w * SPLAT(1.531383769920937332e-01)));
+    VecD2 t2 = z * (SPLAT(6.666666666666735130e-01) +
+                    w * (SPLAT(2.857142874366239149e-01) +
+                         w * (SPLAT(1.818357216161805012e-01) + w * SPLAT(1.479819860511658591e-01))));
+    VecD2 r = t1 + t2;
+    return dk * SPLAT(ln2Hi) - ((hfsq - (s * (hfsq + r) + dk * SPLAT(ln2Lo))) - f);
+}
+
+/* sin(x) with quadrant 0, or cos(x) with quadrant 1. */
+static VecD2 SinCos(VecD2 x, int64_t quadrant)
+{
+    VecI2 n;
+    VecD2 k = RoundInt(x * SPLAT(6.36619772367581382433e-01), &n);
+    /* pi/2 in three parts, so that the first two products are exact. */
+    VecD2 r = x - k * SPLAT(1.57079632673412561417e+00);
+    r = r - k * SPLAT(6.07710050630396597660e-11);
+    r = r - k * SPLAT(2.02226624871116645580e-21);
+    VecD2 z = r * r;
+    VecD2 sinr = r + z * r *
+                         (SPLAT(-1.66666666666666324348e-01) +
+                          z * (SPLAT(8.33333333332248946124e-03) +
+                               z * (SPLAT(-1.98412698298579493134e-04) +
+                                    z * (SPLAT(2.75573137070700676789e-06) +
+                                         z * (SPLAT(-2.50507602534068634195e-08) +
+                                              z * SPLAT(1.58969099521155010221e-10))))));
+    VecD2 cosr = SPLAT(1.0) - SPLAT(0.5) * z +
+                 z * z *
+                     (SPLAT(4.16666666666666019037e-02) +
+                      z * (SPLAT(-1.38888888888741095749e-03) +
+                           z * (SPLAT(2.48015872894767294178e-05) +
+                                z * (SPLAT(-2.75573143513906633035e-07) +
+                                     z * (SPLAT(2.08757232129817482790e-09) +
+                                          z * SPLAT(-1.13596475577881948265e-11))))));
+    VecI2 q = n + quadrant;
+    VecD2 res = Select((q & 1) == 0, sinr, cosr);
+    return (VecD2)((VecI2)res ^ ((q & 2) << 62));
+}
+
+static VecD2 Sin(VecD2 x)
+{
+    if (AnyLane(~(Abs(x) <= SPLAT(1e5))))
+    {
+	return SCALAR_D2(sin, x);
+    }
+    return SinCos(x, 0);
+}
+
+static VecD2 Cos(VecD2 x)
+{
+    if (AnyLane(~(Abs(x) <= SPLAT(1e5))))
+    {
+	return SCALAR_D2(cos, x);
+    }
+    return SinCos(x, 1);
+}
+
+static VecD2 Atan(VecD2 x)
+{
+    if (AnyLane(x != x))
+    {
+	return SCALAR_D2(atan, x);
+    }
+    VecD2 a = Abs(x);
+    /* atan(a) = pi/2 - atan(1/a) brings a to [0, 1], and atan(t) = pi/4 + atan((t-1)/(t+1))
+     * brings that to [0, tan(pi/8)]. */
+    VecI2 big = a > SPLAT(1.0);
+    VecD2 t = Select(big, SPLAT(1.0) / a, a);
+    VecI2 mid = t > SPLAT(0.41421356237309503);
+    VecD2 u = Select(mid, (t - SPLAT(1.0)) / (t + SPLAT(1.0)), t);
+    VecD2 z = u * u;
+    VecD2 w = z * z;
+    VecD2 s1 = z * (SPLAT(3.33333333333329318027e-01) +
+                    w * (SPLAT(1.42857142725034663711e-01) +
+                         w * (SPLAT(9.09088713343650656196e-02) +
+                              w * (SPLAT(6.66107313738753120669e-02) +
+                                   w * (SPLAT(4.97687799461593236017e-02) +
+                                        w * SPLAT(1.62858201153657823623e-02))))));
+    VecD2 s2 = w * (SPLAT(-1.99999999998764832476e-01) +
+                    w * (SPLAT(-1.11111104054623557880e-01) +
+                         w * (SPLAT(-7.69187620504482999495e-02) +
+                              w * (SPLAT(-5.83357013379057348645e-02) +
+                                   w * SPLAT(-3.65315727442169155270e-02)))));
+    VecD2 res = u - u * (s1 + s2);
+    VecD2 quarter = SPLAT(7.85398163397448278999e-01) + (SPLAT(3.06161699786838301793e-17) + res);
+    res = Select(mid, quarter, res);
+    VecD2 half = SPLAT(1.57079632679489655800e+00) - (res - SPLAT(6.12323399573676603587e-17));
+    res = Select(big, half, res);
+    return (VecD2)((VecI2)res | ((VecI2)x & (VecI2){ INT64_MIN, INT64_MIN }));
+}
+
+#define VECTOR_D2(name, func) \
+    VecD2 name(VecD2 x)       \
+    {                         \
+	return func(x);       \
+    }
+
+#define VECTOR_F4(name, func)                                                 \
+    VecF4 name(VecF4 x)                                                       \
+    {                                                                         \
+	VecD2 lo = func(((VecD2){ x[0], x[1] }));                                 \
+	VecD2 hi = func(((VecD2){ x[2], x[3] }));                                 \
+	return (VecF4){ (float)lo[0], (float)lo[1], (float)hi[0], (float)hi[1] }; \
+    }
+
+VECTOR_D2(__vsin_d2, Sin)
+VECTOR_D2(__vcos_d2, Cos)
+VECTOR_D2(__vexp_d2, Exp)
+VECTOR_D2(__vlog_d2, Log)
+VECTOR_D2(__vatan_d2, Atan)
+
+VECTOR_F4(__vsin_f4, Sin)
+VECTOR_F4(__vcos_f4, Cos)
+VECTOR_F4(__vexp_f4, Exp)
+VECTOR_F4(__vlog_f4, Log)
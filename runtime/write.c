@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*******************************************
@@ -31,7 +32,9 @@ void __write_S_int32(String* str, int v, int width)
 void __write_int32(File* file, int v, int width)
 {
     FILE* f = getFile(file);
+    lockFile(file);
     fprintf(f, "%*d", width, v);
+    unlockFile(file);
 }
 
 void __write_S_int64(String* str, int64_t v, int width)
@@ -44,44 +47,113 @@ void __write_S_int64(String* str, int64_t v, int width)
 void __write_int64(File* file, int64_t v, int width)
 {
     FILE* f = getFile(file);
+    lockFile(file);
     fprintf(f, "%*" PRId64, width, v);
+    unlockFile(file);
 }
 
-void __write_S_real(String* str, double v, int width, int precision)
+/* Only as many digits as fit in a string are written to one. */
+void __write_S_bigint(String* str, const struct BigInt* v, int width)
 {
-    char buffer[MaxStringLen + 1];
-    bool scientific = precision == -1;
+    char  buffer[MaxStringLen + 1];
+    char* s = __BigToString(v);
+    int   n = snprintf(buffer, sizeof(buffer), "%*s", width, s);
+    free(s);
+    SetStrResult(str, (n < MaxStringLen - str->len) ? n : MaxStringLen - str->len, buffer);
+}
+
+void __write_bigint(File* file, const struct BigInt* v, int width)
+{
+    FILE* f = getFile(file);
+    char* s = __BigToString(v);
+    lockFile(file);
+    fprintf(f, "%*s", width, s);
+    unlockFile(file);
+    free(s);
+}
+
+/* Default width and precision for writing a real to a string, the same for real, single and extended.
+ * Returns true for scientific notation. */
+static bool StrRealFormat(int* width, int* precision)
+{
+    bool scientific = *precision == -1;
 
     if (scientific)
     {
-	if (width == 0)
+	if (*width == 0)
 	{
-	    width = 13;
+	    *width = 13;
 	}
-	if (precision == 0)
+	if (*precision == 0)
 	{
-	    precision = (width > 8) ? width - 7 : 1;
+	    *precision = (*width > 8) ? *width - 7 : 1;
 	}
     }
-
-    int n = snprintf(buffer, sizeof(buffer), (scientific) ? "% *.*E" : "%*.*f", width, precision, v);
-    SetStrResult(str, n, buffer);
+    return scientific;
 }
 
-void __write_real(File* file, double v, int width, int precision)
+/* As StrRealFormat, for writing to a file. */
+static bool FileRealFormat(int* width, int* precision)
 {
-    FILE* f = getFile(file);
-    bool  scientific = precision == -1;
+    bool scientific = *precision == -1;
 
     if (scientific)
     {
-	if (width == 0)
+	if (*width == 0)
 	{
-	    width = 13;
+	    *width = 13;
 	}
-	precision = (width > 8) ? width - 7 : 1;
+	*precision = (*width > 8) ? *width - 7 : 1;
     }
+    return scientific;
+}
+
+void __write_S_real(String* str, double v, int width, int precision)
+{
+    char buffer[MaxStringLen + 1];
+    bool scientific = StrRealFormat(&width, &precision);
+
+    int n = snprintf(buffer, sizeof(buffer), (scientific) ? "% *.*E" : "%*.*f", width, precision, v);
+    SetStrResult(str, n, buffer);
+}
+
+void __write_real(File* file, double v, int width, int precision)
+{
+    FILE* f = getFile(file);
+    bool  scientific = FileRealFormat(&width, &precision);
+
+    lockFile(file);
     fprintf(f, (scientific) ? "% *.*E" : "%*.*f", width, precision, v);
+    unlockFile(file);
+}
+
+void __write_S_single(String* str, float v, int width, int precision)
+{
+    __write_S_real(str, v, width, precision);
+}
+
+void __write_single(File* file, float v, int width, int precision)
+{
+    __write_real(file, v, width, precision);
+}
+
+void __write_S_extended(String* str, long double v, int width, int precision)
+{
+    char buffer[MaxStringLen + 1];
+    bool scientific = StrRealFormat(&width, &precision);
+
+    int n = snprintf(buffer, sizeof(buffer), (scientific) ? "% *.*LE" : "%*.*Lf", width, precision, v);
+    SetStrResult(str, n, buffer);
+}
+
+void __write_extended(File* file, long double v, int width, int precision)
+{
+    FILE* f = getFile(file);
+    bool  scientific = FileRealFormat(&width, &precision);
+
+    lockFile(file);
+    fprintf(f, (scientific) ? "% *.*LE" : "%*.*Lf", width, precision, v);
+    unlockFile(file);
 }
 
 void __write_S_char(String* str, char v, int width)
@@ -102,7 +174,9 @@ void __write_char(File* file, char v, int width)
     {
 	width = 1;
     }
+    lockFile(file);
     fprintf(f, "%*c", width, v);
+    unlockFile(file);
 }
 
 void __write_S_bool(String* str, int v, int width)
@@ -125,7 +199,9 @@ void __write_bool(File* file, int v, int width)
     {
 	width = (v) ? 4 : 5;
     }
+    lockFile(file);
     fprintf(f, "%*s", width, vstr);
+    unlockFile(file);
 }
 
 void __write_S_chars(String* str, const char* v, int len, int width)
@@ -150,6 +226,7 @@ void __write_S_chars(String* str, const char* v, int len, int width)
 void __write_chars(File* file, const char* v, int len, int width)
 {
     FILE* f = getFile(file);
+    lockFile(file);
     if (width > 0)
     {
 	if (len > width)
@@ -162,6 +239,7 @@ void __write_chars(File* file, const char* v, int len, int width)
     {
 	fprintf(f, "%.*s", len, v);
     }
+    unlockFile(file);
 }
 
 void __write_S_str(String* str, const String* v, int width)
@@ -188,6 +266,7 @@ void __write_str(File* file, const String* v, int width)
     char  s[MaxStringLen + 1];
     memcpy(s, v->str, v->len);
     s[v->len] = 0;
+    lockFile(file);
     if (width < v->len)
     {
 	fprintf(f, "%*s", width, s);
@@ -196,10 +275,13 @@ void __write_str(File* file, const String* v, int width)
     {
 	fprintf(f, "%s", s);
     }
+    unlockFile(file);
 }
 
 void __write_nl(File* file)
 {
     FILE* f = getFile(file);
+    lockFile(file);
     fputc('\n', f);
+    unlockFile(file);
 }
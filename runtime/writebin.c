@@ -13,6 +13,8 @@ void __write_bin(File* file, void* val)
 	fprintf(stderr, "Invalid file used for write binary file\n");
 	return;
     }
+    lockFile(file);
     memcpy(file->buffer, val, file->recordSize);
     __put(file);
+    unlockFile(file);
 }
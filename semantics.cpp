@@ -4,6 +4,8 @@
 #include "token.h"
 #include "trace.h"
 #include "visitor.h"
+#include <algorithm>
+#include <cstdint>
 
 class TypeCheckVisitor : public ASTVisitor
 {
@@ -14,6 +16,8 @@ public:
 private:
     Types::TypeDecl* BinarySetUpdate(BinaryExprAST* b);
     Types::TypeDecl* BinaryExprType(BinaryExprAST* b);
+    Types::TypeDecl* BinaryVectorType(BinaryExprAST* b);
+    Types::TypeDecl* BinaryBigIntType(BinaryExprAST* b);
     template<typename T>
     void Check(T* t);
     template<typename T>
@@ -130,6 +134,109 @@ ExprAST* Recast(ExprAST* a, const Types::TypeDecl* ty)
     return a;
 }
 
+// Make key usable as a key of mty. The runtime copies the whole key, so a string can't be longer
+// than the string type of the keys.
+bool RecastMapKey(ExprAST*& key, const Types::MapDecl* mty)
+{
+    Types::TypeDecl* keyTy = mty->KeyType();
+    Types::TypeDecl* ty = key->Type();
+    if (auto sd = llvm::dyn_cast<Types::StringDecl>(keyTy))
+    {
+	if (auto se = llvm::dyn_cast<StringExprAST>(key))
+	{
+	    return se->Str().size() <= size_t(sd->Capacity());
+	}
+	if (auto st = llvm::dyn_cast<Types::StringDecl>(ty))
+	{
+	    return st->Capacity() <= sd->Capacity();
+	}
+	if (IsCharArray(ty) && llvm::isa<AddressableAST>(key))
+	{
+	    return llvm::cast<Types::ArrayDecl>(ty)->Ranges()[0]->RangeSize() <= size_t(sd->Capacity());
+	}
+	return llvm::isa<Types::CharDecl>(ty);
+    }
+    if (IsIntegral(keyTy))
+    {
+	const Types::TypeDecl* t = keyTy->CompatibleType(ty);
+	if (!t || !IsIntegral(t))
+	{
+	    return false;
+	}
+	key = Recast(key, keyTy);
+	return true;
+    }
+    return keyTy->SameAs(ty);
+}
+
+// A for-in loop over a map copies each key to a variable of type vty.
+static bool IsKeyVariable(const Types::TypeDecl* vty, const Types::TypeDecl* keyTy)
+{
+    if (auto sd = llvm::dyn_cast<Types::StringDecl>(keyTy))
+    {
+	auto st = llvm::dyn_cast<Types::StringDecl>(vty);
+	return st && st->Capacity() >= sd->Capacity();
+    }
+    if (IsIntegral(keyTy))
+    {
+	return IsIntegral(vty) && keyTy->CompatibleType(vty);
+    }
+    return keyTy->SameAs(vty);
+}
+
+// Map elements, and anything inside them, live in the map's slot array, which moves when a later
+// insert grows the table, so their address can't be held across other expressions.
+static bool IsMapElement(const ExprAST* e)
+{
+    if (llvm::isa<MapExprAST>(e))
+    {
+	return true;
+    }
+    if (auto fe = llvm::dyn_cast<FieldExprAST>(e))
+    {
+	return IsMapElement(fe->Base());
+    }
+    if (auto vfe = llvm::dyn_cast<VariantFieldExprAST>(e))
+    {
+	return IsMapElement(vfe->Base());
+    }
+    if (auto ae = llvm::dyn_cast<ArrayExprAST>(e))
+    {
+	return IsMapElement(ae->Base());
+    }
+    return false;
+}
+
+// An element of a {$soa} array has no address of its own, as its fields are in separate arrays.
+static bool IsSoAElement(const ExprAST* e)
+{
+    auto ae = llvm::dyn_cast<ArrayExprAST>(e);
+    return ae && ae->IsSoA();
+}
+
+// An element of a bit-packed array shares its bytes with its neighbours, so has no address either.
+static bool IsBitPackedElement(const ExprAST* e)
+{
+    auto ae = llvm::dyn_cast<ArrayExprAST>(e);
+    return ae && ae->IsBitPacked();
+}
+
+// The most precise real type of the operands, or real if neither is a real.
+static Types::TypeDecl* RealResultType(Types::TypeDecl* lty, Types::TypeDecl* rty)
+{
+    auto lrty = llvm::dyn_cast<Types::RealDecl>(lty);
+    auto rrty = llvm::dyn_cast<Types::RealDecl>(rty);
+    if (lrty && (!rrty || lrty->Bits() >= rrty->Bits()))
+    {
+	return lrty;
+    }
+    if (rrty)
+    {
+	return rrty;
+    }
+    return Types::Get<Types::RealDecl>();
+}
+
 Types::TypeDecl* TypeCheckVisitor::BinarySetUpdate(BinaryExprAST* b)
 {
     auto lty = llvm::cast<Types::SetDecl>(b->lhs->Type());
@@ -197,6 +304,124 @@ Types::TypeDecl* TypeCheckVisitor::BinarySetUpdate(BinaryExprAST* b)
     return rty;
 }
 
+// Element-wise operation on vectors. A scalar on either side is broadcast to all lanes.
+Types::TypeDecl* TypeCheckVisitor::BinaryVectorType(BinaryExprAST* b)
+{
+    auto lvty = llvm::dyn_cast<Types::VectorDecl>(b->lhs->Type());
+    auto rvty = llvm::dyn_cast<Types::VectorDecl>(b->rhs->Type());
+    auto vty = (lvty) ? lvty : rvty;
+    if (lvty && rvty && *lvty != *rvty)
+    {
+	Error(b, "Vectors should have same size and element type");
+	return vty;
+    }
+    ExprAST*& scalar = (lvty) ? b->rhs : b->lhs;
+    if (!vty->CompatibleType(scalar->Type()))
+    {
+	Error(b, "Incompatible type in vector expression");
+	return vty;
+    }
+    scalar = Recast(scalar, vty);
+
+    Types::TypeDecl* elemTy = vty->SubType();
+    bool             isBool = llvm::isa<Types::BoolDecl>(elemTy);
+    bool             isReal = llvm::isa<Types::RealDecl>(elemTy);
+    switch (b->oper.GetToken())
+    {
+    case Token::Plus:
+    case Token::Minus:
+    case Token::Multiply:
+	if (isBool)
+	{
+	    Error(b, "Expected numeric vector type");
+	}
+	return vty;
+
+    case Token::Divide:
+	if (!isReal)
+	{
+	    Error(b, "Divide on vectors only works for real elements, use DIV for integers");
+	}
+	return vty;
+
+    case Token::Div:
+    case Token::Mod:
+	if (isBool || isReal)
+	{
+	    Error(b, "Types for DIV and MOD should be integer");
+	}
+	return vty;
+
+    case Token::And:
+    case Token::Or:
+    case Token::Xor:
+	if (isReal)
+	{
+	    Error(b, "Expression must be integral types on both sides");
+	}
+	return vty;
+
+    default:
+	break;
+    }
+    if (b->oper.IsCompare() && !isBool)
+    {
+	// Comparisons give a mask, one boolean per lane.
+	return vty->MaskType();
+    }
+    Error(b, "Invalid operator for vector type");
+    return vty;
+}
+
+// Integers on either side are converted to bigint, except for the exponent of POW, which is
+// passed to the runtime as a 64-bit integer.
+Types::TypeDecl* TypeCheckVisitor::BinaryBigIntType(BinaryExprAST* b)
+{
+    Types::TypeDecl* bigTy = Types::Get<Types::BigIntDecl>();
+    Token::TokenType op = b->oper.GetToken();
+    for (auto e : { b->lhs, b->rhs })
+    {
+	Types::TypeDecl* ty = e->Type();
+	if (auto rd = llvm::dyn_cast<Types::RangeBaseDecl>(ty))
+	{
+	    ty = rd->SubType();
+	}
+	if (!llvm::isa<Types::BigIntDecl, Types::IntegerDecl, Types::Int64Decl>(ty))
+	{
+	    Error(b, "Operands of bigint expression should be bigint or integer");
+	    return bigTy;
+	}
+    }
+    b->lhs = Recast(b->lhs, bigTy);
+    if (op == Token::Pow)
+    {
+	if (llvm::isa<Types::BigIntDecl>(b->rhs->Type()))
+	{
+	    Error(b, "Exponent of bigint POW should be an integer");
+	}
+	b->rhs = Recast(b->rhs, Types::Get<Types::Int64Decl>());
+	return bigTy;
+    }
+    b->rhs = Recast(b->rhs, bigTy);
+    if (b->oper.IsCompare())
+    {
+	return Types::Get<Types::BoolDecl>();
+    }
+    switch (op)
+    {
+    case Token::Plus:
+    case Token::Minus:
+    case Token::Multiply:
+    case Token::Div:
+    case Token::Mod:
+	break;
+    default:
+	Error(b, "Invalid operator for bigint");
+	break;
+    }
+    return bigTy;
+}
+
 Types::TypeDecl* TypeCheckVisitor::BinaryExprType(BinaryExprAST* b)
 {
     Types::TypeDecl* lty = b->lhs->Type();
@@ -206,6 +431,37 @@ Types::TypeDecl* TypeCheckVisitor::BinaryExprType(BinaryExprAST* b)
 
     ICE_IF(!rty || !lty, "Expect to have types here");
 
+    if (llvm::isa<Types::VectorDecl>(lty) || llvm::isa<Types::VectorDecl>(rty))
+    {
+	return BinaryVectorType(b);
+    }
+
+    if (llvm::isa<Types::BigIntDecl>(lty) || llvm::isa<Types::BigIntDecl>(rty))
+    {
+	return BinaryBigIntType(b);
+    }
+
+    // A real literal takes the type of a single or extended operand, rather than widening it.
+    if (llvm::isa<RealExprAST>(b->rhs) && llvm::isa<Types::RealDecl>(lty))
+    {
+	b->rhs = Recast(b->rhs, lty);
+	rty = lty;
+    }
+    if (llvm::isa<RealExprAST>(b->lhs) && llvm::isa<Types::RealDecl>(rty))
+    {
+	b->lhs = Recast(b->lhs, rty);
+	lty = rty;
+    }
+
+    if (op == Token::In && llvm::isa<Types::MapDecl>(rty))
+    {
+	if (!RecastMapKey(b->lhs, llvm::cast<Types::MapDecl>(rty)))
+	{
+	    Error(b, "Left hand of 'in' expression should be a key of the map.");
+	}
+	return Types::Get<Types::BoolDecl>();
+    }
+
     if (op == Token::In)
     {
 	if (!IsIntegral(lty))
@@ -312,7 +568,7 @@ Types::TypeDecl* TypeCheckVisitor::BinaryExprType(BinaryExprAST* b)
 	}
 	else
 	{
-	    ty = Types::Get<Types::RealDecl>();
+	    ty = RealResultType(lty, rty);
 	}
 
 	b->lhs = Recast(b->lhs, ty);
@@ -336,22 +592,23 @@ Types::TypeDecl* TypeCheckVisitor::BinaryExprType(BinaryExprAST* b)
 	if (llvm::isa<Types::ComplexDecl>(lty))
 	{
 	    ty = Types::Get<Types::ComplexDecl>();
+	    rty = Types::Get<Types::RealDecl>();
 	}
 	else
 	{
-	    ty = Types::Get<Types::RealDecl>();
+	    ty = RealResultType(lty, rty);
+	    rty = ty;
 	}
 
 	b->lhs = Recast(b->lhs, ty);
 	lty = ty;
 
-	if (llvm::isa<Types::ComplexDecl>(rty))
+	if (llvm::isa<Types::ComplexDecl>(b->rhs->Type()))
 	{
 	    Error(b, "Exponent for ** operator should not be a complex value");
 	}
 
-	b->rhs = Recast(b->rhs, Types::Get<Types::RealDecl>());
-	rty = Types::Get<Types::RealDecl>();
+	b->rhs = Recast(b->rhs, rty);
 
 	if (!llvm::isa<Types::RealDecl, Types::ComplexDecl>(lty))
 	{
@@ -483,16 +740,22 @@ void TypeCheckVisitor::Check<UnaryExprAST>(UnaryExprAST* u)
     TRACE();
 
     Types::TypeDecl* ty = u->rhs->Type();
+    Types::TypeDecl* elemTy = ty;
+    if (auto vty = llvm::dyn_cast<Types::VectorDecl>(ty))
+    {
+	elemTy = vty->SubType();
+    }
     if (u->oper.GetToken() == Token::Not)
     {
-	if (!IsIntegral(ty) || llvm::isa<Types::CharDecl>(ty))
+	if (!IsIntegral(elemTy) || llvm::isa<Types::CharDecl>(elemTy))
 	{
 	    Error(u, "Expect integral argument to NOT");
 	}
     }
     if (u->oper.GetToken() == Token::Minus)
     {
-	if (!IsNumeric(ty))
+	bool isNumeric = IsNumeric(elemTy) || llvm::isa<Types::BigIntDecl>(elemTy);
+	if (!isNumeric || llvm::isa<Types::BoolDecl>(elemTy))
 	{
 	    Error(u, "Expect numeric type (Real, Integer) argument to unary '-'");
 	}
@@ -508,6 +771,8 @@ void TypeCheckVisitor::Check<AssignExprAST>(AssignExprAST* a)
     Types::TypeDecl* lty = a->lhs->Type();
     Types::TypeDecl* rty = a->rhs->Type();
 
+    a->valueFirst = FindParentOfType<MapExprAST>(a->lhs) != 0;
+
     auto vExpr = FindParentOfType<VariableExprAST>(a->lhs);
     if (!vExpr)
     {
@@ -579,6 +844,25 @@ void TypeCheckVisitor::Check<AssignExprAST>(AssignExprAST* a)
 	return;
     }
 
+    // Vectors are loaded from and stored to arrays or array slices of the same size.
+    if (auto vty = llvm::dyn_cast<Types::VectorDecl>(lty))
+    {
+	if (vty->MatchesArray(rty))
+	{
+	    a->rhs = Recast(a->rhs, vty);
+	    return;
+	}
+    }
+    auto rvty = llvm::dyn_cast<Types::VectorDecl>(rty);
+    if (rvty && !llvm::isa<Types::VectorDecl>(lty))
+    {
+	if (!rvty->MatchesArray(lty))
+	{
+	    Error(a, "Vector should be stored to an array of same size and element type");
+	}
+	return;
+    }
+
     const Types::TypeDecl* ty = lty->AssignableType(rty);
     if (!ty)
     {
@@ -675,6 +959,28 @@ void TypeCheckVisitor::Check<DynArrayExprAST>(DynArrayExprAST* d)
     }
 }
 
+template<>
+void TypeCheckVisitor::Check<HeapArrayExprAST>(HeapArrayExprAST* h)
+{
+    TRACE();
+
+    if (!IsIntegral(h->index->Type()))
+    {
+	Error(h->index, "Index should be an integral type");
+    }
+}
+
+template<>
+void TypeCheckVisitor::Check<MapExprAST>(MapExprAST* m)
+{
+    TRACE();
+
+    if (!RecastMapKey(m->key, llvm::cast<Types::MapDecl>(m->map->Type())))
+    {
+	Error(m->key, "Key type does not match the map");
+    }
+}
+
 template<>
 void TypeCheckVisitor::Check<BuiltinExprAST>(BuiltinExprAST* b)
 {
@@ -715,6 +1021,32 @@ void TypeCheckVisitor::Check<CallExprAST>(CallExprAST* c)
 	    {
 		Error(c, "Expect variable for 'var' parameter");
 	    }
+	    else if (parg[idx].IsRef() && IsPackedComponent(a))
+	    {
+		Error(a, "Component of packed record can't be a 'var' argument");
+		bad = false;
+	    }
+	    else if (parg[idx].IsRef() && IsIntegral(ty) &&
+	             a->Type()->StorageType() != parg[idx].Type()->StorageType())
+	    {
+		Error(a, "var argument must have the parameter's type");
+		bad = false;
+	    }
+	    else if (parg[idx].IsRef() && IsBitPackedElement(a))
+	    {
+		Error(a, "Element of packed array can't be a 'var' argument");
+		bad = false;
+	    }
+	    else if (parg[idx].IsRef() && IsSoAElement(a))
+	    {
+		Error(a, "Element of {$soa} array can't be a 'var' argument");
+		bad = false;
+	    }
+	    else if (parg[idx].IsRef() && IsMapElement(a))
+	    {
+		Error(a, "Map element can't be a 'var' argument");
+		bad = false;
+	    }
 	    else
 	    {
 		a = Recast(a, ty);
@@ -764,7 +1096,16 @@ void TypeCheckVisitor::Check<ForExprAST>(ForExprAST* f)
     TRACE();
     // Check start + end and cast if necessary. Fail if incompatible types.
     Types::TypeDecl* vty = f->variable->Type();
-    bool             bad = !IsIntegral(vty);
+    auto             mty = llvm::dyn_cast<Types::MapDecl>(f->start->Type());
+    if (mty && !f->end)
+    {
+	if (!IsKeyVariable(vty, mty->KeyType()))
+	{
+	    Error(f->variable, "Expected variable to be compatible with the keys of the map");
+	}
+	return;
+    }
+    bool bad = !IsIntegral(vty);
     if (bad)
     {
 	Error(f->variable, "Loop iteration variable must be integral type");
@@ -838,13 +1179,13 @@ void TypeCheckVisitor::Check<ReadAST>(ReadAST* r)
     {
 	for (auto arg : r->args)
 	{
-	    if (!llvm::isa<AddressableAST>(arg))
+	    if (!llvm::isa<AddressableAST>(arg) || IsBitPackedElement(arg))
 	    {
 		Error(arg, "Invalid argument for Read/ReadLN - must be a variable-expression");
 	    }
 	    if (IsCompound(arg->Type()))
 	    {
-		bool bad = true;
+		bool bad = !llvm::isa<Types::BigIntDecl>(arg->Type());
 		if (llvm::isa<Types::ArrayDecl>(arg->Type()))
 		{
 		    bad = !Types::IsCharArray(arg->Type()) && !llvm::isa<Types::StringDecl>(arg->Type());
@@ -919,7 +1260,7 @@ void TypeCheckVisitor::Check<WriteAST>(WriteAST* w)
 		}
 		else
 		{
-		    bad = !llvm::isa<Types::StringDecl>(e->Type());
+		    bad = !llvm::isa<Types::StringDecl, Types::BigIntDecl>(e->Type());
 		}
 		if (bad)
 		{
@@ -954,12 +1295,18 @@ template<>
 void TypeCheckVisitor::Check<CaseExprAST>(CaseExprAST* c)
 {
     TRACE();
-    if (!IsIntegral(c->expr->Type()))
+    Types::TypeDecl* ty = c->expr->Type();
+    if (Types::IsStringLike(ty) && !llvm::isa<Types::CharDecl>(ty))
+    {
+	c->expr = Recast(c->expr, Types::Get<Types::StringDecl>(255));
+    }
+    else if (!IsIntegral(ty))
     {
-	Error(c, "Case selection must be integral type");
+	Error(c, "Case selection must be integral or string type");
     }
 
     std::vector<std::pair<int, int>> vals;
+    std::vector<std::string>         strs;
     for (auto l : c->labels)
     {
 	for (auto i : l->labelValues)
@@ -970,6 +1317,14 @@ void TypeCheckVisitor::Check<CaseExprAST>(CaseExprAST* c)
 	    }
 	    vals.push_back(i);
 	}
+	for (auto& s : l->labelStrings)
+	{
+	    if (std::find(strs.begin(), strs.end(), s) != strs.end())
+	    {
+		Error(c, "Duplicate case label '" + s + "'");
+	    }
+	    strs.push_back(s);
+	}
     }
 }
 
@@ -1006,30 +1361,20 @@ void TypeCheckVisitor::Check(IfExprAST* i)
 template<>
 void TypeCheckVisitor::Check(InitArrayAST* a)
 {
-    std::vector<int64_t> indices;
-    auto                 CheckDups = [&](int64_t x)
-    {
-	if (std::find(indices.begin(), indices.end(), x) != indices.end())
-	{
-	    Error(a, "Duplicate initializer " + std::to_string(x));
-	}
-    };
-    bool hasOtherwise = false;
+    auto                                      aty = llvm::cast<Types::ArrayDecl>(a->Type());
+    Types::Range*                             range = aty->Ranges()[0]->GetRange();
+    std::vector<std::pair<int64_t, int64_t>> indices;
+    bool                                      hasOtherwise = false;
 
     for (auto v : a->values)
     {
 	switch (v.Kind())
 	{
 	case ArrayInit::InitKind::Range:
-	    for (int64_t i = v.Start(); i <= v.End(); i++)
-	    {
-		CheckDups(i);
-		indices.push_back(i);
-	    }
+	    indices.push_back({ v.Start(), v.End() });
 	    break;
 	case ArrayInit::InitKind::Single:
-	    CheckDups(v.Start());
-	    indices.push_back(v.Start());
+	    indices.push_back({ v.Start(), v.Start() });
 	    break;
 	case ArrayInit::InitKind::Otherwise:
 	    if (hasOtherwise)
@@ -1041,6 +1386,27 @@ void TypeCheckVisitor::Check(InitArrayAST* a)
 	default:
 	    llvm_unreachable("Unexpected initalizer kind");
 	}
+	// The rows of a multidimensional array.
+	if (auto row = llvm::dyn_cast<InitArrayAST>(v.Value()))
+	{
+	    Check(row);
+	}
+    }
+
+    // Sorted by start, an index is a duplicate if it's in the range before.
+    std::sort(indices.begin(), indices.end());
+    int64_t last = INT64_MIN;
+    for (auto i : indices)
+    {
+	if (i.first < range->Start() || i.second > range->End())
+	{
+	    Error(a, "Initializer index out of range " + std::to_string(i.first));
+	}
+	else if (i.first <= last)
+	{
+	    Error(a, "Duplicate initializer " + std::to_string(i.first));
+	}
+	last = std::max(last, i.second);
     }
 }
 
@@ -1085,6 +1451,8 @@ void TypeCheckVisitor::visit(ExprAST* expr)
     MaybeCheck<SetExprAST>(expr);
     MaybeCheck<ArrayExprAST>(expr);
     MaybeCheck<DynArrayExprAST>(expr);
+    MaybeCheck<HeapArrayExprAST>(expr);
+    MaybeCheck<MapExprAST>(expr);
     MaybeCheck<BuiltinExprAST>(expr);
     MaybeCheck<CallExprAST>(expr);
     MaybeCheck<ForExprAST>(expr);
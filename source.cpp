@@ -1,33 +1,35 @@
 #include "source.h"
 #include <iostream>
+#include <iterator>
+
+// The whole file is read up front, as the size of a pipe can't be found by seeking, and the
+// SourceManager needs it to give the file its range of offsets.
+FileSource::FileSource(const std::string& name) : pos(0)
+{
+    std::ifstream input(name);
+    ok = (bool)input;
+    text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    size = text.size();
+    file = GetSourceManager().AddFile(name, size);
+    start = GetSourceManager().FileStart(file);
+}
 
 char FileSource::Get()
 {
-    char ch = input.get();
+    char ch = (pos < size) ? text[pos] : std::char_traits<char>::eof();
+    pos++;
     if (ch == '\n')
     {
-	lineNo++;
-	lineStart[lineNo] = input.tellg();
-	column = 1;
-    }
-    else
-    {
-	column++;
+	GetSourceManager().AddLine(file, start + pos);
     }
     return ch;
 }
 
 void FileSource::PrintSource(uint32_t line)
 {
-    std::fstream::pos_type here = input.tellg();
-    input.clear();
-    input.seekg(lineStart[line]);
-
-    char ch;
-    while ((ch = input.get()) && ch != '\n' && input)
+    for (uint32_t i = GetSourceManager().LineStart(file, line) - start; i < size && text[i] != '\n'; i++)
     {
-	std::cerr << ch;
+	std::cerr << text[i];
     }
     std::cerr << std::endl;
-    input.seekg(here);
 }
@@ -2,9 +2,9 @@
 #define SOURCE_H
 
 #include "location.h"
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
-#include <map>
 #include <string>
 
 class Source
@@ -20,18 +20,19 @@ public:
 class FileSource : public Source
 {
 public:
-    FileSource(const std::string& name) : name(name), input(name), column(1), lineNo(1) { lineStart[1] = 0; }
+    FileSource(const std::string& name);
     char Get() override;
-    operator bool() const override { return (bool)input; }
-    operator Location() const override { return Location(name, lineNo, column); }
+    operator bool() const override { return ok && pos <= size; }
+    operator Location() const override { return Location(start + std::min(pos, size)); }
     void PrintSource(uint32_t line) override;
 
 private:
-    std::string                                name;
-    std::ifstream                              input;
-    uint32_t                                   column;
-    uint32_t                                   lineNo;
-    std::map<uint32_t, std::fstream::pos_type> lineStart;
+    std::string text;
+    bool        ok;
+    size_t      file;
+    uint32_t    start;
+    uint32_t    size;
+    uint32_t    pos;
 };
 
 #endif
@@ -7,6 +7,7 @@
 #include <deque>
 #include <iostream>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -44,7 +45,12 @@ public:
     bool Add(std::string name, const T& v)
     {
 	LowerIfNeeded(name);
-	const auto [it, inserted] = stack.back().insert({ name, v });
+	auto [it, inserted] = stack.back().insert({ name, v });
+	if (!inserted && stack.size() == 1 && overridable.erase(name))
+	{
+	    it->second = v;
+	    inserted = true;
+	}
 	if (verbosity > 1 && inserted)
 	{
 	    std::cerr << "Adding value: " << name << std::endl;
@@ -54,6 +60,16 @@ public:
     // Alternative version, used with NamedObject
     bool Add(const T& v) { return Add(v->Name(), v); }
 
+    /* Add a name to the base level that the program may define again, for predefined
+     * names that aren't in the standard, so code using them as identifiers still works. */
+    bool AddOverridable(const T& v)
+    {
+	std::string name = v->Name();
+	LowerIfNeeded(name);
+	overridable.insert(name);
+	return Add(name, v);
+    }
+
     T Find(std::string name) const
     {
 	if (verbosity > 1)
@@ -105,7 +121,8 @@ public:
     void dump() const;
 
 private:
-    StackType stack;
+    StackType             stack;
+    std::set<std::string> overridable;
 };
 
 template<typename T>
@@ -0,0 +1,34 @@
+program bigindex;
+
+type
+   byte	 = 0..255;
+   huge	 = array [0..3000000000] of byte;
+   grid	 = array [0..99999, 0..99999] of integer;
+   lrange = 3000000000..3000000009;
+
+var
+   a	 : array [lrange] of longint;
+   b	 : array [-5..5] of integer;
+   i	 : longint;
+   j	 : integer;
+   l	 : lrange;
+   sum	 : longint;
+
+begin
+   writeln('Sizes: ', sizeof(huge), ' ', sizeof(grid));
+
+   i := 1500000000;
+   i := i * 2;
+   for l := i to i + 9 do
+      a[l] := l - i;
+   sum := 0;
+   for l := i to i + 9 do
+      sum := sum + a[l];
+   writeln('Sum: ', sum, ' ', a[i + 9]);
+
+   for j := -5 to 5 do
+      b[j] := j * j;
+   i := -5;
+   j := -4;
+   writeln('Ends: ', b[i], ' ', b[j], ' ', b[5]);
+end.
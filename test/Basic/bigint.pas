@@ -0,0 +1,74 @@
+program bigint;
+
+var
+   a, b, c : bigint;
+   i	   : integer;
+   s	   : string;
+
+function fact(n : integer) : bigint;
+var
+   r : bigint;
+   i : integer;
+begin
+   r := 1;
+   for i := 2 to n do
+      r := r * i;
+   fact := r
+end;
+
+function double(x : bigint) : bigint;
+begin
+   x := x + x;
+   double := x
+end;
+
+{ Large enough for the Karatsuba multiply to kick in. }
+function square(x : bigint; n : integer) : bigint;
+var
+   i : integer;
+begin
+   for i := 1 to n do
+      x := x * x;
+   square := x
+end;
+
+begin
+   a := fact(30);
+   writeln(a);
+   writeln(fact(100));
+   b := a;
+   b := b + 1;
+   writeln(a, ' ', b);
+   writeln(double(a), ' ', a);
+   writeln(-a);
+
+   a := 7;
+   writeln(-17 div a, ' ', -17 mod a, ' ', 17 div -a, ' ', 17 mod -a);
+
+   a := 2;
+   c := a pow 200;
+   writeln(c);
+   writeln(c div fact(20), ' ', c mod fact(20));
+   a := 7;
+   writeln(a < c, ' ', c > 5, ' ', 3 = a - 4, ' ', a <> 7, ' ', -c <= c);
+
+   a := 0;
+   b := 1;
+   for i := 1 to 300 do
+   begin
+      c := a + b;
+      a := b;
+      b := c;
+   end;
+   writeln('fib(300) = ', a);
+
+   c := square(fact(25) - 1, 7);
+   b := square(fact(25) - 1, 6);
+   writeln(c mod 1000000007, ' ', c div b = b, ' ', c mod b = 0);
+
+   s := '-123456789012345678901234567890';
+   readstr(s, a);
+   writeln(a * a:70);
+   writestr(s, a:40);
+   writeln('[', s, ']');
+end.
@@ -0,0 +1,75 @@
+program blockmem;
+
+type
+   point = record
+	      x, y : integer;
+	   end;
+   arr = array [1..10] of integer;
+   pts = array [1..4] of point;
+   digit = 5..9;
+
+var
+   a, b	: arr;
+   p	: pts;
+   s	: array [1..16] of char;
+   i	: integer;
+   r	: real;
+   d	: digit;
+
+procedure show(var a : arr);
+var
+   i : integer;
+begin
+   for i := 1 to 10 do
+      write(a[i]:4);
+   writeln;
+end;
+
+begin
+   for i := 1 to 10 do
+      a[i] := i * i;
+   show(a);
+   fillchar(a, sizeof(a), 0);
+   show(a);
+   fillchar(a, 3 * sizeof(integer), 1);
+   show(a);
+   fillchar(s, sizeof(s), '*');
+   writeln(s);
+   fillchar(s, 4, ord('-'));
+   writeln(s);
+
+   for i := 1 to 10 do
+      a[i] := i;
+   move(a, b, sizeof(a));
+   show(b);
+   move(a[1], a[3], 5 * sizeof(integer));
+   show(a);
+   move(a[3], a[1], 5 * sizeof(integer));
+   show(a);
+
+   writeln(comparemem(a, a, sizeof(a)));
+   b := a;
+   writeln(comparemem(a, b, sizeof(a)));
+   b[10] := 42;
+   writeln(comparemem(a, b, sizeof(a)));
+   writeln(comparemem(a, b, 9 * sizeof(integer)));
+
+   for i := 1 to 4 do
+   begin
+      p[i].x := i;
+      p[i].y := -i;
+   end;
+   p := default(pts);
+   writeln(p[1].x, p[4].y);
+   a := default(arr);
+   show(a);
+   r := 3.5;
+   r := default(real);
+   writeln(r:5:2);
+   i := 7;
+   i := default(integer);
+   writeln(i);
+   d := 7;
+   d := default(digit);
+   writeln(d);
+end.
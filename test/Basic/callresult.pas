@@ -0,0 +1,32 @@
+program callresult;
+
+type
+   intarr = array of integer;
+
+var
+   i, sum : integer;
+
+function Squares(n : integer) : intarr;
+var
+   i : integer;
+   t : intarr;
+begin
+   SetLength(t, n);
+   for i := 0 to n - 1 do
+      t[i] := i * i;
+   Squares := t
+end;
+
+function Last(n : integer) : integer;
+begin
+   Last := Squares(n)[n - 1]
+end;
+
+begin
+   writeln('Length: ', Length(Squares(7)), ' High: ', High(Squares(7)));
+   sum := 0;
+   for i := 1 to 1000 do
+      sum := sum + Squares(i)[i - 1] - Length(Squares(i));
+   writeln('Sum: ', sum);
+   writeln('Last: ', Last(12));
+end.
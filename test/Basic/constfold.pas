@@ -0,0 +1,65 @@
+program constfold;
+label 10;
+const
+   n = 10;
+   s = 'hello';
+type
+   colour = (red, green, blue);
+var
+   i  : integer;
+   r  : real;
+   st : string;
+   b  : boolean;
+   c  : char;
+begin
+   i := (n * 4 + 2) div 3 mod 5;
+   writeln(i);
+   i := -(n shl 2) xor 7;
+   writeln(i);
+   r := 1.5 * 2.0 + 4.0 / 8.0;
+   writeln(r:5:2);
+   r := n / 4;
+   writeln(r:5:2);
+   b := (n > 5) and not (n = 3);
+   writeln(b);
+   st := 'ab' + 'cd' + 'ef';
+   writeln(st, ' ', length(st));
+   writeln('abc' < 'abd', ' ', 'abc' = 'ab', ' ', 'ba' > 'abc');
+   writeln('é' > 'z', ' ', 'aé' > 'ab');
+   writeln(length(s), ' ', length('xyz'));
+   writeln(ord('A'), ' ', chr(66), ' ', ord(succ(red)), ' ', ord(pred(blue)));
+   c := succ('a', 2);
+   writeln(c);
+   writeln(sqr(7), ' ', sqr(1.5):5:2, ' ', abs(-12), ' ', abs(-2.5):4:1, ' ', odd(7), ' ', odd(n));
+   writeln(5 in [1..4, 6], ' ', 3 in [1..4, 6], ' ', 'c' in ['a'..'f']);
+   writeln([1, 2] + [3] = [1..3], ' ', [1, 2] <= [1..5], ' ', [1..5] - [2..4] = [1, 5]);
+   if n > 100 then
+      writeln('dead')
+   else
+      writeln('live');
+   if false then
+      writeln('never');
+   while n < 0 do
+      writeln('never');
+   if true then
+      writeln('always');
+   i := 7;
+   i := 0;
+   goto 10;
+   if false then
+   begin
+10:
+      writeln('jumped');
+      i := i + 1;
+   end;
+   repeat
+      if 2 > 1 then
+         i := i + 1
+      else
+         writeln('no');
+   until i > 3;
+   for i := 1 + 1 to 2 * 2 do
+      if i = i then
+         write(i);
+   writeln;
+end.
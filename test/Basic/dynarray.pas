@@ -0,0 +1,158 @@
+program dynarray;
+
+type
+   intarr  = array of integer;
+   realarr = array of real;
+   grid	   = array of array of integer;
+   point   = record
+		x, y : integer;
+	     end;
+   pointarr = array of point;
+   pintarr  = ^intarr;
+
+var
+   a, b	  : intarr;
+   r	  : realarr;
+   g, h	  : grid;
+   pts	  : pointarr;
+   p	  : pintarr;
+   i, j	  : integer;
+   sum	  : integer;
+   rsum	  : real;
+
+function Total(x : intarr) : integer;
+var
+   i, s	: integer;
+begin
+   s := 0;
+   for i := 0 to High(x) do
+      s := s + x[i];
+   Total := s
+end;
+
+procedure Clobber(x : intarr);
+var
+   i : integer;
+begin
+   SetLength(x, Length(x) + 10);
+   for i := 0 to High(x) do
+      x[i] := -1
+end;
+
+procedure Grow(var x : intarr; n : integer);
+var
+   i, old : integer;
+begin
+   old := Length(x);
+   SetLength(x, old + n);
+   for i := old to High(x) do
+      x[i] := i * i
+end;
+
+function Range(n : integer) : intarr;
+var
+   i : integer;
+   t : intarr;
+begin
+   SetLength(t, n);
+   for i := 0 to n - 1 do
+      t[i] := i + 1;
+   Range := t
+end;
+
+function Conformant(x : array [lo..hi : integer] of integer) : integer;
+var
+   i, s	: integer;
+begin
+   s := 0;
+   for i := lo to hi do
+      s := s + x[i];
+   x[lo] := 999;
+   Conformant := s
+end;
+
+procedure Zap(var x : array [lo..hi : integer] of integer);
+begin
+   x[hi] := 0
+end;
+
+begin
+   writeln('Empty: ', Length(a), ' ', High(a));
+
+   { Grow one element at a time. }
+   for i := 0 to 999 do
+   begin
+      SetLength(a, i + 1);
+      a[i] := i
+   end;
+   writeln('Length: ', Length(a), ' High: ', High(a), ' Sum: ', Total(a));
+
+   { Growing again keeps the old elements, and new ones are zero. }
+   SetLength(b, 3);
+   b[0] := 7; b[1] := 8; b[2] := 9;
+   SetLength(b, 6);
+   writeln('Grown: ', b[0], ' ', b[1], ' ', b[2], ' ', b[3], ' ', b[5]);
+   SetLength(b, 2);
+   SetLength(b, 4);
+   writeln('Shrunk: ', Length(b), ' ', b[1], ' ', b[2], ' ', b[3]);
+
+   { Assignment copies. }
+   b := a;
+   b[0] := 100;
+   writeln('Copy: ', a[0], ' ', b[0], ' ', Length(b));
+
+   { Value parameters are copies. }
+   Clobber(a);
+   writeln('After clobber: ', Length(a), ' ', a[10]);
+   Grow(a, 5);
+   writeln('After grow: ', Length(a), ' ', a[1004]);
+
+   { Function results. }
+   b := Range(10);
+   writeln('Range: ', Length(b), ' ', Total(b), ' ', Total(Range(100)));
+
+   { Conformant array parameters see the elements indexed from zero. }
+   writeln('Conformant: ', Conformant(b), ' ', b[0]);
+   Zap(b);
+   writeln('Zap: ', b[9]);
+
+   SetLength(r, 4);
+   for i := 0 to 3 do
+      r[i] := i / 2;
+   rsum := 0;
+   for i := 0 to High(r) do
+      rsum := rsum + r[i];
+   writeln('Real: ', rsum:5:2);
+
+   { Arrays of arrays. }
+   SetLength(g, 5);
+   for i := 0 to 4 do
+   begin
+      SetLength(g[i], i + 1);
+      for j := 0 to i do
+	 g[i][j] := i * 10 + j
+   end;
+   h := g;
+   h[4, 4] := 0;
+   sum := 0;
+   for i := 0 to High(g) do
+      for j := 0 to High(g[i]) do
+	 sum := sum + g[i, j];
+   writeln('Grid: ', Length(g[4]), ' ', g[4, 4], ' ', h[4, 4], ' ', sum);
+   SetLength(g, 2);
+   writeln('Grid shrunk: ', Length(g), ' ', Length(g[1]));
+
+   SetLength(pts, 2);
+   pts[1].x := 3;
+   pts[1].y := 4;
+   writeln('Points: ', pts[0].x, ' ', pts[1].x + pts[1].y);
+
+   new(p);
+   SetLength(p^, 3);
+   p^[2] := 42;
+   writeln('Pointer: ', Length(p^), ' ', p^[2]);
+   dispose(p);
+
+   SetLength(a, 0);
+   writeln('Cleared: ', Length(a));
+end.
@@ -0,0 +1,46 @@
+program fastmath;
+
+var
+   a, b	: array [1..1000] of real;
+   i	: integer;
+
+{$fastmath on}
+function dotfast : real;
+var
+   i   : integer;
+   sum : real;
+
+   {$fastmath off}
+   function strictsum(x, y : real) : real;
+   begin
+      strictsum := x + y;
+   end;
+
+begin
+   sum := 0;
+   for i := 1 to 1000 do
+      sum := sum + a[i] * b[i];
+   dotfast := strictsum(sum, 0.5);
+end;
+
+function dotstrict : real;
+var
+   i   : integer;
+   sum : real;
+begin
+   sum := 0;
+   for i := 1 to 1000 do
+      sum := sum + a[i] * b[i];
+   dotstrict := sum;
+end;
+
+begin
+   for i := 1 to 1000 do
+   begin
+      a[i] := i / 8;
+      b[i] := 2 - i / 16;
+   end;
+   writeln('fast=', dotfast:12:3);
+   writeln('strict=', dotstrict:12:3);
+   writeln('muladd=', a[3] * b[5] - a[7]:10:5);
+end.
@@ -0,0 +1,117 @@
+program hashmap;
+
+type
+   colour = (red, green, blue);
+   point  = record
+               x, y : integer;
+            end;
+   names  = string[20];
+   counts = map of names to integer;
+   pair   = record
+               a, b : integer;
+            end;
+   squares = map of integer to integer;
+
+var
+   m     : map of integer to integer;
+   c     : counts;
+   d     : counts;
+   e     : map of colour to real;
+   p     : map of point to names;
+   s     : hashset of integer;
+   i, k  : integer;
+   sum   : int64;
+   n     : names;
+   pt    : point;
+   col   : colour;
+   r     : map of char to pair;
+   q     : squares;
+   v     : map of integer to names;
+
+procedure show(cs : counts);
+var
+   w : names;
+begin
+   w := 'apple';
+   writeln('apple=', cs[w], ' len=', length(cs));
+   cs['apple'] := 100;
+end;
+
+function makesquares(n : integer) : squares;
+var
+   t : squares;
+   i : integer;
+begin
+   for i := 1 to n do
+      t[i] := i * i;
+   makesquares := t;
+end;
+
+begin
+   for i := 1 to 1000 do
+      m[i * 7] := i;
+   writeln('length ', length(m));
+   writeln('m[70] = ', m[70], ' m[7000] = ', m[7000]);
+   writeln('14 in m ', 14 in m, ' 15 in m ', 15 in m);
+   sum := 0;
+   for k in m do
+      sum := sum + k;
+   writeln('sum of keys ', sum);
+   for i := 1 to 500 do
+      exclude(m, i * 14);
+   writeln('after exclude ', length(m), ' ', 14 in m, ' ', 21 in m);
+   sum := 0;
+   for k in m do
+      sum := sum + m[k];
+   writeln('sum of values ', sum);
+
+   c['apple'] := 1;
+   c['pear'] := 2;
+   c['apple'] := c['apple'] + 10;
+   n := 'plum';
+   c[n] := c[n] + 3;
+   writeln('apple=', c['apple'], ' pear=', c['pear'], ' plum=', c[n], ' fig=', c['fig']);
+   writeln('len ', length(c), ' ', 'fig' in c, ' ', 'kiwi' in c);
+   d := c;
+   d['apple'] := 5;
+   writeln('c apple ', c['apple'], ' d apple ', d['apple']);
+   show(c);
+   writeln('c apple ', c['apple']);
+
+   e[green] := 1.5;
+   e[blue] := e[green] * 2;
+   for col in e do
+      if col = blue then
+         writeln('blue ', e[col]:4:1);
+   writeln(red in e, green in e);
+
+   pt.x := 1; pt.y := 2;
+   p[pt] := 'one two';
+   pt.x := 2;
+   p[pt] := 'two two';
+   pt.x := 1;
+   writeln(p[pt], ' ', length(p));
+
+   for i := 1 to 10 do
+      include(s, i mod 4);
+   writeln('set len ', length(s), ' ', 3 in s, ' ', 4 in s);
+   exclude(s, 3);
+   writeln('set len ', length(s), ' ', 3 in s);
+
+   r['a'].a := 3;
+   r['a'].b := 4;
+   r['b'] := r['a'];
+   r['b'].b := 9;
+   writeln(r['a'].a, r['a'].b, r['b'].a, r['b'].b);
+
+   q := makesquares(100);
+   writeln(length(q), ' ', q[9]);
+   for i := 1 to 1000 do
+      q[i + 1] := q[i] + 1;
+   writeln(q[1001], ' ', length(q));
+
+   v[0] := 'start';
+   for i := 1 to 200 do
+      v[i] := v[i - 1];
+   writeln(v[200], ' ', length(v));
+end.
@@ -0,0 +1,41 @@
+program hotcold;
+
+var
+   a	: array [1..100] of integer;
+   i, s	: integer;
+
+{$cold}
+procedure report(n : integer);
+begin
+   writeln('Bad value ', n);
+   panic('Giving up');
+end;
+
+{$hot}
+function total : integer;
+var
+   i, t	: integer;
+begin
+   t := 0;
+   for i := 1 to 100 do
+   begin
+      if unlikely(a[i] < 0) then
+	 report(a[i]);
+      t := t + a[i];
+   end;
+   total := t;
+end;
+
+begin
+   for i := 1 to 100 do
+      a[i] := i mod 7;
+   writeln('Total=', total);
+   s := 0;
+   for i := 1 to 100 do
+      if likely(a[i] <> 3) then
+	 s := s + 1;
+   writeln('Not three=', s);
+   if likely(s > 1000) then
+      halt(1);
+   writeln(likely(true), ' ', unlikely(false));
+end.
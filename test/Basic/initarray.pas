@@ -0,0 +1,65 @@
+program initarray;
+
+type
+   colour = (red, green, blue);
+   grid = array [1..3, 1..4] of integer;
+   cube = array [colour, 0..1, 1..2] of char;
+   table = array [0..9] of real;
+   flags = packed array [1..20] of boolean;
+   small = packed array [1..10] of 5..8;
+   point = record
+	      x, y : integer;
+	   end;
+   points = array [1..3] of point;
+   names = array [1..3] of string[8];
+   big = array [1..100000] of integer;
+
+var
+   g : grid value [1: [1: 11; 2: 12; 3: 13; 4: 14];
+	       2: [otherwise 7];
+	       3: [2..3: 33; otherwise -1]];
+   g2 : grid value [2: [1..4: 5]; otherwise [otherwise 1]];
+   c : cube value [red: [0: 'ab'; 1: 'cd'];
+	       green: [otherwise [1: 'x'; 2: 'y']];
+	       blue: [0..1: 'zz']];
+   t : table value [0: 1.5; 9: -2.25; otherwise 0.5];
+   z : table value [otherwise 0.0];
+   f : flags value [3: true; 7..9: true; otherwise false];
+   s : small value [1: 8; 2: 6; otherwise 5];
+   p : points value [1: [x: 1; y: 2]; 3: [x: 5; y: 6]; otherwise [x: -1; y: -1]];
+   n : names value [1: 'one'; 2: 'two'; 3: 'three'];
+   b : big value [1..50000: 3; otherwise 4];
+
+   i, j	: integer;
+   col	: colour;
+   sum	: integer;
+
+begin
+   for i := 1 to 3 do
+   begin
+      for j := 1 to 4 do
+	 write(g[i, j]:4, g2[i, j]:3);
+      writeln;
+   end;
+   for col := red to blue do
+      for i := 0 to 1 do
+	 writeln(c[col, i, 1], c[col, i, 2]);
+   for i := 0 to 9 do
+      write(t[i]:6:2);
+   writeln;
+   for i := 0 to 9 do
+      write(z[i]:5:1);
+   writeln;
+   for i := 1 to 20 do
+      write(ord(f[i]));
+   writeln;
+   for i := 1 to 10 do
+      write(s[i]:2);
+   writeln;
+   for i := 1 to 3 do
+      writeln(p[i].x:3, p[i].y:3, ' ', n[i]);
+   sum := 0;
+   for i := 1 to 100000 do
+      sum := sum + b[i];
+   writeln(sum);
+end.
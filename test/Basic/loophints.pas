@@ -0,0 +1,39 @@
+program loophints;
+
+var
+   a, b	: array [1..1000] of integer;
+   i, n	: integer;
+
+begin
+   {$unroll 4} {$R-}
+   for i := 1 to 1000 do
+      a[i] := i;
+   {$vectorize width=4} {$interleave 2}
+   for i := 1 to 1000 do
+      b[i] := a[i] * 3;
+   n := 0;
+   i := 1;
+   {$nounroll}
+   while i <= 1000 do
+   begin
+      n := n + b[i];
+      i := i + 1;
+   end;
+   writeln('Sum=', n);
+   {$I+} {$novectorize}
+   repeat
+      n := n div 2;
+   until n < 1000;
+   writeln('Halved=', n);
+   {$distribute}
+   for i := 2 to 999 do
+   begin
+      a[i] := (a[i - 1] + b[i]) mod 1000;
+      b[i + 1] := a[i] * 2;
+   end;
+   writeln('a[999]=', a[999], ' b[1000]=', b[1000]);
+   {$unroll full}
+   for i := 1 to 8 do
+      write(a[i]:4);
+   writeln;
+end.
@@ -0,0 +1,116 @@
+program packedbits;
+
+const
+   max = 1000000;
+
+type
+   colour  = (red, green, blue);
+   digit   = 0..9;
+   small   = -2..1;
+   flags   = packed array [1..max] of boolean;
+   rec	   = record
+		c : char;
+		x : real;
+		n : integer;
+	     end;
+   prec	   = packed record
+		c : char;
+		x : real;
+		n : integer;
+	     end;
+   precarr = array [1..4] of prec;
+
+var
+   sieve   : flags;
+   i, j, n : integer;
+   colours : packed array [1..20] of colour;
+   digits  : packed array [0..99] of digit;
+   smalls  : packed array [1..8] of small;
+   grid	   : packed array [1..5, 1..7] of boolean;
+   plain   : array [1..20] of colour;
+   pr	   : precarr;
+   sum	   : real;
+
+begin
+   writeln('Sizes: ', sizeof(flags), ' ', sizeof(colours), ' ', sizeof(digits), ' ', sizeof(smalls),
+	   ' ', sizeof(grid));
+   writeln('Records: ', sizeof(rec), ' ', sizeof(prec), ' ', sizeof(precarr));
+
+   for i := 1 to max do
+      sieve[i] := true;
+   sieve[1] := false;
+   i := 2;
+   while i * i <= max do
+   begin
+      if sieve[i] then
+      begin
+	 j := i * i;
+	 while j <= max do
+	 begin
+	    sieve[j] := false;
+	    j := j + i;
+	 end;
+      end;
+      i := i + 1;
+   end;
+   n := 0;
+   for i := 1 to max do
+      if sieve[i] then
+	 n := n + 1;
+   writeln('Primes below ', max:1, ': ', n:1);
+
+   for i := 1 to 20 do
+      case i mod 3 of
+	0 : plain[i] := red;
+	1 : plain[i] := green;
+	2 : plain[i] := blue;
+      end;
+   pack(plain, 1, colours);
+   for i := 1 to 20 do
+      write(ord(colours[i]):2);
+   writeln;
+   colours[4] := blue;
+   unpack(colours, plain, 1);
+   for i := 1 to 20 do
+      write(ord(plain[i]):2);
+   writeln;
+
+   for i := 0 to 99 do
+      digits[i] := (i * 7) mod 10;
+   for i := 0 to 19 do
+      write(digits[i]:2);
+   writeln;
+
+   for i := 1 to 8 do
+      smalls[i] := (i mod 4) - 2;
+   for i := 1 to 8 do
+      write(smalls[i]:3);
+   writeln;
+
+   for i := 1 to 5 do
+      for j := 1 to 7 do
+	 grid[i, j] := (i + j) mod 3 = 0;
+   for i := 1 to 5 do
+   begin
+      for j := 1 to 7 do
+	 if grid[i, j] then
+	    write('#')
+	 else
+	    write('.');
+      writeln;
+   end;
+
+   for i := 1 to 4 do
+   begin
+      pr[i].c := chr(ord('a') + i);
+      pr[i].x := i * 1.5;
+      pr[i].n := i * i;
+   end;
+   sum := 0;
+   for i := 1 to 4 do
+   begin
+      write(pr[i].c, pr[i].n:3);
+      sum := sum + pr[i].x;
+   end;
+   writeln(' ', sum:5:2);
+end.
@@ -0,0 +1,67 @@
+program parfor;
+
+const
+   n = 100000;
+
+var
+   a     : array [1..n] of integer;
+   i     : integer;
+   sum   : longint;
+   prod  : real;
+   lo, hi : integer;
+
+procedure scale(factor : integer);
+var
+   j     : integer;
+   total : longint;
+begin
+   total := 0;
+   {$parallel}
+   for j := 1 to n do
+      a[j] := a[j] * factor;
+   {$parallel reduction(+: total)}
+   for j := 1 to n do
+      total := total + a[j];
+   writeln('total=', total);
+end;
+
+function count(limit : integer) : integer;
+var
+   k, c : integer;
+begin
+   c := 0;
+   {$parallel chunk(7) reduction(+: c)}
+   for k := limit downto 1 do
+      if k mod 3 = 0 then
+         c := c + 1;
+   count := c;
+end;
+
+begin
+   {$parallel}
+   for i := 1 to n do
+      a[i] := (i * 7) mod 1000;
+
+   sum := 0;
+   lo := maxint;
+   hi := -maxint;
+   {$parallel reduction(+: sum) reduction(min: lo) reduction(max: hi)}
+   for i := 1 to n do
+   begin
+      sum := sum + a[i];
+      if a[i] < lo then
+         lo := a[i];
+      if a[i] > hi then
+         hi := a[i];
+   end;
+   writeln('sum=', sum, ' min=', lo, ' max=', hi);
+
+   prod := 1.0;
+   {$parallel reduction(*: prod)}
+   for i := 1 to 20 do
+      prod := prod * 1.5;
+   writeln('prod=', prod:0:4);
+
+   scale(3);
+   writeln('count=', count(1000));
+end.
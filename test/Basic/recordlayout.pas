@@ -0,0 +1,98 @@
+program recordlayout;
+
+type
+   mixed   = {$reorder} record
+		flag   : boolean;
+		amount : real;
+		ch     : char;
+		count  : integer;
+		name   : string[5];
+		mark   : char;
+	     end;
+   plain   = record
+		flag   : boolean;
+		amount : real;
+		ch     : char;
+		count  : integer;
+		name   : string[5];
+		mark   : char;
+	     end;
+   counter = {$align 64} record
+		hits : integer;
+	     end;
+   counters = array [1..4] of counter;
+   spread   = record
+		a : integer;
+		{$align 32}
+		b : integer;
+		c : char;
+	     end;
+   ptr	    = ^node;
+   node	    = {$reorder} record
+		 tag  : char;
+		 next : ptr;
+		 val  : integer;
+	      end;
+
+var
+   m	       : mixed;
+   mi	       : mixed value [flag: true; amount: 2.5; ch: 'x'; count: 7; name: 'hello'; mark: '!'];
+   cs	       : counters;
+   s	       : spread;
+   {$align 64}
+   hot	       : integer;
+   {$align 16}
+   v1, v2      : array [1..8] of real;
+   n	       : ptr;
+   i, sum      : integer;
+
+procedure Local;
+var
+   {$align 128}
+   buf : array [1..10] of char;
+   i   : integer;
+begin
+   for i := 1 to 10 do
+      buf[i] := chr(ord('a') + i - 1);
+   writeln('Local: ', buf);
+end;
+
+begin
+   writeln('Sizes: ', sizeof(mixed), ' ', sizeof(plain));
+   writeln('Counter: ', sizeof(counter), ' ', sizeof(counters));
+   writeln('Spread: ', sizeof(spread));
+   m.flag := false;
+   m.amount := 1.25;
+   m.ch := 'q';
+   m.count := 42;
+   m.name := 'abc';
+   m.mark := '?';
+   writeln('Fields: ', m.flag, ' ', m.amount:0:2, ' ', m.ch, ' ', m.count, ' ', m.name, ' ', m.mark);
+   with mi do
+      writeln('With: ', flag, ' ', amount:0:2, ' ', ch, ' ', count, ' ', name, ' ', mark);
+   for i := 1 to 4 do
+      cs[i].hits := i * 10;
+   sum := 0;
+   for i := 1 to 4 do
+      sum := sum + cs[i].hits;
+   writeln('Counters: ', sum);
+   s.a := 1;
+   s.b := 2;
+   s.c := 'z';
+   writeln('Spread: ', s.a, ' ', s.b, ' ', s.c);
+   hot := 0;
+   for i := 1 to 8 do
+   begin
+      v1[i] := i;
+      v2[i] := v1[i] * 2;
+      hot := hot + 1
+   end;
+   writeln('Globals: ', hot, ' ', v2[8]:0:1);
+   Local;
+   new(n);
+   n^.tag := 'n';
+   n^.val := 99;
+   new(n^.next);
+   n^.next^.val := 100;
+   writeln('Node: ', n^.tag, ' ', n^.val, ' ', n^.next^.val, ' ', sizeof(node));
+end.
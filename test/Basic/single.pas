@@ -0,0 +1,66 @@
+program singletest;
+
+type
+   vec8 = vector[8] of single;
+
+var
+   s, t	: single;
+   r	: real;
+   e	: extended;
+   i	: integer;
+   a	: array [1..8] of single;
+   v	: vec8;
+   str	: string;
+
+function half(x : single) : single;
+begin
+   half := x / 2;
+end;
+
+begin
+   s := 1.5;
+   t := s * 2.0 + 1;
+   writeln('t=', t:8:3);
+   writeln('half=', half(t):8:3);
+   writeln('sqrt=', sqrt(t):8:5);
+   writeln('sin=', sin(s):8:5);
+   writeln('abs=', abs(-s):8:3);
+   writeln('round=', round(t * 1.4));
+   writeln('trunc=', trunc(t * 1.4));
+   writeln('min=', min(s, t):8:3, ' max=', max(s, t):8:3);
+   r := 1.0 / 3.0;
+   s := r;
+   writeln('s=', s:12:9, ' r=', r:12:9);
+   r := s + r;
+   writeln('mixed=', r:12:9);
+   e := 1.0;
+   e := e / 3;
+   writeln('e=', e:20:17);
+   writeln('e*s=', e * s:20:17);
+   writeln('pow=', s ** 2:10:7);
+   for i := 1 to 8 do
+      a[i] := i * 0.5;
+   s := 0;
+   for i := 1 to 8 do
+      s := s + a[i] * a[i];
+   writeln('sum=', s:8:3);
+   v := a;
+   v := v * v;
+   writeln('reduce=', reduceadd(v):8:3);
+   str := '2.25';
+   val(str, s);
+   writeln('val=', s:8:3);
+   str := '  3.75';
+   readstr(str, t);
+   writeln('readstr=', t:8:3);
+   writestr(str, t:6:2);
+   writeln('writestr=', str);
+   e := 0.1;
+   writeln(e);
+   s := 0.1;
+   writeln(s);
+   if s > r then
+      writeln('s greater')
+   else
+      writeln('r greater');
+end.
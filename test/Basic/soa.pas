@@ -0,0 +1,100 @@
+program soa;
+
+const
+   n = 1000;
+
+type
+   vec3	     = record
+		  x, y, z : real;
+	       end;
+   particle  = record
+		  pos	: vec3;
+		  vx, vy, vz : real;
+		  flags	: integer;
+	       end;
+   particles = {$soa} array [1..n] of particle;
+   point     = record
+		  px, py : integer;
+	       end;
+   grid	     = {$soa} array [1..3, 1..4] of point;
+   table     = {$soa} array [1..3] of point;
+
+var
+   ps	  : particles;
+   g	  : grid;
+   t	  : table value [1: [px: 1; py: 2]; 2: [px: 3; py: 4]; otherwise [px: 9; py: 9]];
+   copy	  : particles;
+   p	  : particle;
+   i, j	  : integer;
+   sum	  : real;
+   isum	  : integer;
+
+procedure Move(var q : particle; dt : real);
+begin
+   q.pos.x := q.pos.x + q.vx * dt;
+   q.pos.y := q.pos.y + q.vy * dt;
+   q.pos.z := q.pos.z + q.vz * dt;
+   q.flags := q.flags + 1
+end;
+
+function Speed(q : particle) : real;
+begin
+   Speed := sqrt(q.vx * q.vx + q.vy * q.vy + q.vz * q.vz)
+end;
+
+begin
+   writeln('Size: ', sizeof(particle), ' ', sizeof(particles));
+   for i := 1 to n do
+   begin
+      ps[i].pos.x := i;
+      ps[i].pos.y := 2 * i;
+      ps[i].pos.z := 0;
+      ps[i].vx := 1;
+      ps[i].vy := -1;
+      ps[i].vz := 0.5;
+      ps[i].flags := 0;
+   end;
+
+   for i := 1 to n do
+      ps[i].pos.x := ps[i].pos.x + ps[i].vx;
+   sum := 0;
+   for i := 1 to n do
+      sum := sum + ps[i].pos.x;
+   writeln('Sum x: ', sum:0:1);
+
+   for i := 1 to n do
+      with ps[i] do
+	 pos.z := pos.y + vz;
+   writeln('With: ', ps[10].pos.z:0:1);
+
+   p := ps[5];
+   Move(p, 2.0);
+   ps[5] := p;
+   writeln('Var: ', ps[5].pos.x:0:1, ' ', ps[5].pos.y:0:1, ' ', ps[5].pos.z:0:1, ' ', ps[5].flags);
+   writeln('Value: ', Speed(ps[5]):0:3);
+
+   p := ps[7];
+   writeln('Read: ', p.pos.x:0:1, ' ', p.vy:0:1, ' ', p.flags);
+   p.flags := 42;
+   p.pos.x := -1;
+   ps[8] := p;
+   writeln('Write: ', ps[8].pos.x:0:1, ' ', ps[8].pos.y:0:1, ' ', ps[8].flags, ' ', ps[9].flags);
+   ps[1] := ps[8];
+   writeln('Element: ', ps[1].flags, ' ', ps[1].pos.y:0:1);
+
+   copy := ps;
+   writeln('Copy: ', copy[8].flags, ' ', copy[n].pos.x:0:1);
+
+   for i := 1 to 3 do
+      for j := 1 to 4 do
+      begin
+	 g[i, j].px := i;
+	 g[i, j].py := j * 10;
+      end;
+   isum := 0;
+   for i := 1 to 3 do
+      for j := 1 to 4 do
+	 isum := isum + g[i, j].px * g[i, j].py;
+   writeln('Grid: ', isum);
+   writeln('Init: ', t[1].px, ' ', t[1].py, ' ', t[2].px, ' ', t[2].py, ' ', t[3].px, ' ', t[3].py);
+end.
@@ -0,0 +1,160 @@
+program sorttest;
+
+const
+   bigsize = 100000;
+
+type
+   colour = (red, green, blue, yellow);
+   small  = -5..100;
+   person = record
+      name : string[10];
+      age  : integer;
+   end;
+
+var
+   a   : array [1..10] of integer;
+   c   : array [0..5] of char;
+   e   : array [1..6] of colour;
+   s   : array [1..5] of small;
+   r   : array [1..6] of real;
+   st  : array [1..4] of string;
+   p   : array [1..5] of person;
+   d   : array of longint;
+   big : array [1..bigsize] of integer;
+   i   : integer;
+
+function byage(x, y : person) : boolean;
+begin
+   byage := x.age < y.age
+end;
+
+function desc(var x, y : integer) : boolean;
+begin
+   desc := x > y
+end;
+
+procedure nearest(target : integer);
+var
+   q : array [1..8] of integer;
+   i : integer;
+
+   function closer(a, b : integer) : boolean;
+   begin
+      closer := abs(a - target) < abs(b - target)
+   end;
+
+begin
+   for i := 1 to 8 do
+      q[i] := i * 3;
+   sort(q, closer);
+   for i := 1 to 8 do
+      write(q[i]:3);
+   writeln;
+end;
+
+procedure checkbig(name : string; ascending : boolean);
+var
+   i  : integer;
+   ok : boolean;
+begin
+   ok := true;
+   for i := 2 to bigsize do
+      if (big[i-1] > big[i]) = ascending then
+	 ok := false;
+   writeln(name, ' ', ok);
+end;
+
+procedure fillbig;
+var
+   i : integer;
+begin
+   for i := 1 to bigsize do
+      big[i] := (i * 104729) mod 1000003 - 500000;
+end;
+
+begin
+   for i := 1 to 10 do
+      a[i] := (i * 7919) mod 23 - 11;
+   sort(a);
+   for i := 1 to 10 do
+      write(a[i]:4);
+   writeln;
+   sort(a, desc);
+   for i := 1 to 10 do
+      write(a[i]:4);
+   writeln;
+   sort(a, 3, 7);
+   for i := 1 to 10 do
+      write(a[i]:4);
+   writeln;
+   sort(a, 7, 3);
+   sort(a, 1, 0);
+   sort(a, 11, 10);
+   for i := 1 to 10 do
+      write(a[i]:4);
+   writeln;
+
+   c[0] := 'q'; c[1] := 'a'; c[2] := 'z'; c[3] := 'b'; c[4] := 'A'; c[5] := 'm';
+   sort(c);
+   for i := 0 to 5 do
+      write(c[i]);
+   writeln;
+
+   e[1] := yellow; e[2] := red; e[3] := blue; e[4] := green; e[5] := red; e[6] := blue;
+   sort(e);
+   for i := 1 to 6 do
+      write(ord(e[i]):2);
+   writeln;
+
+   s[1] := 100; s[2] := -5; s[3] := 0; s[4] := -1; s[5] := 50;
+   sort(s);
+   for i := 1 to 5 do
+      write(s[i]:4);
+   writeln;
+
+   r[1] := 3.5; r[2] := -1.25; r[3] := 0; r[4] := 1e6; r[5] := -1e-3; r[6] := 2;
+   sort(r);
+   for i := 1 to 6 do
+      write(r[i]:12:3);
+   writeln;
+
+   st[1] := 'pear'; st[2] := 'apple'; st[3] := 'fig'; st[4] := 'apples';
+   sort(st);
+   for i := 1 to 4 do
+      write(st[i], ' ');
+   writeln;
+
+   p[1].name := 'Ann'; p[1].age := 40;
+   p[2].name := 'Bob'; p[2].age := 25;
+   p[3].name := 'Cid'; p[3].age := 40;
+   p[4].name := 'Dee'; p[4].age := 19;
+   p[5].name := 'Eve'; p[5].age := 25;
+   sort(p, byage);
+   for i := 1 to 5 do
+      write(p[i].name, ':', p[i].age, ' ');
+   writeln;
+
+   nearest(10);
+
+   SetLength(d, 7);
+   for i := 0 to 6 do
+   begin
+      d[i] := 1000000000;
+      d[i] := d[i] * (i * 5 mod 7);
+   end;
+   sort(d, 1, 5);
+   for i := 0 to 6 do
+      write(d[i], ' ');
+   writeln;
+   sort(d);
+   for i := 0 to 6 do
+      write(d[i], ' ');
+   writeln;
+
+   fillbig;
+   sort(big);
+   checkbig('Radix', true);
+   fillbig;
+   sort(big, desc);
+   checkbig('Compare', false);
+end.
@@ -0,0 +1,116 @@
+program stream;
+
+{ Compiled with -fstream, so that each top-level function is emitted on its own. }
+type
+   shape = object
+	      n : integer;
+	      function area : integer; virtual;
+	      function sides : integer; virtual;
+	   end;
+
+   square = object(shape)
+	       function area : integer; override;
+	       function sides : integer; override;
+	    end;
+
+var
+   count : integer;
+   title : string;
+   scale : integer;
+
+function shape.area : integer;
+begin
+   area := 0;
+end;
+
+function shape.sides : integer;
+begin
+   sides := 0;
+end;
+
+function square.area : integer;
+begin
+   area := n * n;
+end;
+
+function square.sides : integer;
+begin
+   sides := 4;
+end;
+
+function odd2(n : integer) : boolean; forward;
+
+function even2(n : integer) : boolean;
+begin
+   count := count + 1;
+   if n = 0 then
+      even2 := true
+   else
+      even2 := odd2(n - 1);
+end;
+
+function odd2(n : integer) : boolean;
+begin
+   count := count + 1;
+   if n = 0 then
+      odd2 := false
+   else
+      odd2 := even2(n - 1);
+end;
+
+function sum(n : integer) : integer;
+var
+   total : integer;
+
+   procedure add(i : integer);
+   begin
+      total := total + i;
+   end;
+
+   procedure addall;
+   var
+      i : integer;
+   begin
+      for i := 1 to n do
+	 add(i * scale);
+   end;
+
+begin
+   total := 0;
+   addall;
+   sum := total;
+end;
+
+function fact(n : integer) : integer;
+begin
+   if n <= 1 then
+      fact := 1
+   else
+      fact := n * fact(n - 1);
+end;
+
+procedure describe(var s : shape);
+begin
+   writeln(title, s.sides, ' sides, area ', s.area);
+end;
+
+procedure setscale(s : integer);
+begin
+   scale := s;
+end;
+
+var
+   sh : shape;
+   sq : square;
+
+begin
+   title := 'A ';
+   count := 0;
+   setscale(3);
+   writeln(even2(10), ' ', odd2(7), ' ', count);
+   writeln(sum(5), ' ', sum(12));
+   writeln(fact(10));
+   sq.n := 7;
+   describe(sh);
+   describe(sq);
+end.
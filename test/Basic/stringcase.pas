@@ -0,0 +1,59 @@
+program stringcase;
+
+type
+   word = packed array [1..4] of char;
+
+var
+   s : string;
+   w : word;
+   i : integer;
+
+procedure dispatch(cmd : string);
+begin
+   write(cmd, ': ');
+   case cmd of
+     'add', 'plus' : writeln('add');
+     'sub'	   : writeln('sub');
+     'mul'	   : writeln('mul');
+     'a'	   : writeln('a');
+     ''		   : writeln('empty');
+     'abc', 'abd'  : writeln('abc or abd');
+     'multiply'	   : writeln('multiply');
+   otherwise
+      writeln('unknown');
+   end;
+end;
+
+begin
+   dispatch('add');
+   dispatch('plus');
+   dispatch('sub');
+   dispatch('mul');
+   dispatch('mux');
+   dispatch('a');
+   dispatch('b');
+   dispatch('');
+   dispatch('abc');
+   dispatch('abd');
+   dispatch('abe');
+   dispatch('multiply');
+   dispatch('multiplx');
+   dispatch('adds');
+
+   w := 'quit';
+   case w of
+     'quit' : writeln('quit');
+     'exit' : writeln('exit');
+   end;
+
+   s := 'xyz';
+   for i := 1 to 4 do
+   begin
+      case s of
+	'xyz' : s := 'xy';
+	'xy'  : s := 'x';
+	'x'   : s := 'done';
+      end;
+   end;
+   writeln(s);
+end.
@@ -0,0 +1,84 @@
+program subrangesize;
+
+type
+   byte	    = 0..255;
+   shortint = -128..127;
+   word	    = 0..65535;
+   medium   = -1000..1000;
+   large    = 0..100000;
+   pixels   = array [1..1000] of byte;
+   pixel    = record
+		 r, g, b : byte;
+		 alpha	 : shortint;
+	      end;
+
+var
+   img	  : pixels;
+   p	  : pixel;
+   b	  : byte;
+   s	  : shortint;
+   w	  : word;
+   m	  : medium;
+   i, sum : integer;
+   str	  : string;
+   small  : array [1..4] of byte;
+   spack  : packed array [1..4] of byte;
+
+procedure Clip(var x : byte);
+begin
+   x := x div 2
+end;
+
+function Half(x : byte) : byte;
+begin
+   Half := x div 2
+end;
+
+begin
+   writeln('Sizes: ', sizeof(byte), ' ', sizeof(shortint), ' ', sizeof(word), ' ', sizeof(medium),
+	   ' ', sizeof(large));
+   writeln('Arrays: ', sizeof(pixels), ' ', sizeof(pixel));
+
+   for i := 1 to 1000 do
+      img[i] := i mod 256;
+   sum := 0;
+   for i := 1 to 1000 do
+      sum := sum + img[i];
+   writeln('Sum: ', sum);
+
+   b := 255;
+   writeln('Widened: ', b + 1, ' ', b * b);
+   s := -128;
+   writeln('Signed: ', s, ' ', s - 1, ' ', abs(s));
+   w := 65535;
+   m := -1000;
+   writeln('Word: ', w, ' ', w + 1, ' Medium: ', m, ' ', m * 2);
+
+   p.r := 200; p.g := 100; p.b := 50; p.alpha := -1;
+   writeln('Pixel: ', p.r, ' ', p.g, ' ', p.b, ' ', p.alpha);
+
+   sum := 0;
+   for b := 0 to 255 do
+      sum := sum + b;
+   writeln('Loop: ', sum);
+
+   b := 10;
+   inc(b);
+   s := -10;
+   dec(s);
+   writeln('Inc/dec: ', b, ' ', s);
+
+   Clip(b);
+   writeln('Var: ', b);
+   writeln('Function: ', Half(201));
+
+   str := '200 -77';
+   readstr(str, b, s);
+   writeln('Read: ', b, ' ', s);
+
+   for i := 1 to 4 do
+      small[i] := i * 60;
+   pack(small, 1, spack);
+   unpack(spack, small, 1);
+   writeln('Pack: ', small[1], ' ', small[2], ' ', small[3], ' ', small[4]);
+end.
@@ -0,0 +1,52 @@
+program tailcall;
+
+var
+   count : integer;
+
+function isodd(n : integer) : boolean; forward;
+
+{$tailcall}
+function iseven(n : integer) : boolean;
+begin
+   if n = 0 then
+      iseven := true
+   else
+      iseven := isodd(n - 1);
+end;
+
+{$tailcall}
+function isodd(n : integer) : boolean;
+begin
+   if n = 0 then
+      isodd := false
+   else
+      isodd := iseven(n - 1);
+end;
+
+{$tailcall}
+function sumto(n, acc : integer) : integer;
+begin
+   if n = 0 then
+      sumto := acc
+   else
+      sumto := sumto(n - 1, (acc + n) mod 1000003);
+end;
+
+{$tailcall}
+procedure countdown(n : integer);
+begin
+   if n mod 2500000 = 0 then
+      writeln('At ', n);
+   count := count + 1;
+   if n > 0 then
+      countdown(n - 1);
+end;
+
+begin
+   writeln('iseven(10000000)=', iseven(10000000));
+   writeln('isodd(7777777)=', isodd(7777777));
+   writeln('sumto(10000000)=', sumto(10000000, 0));
+   count := 0;
+   countdown(10000000);
+   writeln('Count=', count);
+end.
@@ -0,0 +1,154 @@
+program threads;
+
+var
+   counter, lock, plain : integer;
+   total		: longint;
+   jobs, results	: longint;
+   single		: longint;
+   t1, t2, t3, t4	: longint;
+   small, guard		: 0..255;
+
+procedure bump(n : integer);
+var
+   i : integer;
+begin
+   for i := 1 to n do
+      atomicinc(counter);
+end;
+
+procedure drop(n : integer);
+var
+   i : integer;
+begin
+   for i := 1 to n do
+      atomicdec(counter);
+end;
+
+procedure bumpsmall(n : integer);
+var
+   i : integer;
+begin
+   for i := 1 to n do
+      atomicinc(small);
+end;
+
+procedure locked(n : integer);
+var
+   i : integer;
+begin
+   for i := 1 to n do
+   begin
+      repeat
+      until atomiccas(lock, 0, 1);
+      plain := plain + 1;
+      atomicdec(lock);
+   end;
+end;
+
+procedure producer;
+var
+   i : integer;
+begin
+   for i := 1 to 1000 do
+      send(jobs, i);
+   closechannel(jobs);
+end;
+
+procedure worker;
+var
+   v : longint;
+begin
+   while receive(jobs, v) do
+      send(results, v * 2);
+end;
+
+procedure consumer;
+var
+   v : longint;
+begin
+   while receive(results, v) do
+      total := total + v;
+end;
+
+procedure sendsingle;
+var
+   i : integer;
+begin
+   for i := 1 to 100 do
+      send(single, i);
+   closechannel(single);
+end;
+
+procedure nested;
+var
+   local : integer;
+   a, b	 : longint;
+
+   procedure count(n : integer);
+   var
+      i : integer;
+   begin
+      for i := 1 to n do
+	 atomicinc(local);
+   end;
+
+begin
+   local := 0;
+   a := spawn(count, 5000);
+   b := spawn(count, 7000);
+   join(a);
+   join(b);
+   writeln('local=', local);
+end;
+
+begin
+   counter := 0;
+   t1 := spawn(bump, 100000);
+   t2 := spawn(bump, 100000);
+   t3 := spawn(drop, 50000);
+   join(t1);
+   join(t2);
+   join(t3);
+   writeln('counter=', counter);
+
+   lock := 0;
+   plain := 0;
+   t1 := spawn(locked, 20000);
+   t2 := spawn(locked, 30000);
+   join(t1);
+   join(t2);
+   writeln('plain=', plain);
+
+   jobs := makechannel(16);
+   results := makechannel(4);
+   total := 0;
+   t1 := spawn(producer);
+   t2 := spawn(worker);
+   t3 := spawn(worker);
+   t4 := spawn(consumer);
+   join(t1);
+   join(t2);
+   join(t3);
+   closechannel(results);
+   join(t4);
+   writeln('total=', total);
+
+   single := makechannel(1);
+   total := 0;
+   t1 := spawn(sendsingle);
+   while receive(single, t2) do
+      total := total + t2;
+   join(t1);
+   writeln('single=', total);
+
+   small := 0;
+   guard := 77;
+   t1 := spawn(bumpsmall, 100);
+   t2 := spawn(bumpsmall, 100);
+   join(t1);
+   join(t2);
+   if atomiccas(small, 200, 250) then
+      writeln('small=', small, ' guard=', guard);
+
+   nested;
+end.
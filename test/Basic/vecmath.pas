@@ -0,0 +1,68 @@
+program vecmath;
+
+{ Loops calling math functions, which -fveclib=runtime lets the vectoriser turn
+  into calls to the vector functions of the runtime. }
+
+const
+   n = 1003;
+
+type
+   realarr   = array [1..n] of real;
+   singlearr = array [1..n] of single;
+
+var
+   x, s, c, e, l, a : realarr;
+   xs, ss, cs, es	: singlearr;
+   i		: integer;
+
+procedure show(name : string; var v : realarr);
+var
+   i   : integer;
+   sum : real;
+begin
+   sum := 0;
+   for i := 1 to n do
+      sum := sum + v[i];
+   writeln(name:6, sum:18:4, v[1]:16:6, v[n div 2]:16:6, v[n]:16:6);
+end;
+
+procedure shows(name : string; var v : singlearr);
+var
+   i   : integer;
+   sum : real;
+begin
+   sum := 0;
+   for i := 1 to n do
+      sum := sum + v[i];
+   writeln(name:6, sum:14:3, v[1]:10:5, v[n]:10:5);
+end;
+
+begin
+   for i := 1 to n do
+      x[i] := (i - n div 2) / 37;
+   for i := 1 to n do
+   begin
+      s[i] := sin(x[i]);
+      c[i] := cos(x[i]);
+      e[i] := exp(x[i]);
+      l[i] := ln(abs(x[i]) + 0.001);
+      a[i] := arctan(x[i]);
+   end;
+   show('sin', s);
+   show('cos', c);
+   show('exp', e);
+   show('ln', l);
+   show('arctan', a);
+
+   for i := 1 to n do
+      xs[i] := i / 100;
+   for i := 1 to n do
+   begin
+      ss[i] := sin(xs[i]);
+      cs[i] := cos(xs[i]);
+      es[i] := exp(xs[i] / 10) + ln(xs[i]);
+   end;
+   shows('sin', ss);
+   shows('cos', cs);
+   shows('exp+ln', es);
+end.
@@ -0,0 +1,81 @@
+program vectors;
+
+type
+   vreal = vector[4] of real;
+   vint	 = vector[8] of integer;
+   vmask = vector[8] of boolean;
+
+var
+   a, b, c : vreal;
+   x, y, z : vint;
+   m	   : vmask;
+   arr	   : array [1..12] of real;
+   iarr	   : array [0..7] of integer;
+   h	   : vector[4] of integer;
+   i	   : integer;
+
+procedure PrintReal(v : vreal);
+var
+   i : integer;
+begin
+   for i := 0 to 3 do
+      write(v[i]:6:1);
+   writeln;
+end;
+
+procedure PrintInt(v : vint);
+var
+   i : integer;
+begin
+   for i := 0 to 7 do
+      write(v[i]:4);
+   writeln;
+end;
+
+begin
+   for i := 1 to 12 do
+      arr[i] := i;
+   a := arr[1..4];
+   b := arr[5..8];
+   PrintReal(a);
+   c := a + b;
+   PrintReal(c);
+   c := a * b - 1;
+   PrintReal(c);
+   c := b / a;
+   PrintReal(c);
+   c := -a;
+   PrintReal(c);
+   arr[9..12] := a * 2.5;
+   for i := 9 to 12 do
+      write(arr[i]:6:1);
+   writeln;
+
+   for i := 0 to 7 do
+      iarr[i] := i * 3 - 7;
+   x := iarr;
+   y := 2;
+   PrintInt(x);
+   z := x * y + 1;
+   PrintInt(z);
+   PrintInt(x div 2);
+   PrintInt(x mod 4);
+   m := x > 0;
+   writeln('any=', any(m), ' all=', all(m));
+   m := x > -10;
+   writeln('any=', any(m), ' all=', all(m));
+   z := select(x < 0, -x, x);
+   PrintInt(z);
+   z := shuffle(x, 7, 6, 5, 4, 3, 2, 1, 0);
+   PrintInt(z);
+   h := shuffle(x, z, 0, 8, 1, 9);
+   writeln(h[0], ' ', h[1], ' ', h[2], ' ', h[3]);
+   writeln('sum=', reduceadd(x), ' prod=', reducemul(h), ' min=', reducemin(x), ' max=', reducemax(x));
+   writeln('sum=', reduceadd(a):0:1, ' prod=', reducemul(a):0:1, ' min=', reducemin(b):0:1,
+	   ' max=', reducemax(b):0:1);
+   x[3] := 100;
+   iarr := x;
+   for i := 0 to 7 do
+      write(iarr[i]:4);
+   writeln;
+end.
@@ -0,0 +1,12 @@
+program arrayinit;
+
+type
+   grid = array [1..3, 1..4] of integer;
+   row = array [1..5] of integer;
+
+var
+   g : grid value [1: [1: 1; 5: 2]; 2..3: [otherwise 0]; 3: [otherwise 1]];
+   r : row value [1..3: 1; 2: 2; 6: 3; otherwise 0; otherwise 1];
+
+begin
+end.
@@ -0,0 +1,20 @@
+program bigerr;
+
+type
+   rec = record
+	    x : integer;
+	 end;
+
+var
+   a : bigint;
+   r : real;
+   v : rec;
+
+begin
+   a := a + r;
+   a := a and 3;
+   a := a / 2;
+   a := a pow a;
+   r := a;
+   a := v;
+end.
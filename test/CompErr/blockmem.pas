@@ -0,0 +1,28 @@
+program blockmem;
+
+type
+   bits = packed array [1..16] of boolean;
+
+var
+   a, b	: array [1..10] of integer;
+   d	: array of integer;
+   p	: bits;
+   f	: text;
+   i	: integer;
+
+begin
+   fillchar(a, sizeof(a));
+   fillchar(a, sizeof(a), 1.5);
+   fillchar(3, 4, 0);
+   fillchar(d, 4, 0);
+   fillchar(p[2], 1, 0);
+   move(a, b);
+   move(a, f, sizeof(a));
+   if comparemem(a, b, 1.5) then
+      writeln;
+   if comparemem(a, i + 1, sizeof(a)) then
+      writeln;
+   fillchar('abcd', 4, 0);
+   move(a, 'abcd', 4);
+   fillchar([1, 2], 1, 0);
+end.
@@ -0,0 +1,15 @@
+program channel;
+
+var
+   c : longint;
+   i : integer;
+   v : longint;
+
+begin
+   c := makechannel(4);
+   send(c, 1);
+   if receive(c, i) then
+      writeln(i);
+   if receive(c, v) then
+      writeln(v);
+end.
@@ -0,0 +1,19 @@
+program defaulterr;
+
+type
+   shape = class
+	      n : integer;
+	      procedure draw; virtual;
+	   end;
+
+var
+   s : shape;
+
+procedure shape.draw;
+begin
+   writeln(n);
+end;
+
+begin
+   s := default(shape);
+end.
@@ -0,0 +1,15 @@
+program dynarrayerr;
+
+var
+   a : array of integer;
+   r : array of real;
+   s : string;
+   i : integer;
+
+begin
+   SetLength(s, 3);
+   i := High(i);
+   SetLength(a, 'x');
+   a := r;
+   a[1.5] := 1;
+end.
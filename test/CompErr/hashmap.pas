@@ -0,0 +1,32 @@
+program hashmaperr;
+
+type
+   short = string[5];
+
+var
+   m : map of integer to real;
+   n : map of short to integer;
+   h : hashset of char;
+   s : string;
+   r : real;
+   c : char;
+
+procedure Both(var a, b : real);
+begin
+   a := b;
+end;
+
+begin
+   m[1.5] := 1;
+   r := n[3];
+   n['much too long'] := 1;
+   include(h, 1);
+   exclude(s, 'a');
+   if s in n then
+      writeln('found');
+   for c in m do
+      writeln(c);
+   for s in n do
+      writeln(s);
+   Both(m[1], m[2]);
+end.
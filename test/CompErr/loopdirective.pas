@@ -0,0 +1,23 @@
+program loopdirective;
+
+var
+   i, s	: integer;
+
+begin
+   s := 0;
+   {$R-}
+   {$unrol 4}
+   for i := 1 to 10 do
+      s := s + i;
+   {$vectorise}
+   while s > 0 do
+      s := s - 1;
+   {$parallel}
+   repeat
+      s := s + 1
+   until s > 10;
+   {$unroll fast}
+   for i := 1 to 10 do
+      s := s + i;
+   writeln(s);
+end.
@@ -0,0 +1,47 @@
+program packedarg;
+
+type
+   quad	 = 0..3;
+   bits	 = packed array [1..16] of boolean;
+   small = packed array [1..8] of quad;
+   pair	 = packed record
+	      c	: char;
+	      n	: integer;
+	      r	: record
+		     x : integer;
+		  end;
+	   end;
+
+var
+   b : bits;
+   s : small;
+   p : pair;
+
+procedure Count(a : array [l..h : integer] of boolean);
+begin
+   writeln(h - l);
+end;
+
+procedure Sum(a : array [l..h : integer] of quad);
+begin
+   writeln(h - l);
+end;
+
+procedure Bump(var n : integer);
+begin
+   n := n + 1;
+end;
+
+procedure Flip(var x : boolean);
+begin
+   x := not x;
+end;
+
+begin
+   Count(b);
+   Sum(s);
+   Bump(p.n);
+   Bump(p.r.x);
+   Flip(b[3]);
+   inc(s[2]);
+end.
@@ -0,0 +1,30 @@
+program soaerr;
+
+type
+   point  = record
+	       x, y : integer;
+	    end;
+   points = {$soa} array [1..10] of point;
+
+var
+   p : points;
+   q : array [1..10] of point;
+
+procedure Show(a : array [l..h : integer] of point);
+begin
+   writeln(h - l);
+end;
+
+procedure Clear(var a : point);
+begin
+   a.x := 0;
+end;
+
+begin
+   Show(p);
+   pack(q, 1, p);
+   q := p;
+   fillchar(p[1], sizeof(point), 0);
+   move(q[1], p[2], sizeof(point));
+   Clear(p[3]);
+end.
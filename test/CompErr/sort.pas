@@ -0,0 +1,32 @@
+program sorterr;
+
+type
+   pair = record
+      x, y : integer;
+   end;
+
+var
+   a : array [1..10] of integer;
+   m : array [1..3, 1..3] of integer;
+   p : array [1..4] of pair;
+   i : integer;
+
+function less(a, b : real) : boolean;
+begin
+   less := a < b
+end;
+
+function cmp(a, b : integer) : integer;
+begin
+   cmp := a - b
+end;
+
+begin
+   sort(i);
+   sort(m);
+   sort(p);
+   sort(a, less);
+   sort(a, cmp);
+   sort(a, 1.5, 3);
+   sort(a, 1, 2, 3, 4, 5);
+end.
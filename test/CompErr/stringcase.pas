@@ -0,0 +1,15 @@
+program stringcase;
+
+var
+   s : string;
+   r : real;
+
+begin
+   case s of
+     'add', 'plus' : writeln('add');
+     'sub', 'add'  : writeln('sub');
+   end;
+   case r of
+     1 : writeln('one');
+   end;
+end.
@@ -0,0 +1,27 @@
+program subrangevar;
+
+type
+   byte	= 0..255;
+   word	= 0..65535;
+
+var
+   b : byte;
+   w : word;
+   i : integer;
+
+procedure Bump(var x : integer);
+begin
+   x := x + 1000
+end;
+
+procedure Clip(var x : byte);
+begin
+   x := x div 2
+end;
+
+begin
+   Bump(w);
+   Bump(b);
+   Clip(i);
+   Clip(b);
+end.
@@ -0,0 +1,60 @@
+program tailcallerr;
+
+type
+   arr = array [1..10] of integer;
+
+{$tailcall}
+procedure byvalue(a : arr; n : integer);
+begin
+   if n > 0 then
+      byvalue(a, n - 1);
+end;
+
+{$tailcall}
+procedure local(var x : integer; n : integer);
+var
+   y : integer;
+begin
+   y := x;
+   if n > 0 then
+      local(y, n - 1);
+end;
+
+{$tailcall}
+function other(n : integer) : integer;
+begin
+   other := sqr(n);
+end;
+
+{$tailcall}
+procedure outer(n : integer);
+
+   {$tailcall}
+   procedure inner(m : integer);
+   begin
+      if m > n then
+	 inner(m - 1);
+   end;
+
+begin
+   inner(n);
+end;
+
+{$tailcall}
+procedure mismatch(n : integer);
+begin
+   local(n, n);
+end;
+
+{$tailcall}
+procedure owner(n : integer);
+var
+   d : array of integer;
+begin
+   setlength(d, n);
+   if n > 0 then
+      owner(n - 1);
+end;
+
+begin
+end.
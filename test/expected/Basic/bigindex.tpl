@@ -0,0 +1,3 @@
+Sizes: 3000000001 40000000000
+Sum: 45 9
+Ends: 25 16 25
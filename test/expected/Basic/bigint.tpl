@@ -0,0 +1,13 @@
+265252859812191058636308480000000
+93326215443944152681699238856266700490715968264381621468592963895217599993229915608941463976156518286253697920827223758251185210916864000000000000000000000000
+265252859812191058636308480000000 265252859812191058636308480000001
+530505719624382117272616960000000 265252859812191058636308480000000
+-265252859812191058636308480000000
+-2 -3 -2 3
+1606938044258990275541962092341162602522202993782792835301376
+660502576288851129291475938829968811751368 98928087191781376
+TRUE TRUE TRUE FALSE TRUE
+fib(300) = 222232244629420445529739893461909967206666939096499764990979600
+485313787 TRUE TRUE
+           15241578753238836750495351562536198787501905199875019052100
+[         -123456789012345678901234567890]
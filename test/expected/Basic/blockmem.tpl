@@ -0,0 +1,17 @@
+   1   4   9  16  25  36  49  64  81 100
+   0   0   0   0   0   0   0   0   0   0
+168430091684300916843009   0   0   0   0   0   0   0
+****************
+----************
+   1   2   3   4   5   6   7   8   9  10
+   1   2   1   2   3   4   5   8   9  10
+   1   2   3   4   5   4   5   8   9  10
+TRUE
+TRUE
+FALSE
+TRUE
+00
+   0   0   0   0   0   0   0   0   0   0
+ 0.00
+0
+5
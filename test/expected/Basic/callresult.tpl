@@ -0,0 +1,3 @@
+Length: 7 High: 6
+Sum: 332333000
+Last: 121
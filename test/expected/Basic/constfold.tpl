@@ -0,0 +1,18 @@
+4
+-33
+ 3.50
+ 2.50
+TRUE
+abcdef 6
+TRUE FALSE TRUE
+TRUE TRUE
+5 3
+65 B 1 1
+c
+49  2.25 12  2.5 TRUE FALSE
+FALSE TRUE TRUE
+TRUE TRUE TRUE
+live
+always
+jumped
+234
@@ -0,0 +1,16 @@
+Empty: 0 -1
+Length: 1000 High: 999 Sum: 499500
+Grown: 7 8 9 0 0
+Shrunk: 4 8 0 0
+Copy: 0 100 1000
+After clobber: 1000 10
+After grow: 1005 1008016
+Range: 10 55 5050
+Conformant: 55 1
+Zap: 0
+Real:  3.00
+Grid: 5 44 0 420
+Grid shrunk: 2 2
+Points: 0 7
+Pointer: 3 42
+Cleared: 0
@@ -0,0 +1,3 @@
+fast=-2482948.719
+strict=-2482949.219
+muladd=  -0.24219
@@ -0,0 +1,20 @@
+length 1000
+m[70] = 10 m[7000] = 1000
+14 in m TRUE 15 in m FALSE
+sum of keys 3503500
+after exclude 500 FALSE TRUE
+sum of values 250000
+apple=11 pear=2 plum=3 fig=0
+len 4 TRUE FALSE
+c apple 11 d apple 5
+apple=11 len=4
+c apple 11
+blue  3.0
+FALSETRUE
+one two 2
+set len 4 TRUE FALSE
+set len 3 FALSE
+3439
+100 81
+1001 1001
+start 201
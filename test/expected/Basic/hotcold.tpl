@@ -0,0 +1,3 @@
+Total=297
+Not three=86
+TRUE FALSE
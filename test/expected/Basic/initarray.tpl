@@ -0,0 +1,17 @@
+  11  1  12  1  13  1  14  1
+   7  5   7  5   7  5   7  5
+  -1  1  33  1  33  1  -1  1
+ab
+cd
+xy
+xy
+zz
+zz
+  1.50  0.50  0.50  0.50  0.50  0.50  0.50  0.50  0.50 -2.25
+  0.0  0.0  0.0  0.0  0.0  0.0  0.0  0.0  0.0  0.0
+00100011100000000000
+ 8 6 5 5 5 5 5 5 5 5
+  1  2 one
+ -1 -1 two
+  5  6 three
+350000
@@ -0,0 +1,4 @@
+Sum=1501500
+Halved=733
+a[999]=741 b[1000]=1482
+   1   7  21  63 189 567 701 103
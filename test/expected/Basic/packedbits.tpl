@@ -0,0 +1,13 @@
+Sizes: 125000 5 50 2 5
+Records: 24 13 52
+Primes below 1000000: 78498
+ 1 2 0 1 2 0 1 2 0 1 2 0 1 2 0 1 2 0 1 2
+ 1 2 0 2 2 0 1 2 0 1 2 0 1 2 0 1 2 0 1 2
+ 0 7 4 1 8 5 2 9 6 3 0 7 4 1 8 5 2 9 6 3
+ -1  0  1 -2 -1  0  1 -2
+.#..#..
+#..#..#
+..#..#.
+.#..#..
+#..#..#
+b  1c  4d  9e 16 15.00
@@ -0,0 +1,4 @@
+sum=49950000 min=0 max=999
+prod=3325.2567
+total=149850000
+count=333
@@ -0,0 +1,10 @@
+Sizes: 24 32
+Counter: 64 256
+Spread: 64
+Fields: FALSE 1.25 q 42 abc ?
+With: TRUE 2.50 x 7 hello !
+Counters: 100
+Spread: 1 2 z
+Globals: 8 16.0
+Local: abcdefghij
+Node: n 99 100 16
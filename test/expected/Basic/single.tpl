@@ -0,0 +1,21 @@
+t=   4.000
+half=   2.000
+sqrt= 2.00000
+sin= 0.99749
+abs=   1.500
+round=6
+trunc=5
+min=   1.500 max=   4.000
+s= 0.333333343 r= 0.333333333
+mixed= 0.666666677
+e= 0.33333333333333333
+e*s= 0.11111111442248027
+pow= 0.1111111
+sum=  51.000
+reduce=  51.000
+val=   2.250
+readstr=   3.750
+writestr=  3.75
+ 1.000000E-01
+ 1.000000E-01
+r greater
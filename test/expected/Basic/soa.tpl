@@ -0,0 +1,11 @@
+Size: 56 52000
+Sum x: 501500.0
+With: 20.5
+Var: 8.0 8.0 11.5 1
+Value: 1.500
+Read: 8.0 -1.0 0
+Write: -1.0 14.0 42 0
+Element: 42 14.0
+Copy: 42 1001.0
+Grid: 600
+Init: 1 2 3 4 9 9
@@ -0,0 +1,15 @@
+ -10  -8  -6  -4  -1   1   3   6   8  10
+  10   8   6   3   1  -1  -4  -6  -8 -10
+  10   8  -4  -1   1   3   6  -6  -8 -10
+  10   8  -4  -1   1   3   6  -6  -8 -10
+Aabmqz
+ 0 0 1 2 2 3
+  -5  -1   0  50 100
+      -1.250      -0.001       0.000       2.000       3.500 1000000.000
+apple apples fig pear 
+Dee:19 Bob:25 Eve:25 Ann:40 Cid:40 
+  9 12  6 15  3 18 21 24
+0 1000000000 3000000000 4000000000 5000000000 6000000000 2000000000 
+0 1000000000 2000000000 3000000000 4000000000 5000000000 6000000000 
+Radix TRUE
+Compare TRUE
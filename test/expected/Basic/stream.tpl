@@ -0,0 +1,5 @@
+TRUE TRUE 19
+45 234
+3628800
+A 0 sides, area 0
+A 4 sides, area 49
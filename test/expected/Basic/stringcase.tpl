@@ -0,0 +1,16 @@
+add: add
+plus: add
+sub: sub
+mul: mul
+mux: unknown
+a: a
+b: unknown
+: empty
+abc: abc or abd
+abd: abc or abd
+abe: unknown
+multiply: multiply
+multiplx: unknown
+adds: unknown
+quit
+done
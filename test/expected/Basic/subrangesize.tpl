@@ -0,0 +1,13 @@
+Sizes: 1 1 2 2 4
+Arrays: 1000 4
+Sum: 124948
+Widened: 256 65025
+Signed: -128 -129 128
+Word: 65535 65536 Medium: -1000 -2000
+Pixel: 200 100 50 -1
+Loop: 32640
+Inc/dec: 11 -11
+Var: 5
+Function: 100
+Read: 200 -77
+Pack: 60 120 180 240
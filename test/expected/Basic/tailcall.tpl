@@ -0,0 +1,9 @@
+iseven(10000000)=TRUE
+isodd(7777777)=TRUE
+sumto(10000000)=435
+At 10000000
+At 7500000
+At 5000000
+At 2500000
+At 0
+Count=10000001
@@ -0,0 +1,6 @@
+counter=150000
+plain=50000
+total=1001000
+single=5050
+small=250 guard=77
+local=12000
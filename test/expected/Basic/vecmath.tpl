@@ -0,0 +1,8 @@
+sin            1.6694       -0.811750        0.000000        0.842117
+cos           61.7510        0.584005        1.000000        0.539295
+exp     29266923.8671        0.000001        1.000000   780404.432557
+ln         1610.5492        2.603764       -6.907755        2.607756
+arctan            2.9943       -1.496931        0.000000        1.497224
+sin       181.952   0.01000  -0.56894
+cos       -57.805   0.99995  -0.82238
+exp+ln      3041.184  -3.60417   5.03203
@@ -0,0 +1,18 @@
+   1.0   2.0   3.0   4.0
+   6.0   8.0  10.0  12.0
+   4.0  11.0  20.0  31.0
+   5.0   3.0   2.3   2.0
+  -1.0  -2.0  -3.0  -4.0
+   2.5   5.0   7.5  10.0
+  -7  -4  -1   2   5   8  11  14
+ -13  -7  -1   5  11  17  23  29
+  -3  -2   0   1   2   4   5   7
+  -3   0  -1   2   1   0   3   2
+any=TRUE all=FALSE
+any=TRUE all=TRUE
+   7   4   1   2   5   8  11  14
+  14  11   8   5   2  -1  -4  -7
+-7 14 -4 11
+sum=28 prod=4312 min=-7 max=14
+sum=10.0 prod=24.0 min=5.0 max=8.0
+  -7  -4  -1 100   5   8  11  14
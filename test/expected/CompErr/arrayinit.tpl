@@ -0,0 +1,5 @@
+CompErr/arrayinit.pas:8:23: Error: Initializer index out of range 5
+CompErr/arrayinit.pas:8:19: Error: Duplicate initializer 3
+CompErr/arrayinit.pas:9:18: Error: More than one otherwise in initializer
+CompErr/arrayinit.pas:9:18: Error: Duplicate initializer 2
+CompErr/arrayinit.pas:9:18: Error: Initializer index out of range 6
@@ -0,0 +1,6 @@
+CompErr/bigint.pas:14:11: Error: Operands of bigint expression should be bigint or integer
+CompErr/bigint.pas:15:11: Error: Invalid operator for bigint
+CompErr/bigint.pas:16:11: Error: Invalid operator for bigint
+CompErr/bigint.pas:17:11: Error: Exponent of bigint POW should be an integer
+CompErr/bigint.pas:18:9: Error: Incompatible type in assignment
+CompErr/bigint.pas:19:9: Error: Incompatible type in assignment
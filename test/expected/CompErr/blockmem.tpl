@@ -0,0 +1,12 @@
+CompErr/blockmem.pas:14:27: Error: Builtin function: 'fillchar' wrong number of arguments
+CompErr/blockmem.pas:15:32: Error: Builtin function: 'fillchar' wrong argument type(s)
+CompErr/blockmem.pas:16:22: Error: Builtin function: 'fillchar' wrong argument type(s)
+CompErr/blockmem.pas:17:22: Error: Builtin function: 'fillchar' wrong argument type(s)
+CompErr/blockmem.pas:18:25: Error: Builtin function: 'fillchar' wrong argument type(s)
+CompErr/blockmem.pas:19:15: Error: Builtin function: 'move' wrong number of arguments
+CompErr/blockmem.pas:20:26: Error: Builtin function: 'move' wrong argument type(s)
+CompErr/blockmem.pas:21:29: Error: Builtin function: 'comparemem' wrong argument type(s)
+CompErr/blockmem.pas:23:39: Error: Builtin function: 'comparemem' wrong argument type(s)
+CompErr/blockmem.pas:25:27: Error: Builtin function: 'fillchar' wrong argument type(s)
+CompErr/blockmem.pas:26:23: Error: Builtin function: 'move' wrong argument type(s)
+CompErr/blockmem.pas:27:27: Error: Builtin function: 'fillchar' wrong argument type(s)
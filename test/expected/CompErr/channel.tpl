@@ -0,0 +1 @@
+CompErr/channel.pas:11:21: Error: Builtin function: 'receive' wrong argument type(s)
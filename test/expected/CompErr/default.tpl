@@ -0,0 +1 @@
+CompErr/default.pas:18:23: Error: Type has no default value
@@ -0,0 +1,5 @@
+CompErr/dynarray.pas:10:20: Error: Builtin function: 'setlength' wrong argument type(s)
+CompErr/dynarray.pas:11:17: Error: Builtin function: 'high' wrong argument type(s)
+CompErr/dynarray.pas:12:22: Error: Builtin function: 'setlength' wrong argument type(s)
+CompErr/dynarray.pas:13:9: Error: Incompatible type in assignment
+CompErr/dynarray.pas:14:7: Error: Index should be an integral type
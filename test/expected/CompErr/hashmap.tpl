@@ -0,0 +1,9 @@
+CompErr/hashmap.pas:20:7: Error: Key type does not match the map
+CompErr/hashmap.pas:21:12: Error: Key type does not match the map
+CompErr/hashmap.pas:22:7: Error: Key type does not match the map
+CompErr/hashmap.pas:23:18: Error: Builtin function: 'include' wrong argument type(s)
+CompErr/hashmap.pas:24:20: Error: Builtin function: 'exclude' wrong argument type(s)
+CompErr/hashmap.pas:25:9: Error: Left hand of 'in' expression should be a key of the map.
+CompErr/hashmap.pas:27:10: Error: Expected variable to be compatible with the keys of the map
+CompErr/hashmap.pas:31:14: Error: Map element can't be a 'var' argument
+CompErr/hashmap.pas:31:20: Error: Map element can't be a 'var' argument
@@ -0,0 +1 @@
+CompErr/loopdirective.pas:20:8: Error: Expected 'full' or a positive count in unroll directive
@@ -0,0 +1,6 @@
+CompErr/packedarg.pas:41:13: Error: Incompatible argument type 0
+CompErr/packedarg.pas:42:11: Error: Incompatible argument type 0
+CompErr/packedarg.pas:43:13: Error: Component of packed record can't be a 'var' argument
+CompErr/packedarg.pas:44:15: Error: Component of packed record can't be a 'var' argument
+CompErr/packedarg.pas:45:14: Error: Element of packed array can't be a 'var' argument
+CompErr/packedarg.pas:46:13: Error: Builtin function: 'inc' wrong argument type(s)
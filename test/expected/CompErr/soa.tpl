@@ -0,0 +1,6 @@
+CompErr/soa.pas:24:12: Error: Incompatible argument type 0
+CompErr/soa.pas:25:18: Error: Builtin function: 'pack' wrong argument type(s)
+CompErr/soa.pas:26:9: Error: Incompatible type in assignment
+CompErr/soa.pas:27:37: Error: Builtin function: 'fillchar' wrong argument type(s)
+CompErr/soa.pas:28:36: Error: Builtin function: 'move' wrong argument type(s)
+CompErr/soa.pas:29:15: Error: Element of {$soa} array can't be a 'var' argument
@@ -0,0 +1,7 @@
+CompErr/sort.pas:25:12: Error: Builtin function: 'sort' wrong argument type(s)
+CompErr/sort.pas:26:12: Error: Builtin function: 'sort' wrong argument type(s)
+CompErr/sort.pas:27:12: Error: Builtin function: 'sort' wrong argument type(s)
+CompErr/sort.pas:28:18: Error: Builtin function: 'sort' wrong argument type(s)
+CompErr/sort.pas:29:17: Error: Builtin function: 'sort' wrong argument type(s)
+CompErr/sort.pas:30:20: Error: Builtin function: 'sort' wrong argument type(s)
+CompErr/sort.pas:31:27: Error: Builtin function: 'sort' wrong number of arguments
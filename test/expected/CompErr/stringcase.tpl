@@ -0,0 +1,2 @@
+CompErr/stringcase.pas:8:1: Error: Duplicate case label 'add'
+CompErr/stringcase.pas:12:1: Error: Case selection must be integral or string type
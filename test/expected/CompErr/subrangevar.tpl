@@ -0,0 +1,3 @@
+CompErr/subrangevar.pas:23:11: Error: var argument must have the parameter's type
+CompErr/subrangevar.pas:24:11: Error: var argument must have the parameter's type
+CompErr/subrangevar.pas:25:11: Error: var argument must have the parameter's type
@@ -0,0 +1,6 @@
+CompErr/tailcall.pas:10:25:: Can't make tail call to 'byvalue': argument 'a' is copied by value
+CompErr/tailcall.pas:20:23:: Can't make tail call to 'local': argument 'x' refers to a local variable
+CompErr/tailcall.pas:36:16:: Can't make tail call to 'inner': it needs a closure
+CompErr/tailcall.pas:40:13:: Can't make tail call to 'inner': arguments or result differ from the calling function
+CompErr/tailcall.pas:46:16:: Can't make tail call to 'local': arguments or result differ from the calling function
+CompErr/tailcall.pas:56:20:: Can't make tail call to 'owner': 'd' must be released when the calling function returns
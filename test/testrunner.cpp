@@ -81,12 +81,14 @@ public:
     virtual bool        Result();
     virtual std::string Dir() { return "Basic"; }
     std::string         Name() const;
+    void                SetCompileOptions(const std::string& opts) { compileOptions = opts; }
     virtual ~TestCase() {}
 
 protected:
     std::string name;
     std::string source;
     std::string args;
+    std::string compileOptions;
 };
 
 TestCase::TestCase(const std::string& nm, const std::string& src, const std::string& arg)
@@ -106,7 +108,7 @@ void TestCase::Clean()
 
 bool TestCase::Compile(const std::string& options)
 {
-    if (RunCmd(compiler + " " + options + " " + Dir() + "/" + source) == 0)
+    if (RunCmd(compiler + " " + options + " " + compileOptions + " " + Dir() + "/" + source) == 0)
     {
 	return true;
     }
@@ -167,20 +169,64 @@ public:
     virtual std::string Dir() { return "Time"; }
 
 private:
-    long                                               maxTime; // In milliseconds.
+    long                                               maxTime;  // In milliseconds, or percent if relative.
+    bool                                               relative; // Compared with the time at -O0.
+    long                                               baseTime; // In milliseconds.
+    std::string                                        extraOptions;
     std::chrono::time_point<std::chrono::steady_clock> start, end;
 };
 
+// arg is the time limit, optionally followed by options to compile with. A limit of "N%" means
+// at most N percent of the time the same source takes at -O0 without those options.
 TimeTestCase::TimeTestCase(const std::string& nm, const std::string& src, const std::string& arg)
-    : TestCase(nm, src, ""), maxTime(std::stol(arg))
+    : TestCase(nm, src, ""), maxTime(std::stol(arg)), relative(false), baseTime(0)
 {
+    size_t pos = arg.find_first_not_of("0123456789");
+    if (pos != std::string::npos && arg[pos] == '%')
+    {
+	relative = true;
+    }
+    pos = arg.find(' ');
+    if (pos != std::string::npos)
+    {
+	extraOptions = arg.substr(pos + 1);
+    }
+}
+
+// The test mode's options, with any optimisation level replaced by -O0.
+static std::string AtO0(const std::string& options)
+{
+    std::string result;
+    size_t      pos = 0;
+    while ((pos = options.find_first_not_of(' ', pos)) != std::string::npos)
+    {
+	size_t      end = options.find(' ', pos);
+	std::string opt = options.substr(pos, end - pos);
+	if (opt.substr(0, 2) != "-O")
+	{
+	    result += opt + " ";
+	}
+	pos = end;
+    }
+    return result + "-O0";
 }
 
 bool TimeTestCase::Compile(const std::string& options)
 {
+    if (relative)
+    {
+	start = std::chrono::steady_clock::now();
+	if (!TestCase::Compile(AtO0(options)))
+	{
+	    return false;
+	}
+	end = std::chrono::steady_clock::now();
+	baseTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    }
+
     start = std::chrono::steady_clock::now();
 
-    bool res = TestCase::Compile(options);
+    bool res = TestCase::Compile(options + " " + extraOptions);
 
     end = std::chrono::steady_clock::now();
     return res;
@@ -189,15 +235,105 @@ bool TimeTestCase::Compile(const std::string& options)
 bool TimeTestCase::Result()
 {
     long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (elapsed > maxTime)
+    long limit = relative ? baseTime * maxTime / 100 : maxTime;
+    if (elapsed > limit)
     {
 	std::cerr << "Took too long to compile  " << source << " " << std::fixed << std::setprecision(3)
-	          << elapsed << " ms" << std::endl;
+	          << elapsed << " ms";
+	if (relative)
+	{
+	    std::cerr << " (" << baseTime << " ms at -O0)";
+	}
+	std::cerr << std::endl;
 	return false;
     }
     return true;
 }
 
+// Time test on a generated source of "functions" copies of an ordinary function, about 37 lines each,
+// and a main program calling them all.
+class GeneratedTimeTestCase : public TimeTestCase
+{
+public:
+    GeneratedTimeTestCase(const std::string& nm, const std::string& src, const std::string& arg,
+                          int functions);
+    virtual bool Compile(const std::string& options);
+
+private:
+    int functions;
+};
+
+GeneratedTimeTestCase::GeneratedTimeTestCase(const std::string& nm, const std::string& src,
+                                             const std::string& arg, int fns)
+    : TimeTestCase(nm, src, arg), functions(fns)
+{
+}
+
+bool GeneratedTimeTestCase::Compile(const std::string& options)
+{
+    std::ofstream out(Dir() + "/" + source);
+    out << "program " << replace_ext(source, ".pas", "") << ";\n\n"
+        << "type\n"
+        << "   point = record\n"
+        << "\t      x, y : integer;\n"
+        << "\t   end;\n\n"
+        << "var\n"
+        << "   total : integer;\n\n";
+    for (int n = 1; n <= functions; n++)
+    {
+	out << "function f" << n << "(a : integer; var p : point) : integer;\n"
+	    << "var\n"
+	    << "   i, s : integer;\n"
+	    << "   q    : point;\n"
+	    << "   t    : string;\n"
+	    << "begin\n"
+	    << "   s := 0;\n"
+	    << "   q.x := a;\n"
+	    << "   q.y := a * " << n % 7 + 2 << ";\n"
+	    << "   for i := 1 to 16 do\n"
+	    << "   begin\n"
+	    << "      p.x := p.x + i * " << n << ";\n"
+	    << "      if odd(p.x) then\n"
+	    << "\t s := s + p.x mod 100\n"
+	    << "      else\n"
+	    << "\t s := s - p.x mod 50;\n"
+	    << "   end;\n"
+	    << "   case a mod 4 of\n"
+	    << "     0 : s := s + q.x;\n"
+	    << "     1 : s := s - q.y;\n"
+	    << "     2 : s := s xor q.x;\n"
+	    << "   otherwise\n"
+	    << "      s := s + 1;\n"
+	    << "   end;\n"
+	    << "   i := 0;\n"
+	    << "   while (i < 10) and (s > 0) do\n"
+	    << "   begin\n"
+	    << "      s := s div 2 + i;\n"
+	    << "      i := i + 1;\n"
+	    << "   end;\n"
+	    << "   t := 'f';\n"
+	    << "   if length(t) + " << n << " > 1000 then\n"
+	    << "      writeln(t);\n"
+	    << "   p.y := p.y + s;\n"
+	    << "   f" << n << " := s mod 1000;\n"
+	    << "end;\n\n";
+    }
+    out << "var\n"
+        << "   p : point;\n\n"
+        << "begin\n"
+        << "   p.x := 0;\n"
+        << "   p.y := 0;\n"
+        << "   total := 0;\n";
+    for (int n = 1; n <= functions; n++)
+    {
+	out << "   total := (total + f" << n << "(" << n << ", p)) mod 100000;\n";
+    }
+    out << "   writeln(total, ' ', p.y mod 1000);\n"
+        << "end.\n";
+    out.close();
+    return TimeTestCase::Compile(options);
+}
+
 // Class to test compile detection of errors.
 class CompileTimeError : public TestCase
 {
@@ -247,6 +383,12 @@ TestCase* TestCaseFactory(const std::string& type, const std::string& name, cons
 	return new TimeTestCase(name, source, args);
     }
 
+    if (type == "GeneratedTime")
+    {
+	// About 5000 lines.
+	return new GeneratedTimeTestCase(name, source, args, 135);
+    }
+
     if (type == "CompErr")
     {
 	return new CompileTimeError(name, source, args);
@@ -316,15 +458,23 @@ private:
 enum TestFlags
 {
     LACSAP_ONLY = 1 << 0,
+    // Needs a 64-bit address space.
+    NO_M32 = 1 << 1,
 };
 
 struct TestEntry
 {
+    TestEntry(int f, const char* ty, const char* nm, const char* src, const char* arg, const char* opts = 0)
+        : flags(f), type(ty), name(nm), source(src), args(arg), options(opts)
+    {
+    }
     int         flags;
     const char* type;
     const char* name;
     const char* source;
     const char* args;
+    // Compile options the test always needs, on top of the ones of the test mode.
+    const char* options;
 };
 
 TestEntry testCaseList[] = {
@@ -472,6 +622,30 @@ TestEntry testCaseList[] = {
     { 0, "Basic", "Compare Array", "comparr.pas", "" },
     { 0, "Basic", "Array Init", "arrayinit.pas", "" },
     { 0, "Basic", "Read Boolean", "readbool.pas", " < readbool.txt" },
+    { LACSAP_ONLY, "Basic", "Parallel For", "parfor.pas", "" },
+    { LACSAP_ONLY, "Basic", "Threads", "threads.pas", "" },
+    { LACSAP_ONLY, "Basic", "Vector", "vector.pas", "" },
+    { LACSAP_ONLY, "Basic", "Single", "single.pas", "" },
+    { LACSAP_ONLY, "Basic", "Fast Math", "fastmath.pas", "" },
+    { LACSAP_ONLY, "Basic", "Loop Hints", "loophints.pas", "" },
+    { LACSAP_ONLY, "Basic", "Hot Cold", "hotcold.pas", "" },
+    { LACSAP_ONLY, "Basic", "Tail Call", "tailcall.pas", "" },
+    { LACSAP_ONLY, "Basic", "Packed Bits", "packedbits.pas", "" },
+    { LACSAP_ONLY, "Basic", "Subrange Size", "subrangesize.pas", "" },
+    { LACSAP_ONLY, "Basic", "Record Layout", "recordlayout.pas", "" },
+    { LACSAP_ONLY, "Basic", "SoA", "soa.pas", "" },
+    { LACSAP_ONLY, "Basic", "Dynamic Array", "dynarray.pas", "" },
+    { LACSAP_ONLY, "Basic", "Call Result", "callresult.pas", "" },
+    { LACSAP_ONLY | NO_M32, "Basic", "Big Index", "bigindex.pas", "" },
+    { LACSAP_ONLY, "Basic", "Vector Math", "vecmath.pas", "", "-fveclib=runtime" },
+    { LACSAP_ONLY, "Basic", "Stream", "stream.pas", "", "-fstream" },
+    { LACSAP_ONLY, "Basic", "Sort", "sort.pas", "" },
+    { LACSAP_ONLY, "Basic", "Hash Map", "hashmap.pas", "" },
+    { LACSAP_ONLY, "Basic", "Bigint", "bigint.pas", "" },
+    { LACSAP_ONLY, "Basic", "String Case", "stringcase.pas", "" },
+    { LACSAP_ONLY, "Basic", "Block Memory", "blockmem.pas", "" },
+    { LACSAP_ONLY, "Basic", "Init Array", "initarray.pas", "" },
+    { LACSAP_ONLY, "Basic", "Constant Folding", "constfold.pas", "" },
 
     { 0, "File", "CopyFile", "copyfile.pas", "File/infile.dat File/outfile.dat" },
     // get from files not supported.
@@ -480,6 +654,7 @@ TestEntry testCaseList[] = {
 
     // Check that compiler doesn't get too slow.
     { 0, "Time", "LongCompile", "longcompile.pas", "1000" },
+    { LACSAP_ONLY, "GeneratedTime", "FastCompile", "fastcompile.pas", "60% -Ofast-compile" },
 };
 
 // Keep "negative" tests in a separate category
@@ -522,7 +697,21 @@ TestEntry negativeCaseList[] = { { 0, "CompErr", "Goto err", "goto.pas", "" },
                                  { 0, "CompErr", "Precision on integer in write", "writeprecision.pas", "" },
                                  { 0, "CompErr", "Non-integer index", "non-int-index.pas", "" },
                                  { 0, "CompErr", "Non-integer index v2", "non-int-index2.pas", "" },
-                                 { 0, "CompErr", "Protected variable", "prot.pas", "" } };
+                                 { 0, "CompErr", "Protected variable", "prot.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Tail call", "tailcall.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "SoA", "soa.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Packed Arguments", "packedarg.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Subrange var Arguments", "subrangevar.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Channel", "channel.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Dynamic Array", "dynarray.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Sort", "sort.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Hash Map", "hashmap.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Bigint", "bigint.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "String Case", "stringcase.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Block Memory", "blockmem.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Default value", "default.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Array Init", "arrayinit.pas", "" },
+                                 { LACSAP_ONLY, "CompErr", "Loop Directive", "loopdirective.pas", "" } };
 
 void runTestCases(const std::vector<TestCase*>& tc, TestResult& res, const std::string& options)
 {
@@ -558,6 +747,7 @@ void runTestCases(const std::vector<TestCase*>& tc, TestResult& res, const std::
 int main(int argc, char** argv)
 {
     std::vector<TestCase*>   tc;
+    std::vector<TestCase*>   tcM32;
     TestResult               res;
     std::string              mode = "full";
     std::vector<std::string> optimizations = { "", "-O0", "-O1", "-O2" };
@@ -595,6 +785,14 @@ int main(int argc, char** argv)
 	    if ((t.flags & flags) == 0)
 	    {
 		tc.push_back(TestCaseFactory(t.type, t.name, t.source, t.args));
+		if (t.options)
+		{
+		    tc.back()->SetCompileOptions(t.options);
+		}
+		if ((t.flags & NO_M32) == 0)
+		{
+		    tcM32.push_back(tc.back());
+		}
 	    }
 	}
     }
@@ -606,6 +804,7 @@ int main(int argc, char** argv)
 	    if ((t.flags & flags) == 0)
 	    {
 		tc.push_back(TestCaseFactory(t.type, t.name, t.source, t.args));
+		tcM32.push_back(tc.back());
 	    }
 	}
     }
@@ -618,14 +817,14 @@ int main(int argc, char** argv)
 	    {
 		for (auto other : others)
 		{
-		    runTestCases(tc, res, opt + " " + model + " " + other);
+		    runTestCases(model == "-m32" ? tcM32 : tc, res, opt + " " + model + " " + other);
 		}
 	    }
 	}
     }
     else
     {
-	runTestCases(tc, res, mode);
+	runTestCases(mode.find("-m32") != std::string::npos ? tcM32 : tc, res, mode);
     }
 
     res.Report();
@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <fstream>
 #include <string>
+#include <vector>
 
 class Token
 {
@@ -139,7 +140,7 @@ public:
 	Unknown = -1000,
     };
 
-    Token(TokenType t = Unknown, const Location& w = { "", 0, 0 });
+    Token(TokenType t = Unknown, const Location& w = Location());
     Token(TokenType t, const Location& w, const std::string& str);
     Token(TokenType t, const Location& w, uint64_t v);
     Token(const Location& w, double v);
@@ -182,6 +183,10 @@ public:
     std::string     Where();
     const Location& Loc() const { return where; }
 
+    // Compiler directives, "{$...}", that appeared immediately before this token.
+    void                            SetDirectives(const std::vector<std::string>& d) { directives = d; }
+    const std::vector<std::string>& Directives() const { return directives; }
+
     int  Precedence() const;
     bool IsCompare() const { return type >= Token::FirstComparison && type <= Token::LastComparison; }
 
@@ -194,6 +199,8 @@ private:
     std::string strVal;
     uint64_t    intVal;
     double      realVal;
+
+    std::vector<std::string> directives;
 };
 
 #endif
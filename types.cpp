@@ -1,10 +1,14 @@
 #include "types.h"
 #include "expr.h"
+#include "options.h"
 #include "runtime/runtime.h"
 #include "schema.h"
 #include "trace.h"
+#include <algorithm>
 #include <climits>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/TargetParser/Triple.h>
+#include <numeric>
 #include <sstream>
 
 extern llvm::Module* theModule;
@@ -16,13 +20,13 @@ namespace Types
     size_t TypeDecl::Size() const
     {
 	const llvm::DataLayout dl(theModule);
-	return dl.getTypeAllocSize(LlvmType());
+	return dl.getTypeAllocSize(StorageType());
     }
 
     size_t TypeDecl::AlignSize() const
     {
 	const llvm::DataLayout dl(theModule);
-	return dl.getPrefTypeAlign(LlvmType()).value();
+	return std::max<size_t>(dl.getPrefTypeAlign(StorageType()).value(), MinAlign());
     }
 
     Range* TypeDecl::GetRange() const
@@ -112,7 +116,7 @@ namespace Types
 	{
 	    return this;
 	}
-	if (ty->Type() == TK_LongInt || ty->Type() == TK_Real || ty->Type() == TK_Complex)
+	if (ty->Type() == TK_LongInt || llvm::isa<RealDecl>(ty) || ty->Type() == TK_Complex)
 	{
 	    return ty;
 	}
@@ -137,7 +141,7 @@ namespace Types
 	{
 	    return this;
 	}
-	if (ty->Type() == TK_Real)
+	if (llvm::isa<RealDecl>(ty))
 	{
 	    return ty;
 	}
@@ -158,27 +162,79 @@ namespace Types
 	return 0;
     }
 
+    // Extended is the C long double of the target, as that is what the runtime takes: 80-bit on x86,
+    // double-double on PowerPC, IEEE quad precision on other 64-bit targets, and plain double on
+    // 32-bit ARM and the like, Windows and Apple Silicon.
+    static llvm::Type* ExtendedType()
+    {
+	llvm::Triple triple(theModule->getTargetTriple());
+	if (triple.isWindowsMSVCEnvironment() || (triple.isOSDarwin() && !triple.isX86()))
+	{
+	    return llvm::Type::getDoubleTy(theContext);
+	}
+	if (triple.isX86())
+	{
+	    return llvm::Type::getX86_FP80Ty(theContext);
+	}
+	if (triple.isPPC())
+	{
+	    return llvm::Type::getPPC_FP128Ty(theContext);
+	}
+	if (triple.isArch64Bit())
+	{
+	    return llvm::Type::getFP128Ty(theContext);
+	}
+	return llvm::Type::getDoubleTy(theContext);
+    }
+
+    unsigned RealDecl::Bits() const
+    {
+	switch (kind)
+	{
+	case TK_Single:
+	    return 32;
+	case TK_Extended:
+	    return ExtendedType()->getPrimitiveSizeInBits();
+	default:
+	    return 64;
+	}
+    }
+
     void RealDecl::DoDump() const
     {
-	std::cerr << "Type: Real";
+	std::cerr << "Type: Real<" << Bits() << ">";
     }
 
     llvm::Type* RealDecl::GetLlvmType() const
     {
-	return llvm::Type::getDoubleTy(theContext);
+	switch (kind)
+	{
+	case TK_Single:
+	    return llvm::Type::getFloatTy(theContext);
+	case TK_Extended:
+	    return ExtendedType();
+	default:
+	    return llvm::Type::getDoubleTy(theContext);
+	}
     }
 
     llvm::DIType* RealDecl::GetDIType(llvm::DIBuilder* builder) const
     {
-	return builder->createBasicType("REAL", 64, llvm::dwarf::DW_ATE_float);
+	static const char* names[] = { "REAL", "SINGLE", "EXTENDED" };
+	return builder->createBasicType(names[kind - TK_Real], Bits(), llvm::dwarf::DW_ATE_float);
     }
 
+    // Mixing real types gives the more precise one.
     const TypeDecl* RealDecl::CompatibleType(const TypeDecl* ty) const
     {
 	if (SameAs(ty) || ty->Type() == TK_LongInt || ty->Type() == TK_Integer)
 	{
 	    return this;
 	}
+	if (auto rty = llvm::dyn_cast<RealDecl>(ty))
+	{
+	    return (rty->Bits() > Bits()) ? ty : this;
+	}
 	if (ty->Type() == TK_Complex)
 	{
 	    return ty;
@@ -195,8 +251,13 @@ namespace Types
 	return 0;
     }
 
+    // Any real can be assigned to any other, with rounding if needed.
     const TypeDecl* RealDecl::AssignableType(const TypeDecl* ty) const
     {
+	if (llvm::isa<RealDecl>(ty))
+	{
+	    return this;
+	}
 	return CompatibleType(ty);
     }
 
@@ -287,6 +348,9 @@ namespace Types
 	case TK_File:
 	case TK_Text:
 	case TK_Set:
+	case TK_Vector:
+	case TK_HeapArray:
+	case TK_Map:
 	    return true;
 	default:
 	    break;
@@ -347,14 +411,62 @@ namespace Types
 	    nelems *= r->GetRange()->Size();
 	}
 
-	llvm::Type* ty = baseType->LlvmType();
+	if (unsigned bits = BitsPerElement())
+	{
+	    return llvm::ArrayType::get(llvm::Type::getInt8Ty(theContext), (nelems * bits + 7) / CHAR_BIT);
+	}
+
+	if (soa)
+	{
+	    auto                     rd = llvm::cast<RecordDecl>(baseType);
+	    std::vector<llvm::Type*> fv;
+	    for (int i = 0; i < rd->FieldCount(); i++)
+	    {
+		fv.push_back(llvm::ArrayType::get(rd->GetElement(i)->StorageType(), nelems));
+	    }
+	    return llvm::StructType::create(fv);
+	}
+
+	llvm::Type* ty = baseType->StorageType();
 	ICE_IF(!nelems, "Expect number of elements to be non-zero!");
 	ICE_IF(!ty, "Expected to get a type back!");
 	return llvm::ArrayType::get(ty, nelems);
     }
 
+    unsigned ArrayDecl::BitsPerElement() const
+    {
+	if (!packed || !llvm::isa<RangeDecl, EnumDecl, BoolDecl>(baseType))
+	{
+	    return 0;
+	}
+	uint64_t values = baseType->GetRange()->Size();
+	if (values <= 2)
+	{
+	    return 1;
+	}
+	if (values <= 4)
+	{
+	    return 2;
+	}
+	if (values <= 16)
+	{
+	    return 4;
+	}
+	return 0;
+    }
+
     llvm::DIType* ArrayDecl::GetDIType(llvm::DIBuilder* builder) const
     {
+	if (BitsPerElement())
+	{
+	    // Debuggers can't show bit-packed elements, so describe it as the bytes holding them.
+	    uint64_t          size = Size();
+	    llvm::DIType*     byteTy =
+	        builder->createBasicType("BYTE", CHAR_BIT, llvm::dwarf::DW_ATE_unsigned);
+	    llvm::DISubrange* range = builder->getOrCreateSubrange(0, size);
+	    llvm::DINodeArray subsArray = builder->getOrCreateArray({ range });
+	    return builder->createArrayType(size * CHAR_BIT, CHAR_BIT, byteTy, subsArray);
+	}
 	std::vector<llvm::Metadata*> subscripts;
 	for (auto r : ranges)
 	{
@@ -367,6 +479,32 @@ namespace Types
 	    return 0;
 	}
 	llvm::DINodeArray subsArray = builder->getOrCreateArray(subscripts);
+	if (soa)
+	{
+	    // Describe it as it is stored, a record with an array for each field.
+	    auto                         rd = llvm::cast<RecordDecl>(baseType);
+	    const llvm::DataLayout       dl(theModule);
+	    const llvm::StructLayout*    sl = dl.getStructLayout(llvm::cast<llvm::StructType>(LlvmType()));
+	    std::vector<llvm::Metadata*> eltTys;
+	    for (int i = 0; i < rd->FieldCount(); i++)
+	    {
+		const FieldDecl* f = rd->GetElement(i);
+		llvm::DIType*    fd = f->DebugType(builder);
+		if (!fd)
+		{
+		    return 0;
+		}
+		uint64_t size = f->Size() * CHAR_BIT;
+		uint64_t align = f->AlignSize() * CHAR_BIT;
+		uint64_t offset = sl->getElementOffsetInBits(i);
+		fd = builder->createArrayType(size, align, fd, subsArray);
+		eltTys.push_back(builder->createMemberType(0, f->Name(), 0, 0, size, align, offset,
+		                                           llvm::DINode::FlagZero, fd));
+	    }
+	    llvm::DINodeArray elements = builder->getOrCreateArray(eltTys);
+	    return builder->createStructType(0, "", 0, 0, Size() * CHAR_BIT, AlignSize() * CHAR_BIT,
+	                                     llvm::DINode::FlagZero, 0, elements);
+	}
 	return builder->createArrayType(baseType->Size() * CHAR_BIT, baseType->AlignSize() * CHAR_BIT, bd,
 	                                subsArray);
     }
@@ -377,7 +515,8 @@ namespace Types
 	{
 	    if (const auto aty = llvm::dyn_cast<ArrayDecl>(ty))
 	    {
-		if (ranges.size() != aty->Ranges().size())
+		if (ranges.size() != aty->Ranges().size() || BitsPerElement() != aty->BitsPerElement() ||
+		    soa != aty->soa)
 		{
 		    return false;
 		}
@@ -403,6 +542,10 @@ namespace Types
 	}
 	if (const auto aty = llvm::dyn_cast<ArrayDecl>(ty))
 	{
+	    if (BitsPerElement() != aty->BitsPerElement() || soa != aty->soa)
+	    {
+		return 0;
+	    }
 	    if (aty->SubType() == SubType() && ranges.size() == aty->Ranges().size())
 	    {
 		for (size_t i = 0; i < ranges.size(); i++)
@@ -419,7 +562,84 @@ namespace Types
 
     TypeDecl* ArrayDecl::Clone() const
     {
-	return new Types::ArrayDecl(baseType, ranges);
+	auto ad = new Types::ArrayDecl(baseType, ranges);
+	ad->packed = packed;
+	ad->soa = soa;
+	return ad;
+    }
+
+    void VectorDecl::DoDump() const
+    {
+	std::cerr << "Vector[" << count << "] of ";
+	baseType->DoDump();
+    }
+
+    llvm::Type* VectorDecl::GetLlvmType() const
+    {
+	return llvm::FixedVectorType::get(baseType->LlvmType(), count);
+    }
+
+    llvm::DIType* VectorDecl::GetDIType(llvm::DIBuilder* builder) const
+    {
+	llvm::DIType* bd = baseType->DebugType(builder);
+	if (!bd)
+	{
+	    return 0;
+	}
+	llvm::DINodeArray subsArray = builder->getOrCreateArray({ builder->getOrCreateSubrange(0, count) });
+	return builder->createVectorType(Size() * CHAR_BIT, AlignSize() * CHAR_BIT, bd, subsArray);
+    }
+
+    bool VectorDecl::SameAs(const TypeDecl* ty) const
+    {
+	if (CompoundDecl::SameAs(ty))
+	{
+	    return llvm::cast<VectorDecl>(ty)->Count() == count;
+	}
+	return false;
+    }
+
+    // Scalars of the element type are compatible, and are broadcast to all lanes.
+    const TypeDecl* VectorDecl::CompatibleType(const TypeDecl* ty) const
+    {
+	if (SameAs(ty) || (!llvm::isa<VectorDecl>(ty) && baseType->AssignableType(ty)))
+	{
+	    return this;
+	}
+	return 0;
+    }
+
+    // True for a one-dimensional array (or slice) with the same element type and number of elements.
+    // Boolean vectors are packed as bits, so they can't be loaded from or stored to arrays.
+    bool VectorDecl::MatchesArray(const TypeDecl* ty) const
+    {
+	if (llvm::isa<BoolDecl>(baseType))
+	{
+	    return false;
+	}
+	if (auto aty = llvm::dyn_cast<ArrayDecl>(ty))
+	{
+	    if (aty->Ranges().size() == 1 && llvm::isa<RangeDecl>(aty->Ranges()[0]))
+	    {
+		return *aty->SubType() == *baseType && aty->Ranges()[0]->RangeSize() == count;
+	    }
+	}
+	return false;
+    }
+
+    // The result of comparing two vectors, one boolean per lane.
+    VectorDecl* VectorDecl::MaskType() const
+    {
+	if (!maskType)
+	{
+	    maskType = new VectorDecl(Get<BoolDecl>(), count);
+	}
+	return maskType;
+    }
+
+    RangeDecl* VectorDecl::IndexRange() const
+    {
+	return new RangeDecl(new Range(0, count - 1), Get<IntegerDecl>());
     }
 
     llvm::Type* DynArrayDecl::GetArrayType(TypeDecl* baseType)
@@ -456,15 +676,200 @@ namespace Types
 	}
 	if (const auto aty = llvm::dyn_cast<ArrayDecl>(ty))
 	{
-	    if (aty->SubType() != SubType() || aty->Ranges().size() != 1)
+	    if (aty->SubType() != SubType() || aty->Ranges().size() != 1 || aty->IsSoA() ||
+	        aty->BitsPerElement())
 	    {
 		return 0;
 	    }
 	    return aty;
 	}
+	if (const auto hty = llvm::dyn_cast<HeapArrayDecl>(ty))
+	{
+	    return (hty->SubType() == SubType()) ? hty : 0;
+	}
+	return 0;
+    }
+
+    void HeapArrayDecl::DoDump() const
+    {
+	std::cerr << "Array of ";
+	baseType->DoDump();
+    }
+
+    unsigned HeapArrayDecl::Depth() const
+    {
+	if (auto hty = llvm::dyn_cast<HeapArrayDecl>(baseType))
+	{
+	    return hty->Depth() + 1;
+	}
+	return 0;
+    }
+
+    const TypeDecl* HeapArrayDecl::InnerType() const
+    {
+	if (auto hty = llvm::dyn_cast<HeapArrayDecl>(baseType))
+	{
+	    return hty->InnerType();
+	}
+	return baseType;
+    }
+
+    llvm::Type* HeapArrayDecl::GetLlvmType() const
+    {
+	llvm::Type* ptrTy = llvm::PointerType::getUnqual(baseType->StorageType());
+	llvm::Type* sizeTy = Get<Int64Decl>()->LlvmType();
+	return llvm::StructType::get(ptrTy, sizeTy, sizeTy);
+    }
+
+    llvm::DIType* HeapArrayDecl::GetDIType(llvm::DIBuilder* builder) const
+    {
+	llvm::DIType* bd = baseType->DebugType(builder);
+	if (!bd)
+	{
+	    return 0;
+	}
+	const llvm::DataLayout    dl(theModule);
+	const llvm::StructLayout* sl = dl.getStructLayout(llvm::cast<llvm::StructType>(LlvmType()));
+	llvm::DIType*             sizeTy = Get<Int64Decl>()->DebugType(builder);
+	uint64_t                  sizeBits = Get<Int64Decl>()->Size() * CHAR_BIT;
+	uint64_t                  ptrBits = dl.getPointerSizeInBits();
+	llvm::DIType*             ptrTy = builder->createPointerType(bd, ptrBits);
+	std::vector<llvm::Metadata*> eltTys = {
+	    builder->createMemberType(0, "data", 0, 0, ptrBits, ptrBits, sl->getElementOffsetInBits(0),
+	                              llvm::DINode::FlagZero, ptrTy),
+	    builder->createMemberType(0, "length", 0, 0, sizeBits, sizeBits, sl->getElementOffsetInBits(1),
+	                              llvm::DINode::FlagZero, sizeTy),
+	    builder->createMemberType(0, "capacity", 0, 0, sizeBits, sizeBits, sl->getElementOffsetInBits(2),
+	                              llvm::DINode::FlagZero, sizeTy),
+	};
+	llvm::DINodeArray elements = builder->getOrCreateArray(eltTys);
+	return builder->createStructType(0, "", 0, 0, Size() * CHAR_BIT, AlignSize() * CHAR_BIT,
+	                                 llvm::DINode::FlagZero, 0, elements);
+    }
+
+    const TypeDecl* BigIntDecl::CompatibleType(const TypeDecl* ty) const
+    {
+	if (SameAs(ty) || ty->Type() == TK_Integer || ty->Type() == TK_LongInt)
+	{
+	    return this;
+	}
 	return 0;
     }
 
+    void BigIntDecl::DoDump() const
+    {
+	std::cerr << "Bigint";
+    }
+
+    llvm::Type* BigIntDecl::GetLlvmType() const
+    {
+	llvm::Type* sizeTy = Get<Int64Decl>()->LlvmType();
+	return llvm::StructType::get(GetVoidPtrType(), sizeTy, sizeTy);
+    }
+
+    llvm::DIType* BigIntDecl::GetDIType(llvm::DIBuilder* builder) const
+    {
+	const llvm::DataLayout    dl(theModule);
+	const llvm::StructLayout* sl = dl.getStructLayout(llvm::cast<llvm::StructType>(LlvmType()));
+	llvm::DIType*             sizeTy = Get<Int64Decl>()->DebugType(builder);
+	uint64_t                  sizeBits = Get<Int64Decl>()->Size() * CHAR_BIT;
+	uint64_t                  ptrBits = dl.getPointerSizeInBits();
+	llvm::DIType*             ptrTy = builder->createPointerType(0, ptrBits);
+	std::vector<llvm::Metadata*> eltTys = {
+	    builder->createMemberType(0, "limbs", 0, 0, ptrBits, ptrBits, sl->getElementOffsetInBits(0),
+	                              llvm::DINode::FlagZero, ptrTy),
+	    builder->createMemberType(0, "size", 0, 0, sizeBits, sizeBits, sl->getElementOffsetInBits(1),
+	                              llvm::DINode::FlagZero, sizeTy),
+	    builder->createMemberType(0, "capacity", 0, 0, sizeBits, sizeBits, sl->getElementOffsetInBits(2),
+	                              llvm::DINode::FlagZero, sizeTy),
+	};
+	llvm::DINodeArray elements = builder->getOrCreateArray(eltTys);
+	return builder->createStructType(0, "bigint", 0, 0, Size() * CHAR_BIT, AlignSize() * CHAR_BIT,
+	                                 llvm::DINode::FlagZero, 0, elements);
+    }
+
+    void MapDecl::DoDump() const
+    {
+	std::cerr << ((isSet) ? "Hashset of " : "Map of ");
+	keyType->DoDump();
+	if (!isSet)
+	{
+	    std::cerr << " to ";
+	    baseType->DoDump();
+	}
+    }
+
+    bool MapDecl::SameAs(const TypeDecl* ty) const
+    {
+	if (this == ty)
+	{
+	    return true;
+	}
+	auto mty = llvm::dyn_cast<MapDecl>(ty);
+	return mty && isSet == mty->isSet && *keyType == *mty->keyType && *baseType == *mty->baseType;
+    }
+
+    bool MapDecl::IsKeyType(const TypeDecl* ty)
+    {
+	if (IsIntegral(ty) || llvm::isa<StringDecl>(ty))
+	{
+	    return true;
+	}
+	auto rd = llvm::dyn_cast<RecordDecl>(ty);
+	if (!rd || rd->Variant())
+	{
+	    return false;
+	}
+	for (int i = 0; i < rd->FieldCount(); i++)
+	{
+	    if (!IsKeyType(rd->GetElement(i)->SubType()))
+	    {
+		return false;
+	    }
+	}
+	return true;
+    }
+
+    llvm::StructType* MapDecl::SlotType() const
+    {
+	if (isSet)
+	{
+	    return llvm::StructType::get(keyType->StorageType());
+	}
+	return llvm::StructType::get(keyType->StorageType(), baseType->StorageType());
+    }
+
+    // Matches struct Map in the runtime: control bytes, count, slots, capacity and free slots left.
+    llvm::Type* MapDecl::GetLlvmType() const
+    {
+	llvm::Type* ptrTy = GetVoidPtrType();
+	llvm::Type* sizeTy = Get<Int64Decl>()->LlvmType();
+	return llvm::StructType::get(ptrTy, sizeTy, ptrTy, sizeTy, sizeTy);
+    }
+
+    llvm::DIType* MapDecl::GetDIType(llvm::DIBuilder* builder) const
+    {
+	const llvm::DataLayout    dl(theModule);
+	const llvm::StructLayout* sl = dl.getStructLayout(llvm::cast<llvm::StructType>(LlvmType()));
+	llvm::DIType*             sizeTy = Get<Int64Decl>()->DebugType(builder);
+	uint64_t                  sizeBits = Get<Int64Decl>()->Size() * CHAR_BIT;
+	uint64_t                  ptrBits = dl.getPointerSizeInBits();
+	llvm::DIType*             ptrTy = builder->createPointerType(0, ptrBits);
+	std::vector<llvm::Metadata*> eltTys;
+	const char*                  names[] = { "ctrl", "count", "slots", "capacity", "growthleft" };
+	for (unsigned i = 0; i < 5; i++)
+	{
+	    bool     isPtr = i == 0 || i == 2;
+	    uint64_t bits = (isPtr) ? ptrBits : sizeBits;
+	    uint64_t offset = sl->getElementOffsetInBits(i);
+	    eltTys.push_back(builder->createMemberType(0, names[i], 0, 0, bits, bits, offset,
+	                                               llvm::DINode::FlagZero, (isPtr) ? ptrTy : sizeTy));
+	}
+	llvm::DINodeArray elements = builder->getOrCreateArray(eltTys);
+	return builder->createStructType(0, "", 0, 0, Size() * CHAR_BIT, AlignSize() * CHAR_BIT,
+	                                 llvm::DINode::FlagZero, 0, elements);
+    }
+
     void Range::DoDump() const
     {
 	std::cerr << "[" << start << ".." << end << "]";
@@ -487,6 +892,38 @@ namespace Types
 	return Type() == ty->Type();
     }
 
+    llvm::Type* RangeDecl::StorageType() const
+    {
+	// Values are still calculated in the base type, only memory is narrower. 64-bit ranges are
+	// left alone.
+	if (Type() == TK_Integer)
+	{
+	    int64_t start = range->Start();
+	    int64_t end = range->End();
+	    if ((start >= 0 && end <= UCHAR_MAX) || (start >= SCHAR_MIN && end <= SCHAR_MAX))
+	    {
+		return llvm::Type::getInt8Ty(theContext);
+	    }
+	    if ((start >= 0 && end <= USHRT_MAX) || (start >= SHRT_MIN && end <= SHRT_MAX))
+	    {
+		return llvm::Type::getInt16Ty(theContext);
+	    }
+	}
+	return LlvmType();
+    }
+
+    llvm::DIType* RangeDecl::GetDIType(llvm::DIBuilder* builder) const
+    {
+	llvm::Type* ty = StorageType();
+	if (ty == LlvmType())
+	{
+	    return baseType->DebugType(builder);
+	}
+	unsigned bits = ty->getIntegerBitWidth();
+	unsigned encoding = (Start() < 0) ? llvm::dwarf::DW_ATE_signed : llvm::dwarf::DW_ATE_unsigned;
+	return builder->createBasicType("INTEGER" + std::to_string(bits), bits, encoding);
+    }
+
     const TypeDecl* RangeBaseDecl::CompatibleType(const TypeDecl* ty) const
     {
 	if (*this == *ty)
@@ -606,7 +1043,7 @@ namespace Types
 	size_t                 elt = 0;
 	for (auto f : fields)
 	{
-	    llvm::Type* ty = f->LlvmType();
+	    llvm::Type* ty = f->StorageType();
 	    if (auto pf = llvm::dyn_cast<PointerDecl>(f->SubType()))
 	    {
 		if (pf->IsIncomplete())
@@ -634,7 +1071,7 @@ namespace Types
 	    elt++;
 	}
 
-	llvm::Type*              ty = fields[maxAlignElt]->LlvmType();
+	llvm::Type*              ty = fields[maxAlignElt]->StorageType();
 	std::vector<llvm::Type*> fv = { ty };
 	if (maxAlignElt != maxSizeElt)
 	{
@@ -732,13 +1169,28 @@ namespace Types
 	}
     }
 
+    // Add ty to the struct elements in fv, with a byte array in front if it needs more than its
+    // natural alignment.
+    static void AddStructElement(const llvm::DataLayout& dl, std::vector<llvm::Type*>& fv, uint64_t& offset,
+                                 uint64_t& naturalAlign, llvm::Type* ty, uint64_t want, bool packed)
+    {
+	uint64_t natural = (packed) ? 1 : dl.getABITypeAlign(ty).value();
+	uint64_t start = llvm::alignTo(offset, std::max(natural, want));
+	if (start != llvm::alignTo(offset, natural))
+	{
+	    fv.push_back(llvm::ArrayType::get(llvm::Type::getInt8Ty(theContext), start - offset));
+	}
+	fv.push_back(ty);
+	offset = start + dl.getTypeAllocSize(ty);
+	naturalAlign = std::max(naturalAlign, natural);
+    }
+
     llvm::Type* RecordDecl::GetLlvmType() const
     {
 	if (clonedFrom)
 	{
 	    return clonedFrom->LlvmType();
 	}
-	std::vector<llvm::Type*> fv;
 	for (auto f : fields)
 	{
 	    if (auto pf = llvm::dyn_cast_or_null<PointerDecl>(f->SubType()))
@@ -752,22 +1204,101 @@ namespace Types
 		    return opaqueType;
 		}
 	    }
-	    fv.push_back(f->LlvmType());
+	}
+
+	const llvm::DataLayout dl(theModule);
+	std::vector<unsigned>  order(fields.size());
+	std::iota(order.begin(), order.end(), 0);
+	if (reorder)
+	{
+	    // Most aligned first, then largest first, leaves the least padding between fields.
+	    std::vector<std::pair<uint64_t, uint64_t>> key;
+	    for (auto f : fields)
+	    {
+		llvm::Type* ty = f->StorageType();
+		key.push_back({ std::max<uint64_t>(dl.getABITypeAlign(ty).value(), f->MinAlign()),
+		                dl.getTypeAllocSize(ty) });
+	    }
+	    std::stable_sort(order.begin(), order.end(),
+	                     [&](unsigned a, unsigned b) { return key[a] > key[b]; });
+	}
+
+	std::vector<llvm::Type*> fv;
+	uint64_t                 offset = 0;
+	uint64_t                 naturalAlign = 1;
+	structIndex.assign(fields.size() + 1, 0);
+	// A packed record has no padding, so {$align n} is ignored on its fields.
+	for (auto i : order)
+	{
+	    structIndex[i] = fv.size();
+	    AddStructElement(dl, fv, offset, naturalAlign, fields[i]->StorageType(),
+	                     (packed) ? 0 : fields[i]->MinAlign(), packed);
 	}
 	if (variant)
 	{
-	    fv.push_back(variant->LlvmType());
+	    size_t want = 0;
+	    for (int i = 0; i < variant->FieldCount(); i++)
+	    {
+		want = std::max(want, variant->GetElement(i)->MinAlign());
+	    }
+	    structIndex[fields.size()] = fv.size();
+	    AddStructElement(dl, fv, offset, naturalAlign, variant->LlvmType(), want, packed);
+	}
+	uint64_t recAlign = MinAlign();
+	if (recAlign > naturalAlign)
+	{
+	    uint64_t size = llvm::alignTo(offset, recAlign);
+	    if (size != llvm::alignTo(offset, naturalAlign))
+	    {
+		fv.push_back(llvm::ArrayType::get(llvm::Type::getInt8Ty(theContext), size - offset));
+	    }
 	}
 	if (opaqueType)
 	{
-	    opaqueType->setBody(fv);
+	    opaqueType->setBody(fv, packed);
 	    return opaqueType;
 	}
 	if (fv.empty())
 	{
 	    fv.push_back(llvm::Type::getInt8Ty(theContext));
 	}
-	return llvm::StructType::create(fv, name);
+	return llvm::StructType::create(fv, name, packed);
+    }
+
+    size_t RecordDecl::MinAlign() const
+    {
+	if (clonedFrom)
+	{
+	    return clonedFrom->MinAlign();
+	}
+	size_t a = align;
+	for (auto f : fields)
+	{
+	    a = std::max(a, f->MinAlign());
+	}
+	if (variant)
+	{
+	    for (int i = 0; i < variant->FieldCount(); i++)
+	    {
+		a = std::max(a, variant->GetElement(i)->MinAlign());
+	    }
+	}
+	return a;
+    }
+
+    unsigned RecordDecl::StructIndex(unsigned n) const
+    {
+	if (clonedFrom)
+	{
+	    return clonedFrom->StructIndex(n);
+	}
+	LlvmType();
+	if (structIndex.empty())
+	{
+	    return n;
+	}
+	ICE_IF(n >= structIndex.size(), "Out of range field");
+	return structIndex[n];
     }
 
     llvm::DIType* RecordDecl::GetDIType(llvm::DIBuilder* builder) const
@@ -826,7 +1357,7 @@ namespace Types
 	    size_t offsetInBits = 0;
 	    if (sl)
 	    {
-		offsetInBits = sl->getElementOffsetInBits(index);
+		offsetInBits = sl->getElementOffsetInBits(StructIndex(index));
 	    }
 	    d = builder->createMemberType(scope, f->Name(), unit, lineNo, size, align, offsetInBits,
 	                                  llvm::DINode::FlagZero, d);
@@ -1115,7 +1646,7 @@ namespace Types
 			return opaqueType;
 		    }
 		}
-		fv.push_back(f->LlvmType());
+		fv.push_back(f->StorageType());
 	    }
 	}
 	if (variant)
@@ -1353,6 +1884,15 @@ namespace Types
 	return llvm::PointerType::getUnqual(base);
     }
 
+    TypeDecl* GetIndexType()
+    {
+	if (model == m32)
+	{
+	    return Get<IntegerDecl>();
+	}
+	return Get<Int64Decl>();
+    }
+
     bool IsNumeric(const TypeDecl* t)
     {
 	switch (t->Type())
@@ -1360,6 +1900,8 @@ namespace Types
 	case TypeDecl::TK_Integer:
 	case TypeDecl::TK_LongInt:
 	case TypeDecl::TK_Real:
+	case TypeDecl::TK_Single:
+	case TypeDecl::TK_Extended:
 	case TypeDecl::TK_Complex:
 	    return true;
 	default:
@@ -1427,6 +1969,9 @@ namespace Types
 	case TypeDecl::TK_Array:
 	case TypeDecl::TK_String:
 	case TypeDecl::TK_DynArray:
+	case TypeDecl::TK_HeapArray:
+	case TypeDecl::TK_Map:
+	case TypeDecl::TK_BigInt:
 	case TypeDecl::TK_Record:
 	case TypeDecl::TK_Class:
 	    return true;
@@ -1436,6 +1981,11 @@ namespace Types
 	}
     }
 
+    bool IsManaged(const TypeDecl* t)
+    {
+	return llvm::isa<HeapArrayDecl, MapDecl, BigIntDecl>(t);
+    }
+
     bool HasLlvmType(const TypeDecl* t)
     {
 	switch (t->Type())
@@ -1456,6 +2006,7 @@ namespace Types
 	case TypeDecl::TK_Text:
 	case TypeDecl::TK_Set:
 	case TypeDecl::TK_Array:
+	case TypeDecl::TK_HeapArray:
 	case TypeDecl::TK_Field:
 	case TypeDecl::TK_Pointer:
 	{
@@ -1463,6 +2014,12 @@ namespace Types
 	    return HasLlvmType(p->SubType());
 	}
 
+	case TypeDecl::TK_Map:
+	{
+	    auto m = llvm::cast<MapDecl>(t);
+	    return HasLlvmType(m->KeyType()) && HasLlvmType(m->SubType());
+	}
+
 	default:
 	    return true;
 	}
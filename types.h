@@ -39,6 +39,9 @@ namespace Types
     bool IsUnsigned(const TypeDecl* t);
     bool IsCompound(const TypeDecl* t);
     bool HasLlvmType(const TypeDecl* t);
+    // Dynamic arrays, maps and bigints own storage on the heap, which is copied when the variable is
+    // assigned or passed by value, and released when the variable goes out of scope.
+    bool IsManaged(const TypeDecl* t);
 
     // Range is either created by the user, or calculated on basetype
     class Range
@@ -71,12 +74,17 @@ namespace Types
 	    TK_Integer,
 	    TK_LongInt,
 	    TK_Real,
+	    TK_Single,
+	    TK_Extended,
 	    TK_Void,
 	    TK_Array,
 	    TK_SchArray,
 	    TK_String,
 	    TK_LastArray,
 	    TK_DynArray,
+	    TK_HeapArray,
+	    TK_Map,
+	    TK_BigInt,
 	    TK_Range,
 	    TK_DynRange,
 	    TK_SchRange,
@@ -96,6 +104,7 @@ namespace Types
 	    TK_MemberFunc,
 	    TK_Forward,
 	    TK_Complex,
+	    TK_Vector,
 	};
 
 	TypeDecl(TypeKind k) : kind(k), lType(0), diType(0), name(""), init(0) {}
@@ -107,6 +116,7 @@ namespace Types
 	virtual const TypeDecl* CompatibleType(const TypeDecl* ty) const;
 	virtual const TypeDecl* AssignableType(const TypeDecl* ty) const { return CompatibleType(ty); }
 	llvm::Type*             LlvmType() const;
+	virtual llvm::Type*     StorageType() const { return LlvmType(); }
 	llvm::DIType*           DebugType(llvm::DIBuilder* builder) const;
 	llvm::DIType*           DiType() const { return diType; }
 	void                    DiType(llvm::DIType* d) const { diType = d; }
@@ -116,6 +126,8 @@ namespace Types
 	TypeKind                getKind() const { return kind; }
 	virtual size_t          Size() const;
 	size_t                  AlignSize() const;
+	// Alignment asked for with {$align N}, or zero if the natural alignment is used.
+	virtual size_t          MinAlign() const { return 0; }
 	std::string             Name() const { return name; }
 	void                    Name(const std::string& nm) { name = nm; }
 	ExprAST*                Init() { return init; }
@@ -192,21 +204,40 @@ namespace Types
     using IntegerDecl = IntegerXDecl<32, TypeDecl::TK_Integer>;
     using Int64Decl = IntegerXDecl<64, TypeDecl::TK_LongInt>;
 
+    // Real is a 64-bit double, single is 32-bit and extended is the target's long double.
     class RealDecl : public TypeDecl
     {
     public:
-	RealDecl() : TypeDecl(TK_Real) {}
+	RealDecl(TypeKind k = TK_Real) : TypeDecl(k) {}
+	unsigned        Bits() const;
 	const TypeDecl* CompatibleType(const TypeDecl* ty) const override;
 	const TypeDecl* AssignableType(const TypeDecl* ty) const override;
 	void            DoDump() const override;
-	static bool     classof(const TypeDecl* e) { return e->getKind() == TK_Real; }
-	TypeDecl*       Clone() const override { return new RealDecl(); }
+	static bool     classof(const TypeDecl* e)
+	{
+	    return e->getKind() >= TK_Real && e->getKind() <= TK_Extended;
+	}
+	TypeDecl* Clone() const override { return new RealDecl(kind); }
 
     protected:
 	llvm::Type*   GetLlvmType() const override;
 	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
     };
 
+    class SingleDecl : public RealDecl
+    {
+    public:
+	SingleDecl() : RealDecl(TK_Single) {}
+	static bool classof(const TypeDecl* e) { return e->getKind() == TK_Single; }
+    };
+
+    class ExtendedDecl : public RealDecl
+    {
+    public:
+	ExtendedDecl() : RealDecl(TK_Extended) {}
+	static bool classof(const TypeDecl* e) { return e->getKind() == TK_Extended; }
+    };
+
     class VoidDecl : public TypeDecl
     {
     public:
@@ -265,11 +296,16 @@ namespace Types
 	void        DoDump() const override;
 	static bool classof(const TypeDecl* e) { return e->getKind() == TK_Range; }
 	bool        SameAs(const TypeDecl* ty) const override;
-	int         Start() const { return range->Start(); }
-	int         End() const { return range->End(); }
+	int64_t     Start() const { return range->Start(); }
+	int64_t     End() const { return range->End(); }
 	size_t      RangeSize() const override { return range->Size(); }
 	TypeKind    Type() const override { return baseType->Type(); }
 	Range*      GetRange() const override { return range; }
+	// Integer subranges are stored in the narrowest integer that holds them.
+	llvm::Type* StorageType() const override;
+
+    protected:
+	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
 
     private:
 	Range* range;
@@ -301,12 +337,13 @@ namespace Types
     class ArrayDecl : public CompoundDecl
     {
     public:
-	ArrayDecl(TypeDecl* b, const std::vector<RangeBaseDecl*>& r) : CompoundDecl(TK_Array, b), ranges(r)
+	ArrayDecl(TypeDecl* b, const std::vector<RangeBaseDecl*>& r)
+	    : CompoundDecl(TK_Array, b), ranges(r), packed(false), soa(false)
 	{
 	    ICE_IF(r.empty(), "Empty range not allowed");
 	}
 	ArrayDecl(TypeKind tk, TypeDecl* b, const std::vector<RangeBaseDecl*>& r)
-	    : CompoundDecl(tk, b), ranges(r)
+	    : CompoundDecl(tk, b), ranges(r), packed(false), soa(false)
 	{
 	    ICE_IF(tk != TK_String && tk != TK_SchArray, "Expected this to be a string or schema array...");
 	    ICE_IF(r.empty(), "Empty range not allowed");
@@ -320,6 +357,14 @@ namespace Types
 	    return e->getKind() >= TK_Array && e->getKind() <= TK_LastArray;
 	}
 	TypeDecl* Clone() const override;
+	void      SetPacked() { packed = true; }
+	size_t    MinAlign() const override { return baseType->MinAlign(); }
+	// A packed array of booleans, or of enums or ranges with up to 16 values, stores its elements in
+	// 1, 2 or 4 bits each. Returns 0 if the elements are not bit-packed.
+	unsigned BitsPerElement() const;
+	// An array of records declared with {$soa} is stored as one array per field of the record.
+	void     SetSoA() { soa = true; }
+	bool     IsSoA() const { return soa; }
 
     protected:
 	llvm::Type*   GetLlvmType() const override;
@@ -327,6 +372,32 @@ namespace Types
 
     private:
 	std::vector<RangeBaseDecl*> ranges;
+	bool                        packed;
+	bool                        soa;
+    };
+
+    // SIMD vector, "vector[N] of T", maps directly to an LLVM fixed vector type.
+    class VectorDecl : public CompoundDecl
+    {
+    public:
+	VectorDecl(TypeDecl* b, size_t n) : CompoundDecl(TK_Vector, b), count(n), maskType(0) {}
+	size_t          Count() const { return count; }
+	VectorDecl*     MaskType() const;
+	bool            MatchesArray(const TypeDecl* ty) const;
+	RangeDecl*      IndexRange() const;
+	void            DoDump() const override;
+	bool            SameAs(const TypeDecl* ty) const override;
+	const TypeDecl* CompatibleType(const TypeDecl* ty) const override;
+	static bool     classof(const TypeDecl* e) { return e->getKind() == TK_Vector; }
+	TypeDecl*       Clone() const override { return new VectorDecl(baseType, count); }
+
+    protected:
+	llvm::Type*   GetLlvmType() const override;
+	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
+
+    private:
+	size_t              count;
+	mutable VectorDecl* maskType;
     };
 
     class DynArrayDecl : public CompoundDecl
@@ -346,6 +417,66 @@ namespace Types
 	DynRangeDecl* range;
     };
 
+    // "array of T" without bounds. The elements live on the heap, and are indexed from zero. The variable
+    // itself is a descriptor of the element pointer, the length and the capacity of the allocation.
+    class HeapArrayDecl : public CompoundDecl
+    {
+    public:
+	HeapArrayDecl(TypeDecl* b) : CompoundDecl(TK_HeapArray, b) {}
+	void            DoDump() const override;
+	static bool     classof(const TypeDecl* e) { return e->getKind() == TK_HeapArray; }
+	TypeDecl*       Clone() const override { return new HeapArrayDecl(baseType); }
+	// The runtime copies and frees nested "array of array of T" one level at a time, so it needs
+	// to know how many levels there are below this one, and the size of the innermost elements.
+	unsigned        Depth() const;
+	const TypeDecl* InnerType() const;
+
+    protected:
+	llvm::Type*   GetLlvmType() const override;
+	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
+    };
+
+    // "map of K to V", or "hashset of K", which is a map without values. The variable is a descriptor
+    // of a hash table on the heap, where each slot holds a key followed by its value.
+    class MapDecl : public CompoundDecl
+    {
+    public:
+	MapDecl(TypeDecl* k, TypeDecl* v) : CompoundDecl(TK_Map, v ? v : k), keyType(k), isSet(!v) {}
+	void               DoDump() const override;
+	static bool        classof(const TypeDecl* e) { return e->getKind() == TK_Map; }
+	TypeDecl*          Clone() const override { return new MapDecl(keyType, (isSet) ? 0 : baseType); }
+	bool               SameAs(const TypeDecl* ty) const override;
+	TypeDecl*          KeyType() const { return keyType; }
+	bool               IsSet() const { return isSet; }
+	llvm::StructType*  SlotType() const;
+	// Keys are hashed and compared by value, so they are ordinal types, strings, or records of those.
+	static bool        IsKeyType(const TypeDecl* ty);
+
+    protected:
+	llvm::Type*   GetLlvmType() const override;
+	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
+
+    private:
+	TypeDecl* keyType;
+	bool      isSet;
+    };
+
+    // An arbitrary precision integer. Like a dynamic array, the variable is a descriptor of the
+    // limbs on the heap, and each arithmetic operation gives a new descriptor.
+    class BigIntDecl : public TypeDecl
+    {
+    public:
+	BigIntDecl() : TypeDecl(TK_BigInt) {}
+	const TypeDecl* CompatibleType(const TypeDecl* ty) const override;
+	void            DoDump() const override;
+	static bool     classof(const TypeDecl* e) { return e->getKind() == TK_BigInt; }
+	TypeDecl*       Clone() const override { return new BigIntDecl(); }
+
+    protected:
+	llvm::Type*   GetLlvmType() const override;
+	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
+    };
+
     struct EnumValue
     {
 	EnumValue(const std::string& nm, int v) : name(nm), value(v) {}
@@ -462,7 +593,7 @@ namespace Types
 	    Public
 	};
 	FieldDecl(const std::string& nm, TypeDecl* ty, bool stat, Access ac = Public)
-	    : CompoundDecl(TK_Field, ty), isStatic(stat)
+	    : CompoundDecl(TK_Field, ty), isStatic(stat), align(0)
 	{
 	    Name(nm);
 	}
@@ -471,12 +602,16 @@ namespace Types
 	void        DoDump() const override;
 	bool        IsStatic() const { return isStatic; }
 	bool        SameAs(const TypeDecl* ty) const override { return baseType->SameAs(ty); }
+	llvm::Type* StorageType() const override { return baseType->StorageType(); }
+	void        SetAlign(size_t a) { align = a; }
+	size_t      MinAlign() const override { return std::max(align, baseType->MinAlign()); }
 	static bool classof(const TypeDecl* e) { return e->getKind() == TK_Field; }
 	operator Access() { return access; }
 
     private:
 	bool   isStatic;
 	Access access;
+	size_t align;
     };
 
     class FieldCollection : public TypeDecl
@@ -521,17 +656,31 @@ namespace Types
     {
     public:
 	RecordDecl(TypeKind type, const std::vector<FieldDecl*>& flds, VariantDecl* v)
-	    : FieldCollection(type, flds), variant(v), clonedFrom(nullptr){};
+	    : FieldCollection(type, flds), variant(v), clonedFrom(nullptr), packed(false), reorder(false),
+	      align(0){};
 	RecordDecl(const std::vector<FieldDecl*>& flds, VariantDecl* v)
-	    : FieldCollection(TK_Record, flds), variant(v), clonedFrom(nullptr){};
+	    : FieldCollection(TK_Record, flds), variant(v), clonedFrom(nullptr), packed(false),
+	      reorder(false), align(0){};
 	void         DoDump() const override;
 	size_t       Size() const override;
 	VariantDecl* Variant() const { return variant; }
 	bool         SameAs(const TypeDecl* ty) const override;
 	static bool  classof(const TypeDecl* e) { return e->getKind() == TK_Record; }
+	// A packed record has no padding between fields, so they may not be aligned.
+	void         SetPacked() { packed = true; }
+	bool         IsPacked() const { return packed; }
+	// Allow the fields to be stored in a different order from the declaration, to reduce padding.
+	void         SetReorder() { reorder = true; }
+	void         SetAlign(size_t a) { align = a; }
+	size_t       MinAlign() const override;
+	// Index in the LLVM struct of field n, where n == FieldCount() is the variant part.
+	unsigned     StructIndex(unsigned n) const;
 	TypeDecl*    Clone() const override
 	{
 	    RecordDecl* rd = new RecordDecl(getKind(), fields, variant);
+	    rd->packed = packed;
+	    rd->reorder = reorder;
+	    rd->align = align;
 	    if (this->clonedFrom)
 	    {
 		rd->clonedFrom = this->clonedFrom;
@@ -548,8 +697,12 @@ namespace Types
 	llvm::DIType* GetDIType(llvm::DIBuilder* builder) const override;
 
     private:
-	VariantDecl*      variant;
-	const RecordDecl* clonedFrom;
+	VariantDecl*                  variant;
+	const RecordDecl*             clonedFrom;
+	bool                          packed;
+	bool                          reorder;
+	size_t                        align;
+	mutable std::vector<unsigned> structIndex;
     };
 
     // Objects can have member functions/procedures
@@ -728,6 +881,8 @@ namespace Types
     };
 
     llvm::Type* GetVoidPtrType();
+    // Pointer-width integer, used for array index arithmetic and sizes passed to the runtime.
+    TypeDecl* GetIndexType();
 
     void Finalize(llvm::DIBuilder* builder);
 